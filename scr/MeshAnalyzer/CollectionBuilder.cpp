@@ -0,0 +1,259 @@
+//=================================================================================================================
+/**
+ *  @file       CollectionBuilder.cpp
+ *  @brief      CollectionBuilder class implementation file.
+ *  @details    This file contains the implementation of the CollectionBuilder class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "CollectionBuilder.h"
+#include "DescriptorStore.h"
+#include "FeatureFile.h"
+#include "RotationIndexCache.h"
+
+#include "nct/nct_utils.h"
+#include "nct/nct_exception.h"
+#include "nct/random/MersenneTwister.h"
+#include "nct/geometry/mesh.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
+#include <fstream>
+#include <set>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+using namespace nct::geometry::rasterization;
+
+//=================================================================================================================
+//        FUNCTIONS
+//=================================================================================================================
+
+/**
+ *  @brief      Write array.
+ *  @details    This function writes an array in a binary file with the format of the feature files.
+ *  @tparam     ArrayType  The type of array.
+ *  @param[in]  fileName  The name of the file.
+ *  @param[in]  arr  The array to write.
+ */
+template<typename ArrayType>
+static void writeArrayFile(const QString& fileName, const ArrayType& arr)
+{
+    ofstream file(fileName.toLatin1().data(), ios_base::binary);
+    if (!file.is_open())
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    arr.write(file);
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+CollectionBuilder::CollectionBuilder(const MeshData& parameters) :
+    parameters_(parameters)
+{
+    if ((parameters_.nSamps == 0) || (parameters_.nBins == 0) || (parameters_.nVox == 0))
+        throw OperationException("Bad descriptor parameters", "");
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionBuilder::setThreads(unsigned int nThreads) noexcept
+{
+    nThreads_ = nThreads;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionBuilder::setSeed(unsigned long long seed) noexcept
+{
+    seed_ = seed;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MeshData CollectionBuilder::build(const QStringList& meshFiles, const QString& outputPath)
+{
+    failures_.clear();
+
+    QDir output(outputPath);
+    if (!output.mkpath(featureDirectory) || !output.mkpath(screenshotDirectory))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    auto featurePath = QDir(output.absoluteFilePath(featureDirectory)).absolutePath() + "/";
+    auto screenshotsPath = QDir(output.absoluteFilePath(screenshotDirectory)).absolutePath() + "/";
+
+    // Model names. The feature files are identified by the name of the model, so the names
+    // must be unique.
+    auto nFiles = static_cast<size_t>(meshFiles.size());
+    std::vector<QString> names(nFiles);
+    std::vector<QString> errors(nFiles);
+    std::set<QString> usedNames;
+
+    for (size_t i = 0; i < nFiles; i++) {
+        names[i] = modelName(meshFiles[i]);
+        if (!usedNames.insert(names[i]).second)
+            errors[i] = "Duplicated model name";
+    }
+
+    // Matrices shared by the harmonic descriptors of every model.
+    auto hmat = RasterizedObject3D::harmonicMatrices(parameters_.nVox);
+    writeArrayFile(featurePath + "hB.bin", hmat.hB);
+    writeArrayFile(featurePath + "theta.bin", hmat.theta);
+    writeArrayFile(featurePath + "phi.bin", hmat.phi);
+    writeArrayFile(featurePath + "Bt.bin", hmat.Bt);
+    writeArrayFile(featurePath + "BtBI.bin", hmat.BtBI);
+
+    // Rotation indices of the default number of test angles, so that the first query doesn't
+    // calculate them.
+    if (parameters_.nTestAng > 0) {
+        RotationIndexCache::write(featurePath + RotationIndexCache::fileName(parameters_.nVox, parameters_.nTestAng),
+            parameters_.nVox, parameters_.nTestAng, 
+            RotationIndexCache::calculate(parameters_.nVox, parameters_.nTestAng));
+    }
+
+    // Descriptors of each model. Each thread loads, processes and releases one mesh at a time.
+    nct::parallel_for(static_cast<size_t>(0), nFiles, nThreads_, [&](size_t i) {
+        if (!errors[i].isEmpty())
+            return;
+
+        try {
+            auto mesh = readMeshFile(meshFiles[i]);
+            buildModel(mesh, featurePath + names[i], hmat, seed_ + i);
+        }
+        catch (const std::exception& ex) {
+            errors[i] = ex.what();
+        }
+    });
+
+    // Configuration of the collection.
+    MeshData meshData = parameters_;
+    meshData.featurePath = featurePath;
+    meshData.screenshotsPath = screenshotsPath;
+    meshData.nInfo = 1;
+    meshData.infoFields = {"Source file"};
+
+    std::vector<size_t> built;
+    for (size_t i = 0; i < nFiles; i++) {
+        if (errors[i].isEmpty())
+            built.push_back(i);
+        else
+            failures_.push_back({meshFiles[i], errors[i]});
+    }
+
+    meshData.nModels = static_cast<unsigned int>(built.size());
+    meshData.models.assign(built.size(), 9, QString());
+    for (size_t i = 0; i < built.size(); i++) {
+        meshData.models(i, 0) = names[built[i]];
+        meshData.models(i, 1) = QFileInfo(meshFiles[built[i]]).fileName().replace(",", "_");
+    }
+
+    if (meshData.nModels > 0)
+        FeatureFile::convert(featurePath, meshData.models, featurePath + FeatureFile::defaultFileName);
+
+    writeMeshDataFile(output.absoluteFilePath(configFileName), meshData);
+
+    return meshData;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::vector<CollectionBuilder::Failure>& CollectionBuilder::failures() const noexcept
+{
+    return failures_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QStringList CollectionBuilder::findMeshFiles(const QString& directory)
+{
+    QDir dir(directory);
+    auto files = dir.entryList(QStringList{"*.stl", "*.STL", "*.ply", "*.PLY"}, QDir::Files, QDir::Name);
+
+    QStringList paths;
+    for (const auto& file : files)
+        paths.append(dir.absoluteFilePath(file));
+
+    return paths;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString CollectionBuilder::modelName(const QString& meshFile)
+{
+    return QFileInfo(meshFile).completeBaseName().replace(",", "_");
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::Model CollectionBuilder::calculate(const MeshGeometry& mesh,
+    const nct::geometry::RasterizedObject3D::HarmonicMatrices& hmat, unsigned long long seed) const
+{
+    if ((mesh.vertices.size() == 0) || (mesh.triangles.size() == 0))
+        throw OperationException("Empty mesh", "");
+
+    DescriptorStore::Model model;
+
+    // Shape distributions. They are calculated with the original vertices, as the shape
+    // distributions of the queries, and all of them are taken from one pool of random points.
+    random::MersenneTwister gnd(seed);
+    Array<mesh::ShapeDistribution> dists(DescriptorStore::nShapeDistributions);
+    for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++)
+        dists[k] = static_cast<mesh::ShapeDistribution>(k);
+
+    auto descriptors = mesh::calculateShapeDistributions(mesh.vertices, mesh.triangles, gnd, dists, 
+        parameters_.nSamps, parameters_.nBins);
+    for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++) {
+        model.sdHistograms[k] = std::move(std::get<0>(descriptors[k]));
+        model.sdBins[k] = std::move(std::get<1>(descriptors[k]));
+    }
+
+    // Rasterized descriptors.
+    auto scVertices = mesh::centerAndScaleVertices(mesh.vertices);
+    auto triang = mesh::triangleCoord(scVertices, mesh.triangles);
+    RasterizedObject3D rr(triang, -1, 1, parameters_.nVox, NConnectivity3D::TwentySixConnected);
+
+    model.rsd = rr.symmetryDescriptor().rsd;
+    model.hm = rr.harmonicDescriptor(hmat);
+
+    return model;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionBuilder::buildModel(const MeshGeometry& mesh, const QString& fileBase,
+    const nct::geometry::RasterizedObject3D::HarmonicMatrices& hmat, unsigned long long seed) const
+{
+    auto model = calculate(mesh, hmat, seed);
+
+    for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++) {
+        auto suffix = DescriptorStore::sdSuffix(static_cast<mesh::ShapeDistribution>(k));
+        writeArrayFile(fileBase + suffix + "_h.bin", model.sdHistograms[k]);
+        writeArrayFile(fileBase + suffix + "_b.bin", model.sdBins[k]);
+    }
+
+    writeArrayFile(fileBase + "_RSD_RSD.bin", model.rsd);
+    writeArrayFile(fileBase + "_HM.bin", model.hm);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,214 @@
+//=================================================================================================================
+/**
+ *  @file       CollectionBuilder.h
+ *  @brief      CollectionBuilder class.
+ *  @details    Declaration file of the CollectionBuilder class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef COLLECTION_BUILDER_H_INCLUDE
+#define COLLECTION_BUILDER_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "MeshData.h"
+#include "MeshFile.h"
+#include "DescriptorStore.h"
+
+#include "nct/nct.h"
+#include "nct/geometry/RasterizedObject3D.h"
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Collection builder class.
+ *  @details    This class calculates the descriptors of a set of meshes and writes a complete mesh 
+ *              collection: the feature files of every model, the packed feature file and the 
+ *              configuration file that is read by MainWindow::loadConfigFile. The models are 
+ *              processed by a fixed number of threads and the descriptors of each model are written 
+ *              as soon as they are calculated, so at most one mesh per thread is kept in memory.
+ */
+class CollectionBuilder final
+{
+public:
+
+    //// Constants /////
+
+    static constexpr const char* configFileName {"collection.txt"};    /**< Name of the configuration file. */
+
+    static constexpr const char* featureDirectory {"features"};        /**< Directory of the feature files. */
+
+    static constexpr const char* screenshotDirectory {"screenshots"};  /**< Directory of the screenshots. */
+
+    //// Structures /////
+
+    /**
+     *  @brief      Build failure.
+     *  @details    This structure describes a mesh that couldn't be added to the collection.
+     */
+    struct Failure final {
+        QString fileName;       /**< Name of the mesh file. */
+        QString error;          /**< Error message. */
+    };
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the builder with the parameters of the descriptors. 
+     *              Only the configuration fields of the mesh data are used (number of samples, bins, 
+     *              voxels, test angles and test steps).
+     *  @param[in]  parameters  The configuration of the collection.
+     */
+    explicit CollectionBuilder(const MeshData& parameters);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    CollectionBuilder(const CollectionBuilder&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    CollectionBuilder(CollectionBuilder&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~CollectionBuilder() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    CollectionBuilder& operator=(const CollectionBuilder&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    CollectionBuilder& operator=(CollectionBuilder&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Set threads.
+     *  @details    This function sets the number of models that are processed at the same time.
+     *  @param[in]  nThreads  The number of threads. If it is zero, the number of hardware threads is used.
+     */
+    void setThreads(unsigned int nThreads) noexcept;
+
+    /**
+     *  @brief      Set seed.
+     *  @details    This function sets the seed of the random number generators. The shape 
+     *              distributions of model i are calculated with the seed plus i, so the 
+     *              collection doesn't depend on the number of threads.
+     *  @param[in]  seed  The seed.
+     */
+    void setSeed(unsigned long long seed) noexcept;
+
+    /**
+     *  @brief      Build collection.
+     *  @details    This function calculates the descriptors of the meshes and writes the collection
+     *              in the output directory. The name of each model is the base name of its file. 
+     *              Meshes that cannot be processed are skipped and reported by failures().
+     *  @param[in]  meshFiles  The STL or PLY files of the models.
+     *  @param[in]  outputPath  The output directory.
+     *  @returns    The configuration data of the new collection.
+     */
+    MeshData build(const QStringList& meshFiles, const QString& outputPath);
+
+    /**
+     *  @brief      Failures.
+     *  @details    This function returns the meshes that were skipped by the last build.
+     *  @returns    The skipped meshes.
+     */
+    const std::vector<Failure>& failures() const noexcept;
+
+    /**
+     *  @brief      Calculate model.
+     *  @details    This function calculates the descriptors of one mesh with the parameters of the 
+     *              builder.
+     *  @param[in]  mesh  The mesh of the model.
+     *  @param[in]  hmat  The harmonic matrices of the collection.
+     *  @param[in]  seed  The seed of the random number generator of the shape distributions.
+     *  @returns    The descriptors of the model.
+     */
+    DescriptorStore::Model calculate(const MeshGeometry& mesh,
+        const nct::geometry::RasterizedObject3D::HarmonicMatrices& hmat, unsigned long long seed) const;
+
+    /**
+     *  @brief      Find meshes.
+     *  @details    This function returns the STL and PLY files of a directory sorted by name.
+     *  @param[in]  directory  The directory to search.
+     *  @returns    The paths of the mesh files.
+     */
+    static QStringList findMeshFiles(const QString& directory);
+
+    /**
+     *  @brief      Model name.
+     *  @details    This function returns the name of the model of a mesh file, which is the base 
+     *              name of the file without the commas of the configuration format.
+     *  @param[in]  meshFile  The mesh file.
+     *  @returns    The name of the model.
+     */
+    static QString modelName(const QString& meshFile);
+
+private:
+
+    //// Methods /////
+
+    /**
+     *  @brief      Build model.
+     *  @details    This function calculates the descriptors of one mesh and writes its feature files.
+     *  @param[in]  mesh  The mesh of the model.
+     *  @param[in]  fileBase  The path and name of the model, without the suffix of the feature files.
+     *  @param[in]  hmat  The harmonic matrices of the collection.
+     *  @param[in]  seed  The seed of the random number generator of this model.
+     */
+    void buildModel(const MeshGeometry& mesh, const QString& fileBase,
+        const nct::geometry::RasterizedObject3D::HarmonicMatrices& hmat, unsigned long long seed) const;
+
+    //// Member variables ////
+
+    MeshData parameters_;                   /**< Configuration of the collection. */
+
+    unsigned int nThreads_ {0};             /**< Number of threads. */
+
+    unsigned long long seed_ {0};           /**< Seed of the random number generators. */
+
+    std::vector<Failure> failures_;         /**< Meshes skipped by the last build. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
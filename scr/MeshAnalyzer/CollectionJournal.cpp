@@ -0,0 +1,567 @@
+//=================================================================================================================
+/**
+ *  @file       CollectionJournal.cpp
+ *  @brief      CollectionJournal class implementation file.
+ *  @details    This file contains the implementation of the CollectionJournal class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "CollectionJournal.h"
+#include "FeatureFile.h"
+#include "QueryCache.h"
+
+#include "nct/nct_exception.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the journal files.
+ */
+constexpr char journalFileMagic[8] {'A', 'T', 'J', 'O', 'U', 'R', 'N', 'L'};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the journal files.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t reserved0 {0};            /**< Reserved for future use. */
+    std::uint64_t nModels {0};              /**< Number of models of the configuration file. */
+    std::uint64_t checksum {0};             /**< Checksum of the names of the models. */
+    std::uint64_t reserved[2] {};           /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 48, "Unexpected size of the file header.");
+
+/**
+ *  @brief      Record header.
+ *  @details    Header stored before the data of each record.
+ */
+struct RecordHeader final {
+    std::uint32_t type {0};                 /**< Type of the record. */
+    std::uint32_t reserved {0};             /**< Reserved for future use. */
+    std::uint64_t size {0};                 /**< Size of the data in bytes. */
+    std::uint64_t checksum {0};             /**< Checksum of the type, the size and the data. */
+};
+
+static_assert(sizeof(RecordHeader) == 24, "Unexpected size of the record header.");
+
+/**
+ *  @brief      Record checksum.
+ *  @details    This function calculates the checksum of a record.
+ *  @param[in]  header  The header of the record. Its checksum is not used.
+ *  @param[in]  data  The first byte of the data of the record.
+ *  @returns    The checksum.
+ */
+std::uint64_t recordChecksum(const RecordHeader& header, const char* data)
+{
+    auto h = QueryCache::combine(QueryCache::initialHash, header.type);
+    h = QueryCache::combine(h, header.size);
+    return QueryCache::combine(h, data, static_cast<std::size_t>(header.size));
+}
+
+/**
+ *  @brief      Synchronize file.
+ *  @details    This function flushes the buffers of a file and waits until the operating system 
+ *              writes them to the disk.
+ *  @param[in, out]  file  The file.
+ *  @returns    True if the data were written.
+ */
+bool synchronize(QFile& file)
+{
+    if (!file.flush())
+        return false;
+
+#ifdef _WIN32
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+CollectionJournal::CollectionJournal(const QString& configFile) :
+    configFile_(configFile)
+{
+
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+const QString& CollectionJournal::configFile() const noexcept
+{
+    return configFile_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const QString& CollectionJournal::fileName() const noexcept
+{
+    return fileName_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t CollectionJournal::size() const noexcept
+{
+    return nRecords_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionJournal::load(MeshData& meshData, DescriptorStore& store)
+{
+    fileName_ = meshData.featurePath + defaultFileName;
+    base_ = checksum(meshData.models);
+    baseModels_ = meshData.models.rows();
+
+    auto records = read();
+    if (records.empty()) {
+        store.load(meshData.featurePath, meshData.models);
+        return;
+    }
+
+    // Models of the collection after the changes.
+    auto updated = meshData;
+    for (const auto& record : records)
+        apply(record, updated, nullptr);
+
+    // If the packed feature file already contains the changes, the compaction was interrupted 
+    // before the configuration file was replaced.
+    auto packedFile = meshData.featurePath + FeatureFile::defaultFileName;
+    if (QFile::exists(packedFile)) {
+        auto names = FeatureFile(packedFile).modelNames();
+        bool compacted = names.size() == updated.models.rows();
+        for (size_t i = 0; compacted && (i < names.size()); i++)
+            compacted = names[i] == updated.models(i, 0);
+
+        if (compacted) {
+            writeMeshDataFile(configFile_, updated);
+            QFile::remove(fileName_);
+
+            meshData = std::move(updated);
+            base_ = checksum(meshData.models);
+            baseModels_ = meshData.models.rows();
+            fileSize_ = 0;
+            nRecords_ = 0;
+
+            store.load(meshData.featurePath, meshData.models);
+            return;
+        }
+    }
+
+    store.load(meshData.featurePath, meshData.models);
+    for (const auto& record : records)
+        apply(record, meshData, &store);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionJournal::append(MeshData& meshData, DescriptorStore& store, const nct::Array<QString>& fields, 
+    const DescriptorStore::Model& model)
+{
+    if (fileName_.isEmpty())
+        throw OperationException("The collection was not loaded by the journal", "");
+
+    if (fields.size() != nFields)
+        throw ArgumentException("fields", exc_bad_array_size, SOURCE_INFO);
+
+    // The fields are stored in one comma-separated line of the configuration file.
+    for (const auto& field : fields) {
+        if (field.contains(',') || field.contains('\n') || field.contains('\r'))
+            throw ArgumentException("fields", exc_bad_array_elements, SOURCE_INFO);
+    }
+
+    if (fields[0].isEmpty())
+        throw ArgumentException("fields", exc_bad_array_elements, SOURCE_INFO);
+
+    if (findModel(meshData, fields[0]) < meshData.models.rows())
+        throw OperationException("Duplicated model name: " + fields[0].toStdString(), "");
+
+    Record record;
+    record.type = RecordType::Append;
+    record.fields = fields;
+    record.model = model;
+
+    // The store checks the sizes of the descriptors before the record is written.
+    store.append(model);
+    try {
+        write(record);
+    }
+    catch (...) {
+        store.popBack();
+        throw;
+    }
+
+    apply(record, meshData, nullptr);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionJournal::remove(MeshData& meshData, DescriptorStore& store, const QString& name)
+{
+    if (fileName_.isEmpty())
+        throw OperationException("The collection was not loaded by the journal", "");
+
+    if (findModel(meshData, name) == meshData.models.rows())
+        throw OperationException("Unknown model: " + name.toStdString(), "");
+
+    Record record;
+    record.type = RecordType::Remove;
+    record.fields = Array<QString>(1, name);
+
+    write(record);
+    apply(record, meshData, &store);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionJournal::compact(MeshData& meshData, DescriptorStore& store)
+{
+    if (fileName_.isEmpty())
+        throw OperationException("The collection was not loaded by the journal", "");
+
+    Array<QString> names(meshData.models.rows());
+    for (size_t i = 0; i < names.size(); i++)
+        names[i] = meshData.models(i, 0);
+
+    // The store can't keep the packed feature file mapped while it is replaced.
+    store.detach();
+    if (names.size() > 0)
+        FeatureFile::write(meshData.featurePath + FeatureFile::defaultFileName, store, names);
+    writeMeshDataFile(configFile_, meshData);
+
+    // If the journal can't be deleted, its checksum doesn't match the new configuration and it
+    // is discarded when the collection is loaded.
+    QFile::remove(fileName_);
+
+    base_ = checksum(meshData.models);
+    baseModels_ = meshData.models.rows();
+    fileSize_ = 0;
+    nRecords_ = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t CollectionJournal::checksum(const nct::Array2D<QString>& models)
+{
+    std::uint64_t rows = models.rows();
+    auto h = QueryCache::combine(QueryCache::initialHash, rows);
+    for (size_t i = 0; i < models.rows(); i++) {
+        auto name = models(i, 0).toUtf8();
+        std::uint32_t size = static_cast<std::uint32_t>(name.size());
+        h = QueryCache::combine(h, size);
+        h = QueryCache::combine(h, name.constData(), name.size());
+    }
+
+    return h;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::vector<CollectionJournal::Record> CollectionJournal::read()
+{
+    std::vector<Record> records;
+    fileSize_ = 0;
+    nRecords_ = 0;
+
+    QFile file(fileName_);
+    if (!file.exists())
+        return records;
+
+    if (!file.open(QIODevice::ReadOnly))
+        throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+    auto data = file.readAll();
+    file.close();
+    auto size = static_cast<std::size_t>(data.size());
+
+    // A journal of other models was left by an interrupted compaction, and a journal without
+    // a complete header was interrupted while it was created.
+    FileHeader header;
+    bool current = size >= sizeof(FileHeader);
+    if (current) {
+        std::memcpy(&header, data.constData(), sizeof(FileHeader));
+        current = (std::memcmp(header.magic, journalFileMagic, sizeof(journalFileMagic)) == 0) &&
+            (header.nModels == baseModels_) && (header.checksum == base_);
+    }
+
+    if (!current) {
+        QFile::remove(fileName_);
+        return records;
+    }
+
+    if ((header.version == 0) || (header.version > version))
+        throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+    // The first damaged record and the following ones were not completely written.
+    auto offset = sizeof(FileHeader);
+    while (size - offset >= sizeof(RecordHeader)) {
+        RecordHeader recordHeader;
+        std::memcpy(&recordHeader, data.constData() + offset, sizeof(RecordHeader));
+
+        auto first = data.constData() + offset + sizeof(RecordHeader);
+        if ((recordHeader.size > size - offset - sizeof(RecordHeader)) || 
+            (recordChecksum(recordHeader, first) != recordHeader.checksum))
+            break;
+
+        auto type = static_cast<RecordType>(recordHeader.type);
+        if ((type != RecordType::Append) && (type != RecordType::Remove))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        records.push_back(decode(type, first, static_cast<std::size_t>(recordHeader.size)));
+        offset += sizeof(RecordHeader) + static_cast<std::size_t>(recordHeader.size);
+    }
+
+    // The damaged records are also overwritten by the next record, so the collection can be 
+    // read from a read-only directory.
+    if (offset < size) {
+        QFile damaged(fileName_);
+        if (damaged.open(QIODevice::ReadWrite))
+            damaged.resize(static_cast<qint64>(offset));
+    }
+
+    fileSize_ = offset;
+    nRecords_ = records.size();
+    return records;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionJournal::write(const Record& record)
+{
+    auto data = encode(record);
+
+    RecordHeader recordHeader;
+    recordHeader.type = static_cast<std::uint32_t>(record.type);
+    recordHeader.size = static_cast<std::uint64_t>(data.size());
+    recordHeader.checksum = recordChecksum(recordHeader, data.constData());
+
+    // A new journal is created with its header atomically.
+    if (fileSize_ == 0) {
+        FileHeader header;
+        std::memcpy(header.magic, journalFileMagic, sizeof(journalFileMagic));
+        header.version = version;
+        header.nModels = baseModels_;
+        header.checksum = base_;
+
+        QSaveFile file(fileName_);
+        if (!file.open(QIODevice::WriteOnly))
+            throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+        if (file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader)) != sizeof(FileHeader))
+            throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+        if (!file.commit())
+            throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+        fileSize_ = sizeof(FileHeader);
+    }
+
+    // The record is written after the last valid record, over any damaged one.
+    QFile file(fileName_);
+    if (!file.open(QIODevice::ReadWrite))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    if (!file.resize(static_cast<qint64>(fileSize_)) || !file.seek(static_cast<qint64>(fileSize_)))
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    if ((file.write(reinterpret_cast<const char*>(&recordHeader), sizeof(RecordHeader)) != sizeof(RecordHeader)) ||
+        (file.write(data) != data.size()) || !synchronize(file))
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    fileSize_ += sizeof(RecordHeader) + static_cast<std::uint64_t>(data.size());
+    nRecords_++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CollectionJournal::apply(const Record& record, MeshData& meshData, DescriptorStore* store)
+{
+    auto rows = meshData.models.rows();
+    auto columns = std::max<size_t>(meshData.models.columns(), nFields);
+    auto index = findModel(meshData, record.fields[0]);
+
+    if (record.type == RecordType::Append) {
+        if (index < rows)
+            throw OperationException("Duplicated model name: " + record.fields[0].toStdString(), "");
+
+        if (store != nullptr)
+            store->append(record.model);
+
+        Array2D<QString> models(rows + 1, columns);
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < meshData.models.columns(); j++)
+                models(i, j) = meshData.models(i, j);
+        }
+        for (size_t j = 0; j < record.fields.size(); j++)
+            models(rows, j) = record.fields[j];
+
+        meshData.models = std::move(models);
+    }
+    else {
+        if (index == rows)
+            throw OperationException("Unknown model: " + record.fields[0].toStdString(), "");
+
+        if (store != nullptr)
+            store->remove(index);
+
+        Array2D<QString> models(rows - 1, meshData.models.columns());
+        for (size_t i = 0; i < rows - 1; i++) {
+            auto source = i < index ? i : i + 1;
+            for (size_t j = 0; j < meshData.models.columns(); j++)
+                models(i, j) = meshData.models(source, j);
+        }
+
+        meshData.models = std::move(models);
+    }
+
+    meshData.nModels = static_cast<unsigned int>(meshData.models.rows());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t CollectionJournal::findModel(const MeshData& meshData, const QString& name)
+{
+    for (size_t i = 0; i < meshData.models.rows(); i++) {
+        if (meshData.models(i, 0) == name)
+            return i;
+    }
+
+    return meshData.models.rows();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QByteArray CollectionJournal::encode(const Record& record)
+{
+    QByteArray data;
+    auto add = [&data](const void* bytes, std::size_t size) {
+        data.append(static_cast<const char*>(bytes), static_cast<qsizetype>(size));
+    };
+
+    auto addArray = [&add](const double* elements, std::uint64_t rows, std::uint64_t columns) {
+        add(&rows, sizeof(rows));
+        add(&columns, sizeof(columns));
+        add(elements, static_cast<std::size_t>(rows*columns)*sizeof(double));
+    };
+
+    std::uint32_t nRecordFields = static_cast<std::uint32_t>(record.fields.size());
+    add(&nRecordFields, sizeof(nRecordFields));
+    for (const auto& field : record.fields) {
+        auto utf8 = field.toUtf8();
+        std::uint32_t size = static_cast<std::uint32_t>(utf8.size());
+        add(&size, sizeof(size));
+        add(utf8.constData(), utf8.size());
+    }
+
+    if (record.type == RecordType::Append) {
+        const auto& model = record.model;
+        for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++) {
+            addArray(model.sdHistograms[k].data(), model.sdHistograms[k].size(), 1);
+            addArray(model.sdBins[k].data(), model.sdBins[k].size(), 1);
+        }
+        addArray(model.rsd.data(), model.rsd.rows(), model.rsd.columns());
+        addArray(model.hm.data(), model.hm.rows(), model.hm.columns());
+    }
+
+    return data;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+CollectionJournal::Record CollectionJournal::decode(RecordType type, const char* data, std::size_t size)
+{
+    std::size_t offset = 0;
+    auto read = [&](void* bytes, std::size_t n) {
+        if (n > size - offset)
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+        std::memcpy(bytes, data + offset, n);
+        offset += n;
+    };
+
+    auto readArray = [&]() {
+        std::uint64_t rows = 0;
+        std::uint64_t columns = 0;
+        read(&rows, sizeof(rows));
+        read(&columns, sizeof(columns));
+        if ((columns > 0) && (rows > (size - offset)/sizeof(double)/columns))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        Matrix m(static_cast<size_t>(rows), static_cast<size_t>(columns));
+        read(m.data(), m.size()*sizeof(double));
+        return m;
+    };
+
+    Record record;
+    record.type = type;
+
+    std::uint32_t nRecordFields = 0;
+    read(&nRecordFields, sizeof(nRecordFields));
+    if ((nRecordFields == 0) || (nRecordFields > nFields))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    record.fields.resize(nRecordFields);
+    for (auto& field : record.fields) {
+        std::uint32_t fieldSize = 0;
+        read(&fieldSize, sizeof(fieldSize));
+        if (fieldSize > size - offset)
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+        field = QString::fromUtf8(data + offset, static_cast<qsizetype>(fieldSize));
+        offset += fieldSize;
+    }
+
+    if (type == RecordType::Append) {
+        auto& model = record.model;
+        for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++) {
+            auto h = readArray();
+            auto b = readArray();
+            model.sdHistograms[k] = RealVector(h.begin(), h.end());
+            model.sdBins[k] = RealVector(b.begin(), b.end());
+        }
+        model.rsd = readArray();
+        model.hm = readArray();
+    }
+
+    if (offset != size)
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    return record;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,310 @@
+//=================================================================================================================
+/**
+ *  @file       CollectionJournal.h
+ *  @brief      CollectionJournal class.
+ *  @details    Declaration file of the CollectionJournal class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef COLLECTION_JOURNAL_H_INCLUDE
+#define COLLECTION_JOURNAL_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+
+#include "DescriptorStore.h"
+#include "MeshData.h"
+
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Collection journal class.
+ *  @details    This class appends models to a mesh collection and removes them without rebuilding
+ *              it. The configuration file and the feature files of the collection are not modified:
+ *              each change is written as a record at the end of a journal that is stored next to 
+ *              the feature files, and the records are applied to the configuration and to the 
+ *              descriptors every time that the collection is loaded. An appended model only costs 
+ *              the calculation of its descriptors and the writing of one record, and the store and 
+ *              its search indices are extended in place (see DescriptorStore::append). A removed
+ *              model is only marked as removed in the store, whose search indices skip it (see 
+ *              DescriptorStore::remove). Compacting the collection drops the rows of the removed
+ *              models, writes the packed feature file and the configuration file with all the 
+ *              changes and deletes the journal.
+ *
+ *              Each record is flushed to the disk before the change is applied in memory and keeps 
+ *              a checksum, so a record that was partially written by a crash is detected and 
+ *              discarded when the journal is read. The configuration and the packed feature file 
+ *              are only replaced atomically by the compaction. The journal keeps a checksum of the 
+ *              models of the configuration that it modifies, so a journal whose compaction was 
+ *              interrupted after the configuration was replaced is discarded, and a compaction that
+ *              was interrupted after the packed feature file was replaced is completed.
+ *
+ *              File layout (all the integers are little-endian):
+ *              - Header: magic key, version, number of models and checksum of the names of the 
+ *                models of the configuration.
+ *              - Records: type, size of the data and checksum of the record, followed by the data.
+ *                The data of an appended model are its configuration fields (32-bit size and 
+ *                UTF-8 characters) and its descriptors (64-bit rows and columns, followed by the
+ *                elements); the data of a removed model are its name.
+ */
+class CollectionJournal final
+{
+public:
+
+    //// Enumerations /////
+
+    /**
+     *  @brief      Record type.
+     *  @details    Change of the collection that is stored in a record.
+     */
+    enum class RecordType : std::uint32_t {
+
+        Append = 1,         /**< A model is appended to the collection. */
+
+        Remove = 2,         /**< A model is removed from the collection. */
+    };
+
+    //// Constants /////
+
+    static constexpr const char* defaultFileName {"journal.atj"};  /**< Name of the journal files. */
+
+    static constexpr std::uint32_t version {1};                     /**< Current version of the format. */
+
+    static constexpr unsigned int nFields {9};                      /**< Configuration fields of each model. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the journal of a collection. The journal is read by
+     *              load.
+     *  @param[in]  configFile  The configuration file of the collection.
+     */
+    explicit CollectionJournal(const QString& configFile);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    CollectionJournal(const CollectionJournal&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    CollectionJournal(CollectionJournal&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~CollectionJournal() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    CollectionJournal& operator=(const CollectionJournal&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    CollectionJournal& operator=(CollectionJournal&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Configuration file.
+     *  @details    This function returns the configuration file of the collection.
+     *  @returns    The name of the configuration file.
+     */
+    const QString& configFile() const noexcept;
+
+    /**
+     *  @brief      Journal file.
+     *  @details    This function returns the name of the journal file. It is empty until the 
+     *              collection is loaded.
+     *  @returns    The name of the journal file.
+     */
+    const QString& fileName() const noexcept;
+
+    /**
+     *  @brief      Size.
+     *  @details    This function returns the number of records of the journal.
+     *  @returns    The number of records.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     *  @brief      Load collection.
+     *  @details    This function loads the descriptors of a collection and applies the records of 
+     *              its journal to the configuration and to the store. The records after a damaged 
+     *              record are discarded and removed from the file.
+     *  @param[in, out]  meshData  The configuration data read from the configuration file. The 
+     *              models are updated with the records.
+     *  @param[out]  store  The store where the descriptors are loaded.
+     */
+    void load(MeshData& meshData, DescriptorStore& store);
+
+    /**
+     *  @brief      Append model.
+     *  @details    This function adds a model at the end of a collection that was loaded by this
+     *              journal.
+     *  @param[in, out]  meshData  The configuration data of the collection.
+     *  @param[in, out]  store  The descriptors of the collection.
+     *  @param[in]  fields  The configuration fields of the model (nFields). The first one is the 
+     *              name of the model, which must be unique.
+     *  @param[in]  model  The descriptors of the model.
+     */
+    void append(MeshData& meshData, DescriptorStore& store, const nct::Array<QString>& fields, 
+        const DescriptorStore::Model& model);
+
+    /**
+     *  @brief      Remove model.
+     *  @details    This function removes a model of a collection that was loaded by this journal.
+     *  @param[in, out]  meshData  The configuration data of the collection.
+     *  @param[in, out]  store  The descriptors of the collection.
+     *  @param[in]  name  The name of the model.
+     */
+    void remove(MeshData& meshData, DescriptorStore& store, const QString& name);
+
+    /**
+     *  @brief      Compact collection.
+     *  @details    This function writes the packed feature file and the configuration file of a 
+     *              collection that was loaded by this journal, and then deletes the journal. The 
+     *              packed feature file is written first, so an interrupted compaction is completed 
+     *              the next time that the collection is loaded. The cost of this function is 
+     *              proportional to the size of the collection.
+     *  @param[in, out]  meshData  The configuration data of the collection.
+     *  @param[in, out]  store  The descriptors of the collection. The store is detached from its 
+     *              previous packed feature file, and the rows of the removed models are dropped.
+     */
+    void compact(MeshData& meshData, DescriptorStore& store);
+
+    /**
+     *  @brief      Checksum.
+     *  @details    This function calculates the checksum of the names of the models of a 
+     *              collection.
+     *  @param[in]  models  Array of models. The first column must contain the name of each model.
+     *  @returns    The checksum.
+     */
+    static std::uint64_t checksum(const nct::Array2D<QString>& models);
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Record.
+     *  @details    Change of the collection.
+     */
+    struct Record final {
+        RecordType type {RecordType::Append};   /**< Type of change. */
+        nct::Array<QString> fields;             /**< Fields of the appended model, or name of the removed one. */
+        DescriptorStore::Model model;           /**< Descriptors of the appended model. */
+    };
+
+    //// Methods /////
+
+    /**
+     *  @brief      Read records.
+     *  @details    This function reads the records of the journal file. A journal of other models
+     *              is deleted, and the damaged records at the end of the file are truncated.
+     *  @returns    The valid records.
+     */
+    std::vector<Record> read();
+
+    /**
+     *  @brief      Write record.
+     *  @details    This function writes a record at the end of the journal file and flushes it to 
+     *              the disk. The file is created if it doesn't exist.
+     *  @param[in]  record  The record.
+     */
+    void write(const Record& record);
+
+    /**
+     *  @brief      Apply record.
+     *  @details    This function applies a record to the configuration and to the store.
+     *  @param[in]  record  The record.
+     *  @param[in, out]  meshData  The configuration data of the collection.
+     *  @param[in, out]  store  The descriptors of the collection, or nullptr to update only the 
+     *              configuration.
+     */
+    static void apply(const Record& record, MeshData& meshData, DescriptorStore* store);
+
+    /**
+     *  @brief      Find model.
+     *  @details    This function finds a model of a collection by name.
+     *  @param[in]  meshData  The configuration data of the collection.
+     *  @param[in]  name  The name of the model.
+     *  @returns    The index of the model, or the number of models if it isn't found.
+     */
+    static std::size_t findModel(const MeshData& meshData, const QString& name);
+
+    /**
+     *  @brief      Encode record.
+     *  @details    This function encodes the data of a record.
+     *  @param[in]  record  The record.
+     *  @returns    The data of the record.
+     */
+    static QByteArray encode(const Record& record);
+
+    /**
+     *  @brief      Decode record.
+     *  @details    This function decodes the data of a record.
+     *  @param[in]  type  The type of the record.
+     *  @param[in]  data  The first byte of the data.
+     *  @param[in]  size  The size of the data in bytes.
+     *  @returns    The record.
+     */
+    static Record decode(RecordType type, const char* data, std::size_t size);
+
+    //// Member variables ////
+
+    QString configFile_;                    /**< Configuration file of the collection. */
+
+    QString fileName_;                      /**< Journal file. */
+
+    std::uint64_t base_ {0};                /**< Checksum of the models of the configuration file. */
+
+    std::uint64_t baseModels_ {0};          /**< Number of models of the configuration file. */
+
+    std::uint64_t fileSize_ {0};            /**< Size of the valid part of the journal file. */
+
+    std::size_t nRecords_ {0};              /**< Number of records. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,177 @@
+//=================================================================================================================
+/**
+ *  @file       ComparisonTask.cpp
+ *  @brief      ComparisonTask class implementation file.
+ *  @details    This file contains the implementation of the ComparisonTask class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "ComparisonTask.h"
+
+#include "nct/nct_exception.h"
+
+#include <QtCore/QThreadPool>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+ComparisonTask::ComparisonTask(const QueryEngine& engine, 
+    const std::shared_ptr<nct::Array<nct::Point3D>>& vertices,
+    const std::shared_ptr<nct::Array<nct::Vector3D<unsigned int>>>& triangles,
+    const std::shared_ptr<QueryCache>& cache, RankFunction rank, QObject* objFather) :
+    QObject(objFather), engine_(engine), vertices_(vertices), triangles_(triangles), cache_(cache), 
+    rank_(std::move(rank))
+{
+    if (vertices_ == nullptr)
+        throw NullPointerException("vertices", SOURCE_INFO);
+
+    if (triangles_ == nullptr)
+        throw NullPointerException("triangles", SOURCE_INFO);
+
+    if (!rank_)
+        throw NullPointerException("rank", SOURCE_INFO);
+
+    state_ = std::make_shared<State>();
+    state_->progress = std::make_shared<QueryProgress>();
+    engine_.setProgress(state_->progress);
+
+    connect(&timer_, &QTimer::timeout, this, &ComparisonTask::update);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+ComparisonTask::~ComparisonTask()
+{
+    state_->progress->cancel();
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void ComparisonTask::start()
+{
+    if (started_)
+        throw OperationException("The comparison was already started", "");
+
+    started_ = true;
+    running_ = true;
+
+    // The worker keeps its own copies, so it doesn't depend on the lifetime of the task.
+    auto state = state_;
+    auto engine = engine_;
+    auto vertices = vertices_;
+    auto triangles = triangles_;
+    auto cache = cache_;
+    auto rank = rank_;
+
+    QThreadPool::globalInstance()->start([state, engine, vertices, triangles, cache, rank]() {
+        try {
+            FusedQuery query(engine, *vertices, *triangles);
+            query.setCache(cache);
+            auto ranking = rank(query);
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->ranking = std::move(ranking);
+        }
+        catch (const std::exception& ex) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->error = ex.what();
+            state->failed = true;
+        }
+        state->done = true;
+    });
+
+    timer_.start(updateInterval);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool ComparisonTask::isRunning() const noexcept
+{
+    return running_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking ComparisonTask::takeRanking()
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return std::move(state_->ranking);
+}
+
+//=================================================================================================================
+//        SLOTS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void ComparisonTask::cancel()
+{
+    state_->progress->cancel();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void ComparisonTask::update()
+{
+    if (!running_)
+        return;
+
+    // The end is read first, so that the last models of the scan are always reported.
+    bool done = state_->done;
+    auto& progress = *state_->progress;
+
+    auto version = progress.version();
+    if (version != version_) {
+        version_ = version;
+        auto models = progress.models();
+        if (models.size() > 0)
+            emit partialResults(models);
+    }
+    emit progressChanged(progress.scored(), progress.total());
+
+    if (!done)
+        return;
+
+    timer_.stop();
+    running_ = false;
+
+    bool failed = false;
+    QString error;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        failed = state_->failed;
+        error = QString::fromStdString(state_->error);
+    }
+
+    if (progress.canceled())
+        emit canceled();
+    else if (failed)
+        emit this->failed(error);
+    else
+        emit finished();
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
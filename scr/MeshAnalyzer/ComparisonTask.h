@@ -0,0 +1,257 @@
+//=================================================================================================================
+/**
+ *  @file       ComparisonTask.h
+ *  @brief      ComparisonTask class.
+ *  @details    Declaration file of the ComparisonTask class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef COMPARISON_TASK_H_INCLUDE
+#define COMPARISON_TASK_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "QueryEngine.h"
+#include "QueryProgress.h"
+#include "QueryCache.h"
+#include "FusedQuery.h"
+#include "Ranking.h"
+
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Vector3D.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Comparison task class.
+ *  @details    This class compares a mesh with a collection in a thread of the global thread pool,
+ *              so that the user interface keeps responding while the descriptor is calculated and
+ *              the collection is scanned. The progress and the closest models found so far are 
+ *              polled with a timer and reported by signals in the thread of the task. The worker 
+ *              only shares its state with the task, so a canceled comparison finishes its current
+ *              step in the background after the task is destroyed.
+ */
+class ComparisonTask : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    //// Types /////
+
+    /**
+     *  @brief      Rank function.
+     *  @details    Function that ranks the collection with a query of the mesh.
+     */
+    using RankFunction = std::function<Ranking(FusedQuery& query)>;
+
+    //// Constants /////
+
+    static constexpr int updateInterval {100};              /**< Interval between updates (ms). */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the task. The comparison is not started.
+     *  @param[in]  engine  The query engine of the collection. The task keeps a copy that reports
+     *              to the progress of the task.
+     *  @param[in]  vertices  The vertices of the mesh.
+     *  @param[in]  triangles  The triangles of the mesh.
+     *  @param[in]  cache  The cache of the query. If it is null, nothing is cached.
+     *  @param[in]  rank  The function that ranks the collection.
+     *  @param[in]  objFather  The father object.
+     */
+    ComparisonTask(const QueryEngine& engine, 
+        const std::shared_ptr<nct::Array<nct::Point3D>>& vertices,
+        const std::shared_ptr<nct::Array<nct::Vector3D<unsigned int>>>& triangles,
+        const std::shared_ptr<QueryCache>& cache, RankFunction rank, QObject* objFather = nullptr);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    ComparisonTask(const ComparisonTask&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    ComparisonTask(ComparisonTask&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor. A running comparison is canceled.
+     */
+    ~ComparisonTask();
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    ComparisonTask& operator=(const ComparisonTask&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    ComparisonTask& operator=(ComparisonTask&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Start.
+     *  @details    This function starts the comparison. A task can only be started once.
+     */
+    void start();
+
+    /**
+     *  @brief      Running.
+     *  @details    This function indicates whether the comparison was started and its end was not
+     *              reported yet.
+     *  @returns    True if the comparison is running.
+     */
+    bool isRunning() const noexcept;
+
+    /**
+     *  @brief      Take ranking.
+     *  @details    This function returns the ranking of the collection after the task finished.
+     *  @returns    The ranking of the models.
+     */
+    Ranking takeRanking();
+
+public slots:
+
+    //// Slots /////
+
+    /**
+     *  @brief      Cancel.
+     *  @details    This method cancels the comparison. The cancellation is reported when the worker
+     *              reaches the end of its current step.
+     */
+    void cancel();
+
+signals:
+
+    ////////// Signals //////////
+
+    /**
+     *  @brief      Progress changed.
+     *  @details    This signal is produced periodically while the comparison runs.
+     *  @param[in]  scored  The number of models that were compared.
+     *  @param[in]  total  The number of models of the collection. It is zero while the descriptor of
+     *              the mesh is calculated.
+     */
+    void progressChanged(std::size_t scored, std::size_t total);
+
+    /**
+     *  @brief      Partial results.
+     *  @details    This signal is produced when the closest models found so far change.
+     *  @param[in]  models  The indices of the models sorted from the closest to the farthest.
+     */
+    void partialResults(const nct::Array<unsigned int>& models);
+
+    /**
+     *  @brief      Finished.
+     *  @details    This signal is produced when the ranking is ready (see takeRanking).
+     */
+    void finished();
+
+    /**
+     *  @brief      Failed.
+     *  @details    This signal is produced when the comparison fails.
+     *  @param[in]  message  The description of the error.
+     */
+    void failed(const QString& message);
+
+    /**
+     *  @brief      Canceled.
+     *  @details    This signal is produced when the worker stops after a cancellation.
+     */
+    void canceled();
+
+private slots:
+
+    //// Slots /////
+
+    /**
+     *  @brief      Update.
+     *  @details    This method reports the state of the worker.
+     */
+    void update();
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Worker state.
+     *  @details    State that is shared by the task and the worker.
+     */
+    struct State {
+        std::shared_ptr<QueryProgress> progress;            /**< Progress of the comparison. */
+        std::mutex mutex;                                   /**< Mutex that protects the results. */
+        Ranking ranking;                                    /**< Ranking of the collection. */
+        std::string error;                                  /**< Description of the error. */
+        bool failed {false};                                /**< Indicates whether the worker failed. */
+        std::atomic<bool> done {false};                     /**< Indicates whether the worker ended. */
+    };
+
+    //// Member variables ////
+
+    QueryEngine engine_;                                    /**< Query engine of the collection. */
+
+    std::shared_ptr<nct::Array<nct::Point3D>> vertices_;    /**< Vertices of the mesh. */
+
+    std::shared_ptr<nct::Array<nct::Vector3D<unsigned int>>> triangles_;    /**< Triangles of the mesh. */
+
+    std::shared_ptr<QueryCache> cache_;                     /**< Cache of the query. */
+
+    RankFunction rank_;                                     /**< Function that ranks the collection. */
+
+    std::shared_ptr<State> state_;                          /**< State shared with the worker. */
+
+    QTimer timer_;                                          /**< Timer of the updates. */
+
+    std::uint64_t version_ {0};                             /**< Version of the reported models. */
+
+    bool started_ {false};                                  /**< Indicates whether the task was started. */
+
+    bool running_ {false};                                  /**< Indicates whether the task is running. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,577 @@
+//=================================================================================================================
+/**
+ *  @file       CompressedTable.cpp
+ *  @brief      CompressedTable class implementation file.
+ *  @details    This file contains the implementation of the CompressedTable class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "CompressedTable.h"
+
+#include "nct/nct_exception.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// The AVX kernels are compiled for every x86-64 build and only run when the processor supports 
+// them. MSVC accepts the AVX and F16C intrinsics in any function, while GCC and Clang need the 
+// functions that use them to be compiled for those instructions.
+#if defined(_M_X64) || defined(__x86_64__)
+#define COMPRESSED_TABLE_AVX
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define COMPRESSED_TABLE_AVX_TARGET
+#else
+#define COMPRESSED_TABLE_AVX_TARGET __attribute__((target("avx,f16c")))
+#endif
+#endif
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        AUXILIAR FUNCTIONS
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Distance block.
+ *  @details    Number of elements that are compared between two checks of the bound of a distance.
+ */
+constexpr std::size_t distanceBlock {64};
+
+/**
+ *  @brief      Half-precision elements.
+ *  @details    Decoder of a row of half-precision numbers.
+ */
+struct HalfElements {
+    const std::uint16_t* h;
+    double operator()(std::size_t j) const noexcept {return CompressedTable::decodeHalf(h[j]);}
+};
+
+/**
+ *  @brief      8-bit elements.
+ *  @details    Decoder of a row of 8-bit codes.
+ */
+struct ByteElements {
+    const std::uint8_t* c;
+    const double* minimum;
+    const double* step;
+    double operator()(std::size_t j) const noexcept {return minimum[j] + step[j]*c[j];}
+};
+
+/**
+ *  @brief      Row distance.
+ *  @details    This function compares the elements first to last - 1 of a compressed row with a
+ *              descriptor, and accumulates the distance of the function F.
+ *  @param[in]  x  The decoder of the row.
+ *  @param[in]  query  The descriptor.
+ *  @param[in]  first  The first element.
+ *  @param[in]  last  The element after the last element.
+ *  @param[in]  r  The distance accumulated before the first element.
+ *  @returns    The accumulated distance.
+ */
+template<mesh::DistanceFunction F, typename Elements>
+double accumulateDistance(const Elements& x, const double* query, std::size_t first, std::size_t last, 
+    double r) noexcept
+{
+    for (auto j = first; j < last; j++) {
+        double d = x(j) - query[j];
+        if constexpr (F == mesh::DistanceFunction::EuclideanDistance)
+            r += d*d;
+        else if constexpr (F == mesh::DistanceFunction::CityBlockDistance)
+            r += std::abs(d);
+        else
+            r = std::max(r, std::abs(d));
+    }
+
+    return r;
+}
+
+/**
+ *  @brief      Row distance.
+ *  @details    This function compares a compressed row with a descriptor one element at a time. 
+ *              The Euclidean distance is accumulated squared, so the bound is also squared.
+ *  @param[in]  x  The decoder of the row.
+ *  @param[in]  query  The descriptor.
+ *  @param[in]  n  The number of elements.
+ *  @param[in]  bound  The bound of the accumulated distance.
+ *  @returns    The accumulated distance.
+ */
+template<mesh::DistanceFunction F, typename Elements>
+double rowDistance(const Elements& x, const double* query, std::size_t n, double bound) noexcept
+{
+    double r = 0;
+    for (size_t first = 0; (first < n) && (r < bound); first += distanceBlock)
+        r = accumulateDistance<F>(x, query, first, std::min(first + distanceBlock, n), r);
+
+    return r;
+}
+
+#if defined(COMPRESSED_TABLE_AVX)
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      AVX support.
+ *  @details    This function checks whether the processor and the operating system support the
+ *              AVX and F16C instructions.
+ *  @returns    True if the AVX kernels can be used.
+ */
+bool avxSupported() noexcept
+{
+    static const bool supported = [] {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        bool f16c = (info[2] & (1 << 29)) != 0;
+        return osxsave && avx && f16c && ((_xgetbv(0) & 0x6) == 0x6);
+#else
+        return (__builtin_cpu_supports("avx") != 0) && (__builtin_cpu_supports("f16c") != 0);
+#endif
+    }();
+
+    return supported;
+}
+
+/**
+ *  @brief      AVX half-precision elements.
+ *  @details    Decoder of four half-precision numbers at a time.
+ */
+struct AvxHalfElements {
+    const std::uint16_t* h;
+    COMPRESSED_TABLE_AVX_TARGET __m256d operator()(std::size_t j) const noexcept {
+        return _mm256_cvtps_pd(_mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(h + j))));
+    }
+};
+
+/**
+ *  @brief      AVX 8-bit elements.
+ *  @details    Decoder of four 8-bit codes at a time.
+ */
+struct AvxByteElements {
+    const std::uint8_t* c;
+    const double* minimum;
+    const double* step;
+    COMPRESSED_TABLE_AVX_TARGET __m256d operator()(std::size_t j) const noexcept {
+        std::int32_t codes;
+        std::memcpy(&codes, c + j, sizeof(codes));
+        auto x = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(codes)));
+        return _mm256_add_pd(_mm256_loadu_pd(minimum + j), _mm256_mul_pd(_mm256_loadu_pd(step + j), x));
+    }
+};
+
+/**
+ *  @brief      AVX row decoding.
+ *  @details    This function decodes the first elements of a row, four at a time.
+ *  @param[in]  x  The AVX decoder of the row.
+ *  @param[in]  n  The number of elements to decode. It must be a multiple of four.
+ *  @param[out]  out  The decoded elements.
+ */
+template<typename Elements>
+COMPRESSED_TABLE_AVX_TARGET void avxDecode(const Elements& x, std::size_t n, double* out) noexcept
+{
+    for (size_t j = 0; j < n; j += 4)
+        _mm256_storeu_pd(out + j, x(j));
+}
+
+/**
+ *  @brief      AVX row distance.
+ *  @details    This function compares the first elements of a compressed row with a descriptor 
+ *              four at a time, with one partial distance per lane. The Euclidean distance is 
+ *              accumulated squared, so the bound is also squared.
+ *  @param[in]  x  The AVX decoder of the row.
+ *  @param[in]  query  The descriptor.
+ *  @param[in]  n  The number of elements to compare. It must be a multiple of four.
+ *  @param[in]  bound  The bound of the accumulated distance.
+ *  @returns    The accumulated distance.
+ */
+template<mesh::DistanceFunction F, typename Elements>
+COMPRESSED_TABLE_AVX_TARGET double avxDistance(const Elements& x, const double* query, std::size_t n,
+    double bound) noexcept
+{
+    auto sign = _mm256_set1_pd(-0.0);
+    auto acc = _mm256_setzero_pd();
+    double r = 0;
+
+    for (size_t first = 0; (first < n) && (r < bound); first += distanceBlock) {
+        auto last = std::min(first + distanceBlock, n);
+        for (auto j = first; j < last; j += 4) {
+            auto d = _mm256_sub_pd(x(j), _mm256_loadu_pd(query + j));
+            if constexpr (F == mesh::DistanceFunction::EuclideanDistance)
+                acc = _mm256_add_pd(acc, _mm256_mul_pd(d, d));
+            else if constexpr (F == mesh::DistanceFunction::CityBlockDistance)
+                acc = _mm256_add_pd(acc, _mm256_andnot_pd(sign, d));
+            else
+                acc = _mm256_max_pd(acc, _mm256_andnot_pd(sign, d));
+        }
+
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, acc);
+        if constexpr (F == mesh::DistanceFunction::ChebychevDistance)
+            r = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        else
+            r = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    return r;
+}
+#endif
+
+/**
+ *  @brief      Row distance.
+ *  @details    This function compares a compressed row with a descriptor, with the AVX kernel when
+ *              the processor supports it.
+ *  @param[in]  x  The decoder of the row.
+ *  @param[in]  avx  The AVX decoder of the row.
+ *  @param[in]  query  The descriptor.
+ *  @param[in]  n  The number of elements.
+ *  @param[in]  bound  The bound of the accumulated distance.
+ *  @returns    The accumulated distance.
+ */
+template<mesh::DistanceFunction F, typename Elements, typename AvxElements>
+double dispatchDistance(const Elements& x, [[maybe_unused]] const AvxElements& avx, const double* query, 
+    std::size_t n, double bound) noexcept
+{
+#if defined(COMPRESSED_TABLE_AVX)
+    if (avxSupported()) {
+        auto m = n - n % 4;
+        auto r = avxDistance<F>(avx, query, m, bound);
+        return r < bound ? accumulateDistance<F>(x, query, m, n, r) : r;
+    }
+#endif
+
+    return rowDistance<F>(x, query, n, bound);
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+CompressedTable::CompressedTable(std::size_t rows, std::size_t columns, 
+    const std::function<const double*(std::size_t)>& row, Encoding encoding) : 
+    encoding_(encoding), rows_(rows), columns_(columns)
+{
+    if ((rows > 0) && !row)
+        throw NullPointerException("row", SOURCE_INFO);
+
+    switch (encoding) {
+        case Encoding::Float16:
+            halves_.resize(rows*columns);
+            for (size_t i = 0; i < rows; i++) {
+                auto values = row(i);
+                for (size_t j = 0; j < columns; j++)
+                    halves_[i*columns + j] = encodeHalf(values[j]);
+            }
+            break;
+
+        case Encoding::UInt8:
+        {
+            // Each column is divided in 255 steps between its minimum and maximum values.
+            minimum_.assign(columns, std::numeric_limits<double>::infinity());
+            RealVector maximum(columns, -std::numeric_limits<double>::infinity());
+            for (size_t i = 0; i < rows; i++) {
+                auto values = row(i);
+                for (size_t j = 0; j < columns; j++) {
+                    minimum_[j] = std::min(minimum_[j], values[j]);
+                    maximum[j] = std::max(maximum[j], values[j]);
+                }
+            }
+
+            step_.assign(columns, 0);
+            for (size_t j = 0; j < columns; j++)
+                step_[j] = rows > 0 ? (maximum[j] - minimum_[j])/255 : 0;
+
+            codes_.resize(rows*columns);
+            for (size_t i = 0; i < rows; i++) {
+                auto values = row(i);
+                for (size_t j = 0; j < columns; j++) {
+                    double code = step_[j] > 0 ? std::round((values[j] - minimum_[j])/step_[j]) : 0;
+                    codes_[i*columns + j] = static_cast<std::uint8_t>(std::clamp(code, 0.0, 255.0));
+                }
+            }
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+CompressedTable::CompressedTable(std::size_t rows, std::size_t columns, const void* data, Encoding encoding,
+    const nct::RealVector& minimum, const nct::RealVector& step) : 
+    encoding_(encoding), rows_(rows), columns_(columns), base_(data), baseRows_(rows)
+{
+    if ((rows > 0) && (data == nullptr))
+        throw NullPointerException("data", SOURCE_INFO);
+
+    if (encoding == Encoding::UInt8) {
+        if (minimum.size() != columns)
+            throw ArgumentException("minimum", exc_bad_array_size, SOURCE_INFO);
+
+        if (step.size() != columns)
+            throw ArgumentException("step", exc_bad_array_size, SOURCE_INFO);
+
+        minimum_ = minimum;
+        step_ = step;
+    }
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+bool CompressedTable::empty() const noexcept
+{
+    return rows_ == 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+CompressedTable::Encoding CompressedTable::encoding() const noexcept
+{
+    return encoding_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t CompressedTable::rows() const noexcept
+{
+    return rows_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t CompressedTable::columns() const noexcept
+{
+    return columns_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t CompressedTable::memorySize() const noexcept
+{
+    return rows_*columns_*elementSize() + (minimum_.size() + step_.size())*sizeof(double);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t CompressedTable::elementSize() const noexcept
+{
+    return encoding_ == Encoding::Float16 ? sizeof(std::uint16_t) : sizeof(std::uint8_t);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const unsigned char* CompressedTable::encodedRow(std::size_t row) const noexcept
+{
+    auto rowSize = columns_*elementSize();
+    if (row < baseRows_)
+        return static_cast<const unsigned char*>(base_) + row*rowSize;
+
+    auto owned = encoding_ == Encoding::Float16 ? reinterpret_cast<const unsigned char*>(halves_.data()) : 
+        codes_.data();
+    return owned + (row - baseRows_)*rowSize;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::RealVector& CompressedTable::minimum() const noexcept
+{
+    return minimum_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::RealVector& CompressedTable::step() const noexcept
+{
+    return step_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CompressedTable::decode(std::size_t row, double* out) const noexcept
+{
+    size_t m = 0;
+    if (encoding_ == Encoding::Float16) {
+        auto h = reinterpret_cast<const std::uint16_t*>(encodedRow(row));
+#if defined(COMPRESSED_TABLE_AVX)
+        if (avxSupported()) {
+            m = columns_ - columns_ % 4;
+            avxDecode(AvxHalfElements{h}, m, out);
+        }
+#endif
+        HalfElements x {h};
+        for (size_t j = m; j < columns_; j++)
+            out[j] = x(j);
+    }
+    else {
+        auto c = encodedRow(row);
+#if defined(COMPRESSED_TABLE_AVX)
+        if (avxSupported()) {
+            m = columns_ - columns_ % 4;
+            avxDecode(AvxByteElements{c, minimum_.data(), step_.data()}, m, out);
+        }
+#endif
+        ByteElements x {c, minimum_.data(), step_.data()};
+        for (size_t j = m; j < columns_; j++)
+            out[j] = x(j);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double CompressedTable::distance(std::size_t row, const double* query, nct::geometry::mesh::DistanceFunction f,
+    double bound) const
+{
+    if (query == nullptr)
+        throw NullPointerException("query", SOURCE_INFO);
+
+    // The Euclidean distance is accumulated squared. A distance that reaches the bound is not 
+    // smaller than it, as in mesh::compareFeatures.
+    auto compare = [&](const auto& x, const auto& avx) {
+        switch (f) {
+            case mesh::DistanceFunction::EuclideanDistance:
+            {
+                double r = dispatchDistance<mesh::DistanceFunction::EuclideanDistance>(x, avx, query, 
+                    columns_, bound*bound);
+                return r < bound*bound ? std::sqrt(r) : std::max(std::sqrt(r), bound);
+            }
+
+            case mesh::DistanceFunction::CityBlockDistance:
+                return dispatchDistance<mesh::DistanceFunction::CityBlockDistance>(x, avx, query, 
+                    columns_, bound);
+
+            case mesh::DistanceFunction::ChebychevDistance:
+                return dispatchDistance<mesh::DistanceFunction::ChebychevDistance>(x, avx, query, 
+                    columns_, bound);
+
+            default:
+                throw ArgumentException("f", exc_bad_distance_function, SOURCE_INFO);
+        }
+    };
+
+#if defined(COMPRESSED_TABLE_AVX)
+    if (encoding_ == Encoding::Float16) {
+        auto h = reinterpret_cast<const std::uint16_t*>(encodedRow(row));
+        return compare(HalfElements{h}, AvxHalfElements{h});
+    }
+
+    auto c = encodedRow(row);
+    return compare(ByteElements{c, minimum_.data(), step_.data()}, 
+        AvxByteElements{c, minimum_.data(), step_.data()});
+#else
+    if (encoding_ == Encoding::Float16) {
+        auto h = reinterpret_cast<const std::uint16_t*>(encodedRow(row));
+        return compare(HalfElements{h}, HalfElements{h});
+    }
+
+    auto c = encodedRow(row);
+    return compare(ByteElements{c, minimum_.data(), step_.data()}, ByteElements{c, minimum_.data(), step_.data()});
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool CompressedTable::hasDistance(nct::geometry::mesh::DistanceFunction f) noexcept
+{
+    return (f == mesh::DistanceFunction::EuclideanDistance) || (f == mesh::DistanceFunction::CityBlockDistance) ||
+        (f == mesh::DistanceFunction::ChebychevDistance);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CompressedTable::append(const double* row)
+{
+    if (row == nullptr)
+        throw NullPointerException("row", SOURCE_INFO);
+
+    if (encoding_ == Encoding::Float16) {
+        for (size_t j = 0; j < columns_; j++)
+            halves_.push_back(encodeHalf(row[j]));
+    }
+    else {
+        for (size_t j = 0; j < columns_; j++) {
+            double code = step_[j] > 0 ? std::round((row[j] - minimum_[j])/step_[j]) : 0;
+            codes_.push_back(static_cast<std::uint8_t>(std::clamp(code, 0.0, 255.0)));
+        }
+    }
+
+    rows_++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void CompressedTable::popBack()
+{
+    if (rows_ == baseRows_)
+        throw EmptyArrayException("rows", SOURCE_INFO);
+
+    if (encoding_ == Encoding::Float16)
+        halves_.resize(halves_.size() - columns_);
+    else
+        codes_.resize(codes_.size() - columns_);
+
+    rows_--;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint16_t CompressedTable::encodeHalf(double x) noexcept
+{
+    // The number is rounded to single precision first, and then to the nearest half-precision number
+    // with ties to even by adding the rounding bias to the bits of the mantissa.
+    auto f = std::bit_cast<std::uint32_t>(static_cast<float>(x));
+    std::uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    std::uint16_t h = 0;
+    if (f >= 0x47800000u) {
+        // Infinity, not a number, or at least 2^16.
+        h = f > 0x7f800000u ? 0x7e00 : 0x7c00;
+    }
+    else if (f < 0x38800000u) {
+        // Subnormal numbers are aligned by the addition of 0.5.
+        constexpr std::uint32_t magic = 126u << 23;
+        float aligned = std::bit_cast<float>(f) + std::bit_cast<float>(magic);
+        h = static_cast<std::uint16_t>(std::bit_cast<std::uint32_t>(aligned) - magic);
+    }
+    else {
+        std::uint32_t odd = (f >> 13) & 1u;
+        f += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfffu + odd;
+        h = static_cast<std::uint16_t>(f >> 13);
+    }
+
+    return static_cast<std::uint16_t>(h | (sign >> 16));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double CompressedTable::decodeHalf(std::uint16_t h) noexcept
+{
+    // The exponent is rebiased by a multiplication, which also normalizes the subnormal numbers.
+    constexpr float rebias = std::bit_cast<float>(static_cast<std::uint32_t>(254 - 15) << 23);
+    constexpr float infinity = std::bit_cast<float>(static_cast<std::uint32_t>(127 + 16) << 23);
+
+    auto f = std::bit_cast<float>(static_cast<std::uint32_t>(h & 0x7fffu) << 13) * rebias;
+    auto bits = std::bit_cast<std::uint32_t>(f);
+    if (f >= infinity)
+        bits |= 0xffu << 23;
+    bits |= static_cast<std::uint32_t>(h & 0x8000u) << 16;
+
+    return std::bit_cast<float>(bits);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,297 @@
+//=================================================================================================================
+/**
+ *  @file       CompressedTable.h
+ *  @brief      CompressedTable class.
+ *  @details    Declaration file of the CompressedTable class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+#ifndef COMPRESSED_TABLE_H_INCLUDE
+#define COMPRESSED_TABLE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/geometry/mesh.h"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Compressed table class.
+ *  @details    This class keeps a compressed copy of a row-stacked array of descriptors. The elements
+ *              are stored either as half-precision floating point numbers or as 8-bit codes of the
+ *              range of each column, which reduce the size of the table 4 and 8 times. The rows are
+ *              decoded to double precision when they are compared, so the queries keep their full
+ *              precision and only the descriptors of the collection are rounded. The compressed 
+ *              rows can also be read from a mapped feature file, in which case the rows that are
+ *              appended later are stored in memory after them. On x86-64 processors with AVX and
+ *              F16C, the rows are decoded and compared four elements at a time.
+ */
+class CompressedTable final
+{
+public:
+
+    //// Enumerations /////
+
+    /**
+     *  @brief      Encodings.
+     *  @details    Types of the elements of the compressed table.
+     */
+    enum class Encoding : unsigned char {
+
+        Float16,        /**< IEEE 754 half-precision numbers. */
+
+        UInt8,          /**< Codes between the minimum and maximum values of each column. */
+    };
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes an empty table.
+     */
+    CompressedTable() = default;
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor compresses the rows of an array, which don't need to be 
+     *              contiguous.
+     *  @param[in]  rows  The number of rows.
+     *  @param[in]  columns  The number of elements of each row.
+     *  @param[in]  row  The function that returns the first element of a row of the array.
+     *  @param[in]  encoding  The type of the compressed elements.
+     */
+    CompressedTable(std::size_t rows, std::size_t columns, 
+        const std::function<const double*(std::size_t)>& row, Encoding encoding);
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor uses contiguous compressed rows that are stored elsewhere (i.e. 
+     *              in a mapped feature file). The rows are not copied, so they must outlive the table.
+     *  @param[in]  rows  The number of rows.
+     *  @param[in]  columns  The number of elements of each row.
+     *  @param[in]  data  The first element of the compressed rows.
+     *  @param[in]  encoding  The type of the compressed elements.
+     *  @param[in]  minimum  The minimum value of each column of the 8-bit encoding.
+     *  @param[in]  step  The difference between consecutive codes of each column of the 8-bit 
+     *              encoding.
+     */
+    CompressedTable(std::size_t rows, std::size_t columns, const void* data, Encoding encoding,
+        const nct::RealVector& minimum = nct::RealVector(), const nct::RealVector& step = nct::RealVector());
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    CompressedTable(const CompressedTable&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    CompressedTable(CompressedTable&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~CompressedTable() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    CompressedTable& operator=(const CompressedTable&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    CompressedTable& operator=(CompressedTable&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Empty table.
+     *  @details    This function checks whether the table contains rows.
+     *  @returns    True if the table is empty.
+     */
+    bool empty() const noexcept;
+
+    /**
+     *  @brief      Encoding.
+     *  @details    This function returns the type of the compressed elements.
+     *  @returns    The encoding.
+     */
+    Encoding encoding() const noexcept;
+
+    /**
+     *  @brief      Rows.
+     *  @details    This function returns the number of rows of the table.
+     *  @returns    The number of rows.
+     */
+    std::size_t rows() const noexcept;
+
+    /**
+     *  @brief      Columns.
+     *  @details    This function returns the number of elements of each row.
+     *  @returns    The number of columns.
+     */
+    std::size_t columns() const noexcept;
+
+    /**
+     *  @brief      Memory size.
+     *  @details    This function returns the memory used by the compressed elements, including the
+     *              mapped ones, and the ranges of the columns.
+     *  @returns    The size in bytes.
+     */
+    std::size_t memorySize() const noexcept;
+
+    /**
+     *  @brief      Element size.
+     *  @details    This function returns the size of one compressed element.
+     *  @returns    The size in bytes.
+     */
+    std::size_t elementSize() const noexcept;
+
+    /**
+     *  @brief      Encoded row.
+     *  @details    This function returns the compressed elements of one row of the table.
+     *  @param[in]  row  The index of the row.
+     *  @returns    The first byte of the row.
+     */
+    const unsigned char* encodedRow(std::size_t row) const noexcept;
+
+    /**
+     *  @brief      Minimum values.
+     *  @details    This function returns the minimum value of each column of the 8-bit encoding.
+     *  @returns    The minimum values, or an empty vector with the half-precision encoding.
+     */
+    const nct::RealVector& minimum() const noexcept;
+
+    /**
+     *  @brief      Code steps.
+     *  @details    This function returns the difference between consecutive codes of each column 
+     *              of the 8-bit encoding.
+     *  @returns    The steps, or an empty vector with the half-precision encoding.
+     */
+    const nct::RealVector& step() const noexcept;
+
+    /**
+     *  @brief      Decode row.
+     *  @details    This function converts one row of the table to double precision.
+     *  @param[in]  row  The index of the row.
+     *  @param[out]  out  The first of the columns elements where the row is stored.
+     */
+    void decode(std::size_t row, double* out) const noexcept;
+
+    /**
+     *  @brief      Row distance.
+     *  @details    This function decodes one row of the table and compares it with a descriptor in
+     *              the same pass, without storing the decoded row. The comparison is abandoned once 
+     *              the distance reaches the bound, in which case the returned value is only a lower
+     *              bound of the distance that is not smaller than the bound. Only the functions 
+     *              accepted by hasDistance can be used.
+     *  @param[in]  row  The index of the row.
+     *  @param[in]  query  The first of the columns elements of the descriptor.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  bound  The bound of the distance.
+     *  @returns    The distance.
+     */
+    double distance(std::size_t row, const double* query, nct::geometry::mesh::DistanceFunction f,
+        double bound = std::numeric_limits<double>::infinity()) const;
+
+    /**
+     *  @brief      Row distance support.
+     *  @details    This function checks whether a distance function can be calculated from the
+     *              compressed rows (see distance).
+     *  @param[in]  f  The distance function.
+     *  @returns    True for the Euclidean, city block and Chebychev distances.
+     */
+    static bool hasDistance(nct::geometry::mesh::DistanceFunction f) noexcept;
+
+    /**
+     *  @brief      Append row.
+     *  @details    This function compresses one more row at the end of the table. The ranges of 
+     *              the columns of the 8-bit encoding are not changed, so the elements of the row 
+     *              that are out of them are clamped.
+     *  @param[in]  row  The first of the columns elements of the row.
+     */
+    void append(const double* row);
+
+    /**
+     *  @brief      Remove last row.
+     *  @details    This function removes the last row, which must have been compressed in memory 
+     *              after the rows stored elsewhere.
+     */
+    void popBack();
+
+    /**
+     *  @brief      Encode half.
+     *  @details    This function rounds a number to the closest half-precision number. The numbers
+     *              out of the range of the format are converted to infinity.
+     *  @param[in]  x  The number to round.
+     *  @returns    The bits of the half-precision number.
+     */
+    static std::uint16_t encodeHalf(double x) noexcept;
+
+    /**
+     *  @brief      Decode half.
+     *  @details    This function converts a half-precision number to double precision.
+     *  @param[in]  h  The bits of the half-precision number.
+     *  @returns    The number.
+     */
+    static double decodeHalf(std::uint16_t h) noexcept;
+
+private:
+
+    //// Member variables ////
+
+    Encoding encoding_ {Encoding::Float16};                 /**< Type of the compressed elements. */
+
+    std::size_t rows_ {0};                                  /**< Number of rows. */
+
+    std::size_t columns_ {0};                               /**< Number of elements of each row. */
+
+    const void* base_ {nullptr};                            /**< Compressed rows stored elsewhere. */
+
+    std::size_t baseRows_ {0};                              /**< Number of rows stored elsewhere. */
+
+    std::vector<std::uint16_t> halves_;                     /**< Half-precision elements of the other rows. */
+
+    std::vector<std::uint8_t> codes_;                       /**< 8-bit codes of the elements of the other rows. */
+
+    nct::RealVector minimum_;                               /**< Minimum value of each column. */
+
+    nct::RealVector step_;                                  /**< Difference between consecutive codes of each column. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
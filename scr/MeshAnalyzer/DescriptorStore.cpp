@@ -0,0 +1,1085 @@
+//=================================================================================================================
+/**
+ *  @file       DescriptorStore.cpp
+ *  @brief      DescriptorStore class implementation file.
+ *  @details    This file contains the implementation of the DescriptorStore class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "DescriptorStore.h"
+
+#include "nct/nct_exception.h"
+#include "nct/nct_utils.h"
+#include "nct/statistics/statistics.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
+
+#include <cstring>
+#include <numeric>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Appended fraction.
+ *  @details    A search index that is read from a file is built again when more than one in this 
+ *              number of its models were appended after it was built, since the appended models 
+ *              are not organized by the index.
+ */
+constexpr std::size_t appendedFraction {8};
+
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+const double* DescriptorStore::Table::row(std::size_t i) const noexcept
+{
+    return storedRow(rowIndex != nullptr ? rowIndex[i] : i);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const double* DescriptorStore::Table::storedRow(std::size_t r) const noexcept
+{
+    return r < baseRows ? data + r*stride : tail + (r - baseRows)*columns;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::load(const QString& featurePath, const nct::Array2D<QString>& models)
+{
+    const QString packedFile = featurePath + FeatureFile::defaultFileName;
+    if (QFile::exists(packedFile))
+        loadPackedFile(packedFile, models);
+    else
+        loadFeatureFiles(featurePath, models);
+
+    rotations_.reset(featurePath);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::loadFeatureFiles(const QString& featurePath, const nct::Array2D<QString>& models)
+{
+    clear();
+
+    try {
+        auto nModels = models.rows();
+        if (nModels == 0)
+            return;
+
+        // Shared harmonic matrices.
+        hmat_.hB = decodeHarmonicFile(featurePath + "hB.bin");
+        hmat_.theta = decodeVectorFile(featurePath + "theta.bin");
+        hmat_.phi = decodeVectorFile(featurePath + "phi.bin");
+        hmat_.Bt = decodeMatrixFile(featurePath + "Bt.bin");
+        hmat_.BtBI = decodeMatrixFile(featurePath + "BtBI.bin");
+
+        // Descriptors of each model. The size of the first descriptor of each family defines the
+        // number of columns of the stacked array.
+        for (size_t i = 0; i < nModels; i++) {
+            const QString name = featurePath + models(i, 0);
+
+            for (unsigned int k = 0; k < nShapeDistributions; k++) {
+                auto sufix = sdSuffix(static_cast<mesh::ShapeDistribution>(k));
+                auto bin = decodeVectorFile(name + sufix + "_b.bin");
+                auto hist = decodeVectorFile(name + sufix + "_h.bin");
+
+                if (i == 0) {
+                    sdBins_[k].resize(nModels, bin.size());
+                    sdHistograms_[k].resize(nModels, hist.size());
+                }
+
+                if ((bin.size() != sdBins_[k].columns()) || (hist.size() != sdHistograms_[k].columns()))
+                    throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+                std::copy(bin.begin(), bin.end(), sdBins_[k].data() + i*sdBins_[k].columns());
+                std::copy(hist.begin(), hist.end(), sdHistograms_[k].data() + i*sdHistograms_[k].columns());
+            }
+
+            auto rsd = decodeMatrixFile(name + "_RSD_RSD.bin");
+            if (i == 0)
+                rsd_.resize(nModels, rsd.size());
+            if ((rsd.columns() != 2) || (rsd.size() != rsd_.columns()))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+            std::copy(rsd.begin(), rsd.end(), rsd_.data() + i*rsd_.columns());
+
+            auto hm = decodeMatrixFile(name + "_HM.bin");
+            if (i == 0) {
+                hm_.resize(nModels, hm.size());
+                hmRows_ = hm.rows();
+            }
+            if ((hm.size() != hm_.columns()) || (hm.rows() != hmRows_))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+            std::copy(hm.begin(), hm.end(), hm_.data() + i*hm_.columns());
+        }
+
+        nModels_ = nModels;
+        nRows_ = nModels;
+        updateTables();
+        buildSplines();
+        compress();
+    }
+    catch (...) {
+        clear();
+        throw;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::loadPackedFile(const QString& fileName, const nct::Array2D<QString>& models)
+{
+    clear();
+
+    try {
+        auto file = std::make_unique<FeatureFile>(fileName);
+
+        // The rows of the file must correspond to the models of the collection.
+        auto nModels = models.rows();
+        if (file->numberOfModels() != nModels)
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        auto names = file->modelNames();
+        for (size_t i = 0; i < nModels; i++)
+            if (names[i] != models(i, 0))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        if (nModels == 0)
+            return;
+
+        // Views of the descriptors of the collection.
+        auto view = [&](std::uint32_t id, Table& table) {
+            auto s = file->section(id);
+            if ((s == nullptr) || (s->type != static_cast<std::uint32_t>(FeatureFile::ElementType::Float64)) ||
+                (s->rows != nModels) || (s->stride % sizeof(double) != 0))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+            table.data = reinterpret_cast<const double*>(file->data(*s));
+            table.rows = static_cast<size_t>(s->rows);
+            table.columns = static_cast<size_t>(s->columns);
+            table.stride = static_cast<size_t>(s->stride / sizeof(double));
+            table.baseRows = table.rows;
+            return s;
+        };
+
+        for (unsigned int k = 0; k < nShapeDistributions; k++) {
+            view(static_cast<std::uint32_t>(FeatureFile::SectionId::SdHistograms) + k, sdHistogramTables_[k]);
+            view(static_cast<std::uint32_t>(FeatureFile::SectionId::SdBins) + k, sdBinTables_[k]);
+        }
+
+        auto rsdSection = view(static_cast<std::uint32_t>(FeatureFile::SectionId::Rsd), rsdTable_);
+        if ((rsdSection->dim1 != 2) || (rsdSection->columns % 2 != 0) || 
+            (rsdSection->dim0 != rsdSection->columns/2))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        auto hmSection = view(static_cast<std::uint32_t>(FeatureFile::SectionId::Hm), hmTable_);
+        // The dimensions are divided instead of multiplied, so that they can't overflow.
+        if ((hmSection->dim0 == 0) || (hmSection->columns % hmSection->dim0 != 0) || 
+            (hmSection->dim1 != hmSection->columns/hmSection->dim0))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+        hmRows_ = static_cast<size_t>(hmSection->dim0);
+
+        // Shared harmonic matrices are copied, since they are used by the rasterization functions.
+        auto matrix = [&](FeatureFile::SectionId id) {
+            auto s = file->section(id);
+            if ((s == nullptr) || (s->type != static_cast<std::uint32_t>(FeatureFile::ElementType::Float64)) ||
+                (s->stride != s->columns*sizeof(double)))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+            Matrix m(static_cast<size_t>(s->rows), static_cast<size_t>(s->columns));
+            std::memcpy(m.data(), file->data(*s), sizeof(double)*m.size());
+            return m;
+        };
+
+        auto orders = file->section(FeatureFile::SectionId::HarmonicOrders);
+        if ((orders == nullptr) || (orders->type != static_cast<std::uint32_t>(FeatureFile::ElementType::Int32)) ||
+            (orders->columns != 2) || (orders->stride != 2*sizeof(std::int32_t)))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        hmat_.hB.resize(static_cast<size_t>(orders->rows));
+        auto lm = reinterpret_cast<const std::int32_t*>(file->data(*orders));
+        for (size_t i = 0; i < hmat_.hB.size(); i++) {
+            hmat_.hB[i].l = lm[2*i];
+            hmat_.hB[i].m = lm[2*i + 1];
+        }
+
+        auto theta = matrix(FeatureFile::SectionId::Theta);
+        auto phi = matrix(FeatureFile::SectionId::Phi);
+        hmat_.theta = RealVector(theta.begin(), theta.end());
+        hmat_.phi = RealVector(phi.begin(), phi.end());
+        hmat_.Bt = matrix(FeatureFile::SectionId::Bt);
+        hmat_.BtBI = matrix(FeatureFile::SectionId::BtBI);
+
+        file_ = std::move(file);
+        nModels_ = nModels;
+        nRows_ = nModels;
+        baseRows_ = nModels;
+        buildSplines();
+        compress();
+    }
+    catch (...) {
+        clear();
+        throw;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::append(const Model& model)
+{
+    // The descriptors of the model must have the sizes of the descriptors of the collection.
+    bool sameSize = (model.rsd.columns() == 2) && (model.hm.size() > 0);
+    if (nRows_ > 0) {
+        for (unsigned int k = 0; k < nShapeDistributions; k++) {
+            sameSize = sameSize && (model.sdHistograms[k].size() == sdHistogramTables_[k].columns) && 
+                (model.sdBins[k].size() == sdBinTables_[k].columns);
+        }
+        sameSize = sameSize && (model.rsd.size() == rsdTable_.columns) && 
+            (model.hm.rows() == hmRows_) && (model.hm.size() == hmTable_.columns);
+    }
+    if (!sameSize)
+        throw ArgumentException("model", exc_bad_array_size, SOURCE_INFO);
+
+    // The rows mapped from a packed feature file are not copied; the model is stored after them.
+    reserve(model);
+
+    auto r = nRows_;
+    auto t = nRows_ - baseRows_;
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        std::copy(model.sdHistograms[k].begin(), model.sdHistograms[k].end(), &sdHistograms_[k](t, 0));
+        std::copy(model.sdBins[k].begin(), model.sdBins[k].end(), &sdBins_[k](t, 0));
+    }
+    std::copy(model.rsd.begin(), model.rsd.end(), &rsd_(t, 0));
+    std::copy(model.hm.begin(), model.hm.end(), &hm_(t, 0));
+
+    hmRows_ = model.hm.rows();
+    if (!removed_.empty()) {
+        removed_.push_back(0);
+        rowIndex_.push_back(r);
+    }
+    nModels_++;
+    nRows_++;
+    updateTables();
+
+    for (unsigned int k = 0; (k < nShapeDistributions) && (loadMode_ == LoadMode::Queries); k++) {
+        auto dist = static_cast<mesh::ShapeDistribution>(k);
+        if (dist == mesh::ShapeDistribution::TwoVectorsAngle)
+            continue;
+
+        try {
+            sdSplines_[k].push_back(mesh::shapeDistributionSpline(model.sdHistograms[k], model.sdBins[k]));
+        }
+        catch (const std::exception&) {
+            sdSplines_[k].push_back(mesh::ShapeDistributionSpline());
+        }
+    }
+
+    if ((precision_ != Precision::Float64) && (loadMode_ == LoadMode::Queries)) {
+        if (rsdCompressed_.empty()) {
+            compress();
+        }
+        else {
+            rsdCompressed_.append(rsdTable_.storedRow(r));
+            hmCompressed_.append(hmTable_.storedRow(r));
+        }
+    }
+
+    // The search indices in memory compare the new model linearly.
+    std::lock_guard<std::mutex> lock(treeMutex_);
+    for (auto& [name, indexed] : trees_) {
+        RealVector point(indexed.table->columns);
+        indexedDescriptor(*indexed.table, r, indexed.cdf, point.data());
+        indexed.tree->append(point.data());
+    }
+    for (auto& [name, invertedFile] : invertedFiles_)
+        invertedFile->append(hmTable_.storedRow(r));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::remove(std::size_t model)
+{
+    if (model >= nModels_)
+        throw IndexOutOfRangeException("model", SOURCE_INFO);
+
+    // The row is kept, so the mapped rows, the compressed copies and the search indices are 
+    // still valid; only the following models take the previous index.
+    if (removed_.empty()) {
+        removed_.assign(nRows_, 0);
+        rowIndex_.resize(nModels_);
+        std::iota(rowIndex_.begin(), rowIndex_.end(), static_cast<size_t>(0));
+    }
+
+    removed_[rowIndex_[model]] = 1;
+    rowIndex_.erase(rowIndex_.begin() + model);
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        if (!sdSplines_[k].empty())
+            sdSplines_[k].erase(sdSplines_[k].begin() + model);
+    }
+
+    nModels_--;
+    updateTables();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::popBack()
+{
+    if (nModels_ == 0)
+        throw EmptyArrayException("store", SOURCE_INFO);
+
+    if ((modelRow(nModels_ - 1) != nRows_ - 1) || (nRows_ == baseRows_))
+        throw OperationException("The last model is not stored in the last appended row", SOURCE_INFO);
+
+    if (!removed_.empty()) {
+        removed_.pop_back();
+        rowIndex_.pop_back();
+    }
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        if (!sdSplines_[k].empty())
+            sdSplines_[k].pop_back();
+    }
+
+    nModels_--;
+    nRows_--;
+    updateTables();
+
+    if (!rsdCompressed_.empty()) {
+        rsdCompressed_.popBack();
+        hmCompressed_.popBack();
+    }
+
+    // The indices that were built after the model was appended contain it in their nodes or 
+    // cells, so they are built again when they are requested.
+    std::lock_guard<std::mutex> lock(treeMutex_);
+    for (auto it = trees_.begin(); it != trees_.end();) {
+        if (it->second.tree->appended() > 0) {
+            it->second.tree->popBack();
+            ++it;
+        }
+        else {
+            it = trees_.erase(it);
+        }
+    }
+    for (auto it = invertedFiles_.begin(); it != invertedFiles_.end();) {
+        if (it->second->appended() > 0) {
+            it->second->popBack();
+            ++it;
+        }
+        else {
+            it = invertedFiles_.erase(it);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::detach()
+{
+    bool dropped = nRows_ != nModels_;
+    if ((file_ == nullptr) && !dropped)
+        return;
+
+    // The matrices contain the rows after the mapped rows, so they are replaced when the row of 
+    // every model was copied.
+    auto copy = [this](const Table& t, Matrix& m) {
+        Matrix copied(nModels_, t.columns, 0);
+        for (size_t i = 0; i < nModels_; i++)
+            std::copy(t.row(i), t.row(i) + t.columns, &copied(i, 0));
+        m = std::move(copied);
+    };
+
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        copy(sdHistogramTables_[k], sdHistograms_[k]);
+        copy(sdBinTables_[k], sdBins_[k]);
+    }
+    copy(rsdTable_, rsd_);
+    copy(hmTable_, hm_);
+
+    file_.reset();
+    baseRows_ = 0;
+    nRows_ = nModels_;
+    removed_.clear();
+    rowIndex_.clear();
+    updateTables();
+
+    // The compressed descriptors can be views of the released file, so they are encoded again.
+    if (!rsdCompressed_.empty())
+        compress();
+
+    // The search indices contain the rows that were dropped.
+    if (dropped) {
+        std::lock_guard<std::mutex> lock(treeMutex_);
+        trees_.clear();
+        invertedFiles_.clear();
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::clear()
+{
+    nModels_ = 0;
+    nRows_ = 0;
+    baseRows_ = 0;
+    removed_.clear();
+    rowIndex_.clear();
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        sdHistograms_[k].clear();
+        sdBins_[k].clear();
+        sdHistogramTables_[k] = Table();
+        sdBinTables_[k] = Table();
+        sdSplines_[k].clear();
+    }
+    rsd_.clear();
+    hm_.clear();
+    rsdTable_ = Table();
+    hmTable_ = Table();
+    hmRows_ = 0;
+    rsdCompressed_ = CompressedTable();
+    hmCompressed_ = CompressedTable();
+    file_.reset();
+    hmat_ = RasterizedObject3D::HarmonicMatrices();
+    rotations_.reset();
+
+    std::lock_guard<std::mutex> lock(treeMutex_);
+    trees_.clear();
+    invertedFiles_.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool DescriptorStore::empty() const noexcept
+{
+    return nModels_ == 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t DescriptorStore::numberOfModels() const noexcept
+{
+    return nModels_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::vector<char>& DescriptorStore::removedRows() const noexcept
+{
+    return removed_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::Table DescriptorStore::sdHistograms(nct::geometry::mesh::ShapeDistribution dist) const
+{
+    auto k = static_cast<unsigned int>(dist);
+    if (k >= nShapeDistributions)
+        throw ArgumentException("dist", exc_bad_shape_distribution, SOURCE_INFO);
+
+    return sdHistogramTables_[k];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::Table DescriptorStore::sdBins(nct::geometry::mesh::ShapeDistribution dist) const
+{
+    auto k = static_cast<unsigned int>(dist);
+    if (k >= nShapeDistributions)
+        throw ArgumentException("dist", exc_bad_shape_distribution, SOURCE_INFO);
+
+    return sdBinTables_[k];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector DescriptorStore::sdHistogram(nct::geometry::mesh::ShapeDistribution dist, std::size_t model) const
+{
+    if (model >= nModels_)
+        throw IndexOutOfRangeException("model", SOURCE_INFO);
+
+    auto h = sdHistograms(dist);
+    auto row = h.row(model);
+    return RealVector(row, row + h.columns);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector DescriptorStore::sdBins(nct::geometry::mesh::ShapeDistribution dist, std::size_t model) const
+{
+    if (model >= nModels_)
+        throw IndexOutOfRangeException("model", SOURCE_INFO);
+
+    auto b = sdBins(dist);
+    auto row = b.row(model);
+    return RealVector(row, row + b.columns);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::vector<nct::geometry::mesh::ShapeDistributionSpline>& DescriptorStore::sdSplines(
+    nct::geometry::mesh::ShapeDistribution dist) const
+{
+    auto k = static_cast<unsigned int>(dist);
+    if (k >= nShapeDistributions)
+        throw ArgumentException("dist", exc_bad_shape_distribution, SOURCE_INFO);
+
+    return sdSplines_[k];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::Table DescriptorStore::rsdDescriptors() const noexcept
+{
+    return rsdTable_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix DescriptorStore::rsdDescriptor(std::size_t model) const
+{
+    if (model >= nModels_)
+        throw IndexOutOfRangeException("model", SOURCE_INFO);
+
+    Matrix rsd(rsdTable_.columns/2, 2);
+    auto row = rsdTable_.row(model);
+    std::copy(row, row + rsdTable_.columns, rsd.begin());
+    return rsd;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::Table DescriptorStore::hmDescriptors() const noexcept
+{
+    return hmTable_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t DescriptorStore::hmDescriptorRows() const noexcept
+{
+    return hmRows_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector DescriptorStore::hmDescriptor(std::size_t model) const
+{
+    if (model >= nModels_)
+        throw IndexOutOfRangeException("model", SOURCE_INFO);
+
+    auto row = hmTable_.row(model);
+    return RealVector(row, row + hmTable_.columns);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::setPrecision(Precision precision)
+{
+    precision_ = precision;
+    compress();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::Precision DescriptorStore::precision() const noexcept
+{
+    return precision_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::setLoadMode(LoadMode mode) noexcept
+{
+    loadMode_ = mode;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+DescriptorStore::LoadMode DescriptorStore::loadMode() const noexcept
+{
+    return loadMode_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::rsdRow(std::size_t model, double* out, bool compressed) const noexcept
+{
+    if (compressed && !rsdCompressed_.empty()) {
+        rsdCompressed_.decode(modelRow(model), out);
+        return;
+    }
+
+    auto row = rsdTable_.row(model);
+    std::copy(row, row + rsdTable_.columns, out);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::hmRow(std::size_t model, double* out, bool compressed) const noexcept
+{
+    if (compressed && !hmCompressed_.empty()) {
+        hmCompressed_.decode(modelRow(model), out);
+        return;
+    }
+
+    auto row = hmTable_.row(model);
+    std::copy(row, row + hmTable_.columns, out);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool DescriptorStore::hasHmRowDistance(nct::geometry::mesh::DistanceFunction f) const noexcept
+{
+    return !hmCompressed_.empty() && CompressedTable::hasDistance(f);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double DescriptorStore::hmRowDistance(std::size_t model, const nct::RealVector& query, 
+    nct::geometry::mesh::DistanceFunction f, double bound) const
+{
+    if (model >= nModels_)
+        throw IndexOutOfRangeException("model", SOURCE_INFO);
+
+    if (query.size() != hmCompressed_.columns())
+        throw ArgumentException("query", exc_bad_array_size, SOURCE_INFO);
+
+    return hmCompressed_.distance(modelRow(model), query.data(), f, bound);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t DescriptorStore::comparedSize() const noexcept
+{
+    auto rsd = rsdCompressed_.empty() ? nRows_*rsdTable_.columns*sizeof(double) : 
+        rsdCompressed_.memorySize();
+    auto hm = hmCompressed_.empty() ? nRows_*hmTable_.columns*sizeof(double) : 
+        hmCompressed_.memorySize();
+    return rsd + hm;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::geometry::RasterizedObject3D::HarmonicMatrices& DescriptorStore::harmonicMatrices() const noexcept
+{
+    return hmat_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const RotationIndexCache::Indices> DescriptorStore::rotationIndices(unsigned int nVox, 
+    unsigned int nTestAngles) const
+{
+    return rotations_.indices(nVox, nTestAngles);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const RotationIndexCache::Sources> DescriptorStore::rotationSources(unsigned int nVox, 
+    unsigned int nTestAngles) const
+{
+    return rotations_.sources(nVox, nTestAngles);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const MetricTree> DescriptorStore::sdTree(nct::geometry::mesh::ShapeDistribution dist, 
+    nct::geometry::mesh::DistanceFunction f, bool cdf) const
+{
+    if (dist != mesh::ShapeDistribution::TwoVectorsAngle)
+        throw ArgumentException("dist", exc_bad_shape_distribution, SOURCE_INFO);
+
+    auto name = QString("tree%1_%2%3.avp").arg(sdSuffix(dist)).arg(static_cast<unsigned int>(f)).
+        arg(cdf ? "_cdf" : "");
+    return metricTree(name, &sdHistogramTables_[static_cast<unsigned int>(dist)], cdf, f);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const MetricTree> DescriptorStore::hmTree(nct::geometry::mesh::DistanceFunction f) const
+{
+    auto name = QString("tree_HM_%1.avp").arg(static_cast<unsigned int>(f));
+    return metricTree(name, &hmTable_, false, f);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const InvertedFile> DescriptorStore::hmInvertedFile(std::size_t nCells) const
+{
+    if (nCells == 0)
+        nCells = InvertedFile::defaultCells(nRows_);
+    nCells = std::min(nCells, nRows_);
+
+    // The lock is kept while the cells are built, so that concurrent queries wait for them.
+    std::lock_guard<std::mutex> lock(treeMutex_);
+
+    auto name = QString("ivf_HM_%1.aiv").arg(nCells);
+    auto it = invertedFiles_.find(name);
+    if (it != invertedFiles_.end())
+        return it->second;
+
+    if (nRows_ == 0)
+        throw EmptyArrayException("hmTable", SOURCE_INFO);
+
+    // The cells contain the rows of the removed models, which the searches skip.
+    Matrix points(nRows_, hmTable_.columns);
+    for (size_t i = 0; i < nRows_; i++) {
+        auto row = hmTable_.storedRow(i);
+        std::copy(row, row + hmTable_.columns, &points(i, 0));
+    }
+
+    std::shared_ptr<InvertedFile> invertedFile;
+    auto directory = rotations_.directory();
+    QString fileName;
+    if (!directory.isEmpty())
+        fileName = QDir(directory).filePath(name);
+
+    if (!fileName.isEmpty() && QFile::exists(fileName)) {
+        try {
+            invertedFile = std::make_shared<InvertedFile>(fileName, points);
+            if (invertedFile->appended()*appendedFraction > invertedFile->size())
+                invertedFile.reset();
+        }
+        catch (const std::exception&) {
+            // A damaged or outdated file is replaced below.
+            invertedFile.reset();
+        }
+    }
+
+    if (invertedFile == nullptr) {
+        auto built = std::make_shared<InvertedFile>(points, nCells);
+
+        if (!fileName.isEmpty()) {
+            try {
+                built->write(fileName);
+            }
+            catch (const std::exception&) {
+                // The directory of the collection can be read-only; the cells are kept in memory.
+            }
+        }
+        invertedFile = built;
+    }
+
+    invertedFiles_[name] = invertedFile;
+    return invertedFile;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString DescriptorStore::sdSuffix(nct::geometry::mesh::ShapeDistribution dist)
+{
+    switch (dist) {
+        case mesh::ShapeDistribution::CentroidDistance:
+            return "_SD_CD";
+        case mesh::ShapeDistribution::TwoPointDistance:
+            return "_SD_TPD";
+        case mesh::ShapeDistribution::ThreePointArea:
+            return "_SD_TPA";
+        case mesh::ShapeDistribution::FourPointVolume:
+            return "_SD_FPV";
+        case mesh::ShapeDistribution::TwoVectorsAngle:
+            return "_SD_TVA";
+        default:
+            throw ArgumentException("dist", exc_bad_shape_distribution, SOURCE_INFO);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix DescriptorStore::decodeMatrixFile(const QString& arrayFile)
+{
+    QFile file(arrayFile);
+    file.open(QIODevice::ReadOnly);
+    QDataStream i(&file);
+
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_bad_input_stream, SOURCE_INFO);
+
+    // Read number of rows and number of columns.
+    size_t r = 0;
+    size_t c = 0;
+    i.readRawData(reinterpret_cast<char*> (&r), sizeof(size_t));
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_number_of_rows, SOURCE_INFO);
+
+    i.readRawData(reinterpret_cast<char*> (&c), sizeof(size_t));
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_number_of_columns, SOURCE_INFO);
+
+    // Read data.
+    Array2D<double> arr(r, c);
+    i.readRawData(reinterpret_cast<char*> (arr.data()), sizeof(double) * arr.size());
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_data, SOURCE_INFO);
+
+    return arr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector DescriptorStore::decodeVectorFile(const QString& arrayFile)
+{
+    QFile file(arrayFile);
+    file.open(QIODevice::ReadOnly);
+    QDataStream i(&file);
+
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_bad_input_stream, SOURCE_INFO);
+
+    // Read number of rows and number of columns.
+    nct::size_t n_ = 0;
+
+    i.readRawData(reinterpret_cast<char*> (&n_), sizeof(nct::size_t));
+
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_array_size, SOURCE_INFO);
+
+    // Read data.
+    Array<double> arr(n_);
+    i.readRawData(reinterpret_cast<char*> (arr.data()), sizeof(double) * arr.size());
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_data, SOURCE_INFO);
+
+    return arr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<nct::signal::spherical_harmonics::SphericalHarmonic> DescriptorStore::decodeHarmonicFile(
+    const QString& arrayFile)
+{
+    QFile file(arrayFile);
+    file.open(QIODevice::ReadOnly);
+    QDataStream i(&file);
+
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_bad_input_stream, SOURCE_INFO);
+
+    // Read number of rows and number of columns.
+    nct::size_t n_ = 0;
+
+    i.readRawData(reinterpret_cast<char*> (&n_), sizeof(nct::size_t));
+
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_array_size, SOURCE_INFO);
+
+    // Read data.
+    Array<nct::signal::spherical_harmonics::SphericalHarmonic> arr(n_);
+    i.readRawData(reinterpret_cast<char*> (arr.data()),
+        sizeof(nct::signal::spherical_harmonics::SphericalHarmonic) * arr.size());
+    if (!i.status() == QDataStream::Ok)
+        throw IOException(exc_error_reading_data, SOURCE_INFO);
+
+    return arr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t DescriptorStore::modelRow(std::size_t model) const noexcept
+{
+    return removed_.empty() ? model : rowIndex_[model];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::updateTables()
+{
+    // The views of the mapped rows are kept.
+    auto update = [this](Table& t, const Matrix& m) {
+        if (file_ == nullptr) {
+            t.data = m.data();
+            t.columns = m.columns();
+            t.stride = m.columns();
+            t.baseRows = nRows_;
+        }
+        else {
+            t.tail = m.data();
+        }
+        t.rows = nModels_;
+        t.rowIndex = removed_.empty() ? nullptr : rowIndex_.data();
+    };
+
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        update(sdHistogramTables_[k], sdHistograms_[k]);
+        update(sdBinTables_[k], sdBins_[k]);
+    }
+    update(rsdTable_, rsd_);
+    update(hmTable_, hm_);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::reserve(const Model& model)
+{
+    auto n = nRows_ - baseRows_;
+    auto grow = [n](Matrix& m, size_t columns) {
+        if ((m.rows() > n) && (m.columns() == columns))
+            return;
+
+        Matrix grown(std::max<size_t>(2*n, n + 1), columns);
+        if (n > 0)
+            std::copy(m.data(), m.data() + n*columns, grown.data());
+        m = std::move(grown);
+    };
+
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        grow(sdHistograms_[k], model.sdHistograms[k].size());
+        grow(sdBins_[k], model.sdBins[k].size());
+    }
+    grow(rsd_, model.rsd.size());
+    grow(hm_, model.hm.size());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::buildSplines()
+{
+    if (loadMode_ == LoadMode::Updates)
+        return;
+
+    for (unsigned int k = 0; k < nShapeDistributions; k++) {
+        auto dist = static_cast<mesh::ShapeDistribution>(k);
+        if (dist == mesh::ShapeDistribution::TwoVectorsAngle)
+            continue;
+
+        auto hTable = sdHistogramTables_[k];
+        auto bTable = sdBinTables_[k];
+        auto& splines = sdSplines_[k];
+        splines.assign(nModels_, mesh::ShapeDistributionSpline());
+
+        nct::parallel_for(static_cast<size_t>(0), nModels_, 0U, [&](size_t i) {
+            auto hRow = hTable.row(i);
+            auto bRow = bTable.row(i);
+
+            // A histogram that can't be interpolated keeps an empty spline, and its comparisons
+            // report the error of the interpolation.
+            try {
+                splines[i] = mesh::shapeDistributionSpline(RealVector(hRow, hRow + hTable.columns), 
+                    RealVector(bRow, bRow + bTable.columns));
+            }
+            catch (const std::exception&) {
+                splines[i] = mesh::ShapeDistributionSpline();
+            }
+        });
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::compress()
+{
+    rsdCompressed_ = CompressedTable();
+    hmCompressed_ = CompressedTable();
+    if ((precision_ == Precision::Float64) || (nRows_ == 0) || (loadMode_ == LoadMode::Updates))
+        return;
+
+    auto encoding = precision_ == Precision::Float16 ? 
+        CompressedTable::Encoding::Float16 : CompressedTable::Encoding::UInt8;
+
+    // The double-precision rows are only read when the packed feature file doesn't contain the
+    // compressed ones (i.e. files of the first version). The rows of the removed models are 
+    // encoded too, so the compressed rows are the stored rows.
+    auto map = [&](FeatureFile::SectionId halfId, FeatureFile::SectionId byteId, 
+        FeatureFile::SectionId rangesId, const Table& table, CompressedTable& compressed) {
+        auto s = file_ != nullptr ? 
+            file_->section(encoding == CompressedTable::Encoding::Float16 ? halfId : byteId) : nullptr;
+        if (s == nullptr)
+            return false;
+
+        auto type = encoding == CompressedTable::Encoding::Float16 ? 
+            FeatureFile::ElementType::Float16 : FeatureFile::ElementType::UInt8;
+        if ((s->type != static_cast<std::uint32_t>(type)) || (s->rows != baseRows_) || 
+            (s->columns != table.columns) || (s->stride != s->columns*FeatureFile::elementSize(s->type)))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        RealVector minimum;
+        RealVector step;
+        if (encoding == CompressedTable::Encoding::UInt8) {
+            auto r = file_->section(rangesId);
+            if ((r == nullptr) || (r->type != static_cast<std::uint32_t>(FeatureFile::ElementType::Float64)) ||
+                (r->rows != 2) || (r->columns != table.columns) || (r->stride != r->columns*sizeof(double)))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+            auto ranges = reinterpret_cast<const double*>(file_->data(*r));
+            minimum = RealVector(ranges, ranges + table.columns);
+            step = RealVector(ranges + table.columns, ranges + 2*table.columns);
+        }
+
+        compressed = CompressedTable(baseRows_, table.columns, file_->data(*s), encoding, minimum, step);
+        for (size_t i = baseRows_; i < nRows_; i++)
+            compressed.append(table.storedRow(i));
+
+        return true;
+    };
+
+    if (!map(FeatureFile::SectionId::RsdFloat16, FeatureFile::SectionId::RsdUInt8, 
+        FeatureFile::SectionId::RsdUInt8Ranges, rsdTable_, rsdCompressed_)) {
+        rsdCompressed_ = CompressedTable(nRows_, rsdTable_.columns, 
+            [this](size_t i) { return rsdTable_.storedRow(i); }, encoding);
+    }
+
+    if (!map(FeatureFile::SectionId::HmFloat16, FeatureFile::SectionId::HmUInt8, 
+        FeatureFile::SectionId::HmUInt8Ranges, hmTable_, hmCompressed_)) {
+        hmCompressed_ = CompressedTable(nRows_, hmTable_.columns, 
+            [this](size_t i) { return hmTable_.storedRow(i); }, encoding);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const MetricTree> DescriptorStore::metricTree(const QString& name, const Table* table, bool cdf,
+    nct::geometry::mesh::DistanceFunction f) const
+{
+    // The lock is kept while a tree is built, so that concurrent queries wait for it.
+    std::lock_guard<std::mutex> lock(treeMutex_);
+
+    auto it = trees_.find(name);
+    if (it != trees_.end())
+        return it->second.tree;
+
+    if (nRows_ == 0)
+        throw EmptyArrayException("table", SOURCE_INFO);
+
+    // The tree contains the rows of the removed models, which the searches skip.
+    Matrix points(nRows_, table->columns);
+    for (size_t i = 0; i < nRows_; i++)
+        indexedDescriptor(*table, i, cdf, &points(i, 0));
+
+    std::shared_ptr<MetricTree> tree;
+    auto directory = rotations_.directory();
+    QString fileName;
+    if (!directory.isEmpty())
+        fileName = QDir(directory).filePath(name);
+
+    if (!fileName.isEmpty() && QFile::exists(fileName)) {
+        try {
+            tree = std::make_shared<MetricTree>(fileName, points, f);
+            if (tree->appended()*appendedFraction > tree->size())
+                tree.reset();
+        }
+        catch (const std::exception&) {
+            // A damaged or outdated file is replaced below.
+            tree.reset();
+        }
+    }
+
+    if (tree == nullptr) {
+        auto built = std::make_shared<MetricTree>(points, f);
+
+        if (!fileName.isEmpty()) {
+            try {
+                built->write(fileName);
+            }
+            catch (const std::exception&) {
+                // The directory of the collection can be read-only; the tree is kept in memory.
+            }
+        }
+        tree = built;
+    }
+
+    trees_[name] = {tree, table, cdf};
+    return tree;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void DescriptorStore::indexedDescriptor(const Table& table, std::size_t r, bool cdf, double* out)
+{
+    auto row = table.storedRow(r);
+    if (!cdf) {
+        std::copy(row, row + table.columns, out);
+        return;
+    }
+
+    RealVector h(row, row + table.columns);
+    RealVector c(table.columns);
+    statistics::cumulativeData(h.begin(), h.end(), c.begin());
+    std::copy(c.begin(), c.end(), out);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
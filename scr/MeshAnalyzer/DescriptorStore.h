@@ -0,0 +1,720 @@
+//=================================================================================================================
+/**
+ *  @file       DescriptorStore.h
+ *  @brief      DescriptorStore class.
+ *  @details    Declaration file of the DescriptorStore class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef DESCRIPTOR_STORE_H_INCLUDE
+#define DESCRIPTOR_STORE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+#include "nct/geometry/mesh.h"
+#include "nct/geometry/RasterizedObject3D.h"
+#include "nct/signal/spherical_harmonics.h"
+
+#include "CompressedTable.h"
+#include "FeatureFile.h"
+#include "MetricTree.h"
+#include "InvertedFile.h"
+#include "RotationIndexCache.h"
+
+#include <QtCore/QString>
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Descriptor store class.
+ *  @details    This class keeps in memory the descriptors of every model of a mesh collection. The
+ *              descriptors are read once from the feature files and stored as contiguous arrays where
+ *              each row corresponds to one model of the collection, so that comparisons against the
+ *              collection don't need to access the file system. When the collection has a packed
+ *              feature file, the arrays are views of the mapped file and no descriptor is copied; 
+ *              the models that are appended later are stored in memory after the mapped rows.
+ *              The rows of the removed models are kept until the store is detached, so the 
+ *              rows of the store can be more than its models.
+ *              The symmetry and harmonic descriptors that are compared with the queries can be kept
+ *              in a compressed copy (see setPrecision). Models can be appended and removed after the
+ *              collection is loaded (see CollectionJournal).
+ */
+class DescriptorStore final
+{
+public:
+
+    //// Constants /////
+
+    static constexpr unsigned int nShapeDistributions {5};     /**< Number of shape distributions. */
+
+    //// Enumerations /////
+
+    /**
+     *  @brief      Precision.
+     *  @details    Precision of the symmetry and harmonic descriptors that are compared with the 
+     *              queries (see CompressedTable).
+     */
+    enum class Precision : unsigned char {
+
+        Float64,        /**< The descriptors are compared in double precision. */
+
+        Float16,        /**< The descriptors are rounded to half precision. */
+
+        UInt8,          /**< The descriptors are quantized to 256 levels per element. */
+    };
+
+    /**
+     *  @brief      Load mode.
+     *  @details    Structures that are built when a collection is loaded.
+     */
+    enum class LoadMode : unsigned char {
+
+        Queries,        /**< The splines and the compressed copies that the queries compare are built. */
+
+        Updates,        /**< Only the descriptors are loaded, to append and remove models. */
+    };
+
+    //// Structures /////
+
+    /**
+     *  @brief      Descriptor table.
+     *  @details    Read-only view of a row-stacked array of descriptors. The first baseRows stored
+     *              rows start at data + r*stride, and the following ones are contiguous rows that 
+     *              start at tail. Each row contains columns elements. When models were removed, 
+     *              rowIndex contains the stored row of each model.
+     */
+    struct Table final {
+        const double* data {nullptr};       /**< First element of the base rows. */
+        std::size_t rows {0};               /**< Number of rows. */
+        std::size_t columns {0};            /**< Number of elements of each row. */
+        std::size_t stride {0};             /**< Distance between consecutive base rows in elements. */
+        std::size_t baseRows {0};           /**< Number of base rows. */
+        const double* tail {nullptr};       /**< First element of the rows after the base rows. */
+        const std::size_t* rowIndex {nullptr};  /**< Stored row of each model, or null if they are the same. */
+
+        /**
+         *  @brief      Row.
+         *  @details    This function returns the first element of the row of one model.
+         *  @param[in]  i  The index of the model.
+         *  @returns    The first element of the row.
+         */
+        const double* row(std::size_t i) const noexcept;
+
+        /**
+         *  @brief      Stored row.
+         *  @details    This function returns the first element of one stored row of the table,
+         *              which can belong to a removed model.
+         *  @param[in]  r  The index of the stored row.
+         *  @returns    The first element of the row.
+         */
+        const double* storedRow(std::size_t r) const noexcept;
+    };
+
+    /**
+     *  @brief      Model descriptors.
+     *  @details    Descriptors of one model of the collection.
+     */
+    struct Model final {
+        nct::RealVector sdHistograms[nShapeDistributions];  /**< Histogram of each shape distribution. */
+        nct::RealVector sdBins[nShapeDistributions];        /**< Bins of each shape distribution. */
+        nct::Matrix rsd;                                    /**< The nDir-by-2 reflexive symmetry descriptor. */
+        nct::Matrix hm;                                     /**< Harmonic descriptor. */
+    };
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes an empty store.
+     */
+    DescriptorStore() = default;
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    DescriptorStore(const DescriptorStore&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    DescriptorStore(DescriptorStore&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~DescriptorStore() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    DescriptorStore& operator=(const DescriptorStore&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    DescriptorStore& operator=(DescriptorStore&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Load descriptors.
+     *  @details    This function reads the descriptors of all the models of a collection. If the
+     *              feature path contains a packed feature file (FeatureFile::defaultFileName), the
+     *              descriptors are mapped from it. Otherwise, the per-model feature files are read.
+     *              The previous content of the store is replaced.
+     *  @param[in]  featurePath  Path of the feature files.
+     *  @param[in]  models  Array of models. The first column must contain the name of each model.
+     */
+    void load(const QString& featurePath, const nct::Array2D<QString>& models);
+
+    /**
+     *  @brief      Load per-model feature files.
+     *  @details    This function reads the descriptors of all the models of a collection from the
+     *              per-model feature files. The previous content of the store is replaced.
+     *  @param[in]  featurePath  Path of the feature files.
+     *  @param[in]  models  Array of models. The first column must contain the name of each model.
+     */
+    void loadFeatureFiles(const QString& featurePath, const nct::Array2D<QString>& models);
+
+    /**
+     *  @brief      Load packed feature file.
+     *  @details    This function maps a packed feature file and uses it as the storage of the
+     *              descriptors. The models of the file must be the same as the models of the
+     *              collection and must be stored in the same order. The previous content of the
+     *              store is replaced.
+     *  @param[in]  fileName  The name of the packed feature file.
+     *  @param[in]  models  Array of models. The first column must contain the name of each model.
+     */
+    void loadPackedFile(const QString& fileName, const nct::Array2D<QString>& models);
+
+    /**
+     *  @brief      Append model.
+     *  @details    This function adds the descriptors of one model at the end of the store. The 
+     *              model is stored in arrays that grow geometrically after the rows of the 
+     *              collection, which stay mapped from the packed feature file if there is one, and
+     *              the splines, the compressed copies and the search indices in memory are extended 
+     *              with the new model, so the cost doesn't depend on the size of the collection. 
+     *              This function is not thread safe.
+     *  @param[in]  model  The descriptors of the model. Their sizes must be the ones of the 
+     *              descriptors of the collection.
+     */
+    void append(const Model& model);
+
+    /**
+     *  @brief      Remove model.
+     *  @details    This function removes one model. Its row is only marked as removed (see 
+     *              removedRows): the rows stay in the tables, the compressed copies and the search
+     *              indices, which skip it, and they are dropped when the store is detached. The
+     *              following models take the previous index, so the cost is the displacement of the
+     *              indices of the rows, which is linear in the number of models. This function is 
+     *              not thread safe.
+     *  @param[in]  model  The index of the model.
+     */
+    void remove(std::size_t model);
+
+    /**
+     *  @brief      Remove last model.
+     *  @details    This function removes the last model, which must be stored in the last row 
+     *              after the rows mapped from the packed feature file. The row is dropped from the 
+     *              tables, the compressed copies and the search indices in memory, so it reverts 
+     *              append. This function is not thread safe.
+     */
+    void popBack();
+
+    /**
+     *  @brief      Detach store.
+     *  @details    This function copies the descriptors mapped from a packed feature file to memory
+     *              and releases the file, so that the file can be replaced. The rows of the removed
+     *              models are dropped, so the compressed copies are encoded again and the search 
+     *              indices are built again when they are requested. This function is not thread 
+     *              safe.
+     */
+    void detach();
+
+    /**
+     *  @brief      Clear store.
+     *  @details    This function releases all the descriptors.
+     */
+    void clear();
+
+    /**
+     *  @brief      Empty store.
+     *  @details    This function checks whether the store contains descriptors.
+     *  @returns    True if the store is empty.
+     */
+    bool empty() const noexcept;
+
+    /**
+     *  @brief      Number of models.
+     *  @details    This function returns the number of models in the store.
+     *  @returns    The number of models.
+     */
+    std::size_t numberOfModels() const noexcept;
+
+    /**
+     *  @brief      Removed rows.
+     *  @details    This function returns the tombstones of the stored rows, which are non-zero for
+     *              the rows of the removed models. The search indices are built over the stored 
+     *              rows, and their searches skip the removed ones. It is empty when no model was
+     *              removed since the store was loaded or detached.
+     *  @returns    The tombstones of the rows.
+     */
+    const std::vector<char>& removedRows() const noexcept;
+
+    /**
+     *  @brief      Shape distribution histograms.
+     *  @details    This function returns the histograms of one shape distribution. Each row
+     *              corresponds to one model.
+     *  @param[in]  dist  The shape distribution.
+     *  @returns    The histograms of the collection.
+     */
+    Table sdHistograms(nct::geometry::mesh::ShapeDistribution dist) const;
+
+    /**
+     *  @brief      Shape distribution bins.
+     *  @details    This function returns the histogram bins of one shape distribution. Each row
+     *              corresponds to one model.
+     *  @param[in]  dist  The shape distribution.
+     *  @returns    The bins of the collection.
+     */
+    Table sdBins(nct::geometry::mesh::ShapeDistribution dist) const;
+
+    /**
+     *  @brief      Shape distribution histogram.
+     *  @details    This function returns the histogram of one shape distribution of one model.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  model  The index of the model.
+     *  @returns    The histogram of the model.
+     */
+    nct::RealVector sdHistogram(nct::geometry::mesh::ShapeDistribution dist, std::size_t model) const;
+
+    /**
+     *  @brief      Shape distribution bins.
+     *  @details    This function returns the histogram bins of one shape distribution of one model.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  model  The index of the model.
+     *  @returns    The bins of the model.
+     */
+    nct::RealVector sdBins(nct::geometry::mesh::ShapeDistribution dist, std::size_t model) const;
+
+    /**
+     *  @brief      Shape distribution splines.
+     *  @details    This function returns the splines of one shape distribution. The splines are
+     *              built when the collection is loaded and are shared by every query. The angle 
+     *              distribution is compared without scaling, so its splines are not built. The 
+     *              spline of a model whose histogram can't be interpolated is left empty.
+     *  @param[in]  dist  The shape distribution.
+     *  @returns    The spline of each model of the collection.
+     */
+    const std::vector<nct::geometry::mesh::ShapeDistributionSpline>& sdSplines(
+        nct::geometry::mesh::ShapeDistribution dist) const;
+
+    /**
+     *  @brief      Reflexive symmetry descriptors.
+     *  @details    This function returns the reflexive symmetry descriptors of the collection. Each
+     *              row corresponds to one model and contains the nDir-by-2 descriptor in row order.
+     *  @returns    The descriptors of the collection.
+     */
+    Table rsdDescriptors() const noexcept;
+
+    /**
+     *  @brief      Reflexive symmetry descriptor.
+     *  @details    This function returns the reflexive symmetry descriptor of one model.
+     *  @param[in]  model  The index of the model.
+     *  @returns    The nDir-by-2 descriptor of the model.
+     */
+    nct::Matrix rsdDescriptor(std::size_t model) const;
+
+    /**
+     *  @brief      Harmonic descriptors.
+     *  @details    This function returns the harmonic descriptors of the collection. Each row
+     *              corresponds to one model and contains the descriptor matrix in row order.
+     *  @returns    The descriptors of the collection.
+     */
+    Table hmDescriptors() const noexcept;
+
+    /**
+     *  @brief      Rows of harmonic descriptors.
+     *  @details    This function returns the number of rows of the descriptor matrix of each model.
+     *  @returns    The number of rows of the harmonic descriptors.
+     */
+    std::size_t hmDescriptorRows() const noexcept;
+
+    /**
+     *  @brief      Harmonic descriptor.
+     *  @details    This function returns the flattened harmonic descriptor of one model.
+     *  @param[in]  model  The index of the model.
+     *  @returns    The descriptor of the model.
+     */
+    nct::RealVector hmDescriptor(std::size_t model) const;
+
+    /**
+     *  @brief      Set precision.
+     *  @details    This function sets the precision of the symmetry and harmonic descriptors that are
+     *              compared with the queries. The scans of the collection only read the compressed
+     *              descriptors, except with the minimum distance, which is too sensitive to rounding.
+     *              When the collection has a packed feature file, the compressed descriptors are 
+     *              mapped from it and the double-precision sections are only read by the search 
+     *              indices, the minimum distance and the functions that return the descriptors of 
+     *              one model, so they are not loaded by the scans. Otherwise, the compressed 
+     *              descriptors are a copy of the tables read from the per-model feature files. The
+     *              precision is kept when other collections are loaded. This function is not thread
+     *              safe.
+     *  @param[in]  precision  The precision.
+     */
+    void setPrecision(Precision precision);
+
+    /**
+     *  @brief      Precision.
+     *  @details    This function returns the precision of the descriptors that are compared with the
+     *              queries.
+     *  @returns    The precision.
+     */
+    Precision precision() const noexcept;
+
+    /**
+     *  @brief      Set load mode.
+     *  @details    This function sets the structures that are built when a collection is loaded
+     *              or a model is appended. A store that only appends and removes models doesn't
+     *              need the splines and the compressed copies. The mode is kept when other 
+     *              collections are loaded, and it must be set before they are loaded. This function
+     *              is not thread safe.
+     *  @param[in]  mode  The load mode.
+     */
+    void setLoadMode(LoadMode mode) noexcept;
+
+    /**
+     *  @brief      Load mode.
+     *  @details    This function returns the structures that are built when a collection is loaded.
+     *  @returns    The load mode.
+     */
+    LoadMode loadMode() const noexcept;
+
+    /**
+     *  @brief      Compared symmetry descriptor.
+     *  @details    This function copies one row of the table of symmetry descriptors to an array.
+     *  @param[in]  model  The index of the model.
+     *  @param[out]  out  The first of the elements where the row is stored.
+     *  @param[in]  compressed  True if the row is read with the precision of the store. Otherwise,
+     *              it is read in double precision.
+     */
+    void rsdRow(std::size_t model, double* out, bool compressed) const noexcept;
+
+    /**
+     *  @brief      Compared harmonic descriptor.
+     *  @details    This function copies one row of the table of harmonic descriptors to an array.
+     *  @param[in]  model  The index of the model.
+     *  @param[out]  out  The first of the elements where the row is stored.
+     *  @param[in]  compressed  True if the row is read with the precision of the store. Otherwise,
+     *              it is read in double precision.
+     */
+    void hmRow(std::size_t model, double* out, bool compressed) const noexcept;
+
+    /**
+     *  @brief      Compressed harmonic distance.
+     *  @details    This function checks whether the harmonic descriptors are compressed and a 
+     *              distance function can be calculated directly from them (see hmRowDistance).
+     *  @param[in]  f  The distance function.
+     *  @returns    True if hmRowDistance can be used.
+     */
+    bool hasHmRowDistance(nct::geometry::mesh::DistanceFunction f) const noexcept;
+
+    /**
+     *  @brief      Compressed harmonic distance.
+     *  @details    This function compares a descriptor with one row of the compressed harmonic 
+     *              descriptors without decoding the row first (see CompressedTable::distance). It 
+     *              can only be used when hasHmRowDistance is true.
+     *  @param[in]  model  The index of the model.
+     *  @param[in]  query  The descriptor.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  bound  The bound of the distance.
+     *  @returns    The distance, or a lower bound of it that is not smaller than the bound.
+     */
+    double hmRowDistance(std::size_t model, const nct::RealVector& query, 
+        nct::geometry::mesh::DistanceFunction f, double bound = std::numeric_limits<double>::infinity()) const;
+
+    /**
+     *  @brief      Compared size.
+     *  @details    This function returns the memory of the symmetry and harmonic descriptors that are
+     *              read by the scans of the collection.
+     *  @returns    The size in bytes.
+     */
+    std::size_t comparedSize() const noexcept;
+
+    /**
+     *  @brief      Harmonic matrices.
+     *  @details    This function returns the matrices that are shared by the collection to calculate
+     *              harmonic descriptors.
+     *  @returns    The harmonic matrices.
+     */
+    const nct::geometry::RasterizedObject3D::HarmonicMatrices& harmonicMatrices() const noexcept;
+
+    /**
+     *  @brief      Rotation indices.
+     *  @details    This function returns the rotation index table that is used to compare the
+     *              symmetry descriptors. The tables are calculated once and stored next to the 
+     *              feature files of the collection (see RotationIndexCache). This function is thread 
+     *              safe.
+     *  @param[in]  nVox  The number of divisions of the rasterized objects.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The rotation indices.
+     */
+    std::shared_ptr<const RotationIndexCache::Indices> rotationIndices(unsigned int nVox, 
+        unsigned int nTestAngles) const;
+
+    /**
+     *  @brief      Rotation sources.
+     *  @details    This function returns the inverse of the rotation index table, which is used to
+     *              compare the symmetry descriptors without copying the rotated descriptors (see
+     *              RotationIndexCache). This function is thread safe.
+     *  @param[in]  nVox  The number of divisions of the rasterized objects.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The rotation sources.
+     */
+    std::shared_ptr<const RotationIndexCache::Sources> rotationSources(unsigned int nVox, 
+        unsigned int nTestAngles) const;
+
+    /**
+     *  @brief      Shape distribution tree.
+     *  @details    This function returns the metric tree of the histograms of a shape distribution
+     *              (see MetricTree). Only the angle distribution can be indexed: the other 
+     *              distributions are compared at the scale that minimizes their distance, and that
+     *              minimum doesn't satisfy the triangle inequality. The tree is built the first time
+     *              that it is requested and stored next to the feature files of the collection, from 
+     *              where it is read the next time. This function is thread safe.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  cdf  True if the tree compares the cumulative distributions.
+     *  @returns    The metric tree.
+     */
+    std::shared_ptr<const MetricTree> sdTree(nct::geometry::mesh::ShapeDistribution dist, 
+        nct::geometry::mesh::DistanceFunction f, bool cdf) const;
+
+    /**
+     *  @brief      Harmonic descriptor tree.
+     *  @details    This function returns the metric tree of the harmonic descriptors (see 
+     *              MetricTree). The tree is built the first time that it is requested and stored 
+     *              next to the feature files of the collection, from where it is read the next time. 
+     *              This function is thread safe.
+     *  @param[in]  f  The distance function.
+     *  @returns    The metric tree.
+     */
+    std::shared_ptr<const MetricTree> hmTree(nct::geometry::mesh::DistanceFunction f) const;
+
+    /**
+     *  @brief      Harmonic descriptor inverted file.
+     *  @details    This function returns the inverted file of the harmonic descriptors (see 
+     *              InvertedFile). The cells are built the first time that they are requested and 
+     *              stored next to the feature files of the collection, from where they are read the
+     *              next time. This function is thread safe.
+     *  @param[in]  nCells  The number of cells. If it is zero, the default number of cells is used.
+     *  @returns    The inverted file.
+     */
+    std::shared_ptr<const InvertedFile> hmInvertedFile(std::size_t nCells) const;
+
+    /**
+     *  @brief      Shape distribution suffix.
+     *  @details    This function returns the suffix of the feature files of one shape distribution.
+     *  @param[in]  dist  The shape distribution.
+     *  @returns    The suffix of the files.
+     */
+    static QString sdSuffix(nct::geometry::mesh::ShapeDistribution dist);
+
+    /**
+     *  @brief      Decode matrix.
+     *  @details    This function decodes a matrix stored in a binary array file.
+     *  @param[in]  arrayFile  The binary file with the data.
+     *  @returns    The decoded matrix.
+     */
+    static nct::Matrix decodeMatrixFile(const QString& arrayFile);
+
+    /**
+     *  @brief      Decode vector.
+     *  @details    This function decodes a vector stored in a binary array file.
+     *  @param[in]  arrayFile  The binary file with the data.
+     *  @returns    The decoded vector.
+     */
+    static nct::RealVector decodeVectorFile(const QString& arrayFile);
+
+    /**
+     *  @brief      Decode harmonic array.
+     *  @details    This function decodes an array of harmonic funtions stored in a binary array file.
+     *  @param[in]  arrayFile  The binary file with the data.
+     *  @returns    The decoded array.
+     */
+    static nct::Array<nct::signal::spherical_harmonics::SphericalHarmonic> decodeHarmonicFile(
+        const QString& arrayFile);
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Indexed tree.
+     *  @details    Metric tree and the descriptors that it indexes.
+     */
+    struct IndexedTree final {
+        std::shared_ptr<MetricTree> tree;   /**< Metric tree. */
+        const Table* table {nullptr};       /**< Indexed descriptors. */
+        bool cdf {false};                   /**< True if the cumulative sums of the descriptors are indexed. */
+    };
+
+    //// Methods /////
+
+    /**
+     *  @brief      Update tables.
+     *  @details    This function points the descriptor tables to the matrices owned by the store,
+     *              which contain the rows after the mapped rows. The rows of the matrices after the 
+     *              stored rows are spare capacity.
+     */
+    void updateTables();
+
+    /**
+     *  @brief      Model row.
+     *  @details    This function returns the stored row of one model.
+     *  @param[in]  model  The index of the model.
+     *  @returns    The index of the row.
+     */
+    std::size_t modelRow(std::size_t model) const noexcept;
+
+    /**
+     *  @brief      Reserve rows.
+     *  @details    This function ensures that the matrices owned by the store can hold one more 
+     *              row. The capacity is doubled when it is exhausted.
+     *  @param[in]  model  The descriptors of the next model, which define the columns of an empty
+     *              store.
+     */
+    void reserve(const Model& model);
+
+    /**
+     *  @brief      Build splines.
+     *  @details    This function builds the splines of the shape distributions of every model.
+     */
+    void buildSplines();
+
+    /**
+     *  @brief      Compress tables.
+     *  @details    This function builds the compressed copies of the symmetry and harmonic 
+     *              descriptors with the precision of the store. The compressed sections of a packed
+     *              feature file are mapped, and only the rows appended after them are encoded.
+     */
+    void compress();
+
+    /**
+     *  @brief      Metric tree.
+     *  @details    This function returns a metric tree from memory, from the directory of the 
+     *              collection or built from a table, in that order.
+     *  @param[in]  name  The name of the file of the tree.
+     *  @param[in]  table  The descriptors. It must be one of the tables of the store.
+     *  @param[in]  cdf  True if the cumulative sums of the descriptors are indexed.
+     *  @param[in]  f  The distance function.
+     *  @returns    The metric tree.
+     */
+    std::shared_ptr<const MetricTree> metricTree(const QString& name, const Table* table, bool cdf,
+        nct::geometry::mesh::DistanceFunction f) const;
+
+    /**
+     *  @brief      Indexed descriptor.
+     *  @details    This function copies the descriptor of one stored row of a table as it is 
+     *              indexed by the metric trees.
+     *  @param[in]  table  The descriptors.
+     *  @param[in]  r  The index of the stored row.
+     *  @param[in]  cdf  True if the cumulative sum of the descriptor is indexed.
+     *  @param[out]  out  The first of the elements where the descriptor is stored.
+     */
+    static void indexedDescriptor(const Table& table, std::size_t r, bool cdf, double* out);
+
+    //// Member variables ////
+
+    std::size_t nModels_ {0};                               /**< Number of models. */
+
+    std::size_t nRows_ {0};                                 /**< Number of stored rows. */
+
+    std::vector<char> removed_;                             /**< Tombstones of the stored rows. */
+
+    std::vector<std::size_t> rowIndex_;                     /**< Stored row of each model. */
+
+    std::size_t baseRows_ {0};                              /**< Number of rows mapped from the file. */
+
+    Table sdHistogramTables_[nShapeDistributions];          /**< Histograms of each shape distribution. */
+
+    Table sdBinTables_[nShapeDistributions];                /**< Bins of each shape distribution. */
+
+    Table rsdTable_;                                        /**< Reflexive symmetry descriptors. */
+
+    Table hmTable_;                                         /**< Harmonic descriptors. */
+
+    std::size_t hmRows_ {0};                                /**< Rows of each harmonic descriptor. */
+
+    nct::Matrix sdHistograms_[nShapeDistributions];         /**< Storage of the histograms. */
+
+    nct::Matrix sdBins_[nShapeDistributions];               /**< Storage of the bins. */
+
+    /** Splines of each shape distribution. */
+    std::vector<nct::geometry::mesh::ShapeDistributionSpline> sdSplines_[nShapeDistributions];
+
+    nct::Matrix rsd_;                                       /**< Storage of the symmetry descriptors. */
+
+    nct::Matrix hm_;                                        /**< Storage of the harmonic descriptors. */
+
+    std::unique_ptr<FeatureFile> file_;                     /**< Packed feature file. */
+
+    nct::geometry::RasterizedObject3D::HarmonicMatrices hmat_;  /**< Harmonic matrices. */
+
+    Precision precision_ {Precision::Float64};              /**< Precision of the compared descriptors. */
+
+    LoadMode loadMode_ {LoadMode::Queries};                 /**< Structures built when models are loaded. */
+
+    CompressedTable rsdCompressed_;                         /**< Compressed symmetry descriptors. */
+
+    CompressedTable hmCompressed_;                          /**< Compressed harmonic descriptors. */
+
+    mutable RotationIndexCache rotations_;                  /**< Rotation index tables. */
+
+    mutable std::mutex treeMutex_;                          /**< Mutex that protects the search indices. */
+
+    /** Metric trees indexed by file name. */
+    mutable std::map<QString, IndexedTree> trees_;
+
+    /** Inverted files indexed by file name. */
+    mutable std::map<QString, std::shared_ptr<InvertedFile>> invertedFiles_;
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
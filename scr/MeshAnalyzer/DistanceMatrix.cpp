@@ -0,0 +1,290 @@
+//=================================================================================================================
+/**
+ *  @file       DistanceMatrix.cpp
+ *  @brief      DistanceMatrix class implementation file.
+ *  @details    This file contains the implementation of the DistanceMatrix class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "DistanceMatrix.h"
+#include "QueryCache.h"
+
+#include "nct/nct_exception.h"
+#include "nct/nct_utils.h"
+
+#include <QtCore/QFile>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the distance matrix files.
+ */
+constexpr char distanceMatrixMagic[8] {'A', 'T', 'D', 'I', 'S', 'M', 'A', 'T'};
+
+/**
+ *  @brief      Matrix alignment.
+ *  @details    Alignment of the distances in the file, so that they start in a page of the mapping.
+ */
+constexpr std::uint64_t matrixAlignment {4096};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the distance matrix files. It is followed by one
+ *              byte per block of the square grid, which is 1 if the block was calculated, and by 
+ *              the distances at the aligned offset.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t blockSize {0};            /**< Number of models of each block. */
+    std::uint64_t nModels {0};              /**< Number of models. */
+    std::uint64_t key {0};                  /**< Key of the descriptor, the parameters and the collection. */
+    std::uint64_t offset {0};               /**< Offset of the distances. */
+    std::uint64_t reserved {0};             /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 48, "Unexpected size of the file header.");
+
+/**
+ *  @brief      File layout.
+ *  @details    This function fills the offset of the distances of a header.
+ *  @param[in, out]  header  The header.
+ *  @returns    The size of the file.
+ */
+std::uint64_t fileLayout(FileHeader& header)
+{
+    auto nBlocks = header.nModels/header.blockSize + (header.nModels % header.blockSize > 0);
+    header.offset = sizeof(FileHeader) + nBlocks*nBlocks;
+    header.offset = (header.offset + matrixAlignment - 1)/matrixAlignment*matrixAlignment;
+    return header.offset + header.nModels*header.nModels*sizeof(double);
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+DistanceMatrix::DistanceMatrix(const QueryEngine& engine, const Parameters& parameters, std::size_t blockSize) :
+    engine_(engine), parameters_(parameters), blockSize_(blockSize)
+{
+    if (blockSize_ == 0)
+        throw ArgumentException("blockSize", static_cast<unsigned long long>(blockSize_), 0ULL, 
+            RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    if (engine_.store()->numberOfModels() == 0)
+        throw OperationException("The collection doesn't contain models", "");
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t DistanceMatrix::key() const noexcept
+{
+    constexpr char tag[] {'A', 'T', 'D', 'M'};
+    auto key = QueryCache::combine(QueryCache::initialHash, tag);
+    key = QueryCache::combine(key, parameters_.collection);
+    key = QueryCache::combine(key, parameters_.descriptor);
+    key = QueryCache::combine(key, parameters_.f);
+
+    // Only the parameters of the compared descriptor change the distances.
+    if (parameters_.descriptor == Descriptor::ShapeDistribution) {
+        key = QueryCache::combine(key, parameters_.dist);
+        key = QueryCache::combine(key, parameters_.cdf);
+        key = QueryCache::combine(key, parameters_.nScales);
+        key = QueryCache::combine(key, parameters_.sIni);
+        key = QueryCache::combine(key, parameters_.sEnd);
+        key = QueryCache::combine(key, engine_.scaleSearch());
+        key = QueryCache::combine(key, engine_.scaleTolerance());
+        key = QueryCache::combine(key, engine_.scaleStep());
+    }
+    else if (parameters_.descriptor == Descriptor::SymmetryDescriptor) {
+        key = QueryCache::combine(key, parameters_.nRot);
+    }
+
+    return key;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t DistanceMatrix::numberOfBlocks() const noexcept
+{
+    auto nModels = engine_.store()->numberOfModels();
+    auto n = nModels/blockSize_ + (nModels % blockSize_ > 0);
+    return n*(n + 1)/2;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t DistanceMatrix::calculate(const QString& fileName) const
+{
+    auto nModels = engine_.store()->numberOfModels();
+    auto nBlocks = nModels/blockSize_ + (nModels % blockSize_ > 0);
+
+    FileHeader header;
+    std::memcpy(header.magic, distanceMatrixMagic, sizeof(distanceMatrixMagic));
+    header.version = version;
+    header.blockSize = static_cast<std::uint32_t>(blockSize_);
+    header.nModels = nModels;
+    header.key = key();
+    auto fileSize = fileLayout(header);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadWrite))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    // A file of other matrix is cleared; the new file is filled with zeros, so no block is marked.
+    FileHeader stored;
+    bool resume = (static_cast<std::uint64_t>(file.size()) == fileSize) && 
+        (file.read(reinterpret_cast<char*>(&stored), sizeof(FileHeader)) == sizeof(FileHeader)) &&
+        (std::memcmp(&stored, &header, sizeof(FileHeader)) == 0);
+
+    if (!resume) {
+        if (!file.resize(0) || !file.resize(static_cast<qint64>(fileSize)) || !file.seek(0) ||
+            (file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader)) != sizeof(FileHeader)) ||
+            !file.flush())
+            throw IOException(exc_error_writing_header, SOURCE_INFO);
+    }
+
+    auto base = file.map(0, static_cast<qint64>(fileSize));
+    if (base == nullptr)
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    auto done = base + sizeof(FileHeader);
+    auto matrix = reinterpret_cast<double*>(base + header.offset);
+
+    std::vector<std::pair<size_t, size_t>> pending;
+    for (size_t a = 0; a < nBlocks; a++) {
+        for (size_t b = a; b < nBlocks; b++) {
+            if (done[a*nBlocks + b] == 0)
+                pending.push_back({a, b});
+        }
+    }
+
+    auto engine = engine_;
+    engine.setThreads(1);
+    const auto& p = parameters_;
+
+    // The blocks of different pairs write disjoint elements of the matrix. A block is marked after
+    // its distances are stored.
+    try {
+        nct::parallel_for(static_cast<size_t>(0), pending.size(), engine_.threads(), [&](size_t k) {
+            auto [a, b] = pending[k];
+            auto firstRow = a*blockSize_;
+            auto lastRow = std::min(firstRow + blockSize_, nModels);
+            auto firstColumn = b*blockSize_;
+            auto lastColumn = std::min(firstColumn + blockSize_, nModels);
+
+            Matrix distances;
+            if (p.descriptor == Descriptor::ShapeDistribution)
+                distances = engine.compareShapeDistributions(firstRow, lastRow, firstColumn, lastColumn, 
+                    p.dist, p.f, p.cdf, p.nScales, p.sIni, p.sEnd);
+            else if (p.descriptor == Descriptor::SymmetryDescriptor)
+                distances = engine.compareSymmetryDescriptors(firstRow, lastRow, firstColumn, lastColumn, 
+                    p.nRot, p.f);
+            else
+                distances = engine.compareHarmonicDescriptors(firstRow, lastRow, firstColumn, lastColumn, p.f);
+
+            for (size_t i = firstRow; i < lastRow; i++) {
+                if (a == b)
+                    matrix[i*nModels + i] = 0;
+                for (size_t j = std::max(firstColumn, i + 1); j < lastColumn; j++) {
+                    auto d = distances(i - firstRow, j - firstColumn);
+                    matrix[i*nModels + j] = d;
+                    matrix[j*nModels + i] = d;
+                }
+            }
+
+            done[a*nBlocks + b] = 1;
+        });
+    }
+    catch (...) {
+        file.unmap(base);
+        throw;
+    }
+
+    if (!file.unmap(base))
+        throw IOException(exc_error_writing_ouput_file, SOURCE_INFO);
+
+    return pending.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix DistanceMatrix::read(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+    FileHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)) != sizeof(FileHeader))
+        throw IOException(exc_error_reading_file_header, SOURCE_INFO);
+
+    if (std::memcmp(header.magic, distanceMatrixMagic, sizeof(distanceMatrixMagic)) != 0)
+        throw IOException(exc_bad_magic_key, SOURCE_INFO);
+
+    if ((header.version == 0) || (header.version > version))
+        throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+    auto expected = header;
+    if ((header.nModels == 0) || (header.blockSize == 0) || 
+        (fileLayout(expected) != static_cast<std::uint64_t>(file.size())) || (expected.offset != header.offset))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    auto nModels = static_cast<size_t>(header.nModels);
+    auto base = file.map(0, file.size());
+    if (base == nullptr)
+        throw IOException(exc_error_reading_input_file, SOURCE_INFO);
+
+    auto nBlocks = nModels/header.blockSize + (nModels % header.blockSize > 0);
+    auto done = base + sizeof(FileHeader);
+    for (size_t a = 0; a < nBlocks; a++) {
+        for (size_t b = a; b < nBlocks; b++) {
+            if (done[a*nBlocks + b] == 0) {
+                file.unmap(base);
+                throw OperationException("The distance matrix is incomplete", "");
+            }
+        }
+    }
+
+    Matrix distances(nModels, nModels);
+    std::memcpy(distances.data(), base + header.offset, nModels*nModels*sizeof(double));
+    file.unmap(base);
+
+    return distances;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,196 @@
+//=================================================================================================================
+/**
+ *  @file       DistanceMatrix.h
+ *  @brief      DistanceMatrix class.
+ *  @details    Declaration file of the DistanceMatrix class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+#ifndef DISTANCE_MATRIX_H_INCLUDE
+#define DISTANCE_MATRIX_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "QueryEngine.h"
+
+#include "nct/nct.h"
+#include "nct/Array2D.h"
+#include "nct/geometry/mesh.h"
+
+#include <QtCore/QString>
+
+#include <cstdint>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Distance matrix class.
+ *  @details    This class calculates the distances between every pair of models of a collection
+ *              for one descriptor, for example to group them with nct::clustering::SpectralClustering. 
+ *              Only the upper triangle is calculated: model i is compared as a query with every 
+ *              model j > i, and the distance is stored in both (i, j) and (j, i), so the matrix is
+ *              exactly symmetric. The triangle is split in square blocks of models whose 
+ *              descriptors stay in the cache while they are compared, and the blocks are calculated
+ *              in parallel with the threads of the query engine.
+ *
+ *              The matrix is written in a memory-mapped file as N rows of N doubles after a header
+ *              and a table with the state of each block. Each calculated block is marked in the 
+ *              file, so an interrupted calculation resumes with the blocks that are missing. The
+ *              file keeps a key of the descriptor, the comparison parameters and the collection,
+ *              and the blocks of a file with another key are calculated again.
+ */
+class DistanceMatrix final
+{
+public:
+
+    //// Enumerations /////
+
+    /**
+     *  @brief      Descriptors.
+     *  @details    Descriptors that can be compared.
+     */
+    enum class Descriptor : unsigned char {
+        ShapeDistribution,                                  /**< Shape distribution. */
+        SymmetryDescriptor,                                 /**< Reflexive symmetry descriptor. */
+        HarmonicDescriptor                                  /**< Harmonic descriptor. */
+    };
+
+    //// Types /////
+
+    /**
+     *  @brief      Parameters.
+     *  @details    Parameters of the comparison of the models.
+     */
+    struct Parameters final {
+        Descriptor descriptor {Descriptor::HarmonicDescriptor};     /**< Compared descriptor. */
+        nct::geometry::mesh::ShapeDistribution dist {nct::geometry::mesh::ShapeDistribution::CentroidDistance};
+                                                                    /**< Shape distribution. */
+        nct::geometry::mesh::DistanceFunction f {nct::geometry::mesh::DistanceFunction::EuclideanDistance};
+                                                                    /**< Distance function. */
+        bool cdf {false};                                   /**< True if the cumulative distributions are compared. */
+        unsigned int nRot {8};                              /**< Number of rotations of the symmetry descriptors. */
+        unsigned int nScales {256};                         /**< Number of scales of the shape distributions. */
+        double sIni {-10};                                  /**< Log of the first scale. */
+        double sEnd {10};                                   /**< Log of the last scale. */
+        std::uint64_t collection {0};                       /**< Key of the collection. */
+    };
+
+    //// Constants /////
+
+    static constexpr std::uint32_t version {1};             /**< Current version of the format. */
+
+    static constexpr std::size_t defaultBlockSize {64};     /**< Default number of models per block. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the calculation of a distance matrix.
+     *  @param[in]  engine  The query engine of the collection.
+     *  @param[in]  parameters  The parameters of the comparison.
+     *  @param[in]  blockSize  The number of models of each block.
+     */
+    DistanceMatrix(const QueryEngine& engine, const Parameters& parameters, 
+        std::size_t blockSize = defaultBlockSize);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    DistanceMatrix(const DistanceMatrix&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    DistanceMatrix(DistanceMatrix&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~DistanceMatrix() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    DistanceMatrix& operator=(const DistanceMatrix&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    DistanceMatrix& operator=(DistanceMatrix&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Key.
+     *  @details    This function returns the key of the descriptor, the parameters and the collection
+     *              that is stored in the files.
+     *  @returns    The key.
+     */
+    std::uint64_t key() const noexcept;
+
+    /**
+     *  @brief      Number of blocks.
+     *  @details    This function returns the number of blocks of the upper triangle.
+     *  @returns    The number of blocks.
+     */
+    std::size_t numberOfBlocks() const noexcept;
+
+    /**
+     *  @brief      Calculate.
+     *  @details    This function calculates the blocks of the matrix that are missing in a file. The 
+     *              file is created if it doesn't exist or if it belongs to other matrix.
+     *  @param[in]  fileName  The name of the file.
+     *  @returns    The number of blocks that were calculated.
+     */
+    std::size_t calculate(const QString& fileName) const;
+
+    /**
+     *  @brief      Read matrix.
+     *  @details    This function reads a complete distance matrix from a file. The result can be given
+     *              to the distance-matrix constructors of nct::clustering::SpectralClustering.
+     *  @param[in]  fileName  The name of the file.
+     *  @returns    The N-by-N matrix of distances.
+     */
+    static nct::Matrix read(const QString& fileName);
+
+private:
+
+    //// Member variables ////
+
+    QueryEngine engine_;                                    /**< Query engine of the collection. */
+
+    Parameters parameters_;                                 /**< Parameters of the comparison. */
+
+    std::size_t blockSize_ {defaultBlockSize};              /**< Number of models of each block. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
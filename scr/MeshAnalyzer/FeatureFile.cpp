@@ -0,0 +1,537 @@
+//=================================================================================================================
+/**
+ *  @file       FeatureFile.cpp
+ *  @brief      FeatureFile class implementation file.
+ *  @details    This file contains the implementation of the FeatureFile class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "FeatureFile.h"
+#include "CompressedTable.h"
+#include "DescriptorStore.h"
+
+#include "nct/nct_exception.h"
+
+#include <QtCore/QSaveFile>
+
+#include <cstring>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the packed feature files.
+ */
+constexpr char featureFileMagic[8] {'A', 'T', 'F', 'E', 'A', 'T', 'S', '\0'};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the packed feature files.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t nSections {0};            /**< Number of sections. */
+    std::uint64_t nModels {0};              /**< Number of models. */
+    std::uint64_t sectionTableOffset {0};   /**< Offset of the section table. */
+    std::uint64_t namesOffset {0};          /**< Offset of the name index. */
+    std::uint64_t namesSize {0};            /**< Size of the name index in bytes. */
+    std::uint64_t fileSize {0};             /**< Size of the file in bytes. */
+    std::uint64_t reserved {0};             /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 64, "Unexpected size of the file header.");
+static_assert(sizeof(FeatureFile::Section) == 64, "Unexpected size of the section entries.");
+
+/**
+ *  @brief      Align offset.
+ *  @details    This function rounds an offset up to a multiple of FeatureFile::alignment.
+ *  @param[in]  offset  The offset to align.
+ *  @returns    The aligned offset.
+ */
+std::uint64_t alignOffset(std::uint64_t offset)
+{
+    return ((offset + FeatureFile::alignment - 1) / FeatureFile::alignment) * FeatureFile::alignment;
+}
+
+/**
+ *  @brief      Section data.
+ *  @details    Data of one section that will be written in a feature file.
+ */
+struct SectionSource final {
+    FeatureFile::Section entry;             /**< Entry of the section table. */
+    const char* data {nullptr};             /**< First byte of the source data. */
+    std::uint64_t sourceStride {0};         /**< Distance between source rows in bytes. */
+    std::uint64_t baseRows {0};             /**< Number of source rows that start at data. */
+    const char* tail {nullptr};             /**< First byte of the contiguous rows after the base rows. */
+    const std::size_t* rowIndex {nullptr};  /**< Source row of each row, or null if they are the same. */
+};
+
+/**
+ *  @brief      Make section.
+ *  @details    This function initializes a section of double-precision values.
+ *  @param[in]  id  The identifier of the section.
+ *  @param[in]  data  The first element of the source data.
+ *  @param[in]  rows  The number of rows.
+ *  @param[in]  columns  The number of elements of each row.
+ *  @param[in]  sourceStride  The distance between source rows in elements.
+ *  @param[in]  padRows  True if the rows must be padded to the file alignment.
+ *  @returns    The section data.
+ */
+SectionSource makeSection(std::uint32_t id, const double* data, std::uint64_t rows,
+    std::uint64_t columns, std::uint64_t sourceStride, bool padRows)
+{
+    SectionSource s;
+    s.entry.id = id;
+    s.entry.type = static_cast<std::uint32_t>(FeatureFile::ElementType::Float64);
+    s.entry.rows = rows;
+    s.entry.columns = columns;
+    s.entry.stride = padRows ? alignOffset(columns*sizeof(double)) : columns*sizeof(double);
+    s.entry.size = rows*s.entry.stride;
+    s.entry.dim0 = rows;
+    s.entry.dim1 = columns;
+    s.data = reinterpret_cast<const char*>(data);
+    s.sourceStride = sourceStride*sizeof(double);
+    s.baseRows = rows;
+    return s;
+}
+
+/**
+ *  @brief      Make section.
+ *  @details    This function initializes a section with the descriptors of a table of a store. 
+ *              The rows of the removed models are not written.
+ *  @param[in]  id  The identifier of the section.
+ *  @param[in]  table  The descriptors.
+ *  @returns    The section data.
+ */
+SectionSource makeSection(std::uint32_t id, const DescriptorStore::Table& table)
+{
+    auto s = makeSection(id, table.data, table.rows, table.columns, table.stride, true);
+    s.baseRows = table.baseRows;
+    s.tail = reinterpret_cast<const char*>(table.tail);
+    s.rowIndex = table.rowIndex;
+    return s;
+}
+
+/**
+ *  @brief      Make section.
+ *  @details    This function initializes a section with the elements of a compressed table. The
+ *              rows are not padded.
+ *  @param[in]  id  The identifier of the section.
+ *  @param[in]  table  The compressed descriptors.
+ *  @returns    The section data.
+ */
+SectionSource makeSection(std::uint32_t id, const CompressedTable& table)
+{
+    SectionSource s;
+    s.entry.id = id;
+    s.entry.type = static_cast<std::uint32_t>(table.encoding() == CompressedTable::Encoding::Float16 ?
+        FeatureFile::ElementType::Float16 : FeatureFile::ElementType::UInt8);
+    s.entry.rows = table.rows();
+    s.entry.columns = table.columns();
+    s.entry.stride = table.columns()*table.elementSize();
+    s.entry.size = s.entry.rows*s.entry.stride;
+    s.entry.dim0 = s.entry.rows;
+    s.entry.dim1 = s.entry.columns;
+    s.data = reinterpret_cast<const char*>(table.encodedRow(0));
+    s.sourceStride = s.entry.stride;
+    s.baseRows = s.entry.rows;
+    return s;
+}
+
+/**
+ *  @brief      Write bytes.
+ *  @details    This function writes a block of bytes in a file.
+ *  @param[in, out]  file  The output file.
+ *  @param[in]  data  The data to write.
+ *  @param[in]  size  The number of bytes to write.
+ */
+void writeBytes(QFileDevice& file, const char* data, std::uint64_t size)
+{
+    if (file.write(data, static_cast<qint64>(size)) != static_cast<qint64>(size))
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+/**
+ *  @brief      Write padding.
+ *  @details    This function writes zeros until the file position is the specified offset.
+ *  @param[in, out]  file  The output file.
+ *  @param[in]  offset  The target offset.
+ */
+void writePadding(QFileDevice& file, std::uint64_t offset)
+{
+    static const char zeros[FeatureFile::alignment] {};
+    auto pos = static_cast<std::uint64_t>(file.pos());
+    while (pos < offset) {
+        auto n = std::min<std::uint64_t>(offset - pos, FeatureFile::alignment);
+        writeBytes(file, zeros, n);
+        pos += n;
+    }
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+FeatureFile::FeatureFile(const QString& fileName)
+{
+    open(fileName);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+FeatureFile::~FeatureFile()
+{
+    close();
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void FeatureFile::open(const QString& fileName)
+{
+    close();
+
+    try {
+        file_.setFileName(fileName);
+        if (!file_.open(QIODevice::ReadOnly))
+            throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+        size_ = static_cast<std::uint64_t>(file_.size());
+        if (size_ < sizeof(FileHeader))
+            throw IOException(exc_error_reading_file_header, SOURCE_INFO);
+
+        // Map the whole file. Files that cannot be mapped (i.e. compressed resources) are read at once.
+        base_ = file_.map(0, static_cast<qint64>(size_));
+        if (base_ == nullptr) {
+            buffer_ = file_.readAll();
+            if (static_cast<std::uint64_t>(buffer_.size()) != size_)
+                throw IOException(exc_error_reading_data, SOURCE_INFO);
+            base_ = reinterpret_cast<const unsigned char*>(buffer_.constData());
+        }
+
+        // Header.
+        FileHeader header;
+        std::memcpy(&header, base_, sizeof(FileHeader));
+
+        if (std::memcmp(header.magic, featureFileMagic, sizeof(featureFileMagic)) != 0)
+            throw IOException(exc_bad_magic_key, SOURCE_INFO);
+
+        if ((header.version == 0) || (header.version > version))
+            throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+        // The offsets and sizes of a damaged file can be close to the maximum integer, so the 
+        // bounds are compared with the remaining bytes instead of adding or multiplying them.
+        if ((header.fileSize != size_) ||
+            (header.sectionTableOffset > size_) ||
+            (header.nSections > (size_ - header.sectionTableOffset)/sizeof(Section)) ||
+            (header.namesOffset > size_) || (header.namesSize > size_ - header.namesOffset) ||
+            (header.nModels >= header.namesSize/sizeof(std::uint64_t)))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+        // Section table.
+        sections_.resize(header.nSections);
+        std::memcpy(sections_.data(), base_ + header.sectionTableOffset, header.nSections*sizeof(Section));
+
+        for (const auto& s : sections_) {
+            auto size = elementSize(s.type);
+            if (size == 0)
+                throw IOException(exc_bad_data_type_in_file, SOURCE_INFO);
+
+            if ((s.offset % alignment != 0) || (s.offset > size_) || (s.size > size_ - s.offset) ||
+                (s.columns > s.stride/size) || ((s.stride > 0) && (s.rows > s.size/s.stride)))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+        }
+
+        // Name index.
+        auto offsets = reinterpret_cast<const std::uint64_t*>(base_ + header.namesOffset);
+        auto namesDataSize = header.namesSize - (header.nModels + 1)*sizeof(std::uint64_t);
+        for (std::uint64_t i = 0; i < header.nModels; i++) {
+            if ((offsets[i] > offsets[i + 1]) || (offsets[i + 1] > namesDataSize))
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+        }
+
+        nModels_ = header.nModels;
+        namesOffset_ = header.namesOffset;
+    }
+    catch (...) {
+        close();
+        throw;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FeatureFile::close()
+{
+    if ((base_ != nullptr) && buffer_.isEmpty())
+        file_.unmap(const_cast<unsigned char*>(base_));
+
+    file_.close();
+    buffer_ = QByteArray();
+    base_ = nullptr;
+    size_ = 0;
+    nModels_ = 0;
+    namesOffset_ = 0;
+    sections_.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool FeatureFile::isOpen() const noexcept
+{
+    return base_ != nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t FeatureFile::numberOfModels() const noexcept
+{
+    return static_cast<std::size_t>(nModels_);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<QString> FeatureFile::modelNames() const
+{
+    Array<QString> names(static_cast<size_t>(nModels_));
+    if (base_ == nullptr)
+        return names;
+
+    auto offsets = reinterpret_cast<const std::uint64_t*>(base_ + namesOffset_);
+    auto chars = reinterpret_cast<const char*>(offsets + nModels_ + 1);
+    for (size_t i = 0; i < names.size(); i++)
+        names[i] = QString::fromUtf8(chars + offsets[i], static_cast<qsizetype>(offsets[i + 1] - offsets[i]));
+
+    return names;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const FeatureFile::Section* FeatureFile::section(std::uint32_t id) const noexcept
+{
+    for (const auto& s : sections_)
+        if (s.id == id)
+            return &s;
+
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const FeatureFile::Section* FeatureFile::section(SectionId id) const noexcept
+{
+    return section(static_cast<std::uint32_t>(id));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const unsigned char* FeatureFile::data(const Section& s) const noexcept
+{
+    return base_ + s.offset;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t FeatureFile::elementSize(std::uint32_t type) noexcept
+{
+    switch (static_cast<ElementType>(type)) {
+        case ElementType::Float64:
+            return sizeof(double);
+        case ElementType::Int32:
+            return sizeof(std::int32_t);
+        case ElementType::Float16:
+            return sizeof(std::uint16_t);
+        case ElementType::UInt8:
+            return sizeof(std::uint8_t);
+        default:
+            return 0;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FeatureFile::write(const QString& fileName, const DescriptorStore& store,
+    const nct::Array<QString>& modelNames)
+{
+    std::uint64_t nModels = store.numberOfModels();
+    if (modelNames.size() != nModels)
+        throw ArgumentException("modelNames", exc_bad_array_size, SOURCE_INFO);
+
+    // Sections.
+    std::vector<SectionSource> sections;
+
+    for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++) {
+        auto dist = static_cast<geometry::mesh::ShapeDistribution>(k);
+        auto h = store.sdHistograms(dist);
+        auto b = store.sdBins(dist);
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::SdHistograms) + k, h));
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::SdBins) + k, b));
+    }
+
+    auto rsd = store.rsdDescriptors();
+    sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::Rsd), rsd));
+    sections.back().entry.dim0 = rsd.columns/2;
+    sections.back().entry.dim1 = 2;
+
+    auto hm = store.hmDescriptors();
+    sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::Hm), hm));
+    sections.back().entry.dim0 = store.hmDescriptorRows();
+    sections.back().entry.dim1 = store.hmDescriptorRows() > 0 ? hm.columns/store.hmDescriptorRows() : 0;
+
+    // Compressed descriptors. The 8-bit codes are followed by the minimum value and the code step 
+    // of each column.
+    std::vector<CompressedTable> compressed;
+    std::vector<Matrix> ranges;
+    auto compress = [&](const DescriptorStore::Table& table) {
+        auto row = [&table](size_t i) { return table.row(i); };
+        compressed.emplace_back(table.rows, table.columns, row, CompressedTable::Encoding::Float16);
+        compressed.emplace_back(table.rows, table.columns, row, CompressedTable::Encoding::UInt8);
+
+        auto& codes = compressed.back();
+        Matrix r(2, table.columns);
+        std::copy(codes.minimum().begin(), codes.minimum().end(), &r(0, 0));
+        std::copy(codes.step().begin(), codes.step().end(), &r(1, 0));
+        ranges.push_back(std::move(r));
+    };
+
+    compressed.reserve(4);
+    ranges.reserve(2);
+    if (nModels > 0) {
+        compress(rsd);
+        compress(hm);
+
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::RsdFloat16), compressed[0]));
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::RsdUInt8), compressed[1]));
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::RsdUInt8Ranges),
+            ranges[0].data(), 2, rsd.columns, rsd.columns, false));
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::HmFloat16), compressed[2]));
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::HmUInt8), compressed[3]));
+        sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::HmUInt8Ranges),
+            ranges[1].data(), 2, hm.columns, hm.columns, false));
+    }
+
+    const auto& hmat = store.harmonicMatrices();
+    std::vector<std::int32_t> orders(2*hmat.hB.size());
+    for (size_t i = 0; i < hmat.hB.size(); i++) {
+        orders[2*i] = hmat.hB[i].l;
+        orders[2*i + 1] = hmat.hB[i].m;
+    }
+
+    SectionSource hB;
+    hB.entry.id = static_cast<std::uint32_t>(SectionId::HarmonicOrders);
+    hB.entry.type = static_cast<std::uint32_t>(ElementType::Int32);
+    hB.entry.rows = hmat.hB.size();
+    hB.entry.columns = 2;
+    hB.entry.stride = 2*sizeof(std::int32_t);
+    hB.entry.size = hB.entry.rows*hB.entry.stride;
+    hB.entry.dim0 = hB.entry.rows;
+    hB.entry.dim1 = 2;
+    hB.data = reinterpret_cast<const char*>(orders.data());
+    hB.sourceStride = hB.entry.stride;
+    hB.baseRows = hB.entry.rows;
+    sections.push_back(hB);
+
+    sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::Theta),
+        hmat.theta.data(), 1, hmat.theta.size(), hmat.theta.size(), false));
+    sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::Phi),
+        hmat.phi.data(), 1, hmat.phi.size(), hmat.phi.size(), false));
+    sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::Bt),
+        hmat.Bt.data(), hmat.Bt.rows(), hmat.Bt.columns(), hmat.Bt.columns(), false));
+    sections.push_back(makeSection(static_cast<std::uint32_t>(SectionId::BtBI),
+        hmat.BtBI.data(), hmat.BtBI.rows(), hmat.BtBI.columns(), hmat.BtBI.columns(), false));
+
+    // Name index.
+    std::vector<QByteArray> names(static_cast<size_t>(nModels));
+    std::vector<std::uint64_t> nameOffsets(static_cast<size_t>(nModels) + 1, 0);
+    for (size_t i = 0; i < names.size(); i++) {
+        names[i] = modelNames[i].toUtf8();
+        nameOffsets[i + 1] = nameOffsets[i] + static_cast<std::uint64_t>(names[i].size());
+    }
+
+    // Layout.
+    FileHeader header;
+    std::memcpy(header.magic, featureFileMagic, sizeof(featureFileMagic));
+    header.version = version;
+    header.nSections = static_cast<std::uint32_t>(sections.size());
+    header.nModels = nModels;
+    header.sectionTableOffset = sizeof(FileHeader);
+
+    std::uint64_t offset = alignOffset(header.sectionTableOffset + sections.size()*sizeof(Section));
+    for (auto& s : sections) {
+        s.entry.offset = offset;
+        offset = alignOffset(offset + s.entry.size);
+    }
+
+    header.namesOffset = offset;
+    header.namesSize = nameOffsets.size()*sizeof(std::uint64_t) + nameOffsets.back();
+    header.fileSize = header.namesOffset + header.namesSize;
+
+    // Write file. The file is replaced atomically, so that a collection is never left with a 
+    // partial feature file.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    writeBytes(file, reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    for (const auto& s : sections)
+        writeBytes(file, reinterpret_cast<const char*>(&s.entry), sizeof(Section));
+
+    std::vector<char> row;
+    for (const auto& s : sections) {
+        writePadding(file, s.entry.offset);
+        auto rowSize = s.entry.columns*elementSize(s.entry.type);
+        row.assign(static_cast<size_t>(s.entry.stride), 0);
+        for (std::uint64_t i = 0; i < s.entry.rows; i++) {
+            std::uint64_t r = s.rowIndex != nullptr ? s.rowIndex[i] : i;
+            auto source = r < s.baseRows ? s.data + r*s.sourceStride : s.tail + (r - s.baseRows)*rowSize;
+            std::memcpy(row.data(), source, static_cast<size_t>(rowSize));
+            writeBytes(file, row.data(), s.entry.stride);
+        }
+    }
+
+    writePadding(file, header.namesOffset);
+    writeBytes(file, reinterpret_cast<const char*>(nameOffsets.data()), nameOffsets.size()*sizeof(std::uint64_t));
+    for (const auto& name : names)
+        writeBytes(file, name.constData(), static_cast<std::uint64_t>(name.size()));
+
+    if (!file.commit())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FeatureFile::convert(const QString& featurePath, const nct::Array2D<QString>& models,
+    const QString& fileName)
+{
+    DescriptorStore store;
+    store.loadFeatureFiles(featurePath, models);
+
+    Array<QString> modelNames(models.rows());
+    for (size_t i = 0; i < modelNames.size(); i++)
+        modelNames[i] = models(i, 0);
+
+    write(fileName, store, modelNames);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
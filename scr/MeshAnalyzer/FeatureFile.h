@@ -0,0 +1,296 @@
+//=================================================================================================================
+/**
+ *  @file       FeatureFile.h
+ *  @brief      FeatureFile class.
+ *  @details    Declaration file of the FeatureFile class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef FEATURE_FILE_H_INCLUDE
+#define FEATURE_FILE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+
+#include <QtCore/QString>
+#include <QtCore/QFile>
+#include <QtCore/QByteArray>
+
+#include <cstdint>
+
+class DescriptorStore;
+
+//=================================================================================================================
+
+/**
+ *  @brief      Feature file class.
+ *  @details    This class reads and writes the packed feature file of a mesh collection. The file
+ *              contains a header, a table of sections, one section for each descriptor family and
+ *              an index with the names of the models. The descriptors of each family are stored as
+ *              a row-stacked array with one row per model, and every section starts at an offset that
+ *              is aligned to FeatureFile::alignment bytes. Each row is padded to the same aligned
+ *              stride, so that the rows of the collection can be accessed directly from the mapped
+ *              file without copying. The symmetry and harmonic descriptors are also stored with 
+ *              the encodings of CompressedTable, whose rows are not padded, so that the stores that
+ *              compare them with reduced precision don't read the double-precision sections.
+ *
+ *              File layout (all the integers are little-endian):
+ *              - Header: magic key, version, number of models and location of the section table and
+ *                the name index.
+ *              - Section table: one entry per section (see FeatureFile::Section).
+ *              - Sections: row-stacked data of each descriptor family.
+ *              - Name index: nModels+1 offsets followed by the UTF-8 names of the models.
+ */
+class FeatureFile final
+{
+public:
+
+    //// Constants /////
+
+    static constexpr std::uint32_t version {2};             /**< Current version of the format. */
+
+    static constexpr std::uint64_t alignment {64};          /**< Alignment of sections and rows in bytes. */
+
+    static constexpr const char* defaultFileName {"features.atf"};  /**< Default name of the packed file. */
+
+    //// Enumerations /////
+
+    /**
+     *  @brief      Section identifiers.
+     *  @details    Identifiers of the sections stored in the feature file. The sections of
+     *              shape distributions are offset by the value of mesh::ShapeDistribution.
+     */
+    enum class SectionId : std::uint32_t {
+        SdHistograms = 0,       /**< Histograms of the shape distributions (5 consecutive ids). */
+        SdBins = 8,             /**< Bins of the shape distributions (5 consecutive ids). */
+        Rsd = 16,               /**< Reflexive symmetry descriptors. */
+        Hm = 17,                /**< Harmonic descriptors. */
+        RsdFloat16 = 18,        /**< Reflexive symmetry descriptors in half precision (version 2). */
+        HmFloat16 = 19,         /**< Harmonic descriptors in half precision (version 2). */
+        RsdUInt8 = 20,          /**< 8-bit codes of the reflexive symmetry descriptors (version 2). */
+        HmUInt8 = 21,           /**< 8-bit codes of the harmonic descriptors (version 2). */
+        RsdUInt8Ranges = 22,    /**< Minimum values and code steps of RsdUInt8 (version 2). */
+        HmUInt8Ranges = 23,     /**< Minimum values and code steps of HmUInt8 (version 2). */
+        HarmonicOrders = 32,    /**< Orders of the harmonics of the harmonic matrices (hB). */
+        Theta = 33,             /**< Theta angles of the harmonic matrices. */
+        Phi = 34,               /**< Phi angles of the harmonic matrices. */
+        Bt = 35,                /**< Matrix Bt of the harmonic matrices. */
+        BtBI = 36               /**< Matrix BtBI of the harmonic matrices. */
+    };
+
+    /**
+     *  @brief      Element types.
+     *  @details    Types of the elements stored in a section.
+     */
+    enum class ElementType : std::uint32_t {
+        Float64 = 0,            /**< 64-bit floating point numbers. */
+        Int32 = 1,              /**< 32-bit signed integers. */
+        Float16 = 2,            /**< Bits of IEEE 754 half-precision numbers. */
+        UInt8 = 3               /**< 8-bit unsigned integers. */
+    };
+
+    //// Structures /////
+
+    /**
+     *  @brief      Section.
+     *  @details    Entry of the section table. The data of the section is stored as rows of
+     *              columns elements separated by stride bytes. The rows of the sections with one
+     *              row per model are padded to FeatureFile::alignment bytes. Dim0 and dim1 keep the
+     *              original shape of one row when the row represents a matrix.
+     */
+    struct Section final {
+        std::uint32_t id {0};               /**< Identifier of the section. */
+        std::uint32_t type {0};             /**< Element type. */
+        std::uint64_t rows {0};             /**< Number of rows. */
+        std::uint64_t columns {0};          /**< Number of elements of each row. */
+        std::uint64_t stride {0};           /**< Distance between consecutive rows in bytes. */
+        std::uint64_t offset {0};           /**< Offset of the section from the beginning of the file. */
+        std::uint64_t size {0};             /**< Size of the section in bytes. */
+        std::uint64_t dim0 {0};             /**< First dimension of one row. */
+        std::uint64_t dim1 {0};             /**< Second dimension of one row. */
+    };
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes a closed file.
+     */
+    FeatureFile() = default;
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor opens the specified feature file.
+     *  @param[in]  fileName  The name of the file to open.
+     */
+    explicit FeatureFile(const QString& fileName);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    FeatureFile(const FeatureFile&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    FeatureFile(FeatureFile&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor. The file is unmapped and closed.
+     */
+    ~FeatureFile();
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    FeatureFile& operator=(const FeatureFile&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    FeatureFile& operator=(FeatureFile&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Open file.
+     *  @details    This function opens and maps a feature file. The header, the section table and the
+     *              name index are validated, but the data of the sections is not read until it is
+     *              accessed. If the file cannot be mapped (i.e. Qt resources), its content is read
+     *              with a single read operation.
+     *  @param[in]  fileName  The name of the file to open.
+     */
+    void open(const QString& fileName);
+
+    /**
+     *  @brief      Close file.
+     *  @details    This function unmaps and closes the file.
+     */
+    void close();
+
+    /**
+     *  @brief      Is the file open.
+     *  @details    This function checks whether the file is open.
+     *  @returns    True if the file is open.
+     */
+    bool isOpen() const noexcept;
+
+    /**
+     *  @brief      Number of models.
+     *  @details    This function returns the number of models stored in the file.
+     *  @returns    The number of models.
+     */
+    std::size_t numberOfModels() const noexcept;
+
+    /**
+     *  @brief      Model names.
+     *  @details    This function returns the names of the models stored in the file.
+     *  @returns    The names of the models in the order of the rows of the sections.
+     */
+    nct::Array<QString> modelNames() const;
+
+    /**
+     *  @brief      Find section.
+     *  @details    This function returns the entry of one section of the file.
+     *  @param[in]  id  The identifier of the section.
+     *  @returns    A pointer to the section entry or nullptr if the file doesn't contain the section.
+     */
+    const Section* section(std::uint32_t id) const noexcept;
+
+    /**
+     *  @brief      Find section.
+     *  @details    This function returns the entry of one section of the file.
+     *  @param[in]  id  The identifier of the section.
+     *  @returns    A pointer to the section entry or nullptr if the file doesn't contain the section.
+     */
+    const Section* section(SectionId id) const noexcept;
+
+    /**
+     *  @brief      Section data.
+     *  @details    This function returns a pointer to the data of one section.
+     *  @param[in]  s  The section entry.
+     *  @returns    A pointer to the first byte of the section.
+     */
+    const unsigned char* data(const Section& s) const noexcept;
+
+    /**
+     *  @brief      Element size.
+     *  @details    This function returns the size of the elements of one type.
+     *  @param[in]  type  The element type.
+     *  @returns    The size in bytes, or zero if the type is unknown.
+     */
+    static std::uint64_t elementSize(std::uint32_t type) noexcept;
+
+    /**
+     *  @brief      Write feature file.
+     *  @details    This function writes the descriptors of a store in a packed feature file. An
+     *              existing file is replaced atomically.
+     *  @param[in]  fileName  The name of the output file.
+     *  @param[in]  store  The store with the descriptors of the collection.
+     *  @param[in]  modelNames  The names of the models, in the same order as the rows of the store.
+     */
+    static void write(const QString& fileName, const DescriptorStore& store,
+        const nct::Array<QString>& modelNames);
+
+    /**
+     *  @brief      Convert feature files.
+     *  @details    This function reads the per-model feature files of a collection and writes
+     *              them in a single packed feature file.
+     *  @param[in]  featurePath  Path of the per-model feature files.
+     *  @param[in]  models  Array of models. The first column must contain the name of each model.
+     *  @param[in]  fileName  The name of the output file.
+     */
+    static void convert(const QString& featurePath, const nct::Array2D<QString>& models,
+        const QString& fileName);
+
+private:
+
+    //// Member variables ////
+
+    QFile file_;                                    /**< Opened file. */
+
+    QByteArray buffer_;                             /**< File content when the file cannot be mapped. */
+
+    const unsigned char* base_ {nullptr};           /**< First byte of the file content. */
+
+    std::uint64_t size_ {0};                        /**< Size of the file content. */
+
+    std::uint64_t nModels_ {0};                     /**< Number of models. */
+
+    nct::Array<Section> sections_;                  /**< Section table. */
+
+    std::uint64_t namesOffset_ {0};                 /**< Offset of the name index. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,361 @@
+//=================================================================================================================
+/**
+ *  @file       FusedQuery.cpp
+ *  @brief      FusedQuery class implementation file.
+ *  @details    This file contains the implementation of the FusedQuery class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "FusedQuery.h"
+
+#include "nct/nct_exception.h"
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Tags of the keys of the cached descriptors and rankings.
+ */
+constexpr char sdTag[] {'S', 'D'};
+constexpr char rsdTag[] {'R', 'S', 'D'};
+constexpr char hmTag[] {'H', 'M'};
+constexpr char rankingTag[] {'R', 'A', 'N', 'K'};
+
+/**
+ *  @brief      Row matrix.
+ *  @details    This function copies an array in a matrix with one row.
+ *  @param[in]  values  The array.
+ *  @returns    The matrix.
+ */
+Matrix rowMatrix(const RealVector& values)
+{
+    Matrix m(1, values.size());
+    std::copy(values.begin(), values.end(), m.begin());
+    return m;
+}
+
+/**
+ *  @brief      Point matrix.
+ *  @details    This function copies a set of points in a matrix with one point per row.
+ *  @param[in]  points  The points.
+ *  @returns    The matrix.
+ */
+Matrix pointMatrix(const Array<Point3D>& points)
+{
+    Matrix m(points.size(), 3);
+    for (size_t i = 0; i < points.size(); i++) {
+        for (size_t j = 0; j < 3; j++)
+            m(i, j) = points[i][j];
+    }
+    return m;
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+FusedQuery::FusedQuery(const QueryEngine& engine, const nct::Array<nct::Point3D>& vertices,
+    const nct::Array<nct::Vector3D<unsigned int>>& triangles) :
+    engine_(engine), vertices_(vertices), triangles_(triangles)
+{
+    if ((vertices_.size() == 0) || (triangles_.size() == 0))
+        throw OperationException("The mesh is empty", "");
+
+    hash_ = QueryCache::hash(vertices_, triangles_);
+    seed_ = QueryCache::shapeDistributionSeed(hash_, engine_.meshData().nSamps, engine_.meshData().nBins);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+FusedQuery::FusedQuery(const QueryEngine& engine, const nct::Array<nct::Point3D>& vertices,
+    const nct::Array<nct::Vector3D<unsigned int>>& triangles, unsigned long long seed) :
+    engine_(engine), vertices_(vertices), triangles_(triangles), seed_(seed)
+{
+    if ((vertices_.size() == 0) || (triangles_.size() == 0))
+        throw OperationException("The mesh is empty", "");
+
+    hash_ = QueryCache::hash(vertices_, triangles_);
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void FusedQuery::setCache(const std::shared_ptr<QueryCache>& cache)
+{
+    cache_ = cache;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t FusedQuery::hash() const noexcept
+{
+    return hash_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned long long FusedQuery::seed() const noexcept
+{
+    return seed_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::tuple<nct::RealVector, nct::RealVector>& FusedQuery::shapeDistribution(
+    nct::geometry::mesh::ShapeDistribution dist)
+{
+    auto it = sd_.find(dist);
+    if (it != sd_.end())
+        return it->second;
+
+    auto& meshData = engine_.meshData();
+    auto sdKey = [&](mesh::ShapeDistribution d) {
+        auto key = QueryCache::combine(hash_, sdTag);
+        key = QueryCache::combine(key, samplingVersion);
+        key = QueryCache::combine(key, d);
+        key = QueryCache::combine(key, meshData.nSamps);
+        key = QueryCache::combine(key, meshData.nBins);
+        return QueryCache::combine(key, seed_);
+    };
+
+    QueryCache::Arrays arrays;
+    if ((cache_ != nullptr) && cache_->find(sdKey(dist), arrays) && (arrays.size() == 2)) {
+        return sd_.emplace(dist, std::make_tuple(RealVector(arrays[0].begin(), arrays[0].end()), 
+            RealVector(arrays[1].begin(), arrays[1].end()))).first->second;
+    }
+
+    // All the distributions are calculated from the same pool of points, so they are kept even 
+    // if they weren't requested yet. The threads of the engine sample the blocks of the pool.
+    checkCanceled();
+    Array<mesh::ShapeDistribution> dists(DescriptorStore::nShapeDistributions);
+    for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++)
+        dists[k] = static_cast<mesh::ShapeDistribution>(k);
+
+    auto descriptors = mesh::calculateShapeDistributions(vertices_, triangles_, seed_, dists, 
+        meshData.nSamps, meshData.nBins, engine_.threads());
+
+    for (unsigned int k = 0; k < DescriptorStore::nShapeDistributions; k++) {
+        auto inserted = sd_.emplace(dists[k], std::move(descriptors[k]));
+        if ((cache_ != nullptr) && inserted.second) {
+            auto& descriptor = inserted.first->second;
+            cache_->insert(sdKey(dists[k]), {rowMatrix(std::get<0>(descriptor)), 
+                rowMatrix(std::get<1>(descriptor))});
+        }
+    }
+
+    return sd_.at(dist);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::geometry::RasterizedObject3D& FusedQuery::rasterizedObject()
+{
+    if (rr_ == nullptr) {
+        checkCanceled();
+        rr_ = std::make_unique<RasterizedObject3D>(engine_.rasterize(vertices_, triangles_));
+    }
+
+    return *rr_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::geometry::RasterizedObject3D::SymmetryDescriptor& FusedQuery::symmetryDescriptor()
+{
+    if (rsd_ != nullptr)
+        return *rsd_;
+
+    auto key = QueryCache::combine(hash_, rsdTag);
+    key = QueryCache::combine(key, engine_.meshData().nVox);
+
+    QueryCache::Arrays arrays;
+    if ((cache_ != nullptr) && cache_->find(key, arrays) && (arrays.size() == 3) && 
+        (arrays[2].columns() == 3)) {
+        rsd_ = std::make_unique<RasterizedObject3D::SymmetryDescriptor>();
+        rsd_->sd = std::move(arrays[0]);
+        rsd_->rsd = std::move(arrays[1]);
+        rsd_->norms = Array<Point3D>(arrays[2].rows());
+        for (size_t i = 0; i < arrays[2].rows(); i++)
+            rsd_->norms[i] = Point3D(arrays[2](i, 0), arrays[2](i, 1), arrays[2](i, 2));
+        return *rsd_;
+    }
+
+    auto& rr = rasterizedObject();
+    checkCanceled();
+    rsd_ = std::make_unique<RasterizedObject3D::SymmetryDescriptor>(rr.symmetryDescriptor());
+
+    if (cache_ != nullptr)
+        cache_->insert(key, {rsd_->sd, rsd_->rsd, pointMatrix(rsd_->norms)});
+
+    return *rsd_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::RealVector& FusedQuery::harmonicDescriptor()
+{
+    if (hm_ != nullptr)
+        return *hm_;
+
+    auto key = QueryCache::combine(hash_, hmTag);
+    key = QueryCache::combine(key, engine_.meshData().nVox);
+
+    QueryCache::Arrays arrays;
+    if ((cache_ != nullptr) && cache_->find(key, arrays) && (arrays.size() == 1)) {
+        hm_ = std::make_unique<RealVector>(arrays[0].begin(), arrays[0].end());
+        return *hm_;
+    }
+
+    auto& rr = rasterizedObject();
+    checkCanceled();
+    auto hm = rr.harmonicDescriptor(engine_.store()->harmonicMatrices());
+    hm_ = std::make_unique<RealVector>(hm.begin(), hm.end());
+
+    if (cache_ != nullptr)
+        cache_->insert(key, {rowMatrix(*hm_)});
+
+    return *hm_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FusedQuery::calculateDescriptors(bool sd, nct::geometry::mesh::ShapeDistribution dist, bool rsd, bool hm)
+{
+    // The shape distributions and the rasterized object don't share any intermediate result, and
+    // each one uses its own members. If the rasterization throws, the destructor of the future 
+    // waits for the sampling.
+    std::future<void> sampling;
+    if (sd && (rsd || hm))
+        sampling = std::async(std::launch::async, [this, dist]() { shapeDistribution(dist); });
+    else if (sd)
+        shapeDistribution(dist);
+
+    if (rsd)
+        symmetryDescriptor();
+
+    if (hm)
+        harmonicDescriptor();
+
+    if (sampling.valid())
+        sampling.get();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking FusedQuery::rankShapeDistribution(nct::geometry::mesh::ShapeDistribution dist, 
+    nct::geometry::mesh::DistanceFunction f, bool cdf, unsigned int nScales, double sIni, double sEnd,
+    std::size_t k)
+{
+    auto key = QueryCache::combine(hash_, sdTag);
+    key = QueryCache::combine(key, samplingVersion);
+    key = QueryCache::combine(key, dist);
+    key = QueryCache::combine(key, seed_);
+    key = QueryCache::combine(key, f);
+    key = QueryCache::combine(key, cdf);
+    key = QueryCache::combine(key, nScales);
+    key = QueryCache::combine(key, sIni);
+    key = QueryCache::combine(key, sEnd);
+
+    return cachedRanking(rankingKey(key, k), [&]() {
+        auto& descriptor = shapeDistribution(dist);
+        return engine_.rankShapeDistribution(std::get<0>(descriptor), std::get<1>(descriptor), dist, f, cdf,
+            nScales, sIni, sEnd, k);
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking FusedQuery::rankSymmetryDescriptor(unsigned int nRot, nct::geometry::mesh::DistanceFunction f, 
+    std::size_t k)
+{
+    auto key = QueryCache::combine(hash_, rsdTag);
+    key = QueryCache::combine(key, nRot);
+    key = QueryCache::combine(key, f);
+
+    return cachedRanking(rankingKey(key, k), [&]() {
+        return engine_.rankSymmetryDescriptor(symmetryDescriptor().rsd, nRot, f, k);
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking FusedQuery::rankHarmonicDescriptor(nct::geometry::mesh::DistanceFunction f, std::size_t k)
+{
+    auto key = QueryCache::combine(hash_, hmTag);
+    key = QueryCache::combine(key, f);
+
+    return cachedRanking(rankingKey(key, k), [&]() {
+        return engine_.rankHarmonicDescriptor(harmonicDescriptor(), f, k);
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t FusedQuery::rankingKey(std::uint64_t key, std::size_t k) const
+{
+    // The rankings of the indices are approximate, so they depend on every setting of the search.
+    auto& meshData = engine_.meshData();
+    key = QueryCache::combine(key, rankingTag);
+    key = QueryCache::combine(key, meshData.nVox);
+    key = QueryCache::combine(key, meshData.nSamps);
+    key = QueryCache::combine(key, meshData.nBins);
+    key = QueryCache::combine(key, engine_.store()->precision());
+    key = QueryCache::combine(key, engine_.scaleSearch());
+    key = QueryCache::combine(key, engine_.scaleTolerance());
+    key = QueryCache::combine(key, engine_.scaleStep());
+    key = QueryCache::combine(key, engine_.searchIndex());
+    key = QueryCache::combine(key, engine_.invertedFileCells());
+    key = QueryCache::combine(key, engine_.invertedFileProbes());
+
+    // The keys of the whole collection don't change, so they match the rankings of earlier sessions.
+    auto& selection = engine_.selection();
+    if (selection != nullptr) {
+        key = QueryCache::combine(key, static_cast<std::uint64_t>(selection->size()));
+        key = QueryCache::combine(key, selection->data(), selection->size()*sizeof(unsigned int));
+    }
+
+    return QueryCache::combine(key, static_cast<std::uint64_t>(k));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking FusedQuery::cachedRanking(std::uint64_t key, const std::function<Ranking()>& rank)
+{
+    Ranking ranking;
+    if ((cache_ != nullptr) && cache_->findRanking(key, ranking))
+        return ranking;
+
+    ranking = rank();
+    if (cache_ != nullptr)
+        cache_->insertRanking(key, ranking);
+
+    return ranking;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void FusedQuery::checkCanceled() const
+{
+    if (engine_.progress() != nullptr)
+        engine_.progress()->checkCanceled();
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
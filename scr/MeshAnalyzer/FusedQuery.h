@@ -0,0 +1,285 @@
+//=================================================================================================================
+/**
+ *  @file       FusedQuery.h
+ *  @brief      FusedQuery class.
+ *  @details    Declaration file of the FusedQuery class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef FUSED_QUERY_H_INCLUDE
+#define FUSED_QUERY_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "QueryEngine.h"
+#include "QueryCache.h"
+#include "Ranking.h"
+
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Vector3D.h"
+#include "nct/geometry/mesh.h"
+#include "nct/geometry/RasterizedObject3D.h"
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <map>
+#include <tuple>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Fused query class.
+ *  @details    This class ranks a collection with several descriptors of the same query object. Each
+ *              descriptor is calculated once, the first time that it is requested. The mesh is 
+ *              centered, scaled and rasterized once, and the symmetry and harmonic descriptors are 
+ *              calculated from the same rasterized object. The shape distributions are calculated 
+ *              together from one pool of random points, in parallel with the threads of the engine
+ *              (see nct::geometry::mesh::calculateShapeDistributions); they don't depend on the 
+ *              number of threads. The rankings of the descriptors can
+ *              be aggregated with Ranking::fuse. If the query has a cache, the descriptors and the 
+ *              rankings are taken from it when the same mesh was compared before with the same 
+ *              parameters (see QueryCache). The engine must outlive the query.
+ */
+class FusedQuery final
+{
+public:
+
+    //// Constants /////
+
+    /** Version of the sampling and binning of the shape distributions. It is part of the keys of 
+        the cached shape distributions, so the ones that were calculated differently are not reused. */
+    static constexpr std::uint32_t samplingVersion {5};
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the query with a mesh. The shape distributions are
+     *              sampled with a seed derived from the contents of the mesh (see 
+     *              QueryCache::shapeDistributionSeed).
+     *  @param[in]  engine  The query engine of the collection.
+     *  @param[in]  vertices  The vertices of the mesh.
+     *  @param[in]  triangles  The triangles of the mesh.
+     */
+    FusedQuery(const QueryEngine& engine, const nct::Array<nct::Point3D>& vertices,
+        const nct::Array<nct::Vector3D<unsigned int>>& triangles);
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the query with a mesh.
+     *  @param[in]  engine  The query engine of the collection.
+     *  @param[in]  vertices  The vertices of the mesh.
+     *  @param[in]  triangles  The triangles of the mesh.
+     *  @param[in]  seed  The seed of the random number generator that samples the surface. Each shape
+     *              distribution uses its own generator with this seed.
+     */
+    FusedQuery(const QueryEngine& engine, const nct::Array<nct::Point3D>& vertices,
+        const nct::Array<nct::Vector3D<unsigned int>>& triangles, unsigned long long seed);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Deleted copy constructor.
+     */
+    FusedQuery(const FusedQuery&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~FusedQuery() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Deleted assignment operator.
+     *  @returns    A reference to the object.
+     */
+    FusedQuery& operator=(const FusedQuery&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Set cache.
+     *  @details    This function sets the cache of the descriptors and the rankings.
+     *  @param[in]  cache  The cache. If it is null, nothing is cached.
+     */
+    void setCache(const std::shared_ptr<QueryCache>& cache);
+
+    /**
+     *  @brief      Hash.
+     *  @details    This function returns the hash of the contents of the mesh (see QueryCache::hash).
+     *  @returns    The hash of the mesh.
+     */
+    std::uint64_t hash() const noexcept;
+
+    /**
+     *  @brief      Seed.
+     *  @details    This function returns the seed of the shape distributions.
+     *  @returns    The seed.
+     */
+    unsigned long long seed() const noexcept;
+
+    /**
+     *  @brief      Shape distribution.
+     *  @details    This function returns a shape distribution of the query mesh with the number of
+     *              samples and bins of the collection.
+     *  @param[in]  dist  The shape distribution.
+     *  @returns    A tuple with the values of the histogram and the histogram bins.
+     */
+    const std::tuple<nct::RealVector, nct::RealVector>& shapeDistribution(
+        nct::geometry::mesh::ShapeDistribution dist);
+
+    /**
+     *  @brief      Rasterized object.
+     *  @details    This function returns the query mesh centered, scaled and rasterized with the
+     *              number of divisions of the collection.
+     *  @returns    The rasterized object.
+     */
+    const nct::geometry::RasterizedObject3D& rasterizedObject();
+
+    /**
+     *  @brief      Symmetry descriptor.
+     *  @details    This function returns the symmetry descriptor of the rasterized object.
+     *  @returns    The symmetry descriptor.
+     */
+    const nct::geometry::RasterizedObject3D::SymmetryDescriptor& symmetryDescriptor();
+
+    /**
+     *  @brief      Harmonic descriptor.
+     *  @details    This function returns the flattened harmonic descriptor of the rasterized object.
+     *  @returns    The harmonic descriptor.
+     */
+    const nct::RealVector& harmonicDescriptor();
+
+    /**
+     *  @brief      Calculate descriptors.
+     *  @details    This function calculates the requested descriptors of the query mesh. The shape
+     *              distributions are sampled on another thread while the mesh is rasterized, so a
+     *              query with every descriptor costs about as much as the slowest of them when
+     *              there are free cores.
+     *  @param[in]  sd  True to calculate the shape distributions.
+     *  @param[in]  dist  The shape distribution that is requested.
+     *  @param[in]  rsd  True to calculate the symmetry descriptor.
+     *  @param[in]  hm  True to calculate the harmonic descriptor.
+     */
+    void calculateDescriptors(bool sd, nct::geometry::mesh::ShapeDistribution dist, bool rsd, bool hm);
+
+    /**
+     *  @brief      Rank shape distribution.
+     *  @details    This function ranks the collection with a shape distribution of the query mesh.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  cdf  True if the cumulative distributions are compared.
+     *  @param[in]  nScales  The number of scales that are tested.
+     *  @param[in]  sIni  The log of the first scale.
+     *  @param[in]  sEnd  The log of the last scale.
+     *  @param[in]  k  The number of ranks that are expected to be requested.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankShapeDistribution(nct::geometry::mesh::ShapeDistribution dist, 
+        nct::geometry::mesh::DistanceFunction f, bool cdf, unsigned int nScales, double sIni, double sEnd,
+        std::size_t k);
+
+    /**
+     *  @brief      Rank symmetry descriptor.
+     *  @details    This function ranks the collection with the reflexive symmetry descriptor of the
+     *              query object.
+     *  @param[in]  nRot  The number of rotations per axis that are tested.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of ranks that are expected to be requested. If it is zero, every
+     *              distance is calculated.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankSymmetryDescriptor(unsigned int nRot, nct::geometry::mesh::DistanceFunction f, std::size_t k);
+
+    /**
+     *  @brief      Rank harmonic descriptor.
+     *  @details    This function ranks the collection with the harmonic descriptor of the query object.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of ranks that are expected to be requested. If it is zero, every
+     *              distance is calculated.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankHarmonicDescriptor(nct::geometry::mesh::DistanceFunction f, std::size_t k);
+
+    /**
+     *  @brief      Ranking key.
+     *  @details    This function adds the settings of the engine that change the rankings to the key
+     *              of a query, which must identify the mesh and the parameters of the comparison 
+     *              (see hash). The selected models of the engine are part of the key.
+     *  @param[in]  key  The key of the query.
+     *  @param[in]  k  The number of ranks that are expected to be requested.
+     *  @returns    The key of the ranking.
+     */
+    std::uint64_t rankingKey(std::uint64_t key, std::size_t k) const;
+
+private:
+
+    //// Methods /////
+
+    /**
+     *  @brief      Cached ranking.
+     *  @details    This function takes a ranking from the cache, or calculates it and stores it in 
+     *              the cache.
+     *  @param[in]  key  The key of the ranking.
+     *  @param[in]  rank  The function that calculates the ranking.
+     *  @returns    The ranking of the models.
+     */
+    Ranking cachedRanking(std::uint64_t key, const std::function<Ranking()>& rank);
+
+    /**
+     *  @brief      Check cancellation.
+     *  @details    This function throws an exception if the comparison followed by the progress of
+     *              the engine was canceled. It is called before each descriptor is calculated.
+     */
+    void checkCanceled() const;
+
+    //// Member variables ////
+
+    const QueryEngine& engine_;                                 /**< Query engine of the collection. */
+
+    std::shared_ptr<QueryCache> cache_;                         /**< Cache of the query. */
+
+    nct::Array<nct::Point3D> vertices_;                         /**< Vertices of the mesh. */
+
+    nct::Array<nct::Vector3D<unsigned int>> triangles_;         /**< Triangles of the mesh. */
+
+    std::uint64_t hash_ {0};                                    /**< Hash of the mesh. */
+
+    unsigned long long seed_ {0};                               /**< Seed of the shape distributions. */
+
+    /** Shape distributions that were calculated. */
+    std::map<nct::geometry::mesh::ShapeDistribution, std::tuple<nct::RealVector, nct::RealVector>> sd_;
+
+    std::unique_ptr<nct::geometry::RasterizedObject3D> rr_;    /**< Rasterized object. */
+
+    /** Symmetry descriptor of the rasterized object. */
+    std::unique_ptr<nct::geometry::RasterizedObject3D::SymmetryDescriptor> rsd_;
+
+    std::unique_ptr<nct::RealVector> hm_;                       /**< Harmonic descriptor. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
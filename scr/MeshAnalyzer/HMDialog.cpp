@@ -26,6 +26,9 @@
 //=================================================================================================================
 #include "HMDialog.h"
 #include "ResultsDialog.h"
+#include "QueryEngine.h"
+#include "FusedQuery.h"
+#include "ComparisonTask.h"
 
 #include "nct/color/RgbColor.h"
 #include "nct/geometry/mesh.h"
@@ -180,7 +183,7 @@ void HMDialog::compare()
     if ( (vertices_->size() == 0) || (triangles_->size() == 0))
         return;
 
-    if (meshData_.nModels == 0)
+    if ( (meshData_.nModels == 0) || (store_ == nullptr) || (store_->numberOfModels() != meshData_.nModels) )
     {
         showErrorMessage("This operation requires a mesh collection loaded in memory. ", nullptr);
         return;
@@ -188,8 +191,6 @@ void HMDialog::compare()
 
     try
     {
-        QApplication::setOverrideCursor(Qt::WaitCursor);        
-
         // Decode parameters
         auto f = mesh::DistanceFunction::EuclideanDistance;
 
@@ -202,58 +203,23 @@ void HMDialog::compare()
         else if (ui_.distanceMetricComboBox->currentIndex() == 3)
             f = mesh::DistanceFunction::MinDistance;
 
-        // Download transformation matrices
-        RasterizedObject3D::HarmonicMatrices hmat;
-        hmat.hB = MainWindow::decodeHarmonicFile(meshData_.featurePath + "hB.bin");
-        hmat.theta = MainWindow::decodeVectorFile(meshData_.featurePath + "theta.bin");
-        hmat.phi = MainWindow::decodeVectorFile(meshData_.featurePath + "phi.bin");
-        hmat.Bt = MainWindow::decodeMatrixFile(meshData_.featurePath + "Bt.bin");
-        hmat.BtBI = MainWindow::decodeMatrixFile(meshData_.featurePath + "BtBI.bin");
-               
-
-        // Download descriptors of collection
-        auto modelNames = meshData_.models.selectColumn(0);
-
-        Array<Array2D<double>> hm(meshData_.nModels);
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-            hm[i] = MainWindow::decodeMatrixFile(meshData_.featurePath + modelNames[i] + "_HM.bin");
-
-        // Calculate descriptor of loaded object according to the configuration file
-        auto scVertices = mesh::centerAndScaleVertices(*vertices_);
-        auto triang = mesh::triangleCoord(scVertices, *triangles_);
-        RasterizedObject3D rr(triang, -1, 1, meshData_.nVox, NConnectivity3D::TwentySixConnected);
-        auto hmRef = rr.harmonicDescriptor(hmat);
-
-        // Compare descriptor with the rest and get the minimum distances
-        Array<std::pair<double, int>> ranks(meshData_.nModels);
-        
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-        {
-            ranks[i].second = i;
-            ranks[i].first = mesh::compareFeatures(Array<double>(hmRef.begin(), hmRef.end()), 
-                Array<double>(hm[i].begin(), hm[i].end()), f);
-        }
-
-        sort(ranks.begin(), ranks.end(), [](const std::pair<double, int>& p1, const std::pair<double, int>& p2)
-            {return p1.first<p2.first;});
-
-        // Update progress
-        QApplication::restoreOverrideCursor();
-
-        // Show results
-        Array<unsigned int> results(meshData_.nModels);
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-            results[i] = ranks[i].second;
+        // Calculate descriptor of loaded object according to the configuration file and compare 
+        // it with the rest in a worker thread, while the results dialog shows the closest models 
+        // found so far. The descriptor and the ranking of a mesh that was compared before are 
+        // taken from the cache.
+        QueryEngine engine(meshData_, store_);
 
         ResultsDialog rDialog;
         rDialog.setMeshData(meshData_);
-        rDialog.setResults(results);
+        rDialog.setTask(new ComparisonTask(engine, vertices_, triangles_, cache_, 
+            [f](FusedQuery& query) {
+                return query.rankHarmonicDescriptor(f, 10);
+            }));
         rDialog.exec();
 
     }
     catch (const std::exception& ex)
     {
-        QApplication::restoreOverrideCursor();
         showErrorMessage("Unable to compare object descriptor with the collection. "
             "Make shure the collection data is valid.", &ex);
     }
@@ -318,6 +284,18 @@ void HMDialog::setMeshData(const MainWindow::MeshData& meshData)
     meshData_ = meshData;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void HMDialog::setDescriptorStore(const std::shared_ptr<const DescriptorStore>& store)
+{
+    store_ = store;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void HMDialog::setQueryCache(const std::shared_ptr<QueryCache>& cache)
+{
+    cache_ = cache;
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void HMDialog::showErrorMessage(const QString& message, const std::exception* exception)
 {
@@ -0,0 +1,448 @@
+//=================================================================================================================
+/**
+ *  @file       InvertedFile.cpp
+ *  @brief      InvertedFile class implementation file.
+ *  @details    This file contains the implementation of the InvertedFile class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "InvertedFile.h"
+#include "QueryCache.h"
+
+#include "nct/nct_exception.h"
+#include "nct/clustering/KMeans.h"
+#include "nct/random/MersenneTwister.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QByteArray>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the inverted files.
+ */
+constexpr char invertedFileMagic[8] {'A', 'T', 'I', 'V', 'F', 'I', 'D', 'X'};
+
+/**
+ *  @brief      Clustering tolerance.
+ *  @details    Relative change of the mean squared distance to the centers that stops the K-means
+ *              iterations. The cells only guide the search, so they don't need to converge fully.
+ */
+constexpr double clusteringTolerance {1e-4};
+
+/**
+ *  @brief      Training points per cell.
+ *  @details    Maximum number of descriptors per cell that are used to find the centers of the 
+ *              cells. The other descriptors are only assigned to their closest center.
+ */
+constexpr std::size_t trainingPointsPerCell {64};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the inverted files.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t nCells {0};               /**< Number of cells. */
+    std::uint64_t nModels {0};              /**< Number of models. */
+    std::uint64_t nDimensions {0};          /**< Number of elements of each descriptor. */
+    std::uint64_t checksum {0};             /**< Checksum of the descriptors. */
+    std::uint64_t reserved {0};             /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 48, "Unexpected size of the file header.");
+
+/**
+ *  @brief      Checksum.
+ *  @details    This function calculates the FNV-1a hash of the size and the elements of the first
+ *              descriptors of a set.
+ *  @param[in]  points  The descriptors.
+ *  @param[in]  nModels  The number of descriptors.
+ *  @returns    The checksum.
+ */
+std::uint64_t descriptorChecksum(const nct::Matrix& points, std::size_t nModels)
+{
+    auto hash = QueryCache::combine(QueryCache::initialHash, static_cast<std::uint64_t>(nModels));
+    hash = QueryCache::combine(hash, static_cast<std::uint64_t>(points.columns()));
+    return QueryCache::combine(hash, points.data(), nModels*points.columns()*sizeof(double));
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+InvertedFile::InvertedFile(const nct::Matrix& points, std::size_t nCells) :
+    nDimensions_(points.columns())
+{
+    if ((points.rows() == 0) || (points.columns() == 0))
+        throw EmptyArrayException("points", SOURCE_INFO);
+
+    if (points.rows() >= std::numeric_limits<std::uint32_t>::max())
+        throw ArgumentException("points", exc_value_too_large, SOURCE_INFO);
+
+    auto n = points.rows();
+    if (nCells == 0)
+        nCells = defaultCells(n);
+    nCells = std::clamp<std::size_t>(nCells, 1, n);
+
+    // The centers are found with evenly spaced descriptors of large collections.
+    auto nTraining = std::min(n, nCells*trainingPointsPerCell);
+    Matrix training(nTraining, nDimensions_);
+    for (size_t i = 0; i < nTraining; i++) {
+        auto row = i*n/nTraining;
+        std::copy(&points(row, 0), &points(row, 0) + nDimensions_, &training(i, 0));
+    }
+
+    random::MersenneTwister rnd(seed);
+    clustering::KMeans kMeans(std::move(training), static_cast<unsigned int>(nCells), rnd, 
+        clustering::KMeans::InitializationMethod::RandomPoints, 1000, clusteringTolerance);
+    centers_ = kMeans.centers();
+
+    std::vector<std::uint32_t> labels(n);
+    for (size_t i = 0; i < n; i++)
+        labels[i] = static_cast<std::uint32_t>(std::get<1>(kMeans.findClosestCenter(points, i)));
+
+    offsets_.assign(nCells + 1, 0);
+    for (size_t i = 0; i < n; i++)
+        offsets_[labels[i] + 1]++;
+    for (size_t c = 0; c < nCells; c++)
+        offsets_[c + 1] += offsets_[c];
+
+    order_.resize(n);
+    auto next = offsets_;
+    for (size_t i = 0; i < n; i++)
+        order_[next[labels[i]]++] = static_cast<std::uint32_t>(i);
+
+    checksum_ = descriptorChecksum(points, n);
+    appendedModels_.resize(nCells);
+    sortPoints(points);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+InvertedFile::InvertedFile(const QString& fileName, const nct::Matrix& points) : 
+    nDimensions_(points.columns())
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+    auto data = file.readAll();
+    if (static_cast<std::size_t>(data.size()) < sizeof(FileHeader))
+        throw IOException(exc_error_reading_file_header, SOURCE_INFO);
+
+    FileHeader header;
+    std::memcpy(&header, data.constData(), sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, invertedFileMagic, sizeof(invertedFileMagic)) != 0)
+        throw IOException(exc_bad_magic_key, SOURCE_INFO);
+
+    if ((header.version == 0) || (header.version > version))
+        throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+    if ((header.nModels > points.rows()) || (header.nDimensions != points.columns()) ||
+        (header.nModels == 0) || (header.nCells == 0) || (header.nCells > header.nModels) ||
+        (static_cast<std::uint64_t>(data.size()) != sizeof(FileHeader) + 
+            header.nCells*header.nDimensions*sizeof(double) + 
+            (header.nCells + 1)*sizeof(std::uint32_t) + header.nModels*sizeof(std::uint32_t)))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    // Cells of other descriptors would miss the closest models. The descriptors after the ones
+    // of the cells are appended models.
+    checksum_ = descriptorChecksum(points, static_cast<std::size_t>(header.nModels));
+    if (header.checksum != checksum_)
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    auto first = data.constData() + sizeof(FileHeader);
+    centers_.assign(header.nCells, static_cast<size_t>(header.nDimensions), 0);
+    std::memcpy(centers_.data(), first, centers_.size()*sizeof(double));
+    first += centers_.size()*sizeof(double);
+
+    offsets_.resize(header.nCells + 1);
+    std::memcpy(offsets_.data(), first, offsets_.size()*sizeof(std::uint32_t));
+    first += offsets_.size()*sizeof(std::uint32_t);
+
+    order_.resize(static_cast<std::size_t>(header.nModels));
+    std::memcpy(order_.data(), first, order_.size()*sizeof(std::uint32_t));
+
+    if ((offsets_.front() != 0) || (offsets_.back() != header.nModels) || 
+        !std::is_sorted(offsets_.begin(), offsets_.end()))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    for (auto model : order_) {
+        if (model >= header.nModels)
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+    }
+
+    appendedModels_.resize(header.nCells);
+    sortPoints(points);
+
+    for (auto i = order_.size(); i < points.rows(); i++)
+        append(&points(i, 0));
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t InvertedFile::size() const noexcept
+{
+    return order_.size() + appended();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t InvertedFile::numberOfCells() const noexcept
+{
+    return centers_.rows();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t InvertedFile::appended() const noexcept
+{
+    return appendedPoints_.size()/nDimensions_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void InvertedFile::append(const double* point)
+{
+    if (point == nullptr)
+        throw NullPointerException("point", SOURCE_INFO);
+
+    if (size() + 1 >= std::numeric_limits<std::uint32_t>::max())
+        throw ArgumentException("point", exc_value_too_large, SOURCE_INFO);
+
+    size_t closest = 0;
+    double minDistance = std::numeric_limits<double>::infinity();
+    for (size_t c = 0; c < centers_.rows(); c++) {
+        double d = 0;
+        for (size_t j = 0; j < nDimensions_; j++) {
+            double e = point[j] - centers_(c, j);
+            d += e*e;
+        }
+        if (d < minDistance) {
+            minDistance = d;
+            closest = c;
+        }
+    }
+
+    appendedModels_[closest].push_back(static_cast<std::uint32_t>(size()));
+    appendedPoints_.insert(appendedPoints_.end(), point, point + nDimensions_);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void InvertedFile::popBack()
+{
+    if (appended() == 0)
+        throw EmptyArrayException("appended", SOURCE_INFO);
+
+    auto model = static_cast<std::uint32_t>(size() - 1);
+    for (auto& models : appendedModels_) {
+        if (!models.empty() && (models.back() == model)) {
+            models.pop_back();
+            break;
+        }
+    }
+    appendedPoints_.resize(appendedPoints_.size() - nDimensions_);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+InvertedFile::Result InvertedFile::search(const nct::RealVector& query, nct::geometry::mesh::DistanceFunction f,
+    std::size_t k, std::size_t nProbes, const std::vector<char>& removed) const
+{
+    if (query.size() != nDimensions_)
+        throw ArgumentException("query", exc_bad_array_dimensions, SOURCE_INFO);
+
+    auto n = size();
+    if (!removed.empty() && (removed.size() != n))
+        throw ArgumentException("removed", exc_bad_array_size, SOURCE_INFO);
+
+    auto live = removed.empty() ? n : static_cast<size_t>(std::count(removed.begin(), removed.end(), 0));
+    if (live == 0)
+        return Result();
+
+    auto nCells = centers_.rows();
+    if ((k == 0) || (k > live))
+        k = live;
+    if ((nProbes == 0) || (nProbes > nCells))
+        nProbes = nCells;
+
+    // The cells are sorted by the squared Euclidean distance from their centers to the query.
+    std::vector<std::pair<double, std::uint32_t>> cells(nCells);
+    for (size_t c = 0; c < nCells; c++) {
+        double d = 0;
+        for (size_t j = 0; j < nDimensions_; j++) {
+            double e = query[j] - centers_(c, j);
+            d += e*e;
+        }
+        cells[c] = {d, static_cast<std::uint32_t>(c)};
+    }
+    std::partial_sort(cells.begin(), cells.begin() + nProbes, cells.end());
+
+    Result result;
+    result.distances.assign(n, 0);
+    result.exact.assign(n, 0);
+
+    // The k smallest distances of the probed models; the top is the k-th one.
+    std::priority_queue<double> best;
+    double farthest = 0;
+    RealVector descriptor(nDimensions_);
+
+    auto evaluate = [&](const double* row, std::uint32_t model) {
+        if (!removed.empty() && removed[model])
+            return;
+
+        std::copy(row, row + nDimensions_, descriptor.begin());
+
+        double bound = best.size() < k ? std::numeric_limits<double>::infinity() : best.top();
+        double d = mesh::compareFeatures(query, descriptor, f, bound);
+        result.distances[model] = d;
+        result.exact[model] = d < bound;
+        result.evaluations++;
+
+        if (result.exact[model]) {
+            farthest = std::max(farthest, d);
+            best.push(d);
+            if (best.size() > k)
+                best.pop();
+        }
+    };
+
+    auto firstAppended = order_.size();
+    for (size_t p = 0; p < nProbes; p++) {
+        auto c = cells[p].second;
+        for (auto i = offsets_[c]; i < offsets_[c + 1]; i++)
+            evaluate(points_.data() + i*nDimensions_, order_[i]);
+        for (auto model : appendedModels_[c])
+            evaluate(appendedPoints_.data() + (model - firstAppended)*nDimensions_, model);
+    }
+
+    // The models of the other cells are placed after the k closest probed models. 
+    double kth = best.size() < k ? farthest : best.top();
+    for (size_t c = nProbes; c < nCells; c++) {
+        for (auto i = offsets_[cells[c].second]; i < offsets_[cells[c].second + 1]; i++)
+            result.distances[order_[i]] = kth;
+        for (auto model : appendedModels_[cells[c].second])
+            result.distances[model] = kth;
+    }
+
+    // The models after a removed one take the previous index.
+    if (live < n) {
+        RealVector distances(live);
+        std::vector<char> exact(live);
+        for (size_t i = 0, j = 0; i < n; i++) {
+            if (!removed[i]) {
+                distances[j] = result.distances[i];
+                exact[j] = result.exact[i];
+                j++;
+            }
+        }
+        result.distances = std::move(distances);
+        result.exact = std::move(exact);
+    }
+
+    queries_++;
+    evaluations_ += result.evaluations;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+InvertedFile::Statistics InvertedFile::statistics() const noexcept
+{
+    Statistics s;
+    s.queries = queries_;
+    s.evaluations = evaluations_;
+    s.saved = s.queries*size() - s.evaluations;
+    return s;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void InvertedFile::write(const QString& fileName) const
+{
+    FileHeader header;
+    std::memcpy(header.magic, invertedFileMagic, sizeof(invertedFileMagic));
+    header.version = version;
+    header.nCells = static_cast<std::uint32_t>(centers_.rows());
+    header.nModels = order_.size();
+    header.nDimensions = nDimensions_;
+    header.checksum = checksum_;
+
+    QByteArray data;
+    data.reserve(static_cast<qsizetype>(sizeof(FileHeader) + centers_.size()*sizeof(double) + 
+        offsets_.size()*sizeof(std::uint32_t) + order_.size()*sizeof(std::uint32_t)));
+    data.append(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    data.append(reinterpret_cast<const char*>(centers_.data()), 
+        static_cast<qsizetype>(centers_.size()*sizeof(double)));
+    data.append(reinterpret_cast<const char*>(offsets_.data()), 
+        static_cast<qsizetype>(offsets_.size()*sizeof(std::uint32_t)));
+    data.append(reinterpret_cast<const char*>(order_.data()), 
+        static_cast<qsizetype>(order_.size()*sizeof(std::uint32_t)));
+
+    // The file is replaced atomically, so that other processes never read partial cells.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    if (file.write(data) != data.size())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    if (!file.commit())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t InvertedFile::defaultCells(std::size_t nModels) noexcept
+{
+    return std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(std::sqrt(static_cast<double>(nModels)))));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void InvertedFile::sortPoints(const nct::Matrix& points)
+{
+    // The models of a cell are contiguous, so each probe reads one block of memory.
+    points_.assign(order_.size()*nDimensions_, 0);
+    for (size_t i = 0; i < order_.size(); i++)
+        std::copy(&points(order_[i], 0), &points(order_[i], 0) + nDimensions_, points_.begin() + i*nDimensions_);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,282 @@
+//=================================================================================================================
+/**
+ *  @file       InvertedFile.h
+ *  @brief      InvertedFile class.
+ *  @details    Declaration file of the InvertedFile class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+#ifndef INVERTED_FILE_H_INCLUDE
+#define INVERTED_FILE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+#include "nct/geometry/mesh.h"
+
+#include <QtCore/QString>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Inverted file class.
+ *  @details    This class implements an inverted file over the descriptors of a collection. The 
+ *              descriptors are partitioned in cells with the K-means algorithm (see 
+ *              nct::clustering::KMeans), and each cell keeps the list of its models. A query is 
+ *              only compared with the models of the cells whose centers are the closest to it, so
+ *              the search is approximate: the number of probed cells trades the recall of the 
+ *              closest models for speed. The cells are defined by the Euclidean distance, but the
+ *              models of the probed cells can be compared with any distance function.
+ *
+ *              Models can be appended to the inverted file without partitioning the descriptors 
+ *              again: each one is added to the cell of its closest center, and the centers are not 
+ *              moved.
+ *
+ *              The inverted file can be stored next to the feature files of the collection. The
+ *              file keeps a checksum of the descriptors, so the cells are not used with a different
+ *              collection. A file can be read with more descriptors than the ones of the cells, as
+ *              long as the first ones match; the other descriptors are appended.
+ *
+ *              File layout (all the integers are little-endian):
+ *              - Header: magic key, version, number of cells, number of models, number of 
+ *                dimensions and checksum of the descriptors.
+ *              - Centers: the center of each cell (64-bit).
+ *              - Offsets: the position of the first model of each cell and the number of models
+ *                (32-bit).
+ *              - Order: the models sorted by cell (32-bit indices).
+ *
+ *              The searches are thread safe.
+ */
+class InvertedFile final
+{
+public:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Search result.
+     *  @details    Result of a search in the probed cells.
+     */
+    struct Result final {
+        nct::RealVector distances;          /**< Distance of each model, or a lower bound if it is not exact. */
+        std::vector<char> exact;            /**< Non-zero for the models whose distance was calculated. */
+        std::size_t evaluations {0};        /**< Number of distances that were calculated. */
+    };
+
+    /**
+     *  @brief      Search statistics.
+     *  @details    Accumulated statistics of the searches of an inverted file.
+     */
+    struct Statistics final {
+        std::size_t queries {0};            /**< Number of searches. */
+        std::size_t evaluations {0};        /**< Number of distances that were calculated. */
+        std::size_t saved {0};              /**< Number of distances that a linear scan would have added. */
+    };
+
+    //// Constants /////
+
+    static constexpr std::uint32_t version {1};             /**< Current version of the format. */
+
+    static constexpr std::size_t defaultProbes {4};         /**< Default number of probed cells. */
+
+    static constexpr unsigned long long seed {1};           /**< Seed of the initial centers of the cells. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor partitions a set of descriptors. The initial centers are chosen
+     *              with a fixed seed, so the same descriptors always give the same cells.
+     *  @param[in]  points  The descriptors. Each row is the descriptor of one model.
+     *  @param[in]  nCells  The number of cells. If it is zero, the default number of cells is used
+     *              (see defaultCells).
+     */
+    InvertedFile(const nct::Matrix& points, std::size_t nCells);
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor reads the cells of a set of descriptors from a file. 
+     *  @param[in]  fileName  The name of the file.
+     *  @param[in]  points  The descriptors. The first rows must be the ones used to build the 
+     *              cells, and the others are appended (see append).
+     */
+    InvertedFile(const QString& fileName, const nct::Matrix& points);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    InvertedFile(const InvertedFile&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    InvertedFile(InvertedFile&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~InvertedFile() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    InvertedFile& operator=(const InvertedFile&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    InvertedFile& operator=(InvertedFile&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Size.
+     *  @details    This function returns the number of models of the inverted file.
+     *  @returns    The number of models.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     *  @brief      Number of cells.
+     *  @details    This function returns the number of cells of the inverted file.
+     *  @returns    The number of cells.
+     */
+    std::size_t numberOfCells() const noexcept;
+
+    /**
+     *  @brief      Appended models.
+     *  @details    This function returns the number of models that were appended after the cells
+     *              were built.
+     *  @returns    The number of appended models.
+     */
+    std::size_t appended() const noexcept;
+
+    /**
+     *  @brief      Append model.
+     *  @details    This function adds one model to the cell of its closest center. The model gets 
+     *              the next index. This function is not thread safe.
+     *  @param[in]  point  The first of the elements of the descriptor of the model.
+     */
+    void append(const double* point);
+
+    /**
+     *  @brief      Remove last model.
+     *  @details    This function removes the last model, which must have been appended after the 
+     *              cells were built. This function is not thread safe.
+     */
+    void popBack();
+
+    /**
+     *  @brief      Search.
+     *  @details    This function compares a query with the models of the cells whose centers are
+     *              the closest to it. The calculation of a distance is abandoned as soon as it 
+     *              exceeds the k-th distance of the probed models. The models of the other cells 
+     *              get the k-th distance, so they are ranked after the k closest probed models and 
+     *              their distances are calculated when their ranks are requested. The ties are 
+     *              broken by the index of the model, as in Ranking. The removed models are not 
+     *              compared.
+     *  @param[in]  query  The descriptor of the query.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of neighbors.
+     *  @param[in]  nProbes  The number of probed cells. If it is zero or greater than the number 
+     *              of cells, every cell is probed.
+     *  @param[in]  removed  Non-zero for the removed models, or empty if no model was removed. 
+     *              The result only contains the other models, in the same order.
+     *  @returns    The distances of the models.
+     */
+    Result search(const nct::RealVector& query, nct::geometry::mesh::DistanceFunction f, 
+        std::size_t k, std::size_t nProbes, const std::vector<char>& removed = std::vector<char>()) const;
+
+    /**
+     *  @brief      Statistics.
+     *  @details    This function returns the accumulated statistics of the searches.
+     *  @returns    The statistics.
+     */
+    Statistics statistics() const noexcept;
+
+    /**
+     *  @brief      Write.
+     *  @details    This function writes the inverted file in a file. The appended models are not 
+     *              stored.
+     *  @param[in]  fileName  The name of the file.
+     */
+    void write(const QString& fileName) const;
+
+    /**
+     *  @brief      Default cells.
+     *  @details    This function returns the default number of cells of a collection, which is the
+     *              square root of its number of models.
+     *  @param[in]  nModels  The number of models.
+     *  @returns    The number of cells.
+     */
+    static std::size_t defaultCells(std::size_t nModels) noexcept;
+
+private:
+
+    //// Methods /////
+
+    /**
+     *  @brief      Sort points.
+     *  @details    This function copies the descriptors in the order of the cells.
+     *  @param[in]  points  The descriptors. Each row is the descriptor of one model.
+     */
+    void sortPoints(const nct::Matrix& points);
+
+    //// Member variables ////
+
+    nct::Matrix centers_;                                   /**< Center of each cell, one per row. */
+
+    std::vector<std::uint32_t> offsets_;                    /**< Position of the first model of each cell. */
+
+    std::vector<std::uint32_t> order_;                      /**< Models sorted by cell. */
+
+    nct::RealVector points_;                                /**< Descriptors sorted by cell, one after another. */
+
+    /** Appended models of each cell. */
+    std::vector<std::vector<std::uint32_t>> appendedModels_;
+
+    std::vector<double> appendedPoints_;                    /**< Descriptors of the appended models. */
+
+    std::size_t nDimensions_ {0};                           /**< Number of elements of each descriptor. */
+
+    std::uint64_t checksum_ {0};                            /**< Checksum of the descriptors. */
+
+    mutable std::atomic<std::size_t> queries_ {0};          /**< Number of searches. */
+
+    mutable std::atomic<std::size_t> evaluations_ {0};      /**< Number of calculated distances. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -33,6 +33,8 @@
 #include "HMDialog.h"
 #include "RSDDialog.h"
 #include "SDDialog.h"
+#include "FeatureFile.h"
+#include "CollectionJournal.h"
 
 #include "nct/nct_utils.h"
 #include "nct/nct_exception.h"
@@ -44,7 +46,9 @@
 #include "qt_tools/graphics_3d/VoxelizedObject.h"
 #include "qt_tools/QtConfig.h"
 
+#include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QColorDialog>
@@ -69,6 +73,8 @@ MainWindow::MainWindow(QWidget *objFather): QMainWindow(objFather)
     connect(ui_.loadAction, &QAction::triggered, this, &MainWindow::loadModel);
 
     connect(ui_.loadConfigFileAction, &QAction::triggered, this, qOverload<>(&MainWindow::loadConfigFile));
+
+    connect(ui_.packFeaturesAction, &QAction::triggered, this, &MainWindow::packFeatures);
     
     connect(ui_.resetButton, &QPushButton::clicked, this, &MainWindow::reset);
 
@@ -133,6 +139,12 @@ MainWindow::MainWindow(QWidget *objFather): QMainWindow(objFather)
     normals_ = std::make_shared<nct::Array<nct::Vector3D<double>>>();
     triangles_ = std::make_shared<nct::Array<nct::Vector3D<unsigned int>>>();
 
+    descriptorStore_ = std::make_shared<DescriptorStore>();
+
+    // The descriptors of the compared meshes are kept between sessions.
+    queryCache_ = std::make_shared<QueryCache>(QueryCache::defaultCapacity, 
+        QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("queries"));
+
     ui_.loadConfigFileAction->setVisible(false);
     loadConfigFile(":/config/config/model_data_embeded.txt");
 }
@@ -228,14 +240,16 @@ void MainWindow::loadConfigFile(const QString& fileName)
         QApplication::setOverrideCursor(Qt::WaitCursor);
 
         // Load "Config file"
-        QFile file(fileName);
-        file.open(QIODevice::ReadOnly | QIODevice::Text);
-        QByteArray fileData = file.readAll();
+        meshData_ = readMeshDataFile(fileName);
 
-        if (fileData.size() == 0)
-            throw OperationException("Bad input file", "");
+        // Load the descriptors of the collection and the changes of its journal.
+        auto store = std::make_shared<DescriptorStore>();
+        CollectionJournal journal(fileName);
+        journal.load(meshData_, *store);
+        descriptorStore_ = store;
 
-        meshData_ = decodeMeshData(fileData);
+        // The rankings of the previous collection are discarded.
+        queryCache_->reset(queryCache_->directory());
 
         QApplication::restoreOverrideCursor();
     }
@@ -256,11 +270,47 @@ void MainWindow::loadConfigFile(const QString& fileName)
         meshData_.models.clear();
         meshData_.infoFields.clear();
 
+        descriptorStore_ = std::make_shared<DescriptorStore>();
+        queryCache_->reset(queryCache_->directory());
+
         QApplication::restoreOverrideCursor();
         showErrorMessage("Unable to load the specified configuration file", &ex);
     }
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void MainWindow::packFeatures()
+{
+    if (descriptorStore_->empty())
+    {
+        showErrorMessage("This operation requires a mesh collection loaded in memory.", nullptr);
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Packed feature file"), 
+        FeatureFile::defaultFileName);
+    if (fileName.isNull())
+        return;
+
+    try
+    {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+
+        Array<QString> modelNames(meshData_.models.rows());
+        for (unsigned int i = 0; i < modelNames.size(); i++)
+            modelNames[i] = meshData_.models(i, 0);
+
+        FeatureFile::write(fileName, *descriptorStore_, modelNames);
+
+        QApplication::restoreOverrideCursor();
+    }
+    catch (const std::exception& ex)
+    {
+        QApplication::restoreOverrideCursor();
+        showErrorMessage("Unable to write the packed feature file", &ex);
+    }
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void MainWindow::redraw()
 {        
@@ -371,6 +421,8 @@ void MainWindow::showSDDialog()
     dialog.setModal(true);
     dialog.setModel(vertices_, triangles_);
     dialog.setMeshData(meshData_);
+    dialog.setDescriptorStore(descriptorStore_);
+    dialog.setQueryCache(queryCache_);
     dialog.exec();
 }
 
@@ -381,6 +433,8 @@ void MainWindow::showRSDDialog()
     dialog.setModal(true);
     dialog.setModel(vertices_, triangles_);
     dialog.setMeshData(meshData_);
+    dialog.setDescriptorStore(descriptorStore_);
+    dialog.setQueryCache(queryCache_);
     dialog.exec();
 }
 
@@ -391,6 +445,8 @@ void MainWindow::showHMDialog()
     dialog.setModal(true);
     dialog.setModel(vertices_, triangles_);
     dialog.setMeshData(meshData_);
+    dialog.setDescriptorStore(descriptorStore_);
+    dialog.setQueryCache(queryCache_);
     dialog.exec();
 }
 
@@ -423,247 +479,6 @@ void MainWindow::blockControlSignals(bool blockSignals)
     ui_.voxelsSpinBox->blockSignals(blockSignals);
 }
 
-//-----------------------------------------------------------------------------------------------------------------
-MainWindow::MeshData MainWindow::decodeMeshData(const QByteArray& meshData)
-{
-    MeshData data;
-
-    data.featurePath = "";
-    data.screenshotsPath = "";
-    data.nModels = 0;
-    data.models.clear();
-
-    data.nSamps = 0;
-    data.nBins = 0;
-    data.nVox = 0;
-    data.nTestAng = 0;
-    data.nTestSteps = 0;
-    data.iniStep = 0;
-    data.endStep = 0;
-
-    // Read header and secret key
-    stringstream file(meshData.data());
-
-    string line;
-    string entry = "A-TOOLS MESH DATA V1.0";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line != entry)
-        throw OperationException("Bad header", "");
-
-    // Paths
-    entry = "Feature-Path:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad feature file path", "");
-    data.featurePath = QString(line.substr(entry.length() + 1).c_str());
-
-    entry = "Screenshot-Path:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad screenshot file path", "");
-    data.screenshotsPath = QString(line.substr(entry.length() + 1).c_str());
-
-    // Read configuration of descriptors
-    entry = "N-Samples:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of samples", "");
-    data.nSamps = atoi(line.substr(entry.length()).c_str());
-
-    entry = "N-Bins:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of bins", "");
-    data.nBins = atoi(line.substr(entry.length()).c_str());
-
-    entry = "N-Vox:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of voxels", "");
-    data.nVox = atoi(line.substr(entry.length()).c_str());
-
-    entry = "N-Test-Angles:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of test angles", "");
-    data.nTestAng = atoi(line.substr(entry.length()).c_str());
-
-    entry = "N-Test-Steps:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of test angles", "");
-    data.nTestSteps = atoi(line.substr(entry.length()).c_str());
-
-    entry = "Ini-Step:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of test angles", "");
-    data.iniStep = atof(line.substr(entry.length()).c_str());
-
-    entry = "End-Step:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of test angles", "");
-    data.endStep = atof(line.substr(entry.length()).c_str());
-
-    entry = "N-Models:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of models", "");
-    data.nModels = atoi(line.substr(entry.length()).c_str());
-
-    entry = "N-Info:";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad number of info fields", "");
-    data.nInfo = atoi(line.substr(entry.length()).c_str());
-
-    // Read info fields
-    entry = "----Info---";
-    getline(file, line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad info section", "");
-
-    data.infoFields.resize(data.nInfo);
-    for (unsigned int i = 0; i < data.nInfo; i++)
-    {
-        getline(file, entry);
-        entry = nct::trim(entry);
-        if (file.fail())
-            throw OperationException("Bad field", "");
-        data.infoFields[i] = QString::fromLatin1(entry.c_str());
-    }
-
-    // Read models        
-    entry = "----Data----";
-    getline(file, line);
-    line = nct::trim(line);
-    if (file.fail() || line.find(entry) == string::npos)
-        throw OperationException("Bad model section", "");
-
-    data.models.resize(data.nModels, 9);
-    for (unsigned int i = 0; i < data.nModels; i++)
-    {
-        getline(file, entry);
-        entry = nct::trim(entry);
-        if (file.fail())
-            throw OperationException("Bad model", "");
-
-        std::size_t posIni = 0;
-        std::size_t posEnd = 0;
-        for (unsigned int j = 0; j < 9; j++)
-        {
-            if (j < 8)
-                posEnd = entry.find(',', posIni);
-            else
-                posEnd = entry.size();
-
-            if (posEnd != string::npos)
-                data.models(i, j) = QString::fromLatin1(entry.substr(posIni, posEnd - posIni).c_str()).trimmed();
-            posIni = posEnd + 1;
-        }
-    }
-
-
-    return data;
-}
-
-//-----------------------------------------------------------------------------------------------------------------
-nct::Matrix MainWindow::decodeMatrixFile(const QString& arrayFile)
-{
-    QFile file(arrayFile);
-    file.open(QIODevice::ReadOnly);
-    QDataStream i(&file);
-
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_bad_input_stream, SOURCE_INFO);
-
-    // Read number of rows and number of columns.
-    size_t r = 0;
-    size_t c = 0;
-    i.readRawData(reinterpret_cast<char*> (&r), sizeof(size_t));
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_number_of_rows, SOURCE_INFO);
-
-    i.readRawData(reinterpret_cast<char*> (&c), sizeof(size_t));
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_number_of_columns, SOURCE_INFO);
-
-    // Read data.
-    Array2D<double> arr(r, c);
-    i.readRawData(reinterpret_cast<char*> (arr.data()), sizeof(double) * arr.size());
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_data, SOURCE_INFO);
-
-    return arr;
-}
-
-//-----------------------------------------------------------------------------------------------------------------
-nct::RealVector MainWindow::decodeVectorFile(const QString& arrayFile)
-{
-    QFile file(arrayFile);    
-    file.open(QIODevice::ReadOnly);
-    QDataStream i(&file);
-
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_bad_input_stream, SOURCE_INFO);
-
-    // Read number of rows and number of columns.
-    nct::size_t n_ = 0;
-
-    i.readRawData(reinterpret_cast<char*> (&n_), sizeof(nct::size_t));
-
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_array_size, SOURCE_INFO);
-
-    // Read data.
-    Array<double> arr(n_);
-    i.readRawData(reinterpret_cast<char*> (arr.data()), sizeof(double) * arr.size());
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_data, SOURCE_INFO);
-
-    return arr;
-}
-
-//-----------------------------------------------------------------------------------------------------------------
-nct::Array<nct::signal::spherical_harmonics::SphericalHarmonic> MainWindow::decodeHarmonicFile(const QString& arrayFile)
-{
-    QFile file(arrayFile);
-    file.open(QIODevice::ReadOnly);
-    QDataStream i(&file);
-
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_bad_input_stream, SOURCE_INFO);
-
-    // Read number of rows and number of columns.
-    nct::size_t n_ = 0;
-
-    i.readRawData(reinterpret_cast<char*> (&n_), sizeof(nct::size_t));
-
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_array_size, SOURCE_INFO);
-
-    // Read data.
-    Array<nct::signal::spherical_harmonics::SphericalHarmonic> arr(n_);
-    i.readRawData(reinterpret_cast<char*> (arr.data()), sizeof(nct::signal::spherical_harmonics::SphericalHarmonic) * arr.size());
-    if (!i.status() == QDataStream::Ok)
-        throw IOException(exc_error_reading_data, SOURCE_INFO);
-
-    return arr;
-}
-
 //-----------------------------------------------------------------------------------------------------------------
 void MainWindow::showErrorMessage(const QString& message, const std::exception* exception)
 {
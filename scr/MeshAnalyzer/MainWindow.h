@@ -28,6 +28,9 @@
 //        HEADERS
 //=================================================================================================================
 #include "ui_MainWindow.h"
+#include "DescriptorStore.h"
+#include "QueryCache.h"
+#include "MeshData.h"
 
 #include "nct/nct.h"
 #include "nct/Array.h"
@@ -52,30 +55,9 @@ class MainWindow : public QMainWindow
 
 public:    
 
-    //// Structures /////
+    //// Types /////
 
-    /**
-     *  @brief      Mesh data.
-     *  @details    This structure defines the data of the mesh collection to analyze.
-     */
-    struct MeshData
-    {
-        QString featurePath;                /**< Path of the feature files. */        
-        QString screenshotsPath;            /**< Path of the screenshot files. */
-        
-        unsigned int nModels;               /**<  Number of models. */
-        unsigned int nInfo;                 /**<  Number of info fields. */
-        nct::Array2D<QString> models;       /**<  Array of models. */
-        std::vector<QString> infoFields;    /**<  Array of fields that describes the models. */
-
-        unsigned int nSamps;                /**<  Number of samples that are used to calculate the shape distributions. */
-        unsigned int nBins;                 /**<  Number of bins of the shape distributions. */
-        unsigned int nVox;                  /**<  Array of divisions that are used in the model rasterization. */
-        unsigned int nTestAng;              /**<  Number of test angles to compare symmetry descriptors. */
-        unsigned int nTestSteps;            /**<  Number of steps to compare shape dsitributions. */
-        double iniStep;                     /**<  Initial step to compare shape dsitributions. */
-        double endStep;                     /**<  Final step to compare shape dsitributions. */
-    };
+    using MeshData = ::MeshData;    /**< Mesh data of the collection. */
 
     //// Constructors and destructor /////
 
@@ -129,37 +111,6 @@ public:
      */
     void blockControlSignals(bool blockSignals);
 
-    /**
-     *  @brief      Decode mesh data.
-     *  @details    This function decodes the mesh data stored in a byte array.
-     *  @param[in]  meshData  The array with the mesh data.
-     */
-    static MeshData decodeMeshData(const QByteArray& meshData);
-
-    /**
-     *  @brief      Decode matrix.
-     *  @details    This function decodes a matrix stored in a binary array file.
-     *  @param[in]  arrayData  The binary array with the data.
-     *  @returns    The decoded matrix.
-     */
-    static nct::Matrix decodeMatrixFile(const QString& arrayFile);
-
-    /**
-     *  @brief      Decode vector.
-     *  @details    This function decodes a vector stored in a binary array file.
-     *  @param[in]  arrayData  The binary array with the data.
-     *  @returns    The decoded vector.
-     */
-    static nct::RealVector decodeVectorFile(const QString& arrayFile);
-
-    /**
-     *  @brief      Decode harmonic array.
-     *  @details    This function decodes an array of harmonic funtions stored in a binary array file.
-     *  @param[in]  arrayData  The binary array with the data.
-     *  @returns    The decoded array.
-     */
-    static nct::Array<nct::signal::spherical_harmonics::SphericalHarmonic> decodeHarmonicFile(const QString& arrayFile);
-
 private slots:
 
     //// Slots /////
@@ -189,6 +140,12 @@ private slots:
      */
     void loadConfigFile(const QString& fileName);
 
+    /**
+     *  @brief      Pack features.
+     *  @details    Writes the descriptors of the loaded collection in a packed feature file.
+     */
+    void packFeatures();
+
     /**
      *  @brief      Redraw scene.
      *  @details    Redraws the complete scene.
@@ -262,6 +219,10 @@ private:
 
     MainWindow::MeshData meshData_;                                 /**< Mesh data of the collection.*/
 
+    std::shared_ptr<DescriptorStore> descriptorStore_;              /**< Descriptors of the collection. */
+
+    std::shared_ptr<QueryCache> queryCache_;                        /**< Cache of the compared meshes. */
+
     std::shared_ptr<nct::Array<nct::Point3D>> vertices_;           /**< Array with the vertices of the model. */
     
     std::shared_ptr<nct::Array<nct::Vector3D<double>>> normals_;     /**< Array with the normals of the model. */
@@ -0,0 +1,283 @@
+//=================================================================================================================
+/**
+ *  @file       MeshData.cpp
+ *  @brief      MeshData implementation file.
+ *  @details    This file contains the implementation of the functions that decode the MeshData structure.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "MeshData.h"
+
+#include "nct/nct_utils.h"
+#include "nct/nct_exception.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        FUNCTIONS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+MeshData decodeMeshData(const QByteArray& meshData)
+{
+    MeshData data;
+
+    data.featurePath = "";
+    data.screenshotsPath = "";
+    data.nModels = 0;
+    data.models.clear();
+
+    data.nSamps = 0;
+    data.nBins = 0;
+    data.nVox = 0;
+    data.nTestAng = 0;
+    data.nTestSteps = 0;
+    data.iniStep = 0;
+    data.endStep = 0;
+
+    // Read header and secret key
+    stringstream file(meshData.data());
+
+    string line;
+    string entry = "A-TOOLS MESH DATA V1.0";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line != entry)
+        throw OperationException("Bad header", "");
+
+    // Paths
+    entry = "Feature-Path:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad feature file path", "");
+    data.featurePath = QString(line.substr(entry.length() + 1).c_str());
+
+    entry = "Screenshot-Path:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad screenshot file path", "");
+    data.screenshotsPath = QString(line.substr(entry.length() + 1).c_str());
+
+    // Read configuration of descriptors
+    entry = "N-Samples:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of samples", "");
+    data.nSamps = atoi(line.substr(entry.length()).c_str());
+
+    entry = "N-Bins:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of bins", "");
+    data.nBins = atoi(line.substr(entry.length()).c_str());
+
+    entry = "N-Vox:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of voxels", "");
+    data.nVox = atoi(line.substr(entry.length()).c_str());
+
+    entry = "N-Test-Angles:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of test angles", "");
+    data.nTestAng = atoi(line.substr(entry.length()).c_str());
+
+    entry = "N-Test-Steps:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of test angles", "");
+    data.nTestSteps = atoi(line.substr(entry.length()).c_str());
+
+    entry = "Ini-Step:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of test angles", "");
+    data.iniStep = atof(line.substr(entry.length()).c_str());
+
+    entry = "End-Step:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of test angles", "");
+    data.endStep = atof(line.substr(entry.length()).c_str());
+
+    entry = "N-Models:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of models", "");
+    data.nModels = atoi(line.substr(entry.length()).c_str());
+
+    entry = "N-Info:";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad number of info fields", "");
+    data.nInfo = atoi(line.substr(entry.length()).c_str());
+
+    // Read info fields
+    entry = "----Info---";
+    getline(file, line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad info section", "");
+
+    data.infoFields.resize(data.nInfo);
+    for (unsigned int i = 0; i < data.nInfo; i++)
+    {
+        getline(file, entry);
+        entry = nct::trim(entry);
+        if (file.fail())
+            throw OperationException("Bad field", "");
+        data.infoFields[i] = QString::fromLatin1(entry.c_str());
+    }
+
+    // Read models        
+    entry = "----Data----";
+    getline(file, line);
+    line = nct::trim(line);
+    if (file.fail() || line.find(entry) == string::npos)
+        throw OperationException("Bad model section", "");
+
+    data.models.resize(data.nModels, 9);
+    for (unsigned int i = 0; i < data.nModels; i++)
+    {
+        getline(file, entry);
+        entry = nct::trim(entry);
+        if (file.fail())
+            throw OperationException("Bad model", "");
+
+        std::size_t posIni = 0;
+        std::size_t posEnd = 0;
+        for (unsigned int j = 0; j < 9; j++)
+        {
+            if (j < 8)
+                posEnd = entry.find(',', posIni);
+            else
+                posEnd = entry.size();
+
+            if (posEnd != string::npos)
+                data.models(i, j) = QString::fromLatin1(entry.substr(posIni, posEnd - posIni).c_str()).trimmed();
+            posIni = posEnd + 1;
+        }
+    }
+
+
+    return data;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MeshData readMeshDataFile(const QString& fileName)
+{
+    QFile file(fileName);
+    file.open(QIODevice::ReadOnly | QIODevice::Text);
+    QByteArray fileData = file.readAll();
+
+    if (fileData.size() == 0)
+        throw OperationException("Bad input file", "");
+
+    return decodeMeshData(fileData);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QByteArray encodeMeshData(const MeshData& meshData)
+{
+    if ((meshData.models.rows() != meshData.nModels) || (meshData.infoFields.size() != meshData.nInfo))
+        throw OperationException("Bad mesh data", "");
+
+    ostringstream file;
+    file.precision(17);
+
+    // Header and paths
+    file << "A-TOOLS MESH DATA V1.0" << "\n";
+    file << "Feature-Path: " << meshData.featurePath.toLatin1().data() << "\n";
+    file << "Screenshot-Path: " << meshData.screenshotsPath.toLatin1().data() << "\n";
+
+    // Configuration of descriptors
+    file << "N-Samples: " << meshData.nSamps << "\n";
+    file << "N-Bins: " << meshData.nBins << "\n";
+    file << "N-Vox: " << meshData.nVox << "\n";
+    file << "N-Test-Angles: " << meshData.nTestAng << "\n";
+    file << "N-Test-Steps: " << meshData.nTestSteps << "\n";
+    file << "Ini-Step: " << meshData.iniStep << "\n";
+    file << "End-Step: " << meshData.endStep << "\n";
+    file << "N-Models: " << meshData.nModels << "\n";
+    file << "N-Info: " << meshData.nInfo << "\n";
+
+    // Info fields
+    file << "----Info---" << "\n";
+    for (const auto& field : meshData.infoFields)
+        file << field.toLatin1().data() << "\n";
+
+    // Models. Each row has 9 comma-separated fields.
+    file << "----Data----" << "\n";
+    for (unsigned int i = 0; i < meshData.nModels; i++)
+    {
+        for (unsigned int j = 0; j < 9; j++)
+        {
+            if (j > 0)
+                file << ",";
+            if (j < meshData.models.columns())
+                file << meshData.models(i, j).toLatin1().data();
+        }
+        file << "\n";
+    }
+
+    auto text = file.str();
+    return QByteArray(text.data(), static_cast<qsizetype>(text.size()));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void writeMeshDataFile(const QString& fileName, const MeshData& meshData)
+{
+    auto fileData = encodeMeshData(meshData);
+
+    // The file is replaced atomically, so that a collection is never left with a partial 
+    // configuration file.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    if (file.write(fileData) != fileData.size())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    if (!file.commit())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,99 @@
+//=================================================================================================================
+/**
+ *  @file       MeshData.h
+ *  @brief      MeshData structure.
+ *  @details    Declaration file of the MeshData structure.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef MESH_DATA_H_INCLUDE
+#define MESH_DATA_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array2D.h"
+
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Mesh data.
+ *  @details    This structure defines the data of the mesh collection to analyze.
+ */
+struct MeshData
+{
+    QString featurePath;                /**< Path of the feature files. */        
+    QString screenshotsPath;            /**< Path of the screenshot files. */
+    
+    unsigned int nModels {0};           /**<  Number of models. */
+    unsigned int nInfo {0};             /**<  Number of info fields. */
+    nct::Array2D<QString> models;       /**<  Array of models. */
+    std::vector<QString> infoFields;    /**<  Array of fields that describes the models. */
+
+    unsigned int nSamps {0};            /**<  Number of samples that are used to calculate the shape distributions. */
+    unsigned int nBins {0};             /**<  Number of bins of the shape distributions. */
+    unsigned int nVox {0};              /**<  Array of divisions that are used in the model rasterization. */
+    unsigned int nTestAng {0};          /**<  Number of test angles to compare symmetry descriptors. */
+    unsigned int nTestSteps {0};        /**<  Number of steps to compare shape dsitributions. */
+    double iniStep {0};                 /**<  Initial step to compare shape dsitributions. */
+    double endStep {0};                 /**<  Final step to compare shape dsitributions. */
+};
+
+/**
+ *  @brief      Decode mesh data.
+ *  @details    This function decodes the mesh data stored in a byte array.
+ *  @param[in]  meshData  The array with the mesh data.
+ *  @returns    The decoded mesh data.
+ */
+MeshData decodeMeshData(const QByteArray& meshData);
+
+/**
+ *  @brief      Read mesh data.
+ *  @details    This function reads and decodes a configuration file of a mesh collection.
+ *  @param[in]  fileName  The configuration file.
+ *  @returns    The decoded mesh data.
+ */
+MeshData readMeshDataFile(const QString& fileName);
+
+/**
+ *  @brief      Encode mesh data.
+ *  @details    This function encodes the mesh data in the format of the configuration files.
+ *  @param[in]  meshData  The mesh data to encode.
+ *  @returns    The array with the encoded mesh data.
+ */
+QByteArray encodeMeshData(const MeshData& meshData);
+
+/**
+ *  @brief      Write mesh data.
+ *  @details    This function writes a configuration file of a mesh collection. An existing file
+ *              is replaced atomically.
+ *  @param[in]  fileName  The configuration file.
+ *  @param[in]  meshData  The mesh data to write.
+ */
+void writeMeshDataFile(const QString& fileName, const MeshData& meshData);
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,95 @@
+//=================================================================================================================
+/**
+ *  @file       MeshFile.cpp
+ *  @brief      Mesh file implementation file.
+ *  @details    This file contains the implementation of the functions that read mesh files.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "MeshFile.h"
+
+#include "nct/nct_exception.h"
+#include "nct/geometry/StlMesh.h"
+#include "nct/geometry/PlyMesh.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryFile>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FUNCTIONS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+MeshGeometry readMeshFile(const QString& fileName)
+{
+    MeshGeometry result;
+
+    QFileInfo file(fileName);
+    if (file.suffix().toLower() == "stl")
+    {
+        mesh::StlMesh model(fileName.toLatin1().data());
+        auto mesh = model.triangularMesh();
+
+        result.vertices = std::move(std::get<0>(mesh));
+        result.triangles = std::move(std::get<2>(mesh));
+    }
+    else if (file.suffix().toLower() == "ply")
+    {
+        mesh::PlyMesh model(fileName.toLatin1().data());
+        auto mesh = model.triangularMesh();
+
+        result.vertices = std::move(std::get<0>(mesh));
+        result.triangles = std::move(std::get<1>(mesh));
+    }
+    else
+    {
+        throw OperationException("File extension not supported by this application", "");
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MeshGeometry readMeshData(const QByteArray& data, const QString& format)
+{
+    auto suffix = format.toLower();
+    if ((suffix != "stl") && (suffix != "ply"))
+        throw OperationException("File extension not supported by this application", "");
+
+    QTemporaryFile file(QDir(QDir::tempPath()).filePath("MeshData_XXXXXX." + suffix));
+    if (!file.open())
+        throw OperationException("Unable to create a temporary mesh file", "");
+
+    if (file.write(data) != data.size())
+        throw OperationException("Unable to write a temporary mesh file", "");
+    file.close();
+
+    return readMeshFile(file.fileName());
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,71 @@
+//=================================================================================================================
+/**
+ *  @file       MeshFile.h
+ *  @brief      Mesh file functions.
+ *  @details    Declaration file of the functions that read mesh files.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef MESH_FILE_H_INCLUDE
+#define MESH_FILE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Vector3D.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Triangular mesh.
+ *  @details    This structure contains the vertices and the triangles of a mesh.
+ */
+struct MeshGeometry
+{
+    nct::Array<nct::Point3D> vertices;                      /**< Vertices of the mesh. */
+    nct::Array<nct::Vector3D<unsigned int>> triangles;      /**< Triangles of the mesh. */
+};
+
+/**
+ *  @brief      Read mesh.
+ *  @details    This function reads a mesh stored in a STL or PLY file. The format is selected
+ *              according to the extension of the file.
+ *  @param[in]  fileName  The name of the file.
+ *  @returns    The vertices and triangles of the mesh.
+ */
+MeshGeometry readMeshFile(const QString& fileName);
+
+/**
+ *  @brief      Read mesh data.
+ *  @details    This function reads a mesh from the contents of a STL or PLY file. The contents are
+ *              written to a temporary file, because the mesh readers only read files.
+ *  @param[in]  data  The contents of the file.
+ *  @param[in]  format  The format of the contents: stl or ply.
+ *  @returns    The vertices and triangles of the mesh.
+ */
+MeshGeometry readMeshData(const QByteArray& data, const QString& format);
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
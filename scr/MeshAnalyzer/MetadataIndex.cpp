@@ -0,0 +1,171 @@
+//=================================================================================================================
+/**
+ *  @file       MetadataIndex.cpp
+ *  @brief      MetadataIndex class implementation file.
+ *  @details    This file contains the implementation of the MetadataIndex class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "MetadataIndex.h"
+
+#include "nct/nct_exception.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+MetadataIndex::MetadataIndex(const MeshData& meshData) :
+    nModels_(meshData.nModels), fields_(meshData.infoFields)
+{
+    if ((meshData.models.rows() < meshData.nModels) || 
+        ((meshData.nModels > 0) && (meshData.models.columns() < meshData.infoFields.size() + 1)))
+        throw ArgumentException("meshData", exc_bad_array_dimensions, SOURCE_INFO);
+
+    auto nWords = nModels_/64 + (nModels_ % 64 > 0);
+    bitmaps_.resize(fields_.size());
+    for (size_t j = 0; j < fields_.size(); j++) {
+        for (size_t i = 0; i < nModels_; i++) {
+            auto& bitmap = bitmaps_[j][normalize(meshData.models(i, j + 1))];
+            if (bitmap.size() == 0)
+                bitmap.resize(nWords, 0);
+            bitmap[i/64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t MetadataIndex::numberOfModels() const noexcept
+{
+    return nModels_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::vector<QString>& MetadataIndex::fields() const noexcept
+{
+    return fields_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::vector<QString> MetadataIndex::values(const QString& field) const
+{
+    std::vector<QString> result;
+    for (const auto& entry : bitmaps_[fieldIndex(field)])
+        result.push_back(entry.first);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MetadataIndex::Bitmap MetadataIndex::match(const Condition& condition) const
+{
+    auto& values = bitmaps_[fieldIndex(condition.field)];
+
+    Bitmap bitmap(nModels_/64 + (nModels_ % 64 > 0), 0);
+    for (const auto& value : condition.values) {
+        auto it = values.find(normalize(value));
+        if (it == values.end())
+            continue;
+
+        for (size_t w = 0; w < bitmap.size(); w++)
+            bitmap[w] |= it->second[w];
+    }
+
+    return bitmap;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MetadataIndex::Bitmap MetadataIndex::match(const Filter& filter) const
+{
+    // The unused bits of the last word stay clear.
+    Bitmap bitmap(nModels_/64 + (nModels_ % 64 > 0), ~std::uint64_t(0));
+    if (nModels_ % 64 > 0)
+        bitmap.back() = (std::uint64_t(1) << (nModels_ % 64)) - 1;
+
+    for (const auto& condition : filter) {
+        auto matched = match(condition);
+        for (size_t w = 0; w < bitmap.size(); w++)
+            bitmap[w] &= matched[w];
+    }
+
+    return bitmap;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::vector<unsigned int> MetadataIndex::select(const Filter& filter) const
+{
+    return models(match(filter));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t MetadataIndex::count(const Bitmap& bitmap) noexcept
+{
+    std::size_t n = 0;
+    for (auto word : bitmap)
+        n += std::popcount(word);
+
+    return n;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::vector<unsigned int> MetadataIndex::models(const Bitmap& bitmap)
+{
+    std::vector<unsigned int> result;
+    result.reserve(count(bitmap));
+    for (size_t w = 0; w < bitmap.size(); w++) {
+        for (auto word = bitmap[w]; word != 0; word &= word - 1)
+            result.push_back(static_cast<unsigned int>(64*w + std::countr_zero(word)));
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString MetadataIndex::normalize(const QString& value)
+{
+    return value.trimmed().toLower();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t MetadataIndex::fieldIndex(const QString& field) const
+{
+    auto name = normalize(field);
+    for (size_t j = 0; j < fields_.size(); j++) {
+        if (normalize(fields_[j]) == name)
+            return j;
+    }
+
+    throw OperationException("Unknown info field: " + field.toStdString(), "");
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
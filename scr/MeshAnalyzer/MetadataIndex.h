@@ -0,0 +1,222 @@
+//=================================================================================================================
+/**
+ *  @file       MetadataIndex.h
+ *  @brief      MetadataIndex class.
+ *  @details    Declaration file of the MetadataIndex class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef METADATA_INDEX_H_INCLUDE
+#define METADATA_INDEX_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "MeshData.h"
+
+#include <QtCore/QString>
+
+#include <cstdint>
+#include <vector>
+#include <map>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Metadata index class.
+ *  @details    This class indexes the info fields of the models of a collection, so that the 
+ *              comparisons can be restricted to the models that match a filter (see 
+ *              QueryEngine::setSelection). Each distinct value of a field has a bitmap with one bit 
+ *              per model, and a filter is evaluated with a few bitwise operations per word of the 
+ *              bitmaps. The values are compared without leading or trailing spaces and without 
+ *              distinction of case.
+ */
+class MetadataIndex final
+{
+public:
+
+    //// Types /////
+
+    /**
+     *  @brief      Bitmap.
+     *  @details    Words of 64 bits with one bit per model of the collection.
+     */
+    using Bitmap = std::vector<std::uint64_t>;
+
+    /**
+     *  @brief      Condition.
+     *  @details    A model matches a condition if its value of the field is any of the values.
+     */
+    struct Condition final {
+        QString field;                      /**< Name of the info field. */
+        std::vector<QString> values;        /**< Accepted values. */
+    };
+
+    /**
+     *  @brief      Filter.
+     *  @details    A model matches a filter if it matches every condition.
+     */
+    using Filter = std::vector<Condition>;
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes an empty index.
+     */
+    MetadataIndex() = default;
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor builds the bitmaps of the info fields of a collection.
+     *  @param[in]  meshData  The configuration data of the collection.
+     */
+    explicit MetadataIndex(const MeshData& meshData);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    MetadataIndex(const MetadataIndex&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    MetadataIndex(MetadataIndex&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~MetadataIndex() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    MetadataIndex& operator=(const MetadataIndex&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    MetadataIndex& operator=(MetadataIndex&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Number of models.
+     *  @details    This function returns the number of models of the indexed collection.
+     *  @returns    The number of models.
+     */
+    std::size_t numberOfModels() const noexcept;
+
+    /**
+     *  @brief      Fields.
+     *  @details    This function returns the names of the info fields.
+     *  @returns    The names of the fields.
+     */
+    const std::vector<QString>& fields() const noexcept;
+
+    /**
+     *  @brief      Values.
+     *  @details    This function returns the distinct values of a field.
+     *  @param[in]  field  The name of the field. The case is ignored.
+     *  @returns    The normalized values of the field in alphabetical order.
+     */
+    std::vector<QString> values(const QString& field) const;
+
+    /**
+     *  @brief      Match condition.
+     *  @details    This function finds the models that match a condition.
+     *  @param[in]  condition  The condition.
+     *  @returns    The bitmap of the models.
+     */
+    Bitmap match(const Condition& condition) const;
+
+    /**
+     *  @brief      Match filter.
+     *  @details    This function finds the models that match every condition of a filter.
+     *  @param[in]  filter  The filter. If it is empty, every model matches.
+     *  @returns    The bitmap of the models.
+     */
+    Bitmap match(const Filter& filter) const;
+
+    /**
+     *  @brief      Select models.
+     *  @details    This function finds the models that match every condition of a filter.
+     *  @param[in]  filter  The filter. If it is empty, every model matches.
+     *  @returns    The sorted indices of the models.
+     */
+    std::vector<unsigned int> select(const Filter& filter) const;
+
+    /**
+     *  @brief      Count models.
+     *  @details    This function counts the models of a bitmap.
+     *  @param[in]  bitmap  The bitmap.
+     *  @returns    The number of models.
+     */
+    static std::size_t count(const Bitmap& bitmap) noexcept;
+
+    /**
+     *  @brief      Models of a bitmap.
+     *  @details    This function returns the models of a bitmap.
+     *  @param[in]  bitmap  The bitmap.
+     *  @returns    The sorted indices of the models.
+     */
+    static std::vector<unsigned int> models(const Bitmap& bitmap);
+
+    /**
+     *  @brief      Normalize value.
+     *  @details    This function removes the leading and trailing spaces of a value and converts it 
+     *              to lower case.
+     *  @param[in]  value  The value.
+     *  @returns    The normalized value.
+     */
+    static QString normalize(const QString& value);
+
+private:
+
+    //// Methods /////
+
+    /**
+     *  @brief      Field index.
+     *  @details    This function finds a field by name.
+     *  @param[in]  field  The name of the field. The case is ignored.
+     *  @returns    The index of the field.
+     */
+    std::size_t fieldIndex(const QString& field) const;
+
+    //// Member variables ////
+
+    std::size_t nModels_ {0};                           /**< Number of models. */
+
+    std::vector<QString> fields_;                       /**< Names of the info fields. */
+
+    std::vector<std::map<QString, Bitmap>> bitmaps_;    /**< Bitmap of each value of each field. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,462 @@
+//=================================================================================================================
+/**
+ *  @file       MetricTree.cpp
+ *  @brief      MetricTree class implementation file.
+ *  @details    This file contains the implementation of the MetricTree class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "MetricTree.h"
+#include "QueryCache.h"
+
+#include "nct/nct_exception.h"
+#include "nct/statistics/distance_metrics.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QByteArray>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <utility>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the metric tree files.
+ */
+constexpr char treeFileMagic[8] {'A', 'T', 'V', 'P', 'T', 'R', 'E', 'E'};
+
+/**
+ *  @brief      Bound tolerance.
+ *  @details    Relative tolerance of the bounds given by the triangle inequality. The distances
+ *              are rounded, so a node is only discarded when its bound exceeds the k-th distance 
+ *              by more than this fraction.
+ */
+constexpr double boundTolerance {1e-9};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the metric tree files.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t distanceFunction {0};     /**< Distance function. */
+    std::uint64_t nModels {0};              /**< Number of models. */
+    std::uint64_t nDimensions {0};          /**< Number of elements of each descriptor. */
+    std::uint64_t nNodes {0};               /**< Number of nodes. */
+    std::uint64_t checksum {0};             /**< Checksum of the descriptors. */
+    std::uint64_t reserved {0};             /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 56, "Unexpected size of the file header.");
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+MetricTree::MetricTree(const nct::Matrix& points, nct::geometry::mesh::DistanceFunction f) :
+    points_(points.begin(), points.end()), nDimensions_(points.columns()), f_(f)
+{
+    if (!isMetric(f))
+        throw ArgumentException("f", exc_bad_distance_function, SOURCE_INFO);
+
+    if ((points.rows() == 0) || (points.columns() == 0))
+        throw EmptyArrayException("points", SOURCE_INFO);
+
+    if (points.rows() >= std::numeric_limits<std::uint32_t>::max())
+        throw ArgumentException("points", exc_value_too_large, SOURCE_INFO);
+
+    auto n = static_cast<std::uint32_t>(points.rows());
+    order_.resize(n);
+    for (std::uint32_t i = 0; i < n; i++)
+        order_[i] = i;
+
+    nodes_.reserve(2*(n/leafSize + 1));
+    build(0, n);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MetricTree::MetricTree(const QString& fileName, const nct::Matrix& points, 
+    nct::geometry::mesh::DistanceFunction f) : 
+    points_(points.begin(), points.end()), nDimensions_(points.columns()), f_(f)
+{
+    if (!isMetric(f))
+        throw ArgumentException("f", exc_bad_distance_function, SOURCE_INFO);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+    auto data = file.readAll();
+    if (static_cast<std::size_t>(data.size()) < sizeof(FileHeader))
+        throw IOException(exc_error_reading_file_header, SOURCE_INFO);
+
+    FileHeader header;
+    std::memcpy(&header, data.constData(), sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, treeFileMagic, sizeof(treeFileMagic)) != 0)
+        throw IOException(exc_bad_magic_key, SOURCE_INFO);
+
+    if ((header.version == 0) || (header.version > version))
+        throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+    if ((header.distanceFunction != static_cast<std::uint32_t>(f)) || 
+        (header.nModels > points.rows()) || (header.nDimensions != points.columns()) ||
+        (header.nModels == 0) || (header.nNodes == 0) || (header.nNodes > 2*header.nModels) ||
+        (static_cast<std::uint64_t>(data.size()) != sizeof(FileHeader) + 
+            header.nModels*sizeof(std::uint32_t) + header.nNodes*sizeof(Node)))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    // A tree of other descriptors would return wrong neighbors. The descriptors after the ones
+    // of the tree are appended models.
+    if (header.checksum != checksum(static_cast<std::size_t>(header.nModels)))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    auto first = data.constData() + sizeof(FileHeader);
+    order_.resize(static_cast<std::size_t>(header.nModels));
+    std::memcpy(order_.data(), first, order_.size()*sizeof(std::uint32_t));
+    first += order_.size()*sizeof(std::uint32_t);
+
+    nodes_.resize(static_cast<std::size_t>(header.nNodes));
+    std::memcpy(nodes_.data(), first, nodes_.size()*sizeof(Node));
+
+    for (auto model : order_) {
+        if (model >= header.nModels)
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+    }
+
+    for (const auto& node : nodes_) {
+        if ((node.first >= node.last) || (node.last > header.nModels) || 
+            (node.inner >= header.nNodes) || (node.outer >= header.nNodes))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+    }
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t MetricTree::size() const noexcept
+{
+    return points_.size()/nDimensions_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t MetricTree::appended() const noexcept
+{
+    return size() - order_.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MetricTree::append(const double* point)
+{
+    if (point == nullptr)
+        throw NullPointerException("point", SOURCE_INFO);
+
+    if (size() + 1 >= std::numeric_limits<std::uint32_t>::max())
+        throw ArgumentException("point", exc_value_too_large, SOURCE_INFO);
+
+    points_.insert(points_.end(), point, point + nDimensions_);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MetricTree::popBack()
+{
+    if (appended() == 0)
+        throw EmptyArrayException("appended", SOURCE_INFO);
+
+    points_.resize(points_.size() - nDimensions_);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::geometry::mesh::DistanceFunction MetricTree::distanceFunction() const noexcept
+{
+    return f_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MetricTree::Result MetricTree::search(const nct::RealVector& query, std::size_t k, 
+    const std::vector<char>& removed) const
+{
+    if (query.size() != nDimensions_)
+        throw ArgumentException("query", exc_bad_array_dimensions, SOURCE_INFO);
+
+    auto n = size();
+    if (!removed.empty() && (removed.size() != n))
+        throw ArgumentException("removed", exc_bad_array_size, SOURCE_INFO);
+
+    auto live = removed.empty() ? n : static_cast<size_t>(std::count(removed.begin(), removed.end(), 0));
+    if (live == 0)
+        return Result();
+
+    if ((k == 0) || (k > live))
+        k = live;
+
+    std::vector<double> x(query.begin(), query.end());
+
+    Result result;
+    result.distances.assign(n, 0);
+    result.exact.assign(n, 0);
+
+    // The k best models sorted by distance and index; the top is the worst of them.
+    std::priority_queue<std::pair<double, std::uint32_t>> best;
+    auto tau = [&]() {
+        return best.size() < k ? std::numeric_limits<double>::infinity() : best.top().first;
+    };
+
+    auto evaluate = [&](std::uint32_t model) {
+        double d = distance(x.begin(), model);
+        result.distances[model] = d;
+        result.exact[model] = 1;
+        result.evaluations++;
+
+        if (!removed.empty() && removed[model])
+            return d;
+
+        std::pair<double, std::uint32_t> entry {d, model};
+        if (best.size() < k) {
+            best.push(entry);
+        }
+        else if (entry < best.top()) {
+            best.pop();
+            best.push(entry);
+        }
+        return d;
+    };
+
+    // The appended models are not in the nodes, so they are always compared. They are compared 
+    // first, so that their distances can discard nodes.
+    for (auto i = order_.size(); i < n; i++)
+        evaluate(static_cast<std::uint32_t>(i));
+
+    // Each pending node keeps the lower bound of the distances of its models. The closest child 
+    // of each node is visited first.
+    std::vector<std::pair<std::uint32_t, double>> pending {{0, 0.0}};
+
+    while (!pending.empty()) {
+        auto [index, bound] = pending.back();
+        pending.pop_back();
+
+        if (bound > tau())
+            continue;
+
+        const auto& node = nodes_[index];
+        if (node.inner == 0) {
+            for (auto i = node.first; i < node.last; i++)
+                evaluate(order_[i]);
+            continue;
+        }
+
+        double d = evaluate(order_[node.first]);
+        double innerBound = d - node.innerRadius - boundTolerance*(d + node.innerRadius);
+        double outerBound = node.outerRadius - d - boundTolerance*(d + node.outerRadius);
+
+        if (d < 0.5*(node.innerRadius + node.outerRadius)) {
+            pending.push_back({node.outer, outerBound});
+            pending.push_back({node.inner, innerBound});
+        }
+        else {
+            pending.push_back({node.inner, innerBound});
+            pending.push_back({node.outer, outerBound});
+        }
+    }
+
+    // The models that were discarded are farther than the k-th model.
+    double kth = tau();
+    for (size_t i = 0; i < n; i++) {
+        if (!result.exact[i])
+            result.distances[i] = kth;
+    }
+
+    // The models after a removed one take the previous index.
+    if (live < n) {
+        RealVector distances(live);
+        std::vector<char> exact(live);
+        for (size_t i = 0, j = 0; i < n; i++) {
+            if (!removed[i]) {
+                distances[j] = result.distances[i];
+                exact[j] = result.exact[i];
+                j++;
+            }
+        }
+        result.distances = std::move(distances);
+        result.exact = std::move(exact);
+    }
+
+    queries_++;
+    evaluations_ += result.evaluations;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+MetricTree::Statistics MetricTree::statistics() const noexcept
+{
+    Statistics s;
+    s.queries = queries_;
+    s.evaluations = evaluations_;
+    s.saved = s.queries*size() - s.evaluations;
+    return s;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void MetricTree::write(const QString& fileName) const
+{
+    FileHeader header;
+    std::memcpy(header.magic, treeFileMagic, sizeof(treeFileMagic));
+    header.version = version;
+    header.distanceFunction = static_cast<std::uint32_t>(f_);
+    header.nModels = order_.size();
+    header.nDimensions = nDimensions_;
+    header.nNodes = nodes_.size();
+    header.checksum = checksum(order_.size());
+
+    QByteArray data;
+    data.reserve(static_cast<qsizetype>(sizeof(FileHeader) + order_.size()*sizeof(std::uint32_t) + 
+        nodes_.size()*sizeof(Node)));
+    data.append(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    data.append(reinterpret_cast<const char*>(order_.data()), 
+        static_cast<qsizetype>(order_.size()*sizeof(std::uint32_t)));
+    data.append(reinterpret_cast<const char*>(nodes_.data()), static_cast<qsizetype>(nodes_.size()*sizeof(Node)));
+
+    // The file is replaced atomically, so that other processes never read a partial tree.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    if (file.write(data) != data.size())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    if (!file.commit())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool MetricTree::isMetric(nct::geometry::mesh::DistanceFunction f) noexcept
+{
+    return (f == mesh::DistanceFunction::EuclideanDistance) || 
+        (f == mesh::DistanceFunction::CityBlockDistance) ||
+        (f == mesh::DistanceFunction::ChebychevDistance);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double MetricTree::distance(std::vector<double>::const_iterator x, std::size_t model) const
+{
+    auto n = nDimensions_;
+    auto y = points_.begin() + model*n;
+
+    switch (f_) {
+        case mesh::DistanceFunction::EuclideanDistance:
+            return statistics::distance_metrics::euclideanDistance(x, x + n, y, y + n);
+
+        case mesh::DistanceFunction::CityBlockDistance:
+            return statistics::distance_metrics::cityBlockDistance(x, x + n, y, y + n);
+
+        default:
+            return statistics::distance_metrics::chebychevDistance(x, x + n, y, y + n);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint32_t MetricTree::build(std::uint32_t first, std::uint32_t last)
+{
+    auto index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(Node());
+    nodes_[index].first = first;
+    nodes_[index].last = last;
+
+    if (last - first <= leafSize)
+        return index;
+
+    // The vantage point is the model that is farthest from the first one, which tends to lie on 
+    // the border of the set.
+    auto x = points_.begin() + order_[first]*nDimensions_;
+    auto vantage = first;
+    double maxDistance = -1;
+    for (auto i = first + 1; i < last; i++) {
+        double d = distance(x, order_[i]);
+        if (d > maxDistance) {
+            maxDistance = d;
+            vantage = i;
+        }
+    }
+    std::swap(order_[first], order_[vantage]);
+
+    // The other models are split by the median of their distances to the vantage point.
+    x = points_.begin() + order_[first]*nDimensions_;
+    std::vector<std::pair<double, std::uint32_t>> d(last - first - 1);
+    for (auto i = first + 1; i < last; i++)
+        d[i - first - 1] = {distance(x, order_[i]), order_[i]};
+
+    auto middle = d.begin() + d.size()/2;
+    std::nth_element(d.begin(), middle, d.end());
+
+    double innerRadius = 0;
+    for (auto it = d.begin(); it != middle; ++it)
+        innerRadius = std::max(innerRadius, it->first);
+
+    double outerRadius = std::numeric_limits<double>::infinity();
+    for (auto it = middle; it != d.end(); ++it)
+        outerRadius = std::min(outerRadius, it->first);
+
+    for (size_t i = 0; i < d.size(); i++)
+        order_[first + 1 + i] = d[i].second;
+
+    auto split = first + 1 + static_cast<std::uint32_t>(d.size()/2);
+    auto inner = build(first + 1, split);
+    auto outer = build(split, last);
+
+    nodes_[index].inner = inner;
+    nodes_[index].outer = outer;
+    nodes_[index].innerRadius = innerRadius;
+    nodes_[index].outerRadius = outerRadius;
+
+    return index;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t MetricTree::checksum(std::size_t nModels) const
+{
+    // FNV-1a hash of the size and the elements of the descriptors.
+    auto hash = QueryCache::combine(QueryCache::initialHash, static_cast<std::uint64_t>(nModels));
+    hash = QueryCache::combine(hash, static_cast<std::uint64_t>(nDimensions_));
+    return QueryCache::combine(hash, points_.data(), nModels*nDimensions_*sizeof(double));
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
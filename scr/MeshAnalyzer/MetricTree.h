@@ -0,0 +1,300 @@
+//=================================================================================================================
+/**
+ *  @file       MetricTree.h
+ *  @brief      MetricTree class.
+ *  @details    Declaration file of the MetricTree class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef METRIC_TREE_H_INCLUDE
+#define METRIC_TREE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+#include "nct/geometry/mesh.h"
+
+#include <QtCore/QString>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Metric tree class.
+ *  @details    This class implements a vantage-point tree over the descriptors of a collection. Each 
+ *              node of the tree takes one model as vantage point and splits the other models of the 
+ *              node in two halves by their distance to it; the nodes with a few models are leaves. 
+ *              The k nearest models of a query are found exactly, and the triangle inequality 
+ *              discards the nodes whose models cannot be closer than the current k-th distance, so 
+ *              only a part of the distances is calculated. The tree requires a true metric, so only
+ *              the Euclidean, city-block and Chebychev distances are supported. 
+ *
+ *              Models can be appended to a tree without building it again. They are not inserted
+ *              in the nodes: every search compares them with the query, so the results are still 
+ *              exact and the cost of a search grows linearly with the appended models.
+ *
+ *              The tree can be stored next to the feature files of the collection. The file keeps
+ *              a checksum of the descriptors, so a tree is not used with a different collection.
+ *              A file can be read with more descriptors than the ones of the tree, as long as the 
+ *              first ones match; the other descriptors are appended.
+ *
+ *              File layout (all the integers are little-endian):
+ *              - Header: magic key, version, distance function, number of models, number of 
+ *                dimensions, number of nodes and checksum of the descriptors.
+ *              - Order: the models sorted by node (32-bit indices).
+ *              - Nodes: first and last position of the models of the node, indices of the inner and
+ *                outer children (32-bit) and radii of the inner and outer halves (64-bit).
+ *
+ *              The searches are thread safe.
+ */
+class MetricTree final
+{
+public:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Search result.
+     *  @details    Result of a k-nearest-neighbor search.
+     */
+    struct Result final {
+        nct::RealVector distances;          /**< Distance of each model, or a lower bound if it is not exact. */
+        std::vector<char> exact;            /**< Non-zero for the models whose distance was calculated. */
+        std::size_t evaluations {0};        /**< Number of distances that were calculated. */
+    };
+
+    /**
+     *  @brief      Search statistics.
+     *  @details    Accumulated statistics of the searches of a tree.
+     */
+    struct Statistics final {
+        std::size_t queries {0};            /**< Number of searches. */
+        std::size_t evaluations {0};        /**< Number of distances that were calculated. */
+        std::size_t saved {0};              /**< Number of distances that a linear scan would have added. */
+    };
+
+    //// Constants /////
+
+    static constexpr std::uint32_t version {1};             /**< Current version of the format. */
+
+    static constexpr std::size_t leafSize {8};              /**< Maximum number of models of a leaf. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor builds the tree of a set of descriptors.
+     *  @param[in]  points  The descriptors. Each row is the descriptor of one model.
+     *  @param[in]  f  The distance function.
+     */
+    MetricTree(const nct::Matrix& points, nct::geometry::mesh::DistanceFunction f);
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor reads the tree of a set of descriptors from a file. 
+     *  @param[in]  fileName  The name of the file.
+     *  @param[in]  points  The descriptors. The first rows must be the ones used to build the tree,
+     *              and the others are appended (see append).
+     *  @param[in]  f  The distance function. It must be the one used to build the tree.
+     */
+    MetricTree(const QString& fileName, const nct::Matrix& points, nct::geometry::mesh::DistanceFunction f);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    MetricTree(const MetricTree&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    MetricTree(MetricTree&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~MetricTree() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    MetricTree& operator=(const MetricTree&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    MetricTree& operator=(MetricTree&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Size.
+     *  @details    This function returns the number of models of the tree.
+     *  @returns    The number of models.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     *  @brief      Appended models.
+     *  @details    This function returns the number of models that were appended after the tree was
+     *              built, which are compared with every query.
+     *  @returns    The number of appended models.
+     */
+    std::size_t appended() const noexcept;
+
+    /**
+     *  @brief      Append model.
+     *  @details    This function adds one model at the end of the tree. This function is not 
+     *              thread safe.
+     *  @param[in]  point  The first of the elements of the descriptor of the model.
+     */
+    void append(const double* point);
+
+    /**
+     *  @brief      Remove last model.
+     *  @details    This function removes the last model, which must have been appended after the 
+     *              tree was built. This function is not thread safe.
+     */
+    void popBack();
+
+    /**
+     *  @brief      Distance function.
+     *  @details    This function returns the distance function of the tree.
+     *  @returns    The distance function.
+     */
+    nct::geometry::mesh::DistanceFunction distanceFunction() const noexcept;
+
+    /**
+     *  @brief      Search.
+     *  @details    This function finds the k nearest models of a query. The distances of the 
+     *              models that were not calculated are set to the k-th distance, which is a lower 
+     *              bound of them, so the result can be used to build a Ranking. The ties are broken 
+     *              by the index of the model, as in Ranking. The removed models are not returned, 
+     *              but they still discard nodes as vantage points.
+     *  @param[in]  query  The descriptor of the query.
+     *  @param[in]  k  The number of neighbors.
+     *  @param[in]  removed  Non-zero for the removed models, or empty if no model was removed. 
+     *              The result only contains the other models, in the same order.
+     *  @returns    The distances of the models.
+     */
+    Result search(const nct::RealVector& query, std::size_t k, 
+        const std::vector<char>& removed = std::vector<char>()) const;
+
+    /**
+     *  @brief      Statistics.
+     *  @details    This function returns the accumulated statistics of the searches.
+     *  @returns    The statistics.
+     */
+    Statistics statistics() const noexcept;
+
+    /**
+     *  @brief      Write.
+     *  @details    This function writes the tree in a file. The appended models are not stored.
+     *  @param[in]  fileName  The name of the file.
+     */
+    void write(const QString& fileName) const;
+
+    /**
+     *  @brief      Is metric.
+     *  @details    This function indicates whether a distance function is supported by the tree.
+     *  @param[in]  f  The distance function.
+     *  @returns    True if the distance function is a metric.
+     */
+    static bool isMetric(nct::geometry::mesh::DistanceFunction f) noexcept;
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Node.
+     *  @details    Node of the tree. The vantage point is the first model of the node.
+     */
+    struct Node final {
+        std::uint32_t first {0};            /**< Position of the first model of the node. */
+        std::uint32_t last {0};             /**< Position after the last model of the node. */
+        std::uint32_t inner {0};            /**< Inner child, or zero if the node is a leaf. */
+        std::uint32_t outer {0};            /**< Outer child, or zero if the node is a leaf. */
+        double innerRadius {0};             /**< Maximum distance from the vantage point to the inner half. */
+        double outerRadius {0};             /**< Minimum distance from the vantage point to the outer half. */
+    };
+
+    //// Methods /////
+
+    /**
+     *  @brief      Distance.
+     *  @details    This function calculates the distance between a descriptor and the descriptor of 
+     *              a model.
+     *  @param[in]  x  The first element of the descriptor.
+     *  @param[in]  model  The index of the model.
+     *  @returns    The distance.
+     */
+    double distance(std::vector<double>::const_iterator x, std::size_t model) const;
+
+    /**
+     *  @brief      Build.
+     *  @details    This function builds the node of a range of models and its children.
+     *  @param[in]  first  Position of the first model.
+     *  @param[in]  last  Position after the last model.
+     *  @returns    The index of the node.
+     */
+    std::uint32_t build(std::uint32_t first, std::uint32_t last);
+
+    /**
+     *  @brief      Checksum.
+     *  @details    This function calculates the checksum of the first descriptors.
+     *  @param[in]  nModels  The number of descriptors.
+     *  @returns    The checksum.
+     */
+    std::uint64_t checksum(std::size_t nModels) const;
+
+    //// Member variables ////
+
+    std::vector<double> points_;                            /**< Descriptors of the models, one after another. */
+
+    std::size_t nDimensions_ {0};                           /**< Number of elements of each descriptor. */
+
+    nct::geometry::mesh::DistanceFunction f_;               /**< Distance function. */
+
+    std::vector<std::uint32_t> order_;                      /**< Models of the nodes sorted by node. */
+
+    std::vector<Node> nodes_;                               /**< Nodes of the tree. The first is the root. */
+
+    mutable std::atomic<std::size_t> queries_ {0};          /**< Number of searches. */
+
+    mutable std::atomic<std::size_t> evaluations_ {0};      /**< Number of calculated distances. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,392 @@
+//=================================================================================================================
+/**
+ *  @file       QueryCache.cpp
+ *  @brief      QueryCache class implementation file.
+ *  @details    This file contains the implementation of the QueryCache class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "QueryCache.h"
+
+#include "nct/nct_exception.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QByteArray>
+
+#include <cstring>
+#include <utility>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the cache files.
+ */
+constexpr char cacheFileMagic[8] {'A', 'T', 'Q', 'C', 'A', 'C', 'H', 'E'};
+
+/**
+ *  @brief      Maximum number of arrays of an entry.
+ */
+constexpr std::uint32_t maxArrays {1024};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the cache files.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t nArrays {0};              /**< Number of arrays. */
+    std::uint64_t key {0};                  /**< Key of the entry. */
+    std::uint64_t checksum {0};             /**< Checksum of the sizes and the elements. */
+    std::uint64_t reserved[2] {};           /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 48, "Unexpected size of the file header.");
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryCache::QueryCache(std::size_t capacity, const QString& directory) :
+    capacity_(capacity), directory_(directory)
+{
+    if (capacity_ == 0)
+        throw ArgumentException("capacity", static_cast<unsigned long long>(capacity), 0ULL, 
+            RelationalOperator::GreaterThan, SOURCE_INFO);
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryCache::reset(const QString& directory)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = directory;
+    items_.clear();
+    positions_.clear();
+    statistics_ = Statistics();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString QueryCache::directory() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return directory_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t QueryCache::capacity() const noexcept
+{
+    return capacity_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t QueryCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool QueryCache::find(std::uint64_t key, Arrays& arrays)
+{
+    QString name;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = positions_.find(key);
+        if ((it != positions_.end()) && (it->second->arrays != nullptr)) {
+            items_.splice(items_.begin(), items_, it->second);
+            arrays = *it->second->arrays;
+            statistics_.hits++;
+            return true;
+        }
+
+        if (!directory_.isEmpty())
+            name = QDir(directory_).filePath(fileName(key));
+    }
+
+    // The file is read without the lock, so that other queries are not blocked.
+    std::shared_ptr<const Arrays> entry;
+    if (!name.isEmpty() && QFile::exists(name)) {
+        try {
+            entry = std::make_shared<const Arrays>(read(name, key));
+        }
+        catch (const std::exception&) {
+            // A damaged or outdated file is replaced when the entry is inserted.
+            entry.reset();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry == nullptr) {
+        statistics_.misses++;
+        return false;
+    }
+
+    arrays = *entry;
+    statistics_.fileHits++;
+    store({key, std::move(entry), nullptr});
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryCache::insert(std::uint64_t key, const Arrays& arrays)
+{
+    auto entry = std::make_shared<const Arrays>(arrays);
+
+    QString name;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        store({key, entry, nullptr});
+        if (!directory_.isEmpty())
+            name = QDir(directory_).filePath(fileName(key));
+    }
+
+    if (!name.isEmpty()) {
+        try {
+            QDir().mkpath(QFileInfo(name).absolutePath());
+            write(name, key, *entry);
+        }
+        catch (const std::exception&) {
+            // The directory can be read-only; the entry is kept in memory.
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool QueryCache::findRanking(std::uint64_t key, Ranking& ranking)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = positions_.find(key);
+    if ((it == positions_.end()) || (it->second->ranking == nullptr)) {
+        statistics_.misses++;
+        return false;
+    }
+
+    items_.splice(items_.begin(), items_, it->second);
+    ranking = *it->second->ranking;
+    statistics_.hits++;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryCache::insertRanking(std::uint64_t key, const Ranking& ranking)
+{
+    auto copy = std::make_shared<const Ranking>(ranking);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    store({key, nullptr, std::move(copy)});
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryCache::Statistics QueryCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString QueryCache::fileName(std::uint64_t key)
+{
+    return QString("query_%1.aqc").arg(key, 16, 16, QChar('0'));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryCache::Arrays QueryCache::read(const QString& fileName, std::uint64_t key)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+    auto data = file.readAll();
+    if (static_cast<std::size_t>(data.size()) < sizeof(FileHeader))
+        throw IOException(exc_error_reading_file_header, SOURCE_INFO);
+
+    FileHeader header;
+    std::memcpy(&header, data.constData(), sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, cacheFileMagic, sizeof(cacheFileMagic)) != 0)
+        throw IOException(exc_bad_magic_key, SOURCE_INFO);
+
+    if ((header.version == 0) || (header.version > version))
+        throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+    std::uint64_t sizesLength = header.nArrays*2*sizeof(std::uint64_t);
+    if ((header.key != key) || (header.nArrays > maxArrays) || 
+        (static_cast<std::uint64_t>(data.size()) < sizeof(FileHeader) + sizesLength))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    auto payload = data.constData() + sizeof(FileHeader);
+    auto payloadLength = static_cast<std::uint64_t>(data.size()) - sizeof(FileHeader);
+    if (combine(initialHash, payload, static_cast<std::size_t>(payloadLength)) != header.checksum)
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    std::vector<std::uint64_t> sizes(2*header.nArrays);
+    std::memcpy(sizes.data(), payload, static_cast<std::size_t>(sizesLength));
+
+    std::uint64_t nElements = 0;
+    for (std::uint32_t i = 0; i < header.nArrays; i++) {
+        if ((sizes[2*i] != 0) && (sizes[2*i + 1] > (payloadLength/sizeof(double))/sizes[2*i]))
+            throw IOException(exc_bad_file_format, SOURCE_INFO);
+        nElements += sizes[2*i]*sizes[2*i + 1];
+    }
+
+    if (payloadLength != sizesLength + nElements*sizeof(double))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    Arrays arrays(header.nArrays);
+    auto first = payload + sizesLength;
+    for (std::uint32_t i = 0; i < header.nArrays; i++) {
+        arrays[i].resize(static_cast<std::size_t>(sizes[2*i]), static_cast<std::size_t>(sizes[2*i + 1]));
+        std::memcpy(arrays[i].data(), first, arrays[i].size()*sizeof(double));
+        first += arrays[i].size()*sizeof(double);
+    }
+
+    return arrays;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryCache::write(const QString& fileName, std::uint64_t key, const Arrays& arrays)
+{
+    if (arrays.size() > maxArrays)
+        throw ArgumentException("arrays", exc_value_too_large, SOURCE_INFO);
+
+    std::vector<std::uint64_t> sizes;
+    std::size_t nElements = 0;
+    for (const auto& array : arrays) {
+        sizes.push_back(array.rows());
+        sizes.push_back(array.columns());
+        nElements += array.size();
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, cacheFileMagic, sizeof(cacheFileMagic));
+    header.version = version;
+    header.nArrays = static_cast<std::uint32_t>(arrays.size());
+    header.key = key;
+
+    QByteArray data;
+    data.reserve(static_cast<qsizetype>(sizeof(FileHeader) + sizes.size()*sizeof(std::uint64_t) + 
+        nElements*sizeof(double)));
+    data.append(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    data.append(reinterpret_cast<const char*>(sizes.data()), 
+        static_cast<qsizetype>(sizes.size()*sizeof(std::uint64_t)));
+    for (const auto& array : arrays)
+        data.append(reinterpret_cast<const char*>(array.data()), static_cast<qsizetype>(array.size()*sizeof(double)));
+
+    header.checksum = combine(initialHash, data.constData() + sizeof(FileHeader), data.size() - sizeof(FileHeader));
+    std::memcpy(data.data(), &header, sizeof(FileHeader));
+
+    // The file is replaced atomically, so that other processes never read a partial entry.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    if (file.write(data) != data.size())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    if (!file.commit())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t QueryCache::hash(const nct::Array<nct::Point3D>& vertices,
+    const nct::Array<nct::Vector3D<unsigned int>>& triangles)
+{
+    auto h = combine(initialHash, static_cast<std::uint64_t>(vertices.size()));
+    for (const auto& vertex : vertices) {
+        double coordinates[3] {vertex[0], vertex[1], vertex[2]};
+        h = combine(h, coordinates, sizeof(coordinates));
+    }
+
+    h = combine(h, static_cast<std::uint64_t>(triangles.size()));
+    for (const auto& triangle : triangles) {
+        std::uint32_t indices[3] {triangle[0], triangle[1], triangle[2]};
+        h = combine(h, indices, sizeof(indices));
+    }
+
+    return h;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned long long QueryCache::shapeDistributionSeed(std::uint64_t hash, unsigned int nSamps, 
+    unsigned int nBins) noexcept
+{
+    constexpr char tag[] {'s', 'e', 'e', 'd'};
+    hash = combine(hash, tag, sizeof(tag));
+    hash = combine(hash, nSamps);
+    return combine(hash, nBins);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t QueryCache::combine(std::uint64_t hash, const void* data, std::size_t size) noexcept
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t QueryCache::combine(std::uint64_t hash, const QString& text)
+{
+    hash = combine(hash, static_cast<std::uint64_t>(text.size()));
+    return combine(hash, text.utf16(), static_cast<std::size_t>(text.size())*sizeof(char16_t));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryCache::store(Item item)
+{
+    auto it = positions_.find(item.key);
+    if (it != positions_.end()) {
+        items_.erase(it->second);
+        positions_.erase(it);
+    }
+
+    items_.push_front(std::move(item));
+    positions_[items_.front().key] = items_.begin();
+
+    while (items_.size() > capacity_) {
+        positions_.erase(items_.back().key);
+        items_.pop_back();
+    }
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,355 @@
+//=================================================================================================================
+/**
+ *  @file       QueryCache.h
+ *  @brief      QueryCache class.
+ *  @details    Declaration file of the QueryCache class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+#ifndef QUERY_CACHE_H_INCLUDE
+#define QUERY_CACHE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "Ranking.h"
+
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+#include "nct/Vector3D.h"
+
+#include <QtCore/QString>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Query cache class.
+ *  @details    This class keeps the descriptors and the rankings of the meshes that were compared with
+ *              a collection, so that comparing a mesh again doesn't calculate them again. The entries
+ *              are addressed by keys that are hashes of the contents of the mesh and of the parameters
+ *              of the calculation (see hash and combine); the same hashes give the seeds of the
+ *              shape distributions, so a mesh always gets the same descriptors. 
+ *
+ *              The cache keeps the most recently used entries in memory. The entries made of arrays,
+ *              such as the descriptors, are also stored in the directory of the cache, one file per
+ *              key, and they are read from there when they are not in memory. A Ranking calculates 
+ *              the distances that are requested with the descriptors of the collection, so the 
+ *              rankings are only kept in memory and they are removed when the cache is reset. The 
+ *              class is thread safe.
+ *
+ *              File layout (all the integers are little-endian):
+ *              - Header: magic key, version, number of arrays, key of the entry and checksum of the
+ *                data.
+ *              - Sizes: the number of rows and columns of each array (64-bit).
+ *              - Data: the elements of each array (64-bit).
+ */
+class QueryCache final
+{
+public:
+
+    //// Types /////
+
+    /**
+     *  @brief      Arrays.
+     *  @details    Arrays that contain a descriptor or the closest models of a query.
+     */
+    using Arrays = std::vector<nct::Matrix>;
+
+    //// Structures /////
+
+    /**
+     *  @brief      Cache statistics.
+     *  @details    Accumulated statistics of the searches in a cache.
+     */
+    struct Statistics final {
+        std::size_t hits {0};               /**< Number of entries found in memory. */
+        std::size_t fileHits {0};           /**< Number of entries read from the directory. */
+        std::size_t misses {0};             /**< Number of entries that were not found. */
+    };
+
+    //// Constants /////
+
+    static constexpr std::uint32_t version {1};             /**< Current version of the format. */
+    static constexpr std::size_t defaultCapacity {64};      /**< Default number of entries in memory. */
+    static constexpr std::uint64_t initialHash {14695981039346656037ULL};   /**< Hash of empty data. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes an empty cache.
+     *  @param[in]  capacity  The maximum number of entries kept in memory.
+     *  @param[in]  directory  The directory where the arrays are stored. If it is empty, the arrays
+     *              are only kept in memory.
+     */
+    explicit QueryCache(std::size_t capacity = defaultCapacity, const QString& directory = QString());
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    QueryCache(const QueryCache&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    QueryCache(QueryCache&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~QueryCache() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    QueryCache& operator=(QueryCache&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Reset.
+     *  @details    This function removes the entries from memory and changes the directory of the 
+     *              cache. The files of the previous directory are kept.
+     *  @param[in]  directory  The directory where the arrays are stored. If it is empty, the arrays
+     *              are only kept in memory.
+     */
+    void reset(const QString& directory = QString());
+
+    /**
+     *  @brief      Directory.
+     *  @details    This function returns the directory where the arrays are stored.
+     *  @returns    The directory.
+     */
+    QString directory() const;
+
+    /**
+     *  @brief      Capacity.
+     *  @details    This function returns the maximum number of entries kept in memory.
+     *  @returns    The capacity of the cache.
+     */
+    std::size_t capacity() const noexcept;
+
+    /**
+     *  @brief      Size.
+     *  @details    This function returns the number of entries in memory.
+     *  @returns    The number of entries.
+     */
+    std::size_t size() const;
+
+    /**
+     *  @brief      Find arrays.
+     *  @details    This function searches the arrays of an entry in memory and then in the directory 
+     *              of the cache. A damaged or outdated file is treated as a miss.
+     *  @param[in]  key  The key of the entry.
+     *  @param[out]  arrays  The arrays of the entry, if it is found.
+     *  @returns    True if the entry was found.
+     */
+    bool find(std::uint64_t key, Arrays& arrays);
+
+    /**
+     *  @brief      Insert arrays.
+     *  @details    This function stores the arrays of an entry in memory and in the directory of the
+     *              cache. If the file cannot be written, the entry is only kept in memory.
+     *  @param[in]  key  The key of the entry.
+     *  @param[in]  arrays  The arrays of the entry.
+     */
+    void insert(std::uint64_t key, const Arrays& arrays);
+
+    /**
+     *  @brief      Find ranking.
+     *  @details    This function searches a ranking in memory. The copy keeps the ranks that were 
+     *              already sorted.
+     *  @param[in]  key  The key of the ranking.
+     *  @param[out]  ranking  A copy of the ranking, if it is found.
+     *  @returns    True if the ranking was found.
+     */
+    bool findRanking(std::uint64_t key, Ranking& ranking);
+
+    /**
+     *  @brief      Insert ranking.
+     *  @details    This function stores a copy of a ranking in memory.
+     *  @param[in]  key  The key of the ranking.
+     *  @param[in]  ranking  The ranking.
+     */
+    void insertRanking(std::uint64_t key, const Ranking& ranking);
+
+    /**
+     *  @brief      Statistics.
+     *  @details    This function returns the accumulated statistics of the searches.
+     *  @returns    The statistics.
+     */
+    Statistics statistics() const;
+
+    /**
+     *  @brief      File name.
+     *  @details    This function returns the name of the file of an entry.
+     *  @param[in]  key  The key of the entry.
+     *  @returns    The file name.
+     */
+    static QString fileName(std::uint64_t key);
+
+    /**
+     *  @brief      Read arrays.
+     *  @details    This function reads the arrays of an entry from a file.
+     *  @param[in]  fileName  The name of the file.
+     *  @param[in]  key  The expected key of the entry.
+     *  @returns    The arrays of the entry.
+     */
+    static Arrays read(const QString& fileName, std::uint64_t key);
+
+    /**
+     *  @brief      Write arrays.
+     *  @details    This function writes the arrays of an entry in a file.
+     *  @param[in]  fileName  The name of the file.
+     *  @param[in]  key  The key of the entry.
+     *  @param[in]  arrays  The arrays of the entry.
+     */
+    static void write(const QString& fileName, std::uint64_t key, const Arrays& arrays);
+
+    /**
+     *  @brief      Mesh hash.
+     *  @details    This function calculates the FNV-1a hash of the vertices and the triangles of a 
+     *              mesh. Meshes with the same contents have the same hash regardless of the file they
+     *              were read from.
+     *  @param[in]  vertices  The vertices of the mesh.
+     *  @param[in]  triangles  The triangles of the mesh.
+     *  @returns    The hash of the mesh.
+     */
+    static std::uint64_t hash(const nct::Array<nct::Point3D>& vertices,
+        const nct::Array<nct::Vector3D<unsigned int>>& triangles);
+
+    /**
+     *  @brief      Shape distribution seed.
+     *  @details    This function returns the seed of the random number generators that sample the
+     *              surface of a mesh to calculate its shape distributions. The seed only depends on 
+     *              the contents of the mesh and on the size of the distributions, so the same mesh 
+     *              always gets the same histograms.
+     *  @param[in]  hash  The hash of the mesh.
+     *  @param[in]  nSamps  The number of samples of the distributions.
+     *  @param[in]  nBins  The number of bins of the histograms.
+     *  @returns    The seed.
+     */
+    static unsigned long long shapeDistributionSeed(std::uint64_t hash, unsigned int nSamps, 
+        unsigned int nBins) noexcept;
+
+    /**
+     *  @brief      Combine hash.
+     *  @details    This function adds a block of data to a FNV-1a hash.
+     *  @param[in]  hash  The current hash.
+     *  @param[in]  data  The first byte of the data.
+     *  @param[in]  size  The number of bytes.
+     *  @returns    The new hash.
+     */
+    static std::uint64_t combine(std::uint64_t hash, const void* data, std::size_t size) noexcept;
+
+    /**
+     *  @brief      Combine hash.
+     *  @details    This function adds the UTF-16 characters of a text to a FNV-1a hash.
+     *  @param[in]  hash  The current hash.
+     *  @param[in]  text  The text.
+     *  @returns    The new hash.
+     */
+    static std::uint64_t combine(std::uint64_t hash, const QString& text);
+
+    /**
+     *  @brief      Combine hash.
+     *  @details    This function adds a parameter to a FNV-1a hash.
+     *  @tparam     T  The type of the parameter. It must be trivially copyable.
+     *  @param[in]  hash  The current hash.
+     *  @param[in]  value  The parameter.
+     *  @returns    The new hash.
+     */
+    template<typename T>
+    static std::uint64_t combine(std::uint64_t hash, const T& value) noexcept;
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Cache item.
+     *  @details    Entry kept in memory. It contains either arrays or a ranking.
+     */
+    struct Item final {
+        std::uint64_t key {0};                              /**< Key of the entry. */
+        std::shared_ptr<const Arrays> arrays;               /**< Arrays of the entry. */
+        std::shared_ptr<const Ranking> ranking;             /**< Ranking. */
+    };
+
+    //// Methods /////
+
+    /**
+     *  @brief      Store item.
+     *  @details    This function puts an item at the front of the list and removes the least recently
+     *              used items that exceed the capacity. The mutex must be locked.
+     *  @param[in]  item  The item.
+     */
+    void store(Item item);
+
+    //// Member variables ////
+
+    mutable std::mutex mutex_;                              /**< Mutex that protects the cache. */
+
+    std::size_t capacity_ {defaultCapacity};                /**< Maximum number of entries in memory. */
+
+    QString directory_;                                     /**< Directory of the entries. */
+
+    std::list<Item> items_;                                 /**< Entries from the most recently used. */
+
+    /** Position of each entry in the list. */
+    std::unordered_map<std::uint64_t, std::list<Item>::iterator> positions_;
+
+    Statistics statistics_;                                 /**< Statistics of the searches. */
+};
+
+////////// Implementation of member templates //////////
+
+//-----------------------------------------------------------------------------------------------------------------
+template<typename T>
+std::uint64_t QueryCache::combine(std::uint64_t hash, const T& value) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<T>, "The parameters of a key must be trivially copyable.");
+    return combine(hash, &value, sizeof(T));
+}
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
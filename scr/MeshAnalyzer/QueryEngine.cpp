@@ -0,0 +1,717 @@
+//=================================================================================================================
+/**
+ *  @file       QueryEngine.cpp
+ *  @brief      QueryEngine class implementation file.
+ *  @details    This file contains the implementation of the QueryEngine class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "QueryEngine.h"
+
+#include "nct/nct_utils.h"
+#include "nct/nct_exception.h"
+#include "nct/statistics/statistics.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <queue>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+using namespace nct::geometry::rasterization;
+
+//=================================================================================================================
+//        AUXILIAR FUNCTIONS
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Copy symmetry descriptor columns.
+ *  @details    This function copies a row of the table of symmetry descriptors into the layout of
+ *              mesh::symmetryDescriptorColumns. The last column of the matrix is not modified.
+ *  @param[in]  row  The row of the table.
+ *  @param[in, out]  columns  The columns of the descriptor.
+ */
+void copySymmetryDescriptorColumns(const double* row, Matrix& columns)
+{
+    auto nDir = columns.columns() - 1;
+    for (size_t j = 0; j < nDir; j++) {
+        columns(0, j) = row[2*j];
+        columns(1, j) = row[2*j + 1];
+    }
+}
+
+/**
+ *  @brief      Compressed comparison.
+ *  @details    This function indicates whether a distance function compares the descriptors of the
+ *              collection with the precision of the store. The minimum distance is the smallest 
+ *              difference of one element, which is dominated by the rounding of the descriptors, so
+ *              it always compares them in double precision.
+ *  @param[in]  f  The distance function.
+ *  @returns    True if the compressed descriptors are compared.
+ */
+bool compressedComparison(mesh::DistanceFunction f) noexcept
+{
+    return f != mesh::DistanceFunction::MinDistance;
+}
+
+/**
+ *  @brief      Check block.
+ *  @details    This function verifies the ranges of models of a block of a distance matrix.
+ *  @param[in]  firstRow  The first model of the rows.
+ *  @param[in]  lastRow  The model after the last model of the rows.
+ *  @param[in]  firstColumn  The first model of the columns.
+ *  @param[in]  lastColumn  The model after the last model of the columns.
+ *  @param[in]  nModels  The number of models of the collection.
+ */
+void checkBlock(std::size_t firstRow, std::size_t lastRow, std::size_t firstColumn, std::size_t lastColumn, 
+    std::size_t nModels)
+{
+    if ((firstRow > lastRow) || (lastRow > nModels))
+        throw ArgumentException("lastRow", exc_bad_range, SOURCE_INFO);
+
+    if ((firstColumn > lastColumn) || (lastColumn > nModels))
+        throw ArgumentException("lastColumn", exc_bad_range, SOURCE_INFO);
+}
+
+/**
+ *  @brief      Progress blocks.
+ *  @details    Minimum number of blocks of a scan of the collection that is followed by a progress
+ *              object.
+ */
+constexpr std::size_t progressBlocks {64};
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryEngine::QueryEngine(const MeshData& meshData, const std::shared_ptr<const DescriptorStore>& store) :
+    meshData_(meshData), store_(store)
+{
+    if (store_ == nullptr)
+        throw NullPointerException("store", SOURCE_INFO);
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+const MeshData& QueryEngine::meshData() const noexcept
+{
+    return meshData_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::shared_ptr<const DescriptorStore>& QueryEngine::store() const noexcept
+{
+    return store_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::setThreads(unsigned int nThreads) noexcept
+{
+    nThreads_ = nThreads;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned int QueryEngine::threads() const noexcept
+{
+    return nThreads_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::setScaleSearch(ScaleSearch search, double tolerance, unsigned int step)
+{
+    if (tolerance <= 0)
+        throw ArgumentException("tolerance", tolerance, 0.0, RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    if (step == 0)
+        throw ArgumentException("step", step, 0U, RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    scaleSearch_ = search;
+    scaleTolerance_ = tolerance;
+    scaleStep_ = step;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryEngine::ScaleSearch QueryEngine::scaleSearch() const noexcept
+{
+    return scaleSearch_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double QueryEngine::scaleTolerance() const noexcept
+{
+    return scaleTolerance_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned int QueryEngine::scaleStep() const noexcept
+{
+    return scaleStep_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::setSearchIndex(SearchIndex index) noexcept
+{
+    searchIndex_ = index;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryEngine::SearchIndex QueryEngine::searchIndex() const noexcept
+{
+    return searchIndex_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::setInvertedFile(std::size_t nCells, std::size_t nProbes) noexcept
+{
+    nCells_ = nCells;
+    nProbes_ = nProbes;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t QueryEngine::invertedFileCells() const noexcept
+{
+    return nCells_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t QueryEngine::invertedFileProbes() const noexcept
+{
+    return nProbes_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::setSelection(std::vector<unsigned int> models)
+{
+    std::sort(models.begin(), models.end());
+    models.erase(std::unique(models.begin(), models.end()), models.end());
+    if ((models.size() > 0) && (models.back() >= store_->numberOfModels()))
+        throw IndexOutOfRangeException("models", SOURCE_INFO);
+
+    selection_ = std::make_shared<const std::vector<unsigned int>>(std::move(models));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::clearSelection() noexcept
+{
+    selection_.reset();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::shared_ptr<const std::vector<unsigned int>>& QueryEngine::selection() const noexcept
+{
+    return selection_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryEngine::setProgress(const std::shared_ptr<QueryProgress>& progress) noexcept
+{
+    progress_ = progress;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const std::shared_ptr<QueryProgress>& QueryEngine::progress() const noexcept
+{
+    return progress_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::geometry::RasterizedObject3D QueryEngine::rasterize(const nct::Array<nct::Point3D>& vertices,
+    const nct::Array<nct::Vector3D<unsigned int>>& triangles) const
+{
+    auto scVertices = mesh::centerAndScaleVertices(vertices);
+    auto triang = mesh::triangleCoord(scVertices, triangles);
+    return RasterizedObject3D(triang, -1, 1, meshData_.nVox, NConnectivity3D::TwentySixConnected);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const RotationIndexCache::Indices> QueryEngine::rotationIndices(unsigned int nTestAngles) const
+{
+    return store_->rotationIndices(meshData_.nVox, nTestAngles);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector QueryEngine::compareShapeDistribution(const nct::RealVector& hist, const nct::RealVector& bins,
+    nct::geometry::mesh::ShapeDistribution dist, nct::geometry::mesh::DistanceFunction f, bool cdf,
+    unsigned int nScales, double sIni, double sEnd) const
+{
+    auto hTable = store_->sdHistograms(dist);
+    auto bTable = store_->sdBins(dist);
+
+    // The angle distribution is compared without scaling.
+    if (dist == mesh::ShapeDistribution::TwoVectorsAngle) {
+        return score([&](const unsigned int* first, const unsigned int* last, RealVector& distances) {
+            RealVector h(hTable.columns);
+
+            for (auto model = first; model < last; model++) {
+                auto i = *model;
+                auto hRow = hTable.row(i);
+                std::copy(hRow, hRow + hTable.columns, h.begin());
+                distances[i] = mesh::calculateShapeDistributionDistance(hist, h, f, cdf);
+            }
+        });
+    }
+
+    // The splines of the collection are built when it is loaded, so only the spline of the query
+    // is built here.
+    auto& splines = store_->sdSplines(dist);
+    auto querySpline = mesh::shapeDistributionSpline(hist, bins);
+
+    // The distances of the centroid distance have several narrow minima that the coarse-to-fine
+    // search misses, so it is always scanned exhaustively.
+    bool search = (scaleSearch_ == ScaleSearch::CoarseToFine) && (nScales > 1) && 
+        (dist != mesh::ShapeDistribution::CentroidDistance);
+
+    return score([&](const unsigned int* first, const unsigned int* last, RealVector& distances) {
+        for (auto model = first; model < last; model++) {
+            auto i = *model;
+            if (splines[i].spline.deriv2().size() == 0) {
+                auto hRow = hTable.row(i);
+                auto bRow = bTable.row(i);
+                distances[i] = mesh::calculateShapeDistributionDistance(hist, bins, 
+                    RealVector(hRow, hRow + hTable.columns), RealVector(bRow, bRow + bTable.columns), 
+                    f, cdf, meshData_.nBins, nScales, sIni, sEnd);
+            }
+            else if (search) {
+                distances[i] = mesh::searchShapeDistributionDistance(querySpline, splines[i], f, cdf, 
+                    meshData_.nBins, nScales, scaleStep_, scaleTolerance_, sIni, sEnd);
+            }
+            else {
+                distances[i] = mesh::calculateShapeDistributionDistance(querySpline, splines[i], f, cdf, 
+                    meshData_.nBins, nScales, sIni, sEnd);
+            }
+        }
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector QueryEngine::compareSymmetryDescriptor(const nct::Matrix& rsd, 
+    const nct::Array<nct::Array<std::size_t>>& rotIndices, nct::geometry::mesh::DistanceFunction f) const
+{
+    auto table = store_->rsdDescriptors();
+    auto query = mesh::symmetryDescriptorColumns(rsd);
+    auto rotSources = mesh::findRotationSources(rotIndices);
+    auto compressed = compressedComparison(f);
+
+    return score([&](const unsigned int* first, const unsigned int* last, RealVector& distances) {
+        RealVector row(table.columns);
+        Matrix descriptor(2, table.columns/2 + 1, 0);
+
+        for (auto model = first; model < last; model++) {
+            auto i = *model;
+            store_->rsdRow(i, row.data(), compressed);
+            copySymmetryDescriptorColumns(row.data(), descriptor);
+            distances[i] = mesh::compareSymmetryDescriptorColumns(query, descriptor, rotSources, f,
+                std::numeric_limits<double>::infinity());
+        }
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector QueryEngine::compareHarmonicDescriptor(const nct::RealVector& hm, 
+    nct::geometry::mesh::DistanceFunction f) const
+{
+    auto table = store_->hmDescriptors();
+    auto compressed = compressedComparison(f);
+    auto decoded = !compressed || !store_->hasHmRowDistance(f);
+
+    return score([&](const unsigned int* first, const unsigned int* last, RealVector& distances) {
+        RealVector descriptor(table.columns);
+
+        for (auto model = first; model < last; model++) {
+            auto i = *model;
+            if (decoded) {
+                store_->hmRow(i, descriptor.data(), compressed);
+                distances[i] = mesh::compareFeatures(hm, descriptor, f);
+            }
+            else {
+                distances[i] = store_->hmRowDistance(i, hm, f);
+            }
+        }
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix QueryEngine::compareShapeDistributions(std::size_t firstRow, std::size_t lastRow, 
+    std::size_t firstColumn, std::size_t lastColumn, nct::geometry::mesh::ShapeDistribution dist, 
+    nct::geometry::mesh::DistanceFunction f, bool cdf, unsigned int nScales, double sIni, double sEnd) const
+{
+    checkBlock(firstRow, lastRow, firstColumn, lastColumn, store_->numberOfModels());
+
+    auto hTable = store_->sdHistograms(dist);
+    auto bTable = store_->sdBins(dist);
+    auto histogram = [&](size_t i) {
+        auto row = hTable.row(i);
+        return RealVector(row, row + hTable.columns);
+    };
+    auto bins = [&](size_t i) {
+        auto row = bTable.row(i);
+        return RealVector(row, row + bTable.columns);
+    };
+
+    Matrix distances(lastRow - firstRow, lastColumn - firstColumn, 0);
+
+    // The angle distribution is compared without scaling. The histograms of the columns are
+    // copied once for the whole block.
+    if (dist == mesh::ShapeDistribution::TwoVectorsAngle) {
+        std::vector<RealVector> columns;
+        for (size_t j = firstColumn; j < lastColumn; j++)
+            columns.push_back(histogram(j));
+
+        for (size_t i = firstRow; i < lastRow; i++) {
+            auto h = histogram(i);
+            for (size_t j = std::max(firstColumn, i + 1); j < lastColumn; j++)
+                distances(i - firstRow, j - firstColumn) = 
+                    mesh::calculateShapeDistributionDistance(h, columns[j - firstColumn], f, cdf);
+        }
+
+        return distances;
+    }
+
+    auto& splines = store_->sdSplines(dist);
+    bool search = (scaleSearch_ == ScaleSearch::CoarseToFine) && (nScales > 1) && 
+        (dist != mesh::ShapeDistribution::CentroidDistance);
+    for (size_t i = firstRow; i < lastRow; i++) {
+        for (size_t j = std::max(firstColumn, i + 1); j < lastColumn; j++) {
+            auto& d = distances(i - firstRow, j - firstColumn);
+            if ((splines[i].spline.deriv2().size() == 0) || (splines[j].spline.deriv2().size() == 0)) {
+                d = mesh::calculateShapeDistributionDistance(histogram(i), bins(i), histogram(j), bins(j), 
+                    f, cdf, meshData_.nBins, nScales, sIni, sEnd);
+            }
+            else if (search) {
+                d = mesh::searchShapeDistributionDistance(splines[i], splines[j], f, cdf, 
+                    meshData_.nBins, nScales, scaleStep_, scaleTolerance_, sIni, sEnd);
+            }
+            else {
+                d = mesh::calculateShapeDistributionDistance(splines[i], splines[j], f, cdf, 
+                    meshData_.nBins, nScales, sIni, sEnd);
+            }
+        }
+    }
+
+    return distances;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix QueryEngine::compareSymmetryDescriptors(std::size_t firstRow, std::size_t lastRow, 
+    std::size_t firstColumn, std::size_t lastColumn, unsigned int nTestAngles, 
+    nct::geometry::mesh::DistanceFunction f) const
+{
+    checkBlock(firstRow, lastRow, firstColumn, lastColumn, store_->numberOfModels());
+
+    auto table = store_->rsdDescriptors();
+    auto rotSources = store_->rotationSources(meshData_.nVox, nTestAngles);
+
+    // The descriptors of the columns are converted once for the whole block.
+    RealVector row(table.columns);
+    auto descriptor = [&](size_t i) {
+        Matrix columns(2, table.columns/2 + 1, 0);
+        store_->rsdRow(i, row.data(), false);
+        copySymmetryDescriptorColumns(row.data(), columns);
+        return columns;
+    };
+
+    std::vector<Matrix> columns;
+    for (size_t j = firstColumn; j < lastColumn; j++)
+        columns.push_back(descriptor(j));
+
+    Matrix distances(lastRow - firstRow, lastColumn - firstColumn, 0);
+    for (size_t i = firstRow; i < lastRow; i++) {
+        if (i + 1 >= lastColumn)
+            continue;
+
+        auto query = descriptor(i);
+        for (size_t j = std::max(firstColumn, i + 1); j < lastColumn; j++)
+            distances(i - firstRow, j - firstColumn) = mesh::compareSymmetryDescriptorColumns(query, 
+                columns[j - firstColumn], *rotSources, f, std::numeric_limits<double>::infinity());
+    }
+
+    return distances;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix QueryEngine::compareHarmonicDescriptors(std::size_t firstRow, std::size_t lastRow, 
+    std::size_t firstColumn, std::size_t lastColumn, nct::geometry::mesh::DistanceFunction f) const
+{
+    checkBlock(firstRow, lastRow, firstColumn, lastColumn, store_->numberOfModels());
+
+    auto table = store_->hmDescriptors();
+    auto descriptor = [&](size_t i) {
+        RealVector row(table.columns);
+        store_->hmRow(i, row.data(), false);
+        return row;
+    };
+
+    std::vector<RealVector> columns;
+    for (size_t j = firstColumn; j < lastColumn; j++)
+        columns.push_back(descriptor(j));
+
+    Matrix distances(lastRow - firstRow, lastColumn - firstColumn, 0);
+    for (size_t i = firstRow; i < lastRow; i++) {
+        if (i + 1 >= lastColumn)
+            continue;
+
+        auto query = descriptor(i);
+        for (size_t j = std::max(firstColumn, i + 1); j < lastColumn; j++)
+            distances(i - firstRow, j - firstColumn) = mesh::compareFeatures(query, columns[j - firstColumn], f);
+    }
+
+    return distances;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking QueryEngine::rankShapeDistribution(const nct::RealVector& hist, const nct::RealVector& bins,
+    nct::geometry::mesh::ShapeDistribution dist, nct::geometry::mesh::DistanceFunction f, bool cdf,
+    unsigned int nScales, double sIni, double sEnd, std::size_t k) const
+{
+    if ((searchIndex_ != SearchIndex::VantagePointTree) || (k == 0) || (selection_ != nullptr) ||
+        (dist != mesh::ShapeDistribution::TwoVectorsAngle) || !MetricTree::isMetric(f))
+        return Ranking(compareShapeDistribution(hist, bins, dist, f, cdf, nScales, sIni, sEnd), 
+            selection_.get());
+
+    // The tree stores the cumulative distributions when they are compared.
+    if (progress_ != nullptr)
+        progress_->checkCanceled();
+
+    RealVector query(hist.size());
+    if (cdf)
+        statistics::cumulativeData(hist.begin(), hist.end(), query.begin());
+    else
+        query = hist;
+
+    auto result = store_->sdTree(dist, f, cdf)->search(query, k, store_->removedRows());
+
+    auto store = store_;
+    return Ranking(result.distances, result.exact, [store, hist, dist, f, cdf](size_t i) {
+        auto table = store->sdHistograms(dist);
+        auto row = table.row(i);
+        return mesh::calculateShapeDistributionDistance(hist, RealVector(row, row + table.columns), f, cdf);
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking QueryEngine::rankSymmetryDescriptor(const nct::Matrix& rsd, 
+    const nct::Array<nct::Array<std::size_t>>& rotIndices, nct::geometry::mesh::DistanceFunction f,
+    std::size_t k) const
+{
+    return rankSymmetryDescriptor(rsd, 
+        std::make_shared<const RotationIndexCache::Sources>(mesh::findRotationSources(rotIndices)), f, k);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking QueryEngine::rankSymmetryDescriptor(const nct::Matrix& rsd, unsigned int nTestAngles, 
+    nct::geometry::mesh::DistanceFunction f, std::size_t k) const
+{
+    return rankSymmetryDescriptor(rsd, store_->rotationSources(meshData_.nVox, nTestAngles), f, k);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking QueryEngine::rankSymmetryDescriptor(const nct::Matrix& rsd, 
+    const std::shared_ptr<const RotationIndexCache::Sources>& rotSources, 
+    nct::geometry::mesh::DistanceFunction f, std::size_t k) const
+{
+    auto table = store_->rsdDescriptors();
+    auto query = mesh::symmetryDescriptorColumns(rsd);
+    auto compressed = compressedComparison(f);
+    std::vector<char> exact(store_->numberOfModels());
+
+    auto distances = score([&](const unsigned int* first, const unsigned int* last, RealVector& distances) {
+        RealVector row(table.columns);
+        Matrix descriptor(2, table.columns/2 + 1, 0);
+        std::priority_queue<double> best;
+
+        for (auto model = first; model < last; model++) {
+            auto i = *model;
+            store_->rsdRow(i, row.data(), compressed);
+            copySymmetryDescriptorColumns(row.data(), descriptor);
+
+            double bound = (k == 0) || (best.size() < k) ? 
+                std::numeric_limits<double>::infinity() : best.top();
+            distances[i] = mesh::compareSymmetryDescriptorColumns(query, descriptor, *rotSources, f, bound);
+            exact[i] = distances[i] < bound;
+
+            if (exact[i] && (k > 0)) {
+                best.push(distances[i]);
+                if (best.size() > k)
+                    best.pop();
+            }
+        }
+    }, &exact);
+
+    auto store = store_;
+    return Ranking(distances, exact, [store, query, rotSources, f, compressed](size_t i) {
+        auto table = store->rsdDescriptors();
+        RealVector row(table.columns);
+        Matrix descriptor(2, table.columns/2 + 1, 0);
+        store->rsdRow(i, row.data(), compressed);
+        copySymmetryDescriptorColumns(row.data(), descriptor);
+        return mesh::compareSymmetryDescriptorColumns(query, descriptor, *rotSources, f,
+            std::numeric_limits<double>::infinity());
+    }, selection_.get());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking QueryEngine::rankHarmonicDescriptor(const nct::RealVector& hm, 
+    nct::geometry::mesh::DistanceFunction f, std::size_t k) const
+{
+    // The indices are built with the descriptors in double precision.
+    auto store = store_;
+    auto exactDistance = [store, hm, f](size_t i) {
+        auto table = store->hmDescriptors();
+        auto row = table.row(i);
+        RealVector descriptor(row, row + table.columns);
+        return mesh::compareFeatures(hm, descriptor, f);
+    };
+
+    if ((progress_ != nullptr) && (searchIndex_ != SearchIndex::LinearScan) && (selection_ == nullptr))
+        progress_->checkCanceled();
+
+    if ((searchIndex_ == SearchIndex::VantagePointTree) && (k > 0) && (selection_ == nullptr) && 
+        MetricTree::isMetric(f)) {
+        auto result = store_->hmTree(f)->search(hm, k, store_->removedRows());
+        return Ranking(result.distances, result.exact, exactDistance);
+    }
+
+    if ((searchIndex_ == SearchIndex::InvertedFile) && (k > 0) && (selection_ == nullptr)) {
+        auto result = store_->hmInvertedFile(nCells_)->search(hm, f, k, nProbes_, store_->removedRows());
+        return Ranking(result.distances, result.exact, exactDistance);
+    }
+
+    // The compressed descriptors are compared without decoding them first when the distance 
+    // function allows it.
+    auto table = store_->hmDescriptors();
+    auto compressed = compressedComparison(f);
+    auto decoded = !compressed || !store_->hasHmRowDistance(f);
+    std::vector<char> exact(store_->numberOfModels());
+
+    auto distances = score([&](const unsigned int* first, const unsigned int* last, RealVector& distances) {
+        RealVector descriptor(table.columns);
+        std::priority_queue<double> best;
+
+        for (auto model = first; model < last; model++) {
+            auto i = *model;
+            double bound = (k == 0) || (best.size() < k) ? 
+                std::numeric_limits<double>::infinity() : best.top();
+
+            if (decoded) {
+                store_->hmRow(i, descriptor.data(), compressed);
+                distances[i] = mesh::compareFeatures(hm, descriptor, f, bound);
+            }
+            else {
+                distances[i] = store_->hmRowDistance(i, hm, f, bound);
+            }
+            exact[i] = distances[i] < bound;
+
+            if (exact[i] && (k > 0)) {
+                best.push(distances[i]);
+                if (best.size() > k)
+                    best.pop();
+            }
+        }
+    }, &exact);
+
+    return Ranking(distances, exact, [store, hm, f, compressed, decoded](size_t i) {
+        if (!decoded)
+            return store->hmRowDistance(i, hm, f);
+
+        RealVector descriptor(store->hmDescriptors().columns);
+        store->hmRow(i, descriptor.data(), compressed);
+        return mesh::compareFeatures(hm, descriptor, f);
+    }, selection_.get());
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<unsigned int> QueryEngine::rank(const nct::RealVector& distances)
+{
+    Array<unsigned int> indices(distances.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::stable_sort(indices.begin(), indices.end(), 
+        [&distances](unsigned int i, unsigned int j) {return distances[i] < distances[j];});
+
+    return indices;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+template<typename ScoreFunction>
+nct::RealVector QueryEngine::score(ScoreFunction f, const std::vector<char>* exact) const
+{
+    // The models that are not selected are not compared.
+    std::vector<unsigned int> all;
+    if (selection_ == nullptr) {
+        all.resize(store_->numberOfModels());
+        std::iota(all.begin(), all.end(), 0);
+    }
+    const auto& models = selection_ != nullptr ? *selection_ : all;
+
+    auto nModels = models.size();
+    RealVector distances(store_->numberOfModels(), std::numeric_limits<double>::infinity());
+    if (progress_ != nullptr) {
+        progress_->checkCanceled();
+        progress_->start(nModels);
+    }
+    if (nModels == 0)
+        return distances;
+
+    // A few blocks per thread balance the load when some models are slower than others.
+    unsigned int nThreads = nThreads_;
+    if (nThreads == 0)
+        nThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+    size_t nBlocks = std::min<size_t>(nModels, nThreads == 1 ? 1 : 4*static_cast<size_t>(nThreads));
+
+    // A followed scan is reported and canceled at the end of each block, so it is split in more
+    // blocks; they are still large enough to keep the bounds of the early abandoning tight.
+    if (progress_ != nullptr)
+        nBlocks = std::min<size_t>(nModels, std::max<size_t>(nBlocks, progressBlocks));
+
+    size_t blockSize = nModels/nBlocks + (nModels % nBlocks > 0);
+    nBlocks = nModels/blockSize + (nModels % blockSize > 0);
+
+    nct::parallel_for(static_cast<size_t>(0), nBlocks, nThreads, [&](size_t block) {
+        auto first = block*blockSize;
+        auto last = std::min(first + blockSize, nModels);
+        if ((progress_ != nullptr) && progress_->canceled())
+            return;
+
+        f(models.data() + first, models.data() + last, distances);
+        if (progress_ != nullptr)
+            progress_->add(models.data() + first, models.data() + last, distances, exact);
+    });
+
+    if (progress_ != nullptr)
+        progress_->checkCanceled();
+
+    return distances;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,557 @@
+//=================================================================================================================
+/**
+ *  @file       QueryEngine.h
+ *  @brief      QueryEngine class.
+ *  @details    Declaration file of the QueryEngine class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef QUERY_ENGINE_H_INCLUDE
+#define QUERY_ENGINE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "MeshData.h"
+#include "DescriptorStore.h"
+#include "Ranking.h"
+#include "QueryProgress.h"
+
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+#include "nct/Vector3D.h"
+#include "nct/geometry/mesh.h"
+#include "nct/geometry/RasterizedObject3D.h"
+
+#include <memory>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Query engine class.
+ *  @details    This class compares the descriptors of a query object with the descriptors of a mesh
+ *              collection and ranks the models of the collection. The class only depends on nct
+ *              and QtCore, so it is shared by the user interface and the command line tools.
+ */
+class QueryEngine final
+{
+public:
+
+    //// Enumerations /////
+
+    /**
+     *  @brief      Scale search.
+     *  @details    Methods to find the scale that minimizes the distance between shape distributions.
+     */
+    enum class ScaleSearch : unsigned char {
+
+        Exhaustive,     /**< Every scale of the configuration is tested. */
+
+        CoarseToFine,   /**< A grid of scales is tested and its best scale is refined. */
+    };
+
+    /**
+     *  @brief      Search index.
+     *  @details    Methods to find the closest models of the collection.
+     */
+    enum class SearchIndex : unsigned char {
+
+        LinearScan,         /**< The query is compared with every model. */
+
+        VantagePointTree,   /**< The metric tree of the descriptors is searched (see MetricTree). */
+
+        InvertedFile,       /**< The closest cells of the descriptors are searched (see InvertedFile). */
+    };
+
+    //// Constants /////
+
+    static constexpr double defaultScaleTolerance {0.1};    /**< Default tolerance of the scale search (dB). */
+
+    static constexpr unsigned int defaultScaleStep {16};    /**< Default grid step of the scale search. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the engine with the data of a collection.
+     *  @param[in]  meshData  The configuration data of the collection.
+     *  @param[in]  store  The descriptors of the collection.
+     */
+    QueryEngine(const MeshData& meshData, const std::shared_ptr<const DescriptorStore>& store);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    QueryEngine(const QueryEngine&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    QueryEngine(QueryEngine&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~QueryEngine() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    QueryEngine& operator=(const QueryEngine&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    QueryEngine& operator=(QueryEngine&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Mesh data.
+     *  @details    This function returns the configuration data of the collection.
+     *  @returns    The mesh data.
+     */
+    const MeshData& meshData() const noexcept;
+
+    /**
+     *  @brief      Descriptor store.
+     *  @details    This function returns the descriptors of the collection.
+     *  @returns    The descriptor store.
+     */
+    const std::shared_ptr<const DescriptorStore>& store() const noexcept;
+
+    /**
+     *  @brief      Set threads.
+     *  @details    This function sets the number of threads that score the collection. The collection
+     *              is split in contiguous blocks of models and each block reuses its own scratch
+     *              buffers. The distances don't depend on the number of threads.
+     *  @param[in]  nThreads  The number of threads. If it is zero, the number of hardware threads is used.
+     */
+    void setThreads(unsigned int nThreads) noexcept;
+
+    /**
+     *  @brief      Threads.
+     *  @details    This function returns the number of threads that score the collection.
+     *  @returns    The number of threads. Zero means the number of hardware threads.
+     */
+    unsigned int threads() const noexcept;
+
+    /**
+     *  @brief      Set scale search.
+     *  @details    This function sets the method that finds the scale that minimizes the distance
+     *              between shape distributions. The coarse-to-fine search tests one scale of every
+     *              step/2 within step scales of the scale that matches the means, and one of every 
+     *              2*step elsewhere, and refines the best one with steps that are halved down to 
+     *              the tolerance (see mesh::searchShapeDistributionDistance). The centroid 
+     *              distance, whose distances have several narrow minima, is always compared with 
+     *              the exhaustive scan.
+     *  @param[in]  search  The search method.
+     *  @param[in]  tolerance  The tolerance of the coarse-to-fine search (dB).
+     *  @param[in]  step  The grid step of the coarse-to-fine search (number of scales).
+     */
+    void setScaleSearch(ScaleSearch search, double tolerance = defaultScaleTolerance, 
+        unsigned int step = defaultScaleStep);
+
+    /**
+     *  @brief      Scale search.
+     *  @details    This function returns the method that finds the scale that minimizes the distance
+     *              between shape distributions.
+     *  @returns    The search method.
+     */
+    ScaleSearch scaleSearch() const noexcept;
+
+    /**
+     *  @brief      Scale tolerance.
+     *  @details    This function returns the tolerance of the coarse-to-fine scale search.
+     *  @returns    The tolerance (dB).
+     */
+    double scaleTolerance() const noexcept;
+
+    /**
+     *  @brief      Scale step.
+     *  @details    This function returns the grid step of the coarse-to-fine scale search.
+     *  @returns    The number of scales of the step.
+     */
+    unsigned int scaleStep() const noexcept;
+
+    /**
+     *  @brief      Set search index.
+     *  @details    This function sets the method that finds the closest models. The metric tree is
+     *              used by the rankings of the harmonic descriptors and of the angle distribution 
+     *              with the Euclidean, city-block and Chebychev distances when a number of ranks is
+     *              specified; the other rankings scan the collection. The tree finds the same models
+     *              as the linear scan. The inverted file is only used by the rankings of the harmonic
+     *              descriptors when a number of ranks is specified; it only compares the models of the
+     *              closest cells, so it can miss some of the closest models (see setInvertedFile).
+     *              The indices contain the whole collection, so the selections are always scanned.
+     *  @param[in]  index  The search method.
+     */
+    void setSearchIndex(SearchIndex index) noexcept;
+
+    /**
+     *  @brief      Search index.
+     *  @details    This function returns the method that finds the closest models.
+     *  @returns    The search method.
+     */
+    SearchIndex searchIndex() const noexcept;
+
+    /**
+     *  @brief      Set inverted file.
+     *  @details    This function sets the parameters of the inverted file of the harmonic 
+     *              descriptors. More probed cells find more of the closest models and compare the 
+     *              query with more models.
+     *  @param[in]  nCells  The number of cells. If it is zero, the default number of cells is used
+     *              (see InvertedFile::defaultCells).
+     *  @param[in]  nProbes  The number of cells that are probed by each query. If it is zero, every
+     *              cell is probed.
+     */
+    void setInvertedFile(std::size_t nCells, std::size_t nProbes) noexcept;
+
+    /**
+     *  @brief      Inverted file cells.
+     *  @details    This function returns the number of cells of the inverted file.
+     *  @returns    The number of cells. Zero means the default number of cells.
+     */
+    std::size_t invertedFileCells() const noexcept;
+
+    /**
+     *  @brief      Inverted file probes.
+     *  @details    This function returns the number of cells that are probed by each query.
+     *  @returns    The number of probed cells. Zero means every cell.
+     */
+    std::size_t invertedFileProbes() const noexcept;
+
+    /**
+     *  @brief      Set selection.
+     *  @details    This function restricts the comparisons to some models of the collection, for
+     *              example the models that match a filter of a MetadataIndex. Only the selected models
+     *              are scored; the distances of the other models are infinite and they are not 
+     *              ranked.
+     *  @param[in]  models  The indices of the selected models.
+     */
+    void setSelection(std::vector<unsigned int> models);
+
+    /**
+     *  @brief      Clear selection.
+     *  @details    This function compares every model of the collection again.
+     */
+    void clearSelection() noexcept;
+
+    /**
+     *  @brief      Selection.
+     *  @details    This function returns the models that are compared.
+     *  @returns    The sorted indices of the selected models, or null if every model is compared.
+     */
+    const std::shared_ptr<const std::vector<unsigned int>>& selection() const noexcept;
+
+    /**
+     *  @brief      Set progress.
+     *  @details    This function sets the object that follows the comparisons of the engine. Each 
+     *              scan of the collection reports the distances of every block of models when it is
+     *              scored, and it stops and throws an exception when the comparison is canceled. The
+     *              searches of the indices are only checked before they start.
+     *  @param[in]  progress  The progress of the comparisons. If it is null, nothing is reported.
+     */
+    void setProgress(const std::shared_ptr<QueryProgress>& progress) noexcept;
+
+    /**
+     *  @brief      Progress.
+     *  @details    This function returns the object that follows the comparisons of the engine.
+     *  @returns    The progress of the comparisons, or null.
+     */
+    const std::shared_ptr<QueryProgress>& progress() const noexcept;
+
+    /**
+     *  @brief      Rasterize object.
+     *  @details    This function centers, scales and rasterizes a mesh with the number of
+     *              divisions of the collection.
+     *  @param[in]  vertices  The vertices of the mesh.
+     *  @param[in]  triangles  The triangles of the mesh.
+     *  @returns    The rasterized object.
+     */
+    nct::geometry::RasterizedObject3D rasterize(const nct::Array<nct::Point3D>& vertices,
+        const nct::Array<nct::Vector3D<unsigned int>>& triangles) const;
+
+    /**
+     *  @brief      Rotation indices.
+     *  @details    This function returns the indices of the tested rotations of the symmetry
+     *              descriptors of objects rasterized with the number of divisions of the collection.
+     *              The table is equal to the result of mesh::findRotationIndices, but it is only 
+     *              calculated once for each number of test angles.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The rotation indices.
+     */
+    std::shared_ptr<const RotationIndexCache::Indices> rotationIndices(unsigned int nTestAngles) const;
+
+    /**
+     *  @brief      Compare shape distribution.
+     *  @details    This function calculates the distance between a shape distribution and the
+     *              distributions of every model of the collection.
+     *  @param[in]  hist  The histogram of the query object.
+     *  @param[in]  bins  The bins of the histogram of the query object.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  cdf  True if the cumulative distributions are compared.
+     *  @param[in]  nScales  The number of scales that are tested.
+     *  @param[in]  sIni  The log of the first scale.
+     *  @param[in]  sEnd  The log of the last scale.
+     *  @returns    The distance to each model of the collection.
+     */
+    nct::RealVector compareShapeDistribution(const nct::RealVector& hist, const nct::RealVector& bins,
+        nct::geometry::mesh::ShapeDistribution dist, nct::geometry::mesh::DistanceFunction f, bool cdf,
+        unsigned int nScales, double sIni, double sEnd) const;
+
+    /**
+     *  @brief      Compare symmetry descriptor.
+     *  @details    This function calculates the distance between a reflexive symmetry descriptor
+     *              and the descriptors of every model of the collection. The descriptors of the
+     *              collection are read with the precision of the store (see 
+     *              DescriptorStore::setPrecision), and the query keeps its full precision. The minimum
+     *              distance always compares the descriptors in double precision.
+     *  @param[in]  rsd  The descriptor of the query object.
+     *  @param[in]  rotIndices  The indices of the tested rotations.
+     *  @param[in]  f  The distance function.
+     *  @returns    The distance to each model of the collection.
+     */
+    nct::RealVector compareSymmetryDescriptor(const nct::Matrix& rsd, 
+        const nct::Array<nct::Array<std::size_t>>& rotIndices, nct::geometry::mesh::DistanceFunction f) const;
+
+    /**
+     *  @brief      Compare harmonic descriptor.
+     *  @details    This function calculates the distance between a harmonic descriptor and the
+     *              descriptors of every model of the collection. The descriptors of the collection 
+     *              are read with the precision of the store, and the query keeps its full precision.
+     *  @param[in]  hm  The flattened descriptor of the query object.
+     *  @param[in]  f  The distance function.
+     *  @returns    The distance to each model of the collection.
+     */
+    nct::RealVector compareHarmonicDescriptor(const nct::RealVector& hm, 
+        nct::geometry::mesh::DistanceFunction f) const;
+
+    /**
+     *  @brief      Compare shape distributions of models.
+     *  @details    This function calculates the distances between the shape distributions of a block
+     *              of models (the rows) and the distributions of other block of models (the columns).
+     *              Each row model is compared as a query, and only the pairs whose column model
+     *              follows the row model are calculated; the other elements are zero. The function
+     *              is thread safe and doesn't use the threads of the engine.
+     *  @param[in]  firstRow  The first model of the rows.
+     *  @param[in]  lastRow  The model after the last model of the rows.
+     *  @param[in]  firstColumn  The first model of the columns.
+     *  @param[in]  lastColumn  The model after the last model of the columns.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  cdf  True if the cumulative distributions are compared.
+     *  @param[in]  nScales  The number of scales that are tested.
+     *  @param[in]  sIni  The log of the first scale.
+     *  @param[in]  sEnd  The log of the last scale.
+     *  @returns    The distances between the models.
+     */
+    nct::Matrix compareShapeDistributions(std::size_t firstRow, std::size_t lastRow, std::size_t firstColumn,
+        std::size_t lastColumn, nct::geometry::mesh::ShapeDistribution dist, 
+        nct::geometry::mesh::DistanceFunction f, bool cdf, unsigned int nScales, double sIni, double sEnd) const;
+
+    /**
+     *  @brief      Compare symmetry descriptors of models.
+     *  @details    This function calculates the distances between the reflexive symmetry descriptors
+     *              of two blocks of models as compareShapeDistributions does. The descriptors are 
+     *              compared in double precision.
+     *  @param[in]  firstRow  The first model of the rows.
+     *  @param[in]  lastRow  The model after the last model of the rows.
+     *  @param[in]  firstColumn  The first model of the columns.
+     *  @param[in]  lastColumn  The model after the last model of the columns.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @param[in]  f  The distance function.
+     *  @returns    The distances between the models.
+     */
+    nct::Matrix compareSymmetryDescriptors(std::size_t firstRow, std::size_t lastRow, std::size_t firstColumn,
+        std::size_t lastColumn, unsigned int nTestAngles, nct::geometry::mesh::DistanceFunction f) const;
+
+    /**
+     *  @brief      Compare harmonic descriptors of models.
+     *  @details    This function calculates the distances between the harmonic descriptors of two
+     *              blocks of models as compareShapeDistributions does. The descriptors are compared in
+     *              double precision.
+     *  @param[in]  firstRow  The first model of the rows.
+     *  @param[in]  lastRow  The model after the last model of the rows.
+     *  @param[in]  firstColumn  The first model of the columns.
+     *  @param[in]  lastColumn  The model after the last model of the columns.
+     *  @param[in]  f  The distance function.
+     *  @returns    The distances between the models.
+     */
+    nct::Matrix compareHarmonicDescriptors(std::size_t firstRow, std::size_t lastRow, std::size_t firstColumn,
+        std::size_t lastColumn, nct::geometry::mesh::DistanceFunction f) const;
+
+    /**
+     *  @brief      Rank shape distribution.
+     *  @details    This function ranks the models of the collection by the distance between a shape
+     *              distribution and the distributions of the models. The distances are calculated
+     *              exactly and only the ranks that are requested are sorted. When the metric tree 
+     *              is used, only the distances of the first k ranks are guaranteed to be calculated.
+     *  @param[in]  hist  The histogram of the query object.
+     *  @param[in]  bins  The bins of the histogram of the query object.
+     *  @param[in]  dist  The shape distribution.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  cdf  True if the cumulative distributions are compared.
+     *  @param[in]  nScales  The number of scales that are tested.
+     *  @param[in]  sIni  The log of the first scale.
+     *  @param[in]  sEnd  The log of the last scale.
+     *  @param[in]  k  The number of ranks that are expected to be requested. If it is zero, every
+     *              distance is calculated.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankShapeDistribution(const nct::RealVector& hist, const nct::RealVector& bins,
+        nct::geometry::mesh::ShapeDistribution dist, nct::geometry::mesh::DistanceFunction f, bool cdf,
+        unsigned int nScales, double sIni, double sEnd, std::size_t k) const;
+
+    /**
+     *  @brief      Rank symmetry descriptor.
+     *  @details    This function ranks the models of the collection by the distance between a
+     *              reflexive symmetry descriptor and the descriptors of the models. Each block of
+     *              models keeps its k closest models, and the calculation of the Euclidean, city-block
+     *              and Chebychev distances of the other models is abandoned as soon as it exceeds the 
+     *              k-th distance. The abandoned distances are calculated when their ranks are requested.
+     *              The descriptors of the collection are read with the precision of the store.
+     *  @param[in]  rsd  The descriptor of the query object.
+     *  @param[in]  rotIndices  The indices of the tested rotations.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of ranks that are expected to be requested. If it is zero, every
+     *              distance is calculated.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankSymmetryDescriptor(const nct::Matrix& rsd, 
+        const nct::Array<nct::Array<std::size_t>>& rotIndices, nct::geometry::mesh::DistanceFunction f,
+        std::size_t k) const;
+
+    /**
+     *  @brief      Rank symmetry descriptor.
+     *  @details    This function ranks the models of the collection by the distance between a
+     *              reflexive symmetry descriptor of an object rasterized with the number of divisions 
+     *              of the collection and the descriptors of the models. The rotation indices are 
+     *              taken from the cache of the collection (see rotationIndices).
+     *  @param[in]  rsd  The descriptor of the query object.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of ranks that are expected to be requested. If it is zero, every
+     *              distance is calculated.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankSymmetryDescriptor(const nct::Matrix& rsd, unsigned int nTestAngles, 
+        nct::geometry::mesh::DistanceFunction f, std::size_t k) const;
+
+    /**
+     *  @brief      Rank harmonic descriptor.
+     *  @details    This function ranks the models of the collection by the distance between a
+     *              harmonic descriptor and the descriptors of the models. Each block of models keeps
+     *              its k closest models, and the calculation of the Euclidean and city-block distances
+     *              of the other models is abandoned as soon as it exceeds the k-th distance. The 
+     *              abandoned distances are calculated when their ranks are requested. The scan reads
+     *              the descriptors with the precision of the store; the search indices compare them 
+     *              in double precision. When the inverted file is used, the first k ranks only 
+     *              contain models of the probed cells.
+     *  @param[in]  hm  The flattened descriptor of the query object.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of ranks that are expected to be requested. If it is zero, every
+     *              distance is calculated.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankHarmonicDescriptor(const nct::RealVector& hm, 
+        nct::geometry::mesh::DistanceFunction f, std::size_t k) const;
+
+    /**
+     *  @brief      Rank models.
+     *  @details    This function sorts the models of the collection by distance. Models with the
+     *              same distance keep the order of the collection.
+     *  @param[in]  distances  The distance to each model.
+     *  @returns    The indices of the models sorted from the closest to the farthest.
+     */
+    static nct::Array<unsigned int> rank(const nct::RealVector& distances);
+
+private:
+
+    //// Methods /////
+
+    /**
+     *  @brief      Score collection.
+     *  @details    This function splits the selected models in blocks and calls a scoring function
+     *              for each block in parallel. The function receives pointers to the first index and
+     *              one past the last index of the models of the block and the array where the 
+     *              distances are stored. The blocks are reported to the progress of the engine. The
+     *              distances of the models that are not selected are infinite.
+     *  @tparam     ScoreFunction  The type of the scoring function.
+     *  @param[in]  f  The scoring function.
+     *  @param[in]  exact  If non-null, indicates which distances are exact when a block is scored.
+     *  @returns    The distance to each model of the collection.
+     */
+    template<typename ScoreFunction>
+    nct::RealVector score(ScoreFunction f, const std::vector<char>* exact = nullptr) const;
+
+    /**
+     *  @brief      Rank symmetry descriptor.
+     *  @details    This function ranks the models of the collection with a shared table of rotation
+     *              sources, which is kept by the ranking to calculate the abandoned distances.
+     *  @param[in]  rsd  The descriptor of the query object.
+     *  @param[in]  rotSources  The sources of the tested rotations.
+     *  @param[in]  f  The distance function.
+     *  @param[in]  k  The number of ranks that are expected to be requested.
+     *  @returns    The ranking of the models.
+     */
+    Ranking rankSymmetryDescriptor(const nct::Matrix& rsd, 
+        const std::shared_ptr<const RotationIndexCache::Sources>& rotSources, 
+        nct::geometry::mesh::DistanceFunction f, std::size_t k) const;
+
+    //// Member variables ////
+
+    MeshData meshData_;                                 /**< Configuration data of the collection. */
+
+    std::shared_ptr<const DescriptorStore> store_;      /**< Descriptors of the collection. */
+
+    unsigned int nThreads_ {0};                         /**< Number of scoring threads. */
+
+    ScaleSearch scaleSearch_ {ScaleSearch::Exhaustive}; /**< Scale search of shape distributions. */
+
+    double scaleTolerance_ {defaultScaleTolerance};     /**< Tolerance of the scale search. */
+
+    unsigned int scaleStep_ {defaultScaleStep};         /**< Grid step of the scale search. */
+
+    SearchIndex searchIndex_ {SearchIndex::LinearScan}; /**< Method that finds the closest models. */
+
+    std::size_t nCells_ {0};                            /**< Number of cells of the inverted file. */
+
+    std::size_t nProbes_ {InvertedFile::defaultProbes}; /**< Number of probed cells of the inverted file. */
+
+    std::shared_ptr<QueryProgress> progress_;           /**< Progress of the comparisons. */
+
+    std::shared_ptr<const std::vector<unsigned int>> selection_;  /**< Models that are compared. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
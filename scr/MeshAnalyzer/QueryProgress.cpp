@@ -0,0 +1,159 @@
+//=================================================================================================================
+/**
+ *  @file       QueryProgress.cpp
+ *  @brief      QueryProgress class implementation file.
+ *  @details    This file contains the implementation of the QueryProgress class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "QueryProgress.h"
+
+#include "nct/nct_exception.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryProgress::QueryProgress(std::size_t k) : k_(k)
+{
+    if (k_ == 0)
+        throw ArgumentException("k", static_cast<unsigned long long>(k), 0ULL, 
+            RelationalOperator::GreaterThan, SOURCE_INFO);
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryProgress::cancel() noexcept
+{
+    canceled_ = true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool QueryProgress::canceled() const noexcept
+{
+    return canceled_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryProgress::checkCanceled() const
+{
+    if (canceled_)
+        throw OperationException("The comparison was canceled", "");
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryProgress::start(std::size_t nModels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    best_ = std::priority_queue<std::pair<double, unsigned int>>();
+    scored_ = 0;
+    total_ = nModels;
+    version_++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryProgress::add(const unsigned int* first, const unsigned int* last, const nct::RealVector& distances, 
+    const std::vector<char>* exact)
+{
+    if ((first == nullptr) || (last == nullptr))
+        throw NullPointerException("first, last", SOURCE_INFO);
+
+    if (first > last)
+        throw ArgumentException("first, last", exc_bad_range, SOURCE_INFO);
+
+    for (auto model = first; model < last; model++) {
+        if (*model >= distances.size())
+            throw IndexOutOfRangeException("first, last", SOURCE_INFO);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool changed = false;
+    for (auto model = first; model < last; model++) {
+        auto i = *model;
+        if ((exact != nullptr) && !(*exact)[i])
+            continue;
+
+        // Ties keep the order of the collection, as in the final ranking.
+        std::pair<double, unsigned int> entry {distances[i], i};
+        if (best_.size() < k_) {
+            best_.push(entry);
+            changed = true;
+        }
+        else if (entry < best_.top()) {
+            best_.pop();
+            best_.push(entry);
+            changed = true;
+        }
+    }
+
+    scored_ += static_cast<std::size_t>(last - first);
+    if (changed)
+        version_++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t QueryProgress::total() const noexcept
+{
+    return total_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t QueryProgress::scored() const noexcept
+{
+    return scored_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::uint64_t QueryProgress::version() const noexcept
+{
+    return version_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<unsigned int> QueryProgress::models() const
+{
+    std::priority_queue<std::pair<double, unsigned int>> best;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        best = best_;
+    }
+
+    Array<unsigned int> models(best.size());
+    for (auto i = models.size(); i > 0; i--) {
+        models[i - 1] = best.top().second;
+        best.pop();
+    }
+
+    return models;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
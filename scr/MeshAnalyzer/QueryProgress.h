@@ -0,0 +1,182 @@
+//=================================================================================================================
+/**
+ *  @file       QueryProgress.h
+ *  @brief      QueryProgress class.
+ *  @details    Declaration file of the QueryProgress class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef QUERY_PROGRESS_H_INCLUDE
+#define QUERY_PROGRESS_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Query progress class.
+ *  @details    This class follows a comparison with a collection while it runs in other threads. 
+ *              The query engine reports the distances of each block of models that it scores, and 
+ *              the class keeps the closest models found so far, so that they can be shown before 
+ *              the whole collection is compared. The comparison can be canceled at any time: the 
+ *              blocks that have not started are skipped and the ranking function throws an 
+ *              exception. The class is thread safe.
+ */
+class QueryProgress final
+{
+public:
+
+    //// Constants /////
+
+    static constexpr std::size_t defaultModels {10};        /**< Default number of closest models. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the progress of a comparison.
+     *  @param[in]  k  The number of closest models that are kept.
+     */
+    explicit QueryProgress(std::size_t k = defaultModels);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Deleted copy constructor.
+     */
+    QueryProgress(const QueryProgress&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~QueryProgress() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Deleted assignment operator.
+     *  @returns    A reference to the object.
+     */
+    QueryProgress& operator=(const QueryProgress&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Cancel.
+     *  @details    This function requests the cancellation of the comparison.
+     */
+    void cancel() noexcept;
+
+    /**
+     *  @brief      Canceled.
+     *  @details    This function indicates whether the cancellation of the comparison was requested.
+     *  @returns    True if the comparison was canceled.
+     */
+    bool canceled() const noexcept;
+
+    /**
+     *  @brief      Check cancellation.
+     *  @details    This function throws an exception if the cancellation of the comparison was 
+     *              requested. It is called between the stages of a comparison.
+     */
+    void checkCanceled() const;
+
+    /**
+     *  @brief      Start scan.
+     *  @details    This function indicates that a new scan of the collection starts. The number of 
+     *              scored models and the closest models are reset.
+     *  @param[in]  nModels  The number of models that are scored.
+     */
+    void start(std::size_t nModels);
+
+    /**
+     *  @brief      Add block.
+     *  @details    This function adds the distances of a block of scored models.
+     *  @param[in]  first  Pointer to the index of the first model of the block.
+     *  @param[in]  last  Pointer one past the index of the last model of the block.
+     *  @param[in]  distances  The distance to each model of the collection.
+     *  @param[in]  exact  If non-null, indicates which distances are exact. The distances of the 
+     *              models that were abandoned by a bound are lower than the real ones and are not 
+     *              taken into account.
+     */
+    void add(const unsigned int* first, const unsigned int* last, const nct::RealVector& distances, 
+        const std::vector<char>* exact = nullptr);
+
+    /**
+     *  @brief      Total models.
+     *  @details    This function returns the number of models of the current scan.
+     *  @returns    The number of models. It is zero before the scan starts.
+     */
+    std::size_t total() const noexcept;
+
+    /**
+     *  @brief      Scored models.
+     *  @details    This function returns the number of models of the current scan that were scored.
+     *  @returns    The number of scored models.
+     */
+    std::size_t scored() const noexcept;
+
+    /**
+     *  @brief      Version.
+     *  @details    This function returns a counter that changes every time the closest models change.
+     *  @returns    The version of the closest models.
+     */
+    std::uint64_t version() const noexcept;
+
+    /**
+     *  @brief      Closest models.
+     *  @details    This function returns the closest models found so far.
+     *  @returns    The indices of the models sorted from the closest to the farthest.
+     */
+    nct::Array<unsigned int> models() const;
+
+private:
+
+    //// Member variables ////
+
+    std::size_t k_ {defaultModels};                         /**< Number of closest models. */
+
+    std::atomic<bool> canceled_ {false};                    /**< Cancellation request. */
+
+    std::atomic<std::size_t> total_ {0};                    /**< Number of models of the scan. */
+
+    std::atomic<std::size_t> scored_ {0};                   /**< Number of scored models. */
+
+    std::atomic<std::uint64_t> version_ {0};                /**< Version of the closest models. */
+
+    std::priority_queue<std::pair<double, unsigned int>> best_; /**< Closest models; the top is the worst. */
+
+    mutable std::mutex mutex_;                              /**< Mutex that protects the closest models. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -26,6 +26,9 @@
 //=================================================================================================================
 #include "RSDDialog.h"
 #include "ResultsDialog.h"
+#include "QueryEngine.h"
+#include "FusedQuery.h"
+#include "ComparisonTask.h"
 
 #include "nct/color/RgbColor.h"
 #include "nct/geometry/mesh.h"
@@ -135,7 +138,7 @@ void RSDDialog::compare()
     if ( (vertices_->size() == 0) || (triangles_->size() == 0))
         return;
 
-    if (meshData_.nModels == 0)
+    if ( (meshData_.nModels == 0) || (store_ == nullptr) || (store_->numberOfModels() != meshData_.nModels) )
     {
         showErrorMessage("This operation requires a mesh collection loaded in memory.",nullptr);
         return;
@@ -143,9 +146,6 @@ void RSDDialog::compare()
 
     try
     {
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-       
-    
         // Decode parameters
         unsigned int nRot = static_cast<unsigned int>(ui_.rotationsSpinBox->value());
         
@@ -159,50 +159,23 @@ void RSDDialog::compare()
         else if (ui_.distanceMetricComboBox->currentIndex() == 3)
             f = mesh::DistanceFunction::MinDistance;
 
-        // Download descriptors of collection
-        auto modelNames = meshData_.models.selectColumn(0);
-
-        Array<Array2D<double>> rsd(meshData_.nModels);
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-            rsd[i] = MainWindow::decodeMatrixFile(meshData_.featurePath + modelNames[i] + "_RSD_RSD.bin");
-
-        // Calculate descriptor of loaded object according to the configuration file
-        auto scVertices = mesh::centerAndScaleVertices(*vertices_);
-        auto triang = mesh::triangleCoord(scVertices, *triangles_);
-        RasterizedObject3D rr(triang, -1, 1, meshData_.nVox, NConnectivity3D::TwentySixConnected);
-        auto descriptor = rr.symmetryDescriptor();
-
-        // Compare descriptor with the rest and get the minimum distances        
-        auto indices = mesh::findRotationIndices(descriptor.norms, nRot);
-
-        Array<std::pair<double, int>> ranks(meshData_.nModels);
-        
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-        {
-            ranks[i].second = i;
-            ranks[i].first = mesh::compareSymmetryDescriptors(descriptor.rsd, rsd[i], indices, f);
-        }
-
-        sort(ranks.begin(), ranks.end(), [](const std::pair<double, int>& p1, const std::pair<double, int>& p2)
-            {return p1.first<p2.first;});
-
-        // Update progress
-        QApplication::restoreOverrideCursor();
-
-        // Show results
-        Array<unsigned int> results(meshData_.nModels);
-        for (unsigned int i = 0; i < meshData_.nModels; i++)
-            results[i] = ranks[i].second;
+        // Calculate descriptor of loaded object according to the configuration file and compare 
+        // it with the rest in a worker thread, while the results dialog shows the closest models 
+        // found so far. The descriptor and the ranking of a mesh that was compared before are 
+        // taken from the cache.
+        QueryEngine engine(meshData_, store_);
 
         ResultsDialog rDialog;
         rDialog.setMeshData(meshData_);
-        rDialog.setResults(results);
+        rDialog.setTask(new ComparisonTask(engine, vertices_, triangles_, cache_, 
+            [nRot, f](FusedQuery& query) {
+                return query.rankSymmetryDescriptor(nRot, f, 10);
+            }));
         rDialog.exec();
 
     }
     catch (const std::exception& ex)
     {
-        QApplication::restoreOverrideCursor();
         showErrorMessage("Unable to compare object descriptor with the collection. "
             "Make shure the collection data is valid.", &ex);
     }
@@ -276,6 +249,18 @@ void RSDDialog::setMeshData(const MainWindow::MeshData& meshData)
     meshData_ = meshData;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void RSDDialog::setDescriptorStore(const std::shared_ptr<const DescriptorStore>& store)
+{
+    store_ = store;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void RSDDialog::setQueryCache(const std::shared_ptr<QueryCache>& cache)
+{
+    cache_ = cache;
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void RSDDialog::showErrorMessage(const QString& message, const std::exception* exception)
 {
@@ -29,6 +29,8 @@
 //=================================================================================================================
 #include "ui_RSDDialog.h"
 #include "MainWindow.h"
+#include "DescriptorStore.h"
+#include "QueryCache.h"
 
 #include "nct/nct.h"
 #include "nct/Array.h"
@@ -108,6 +110,21 @@ public:
      */
     void setMeshData(const MainWindow::MeshData& meshData);
 
+    /**
+     *  @brief      Set descriptor store.
+     *  @details    This function sets the store with the descriptors of the model collection.
+     *  @param[in]  store  The descriptor store.
+     */
+    void setDescriptorStore(const std::shared_ptr<const DescriptorStore>& store);
+
+    /**
+     *  @brief      Set query cache.
+     *  @details    This function sets the cache of the descriptors and the rankings of the compared
+     *              meshes.
+     *  @param[in]  cache  The query cache. If it is null, nothing is cached.
+     */
+    void setQueryCache(const std::shared_ptr<QueryCache>& cache);
+
 public slots:
 
     //// Slots /////    
@@ -144,6 +161,10 @@ private:
 
     MainWindow::MeshData meshData_;                                     /**< Mesh data of the collection.*/
 
+    std::shared_ptr<const DescriptorStore> store_;                      /**< Descriptors of the collection.*/
+
+    std::shared_ptr<QueryCache> cache_;                                 /**< Cache of the compared meshes.*/
+
     std::shared_ptr<nct::Array<nct::Point3D>> vertices_;                    /**< Array with the vertices of the model. */
 
     std::shared_ptr<nct::Array<nct::Vector3D<unsigned int>>> triangles_;    /**< Array with the triangles of the model. */    
@@ -0,0 +1,226 @@
+//=================================================================================================================
+/**
+ *  @file       Ranking.cpp
+ *  @brief      Ranking class implementation file.
+ *  @details    This file contains the implementation of the Ranking class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "Ranking.h"
+
+#include "nct/nct_exception.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking::Ranking(const nct::RealVector& distances, const std::vector<unsigned int>* models)
+{
+    if (models == nullptr) {
+        heap_.resize(distances.size());
+        for (size_t i = 0; i < distances.size(); i++)
+            heap_[i] = {distances[i], static_cast<unsigned int>(i), true};
+    }
+    else {
+        heap_.reserve(models->size());
+        for (auto model : *models) {
+            if (model >= distances.size())
+                throw IndexOutOfRangeException("models", SOURCE_INFO);
+            heap_.push_back({distances[model], model, true});
+        }
+    }
+
+    std::make_heap(heap_.begin(), heap_.end(), after);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking::Ranking(const nct::RealVector& distances, const std::vector<char>& exact, DistanceFunction f,
+    const std::vector<unsigned int>* models) :
+    distanceFunction_(std::move(f))
+{
+    if (exact.size() != distances.size())
+        throw ArgumentException("distances, exact", exc_arrays_of_different_lengths, SOURCE_INFO);
+
+    if (!distanceFunction_)
+        throw NullPointerException("f", SOURCE_INFO);
+
+    if (models == nullptr) {
+        heap_.resize(distances.size());
+        for (size_t i = 0; i < distances.size(); i++)
+            heap_[i] = {distances[i], static_cast<unsigned int>(i), exact[i] != 0};
+    }
+    else {
+        heap_.reserve(models->size());
+        for (auto model : *models) {
+            if (model >= distances.size())
+                throw IndexOutOfRangeException("models", SOURCE_INFO);
+            heap_.push_back({distances[model], model, exact[model] != 0});
+        }
+    }
+
+    std::make_heap(heap_.begin(), heap_.end(), after);
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t Ranking::size() const noexcept
+{
+    return models_.size() + heap_.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t Ranking::resolved() const noexcept
+{
+    return models_.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void Ranking::resolve(std::size_t n)
+{
+    while ((models_.size() < n) && (heap_.size() > 0)) {
+        std::pop_heap(heap_.begin(), heap_.end(), after);
+        auto& entry = heap_.back();
+
+        // The remaining entries are not smaller than the top one, and their exact distances are not
+        // smaller than their bounds. An exact entry at the top is therefore the next rank.
+        if (entry.exact) {
+            models_.push_back(entry.model);
+            distances_.push_back(entry.distance);
+            heap_.pop_back();
+        }
+        else {
+            entry.distance = distanceFunction_(entry.model);
+            entry.exact = true;
+            std::push_heap(heap_.begin(), heap_.end(), after);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+unsigned int Ranking::model(std::size_t rank)
+{
+    if (rank >= size())
+        throw IndexOutOfRangeException("rank", SOURCE_INFO);
+
+    resolve(rank + 1);
+    return models_[rank];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double Ranking::distance(std::size_t rank)
+{
+    if (rank >= size())
+        throw IndexOutOfRangeException("rank", SOURCE_INFO);
+
+    resolve(rank + 1);
+    return distances_[rank];
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<unsigned int> Ranking::models(std::size_t n)
+{
+    n = std::min(n, size());
+    resolve(n);
+    return Array<unsigned int>(models_.begin(), models_.begin() + n);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+Ranking Ranking::fuse(std::vector<Ranking>& rankings, const std::vector<double>& weights, 
+    std::size_t depth)
+{
+    if (rankings.size() == 0)
+        throw EmptyArrayException("rankings", SOURCE_INFO);
+
+    if (weights.size() != rankings.size())
+        throw ArgumentException("rankings, weights", exc_arrays_of_different_lengths, SOURCE_INFO);
+
+    auto n = rankings[0].size();
+    double totalWeight = 0;
+    for (size_t i = 0; i < rankings.size(); i++) {
+        if (rankings[i].size() != n)
+            throw ArgumentException("rankings", exc_arrays_of_different_lengths, SOURCE_INFO);
+
+        if (weights[i] < 0)
+            throw ArgumentException("weights", weights[i], 0.0, RelationalOperator::GreaterThanOrEqualTo, 
+                SOURCE_INFO);
+
+        totalWeight += weights[i];
+    }
+
+    if (totalWeight <= 0)
+        throw ArgumentException("weights", totalWeight, 0.0, RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    if ((depth == 0) || (depth > n))
+        depth = n;
+
+    // The rankings of a selection of the collection only contain some models, so the scores are
+    // indexed by the models of the first ranking.
+    std::vector<unsigned int> models(rankings[0].models_);
+    for (const auto& entry : rankings[0].heap_)
+        models.push_back(entry.model);
+    std::sort(models.begin(), models.end());
+    size_t nModels = models.size() > 0 ? models.back() + 1 : 0;
+
+    // Every model starts with the rank that follows the sorted ones, and the models of the sorted ranks
+    // replace it with their actual rank. The ranks are added in the same order for every model, so
+    // models with the same ranks get the same score.
+    RealVector scores(nModels, 0.0);
+    RealVector ranks(nModels);
+    for (size_t i = 0; i < rankings.size(); i++) {
+        auto& r = rankings[i];
+        r.resolve(depth);
+
+        std::fill(ranks.begin(), ranks.end(), static_cast<double>(depth + 1));
+        for (size_t j = 0; j < depth; j++) {
+            if (r.models_[j] < nModels)
+                ranks[r.models_[j]] = static_cast<double>(j + 1);
+        }
+
+        for (auto model : models)
+            scores[model] += weights[i]*ranks[model];
+    }
+
+    scores /= totalWeight;
+
+    return Ranking(scores, &models);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+bool Ranking::after(const Entry& e1, const Entry& e2) noexcept
+{
+    if (e1.distance != e2.distance)
+        return e1.distance > e2.distance;
+
+    return e1.model > e2.model;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,228 @@
+//=================================================================================================================
+/**
+ *  @file       Ranking.h
+ *  @brief      Ranking class.
+ *  @details    Declaration file of the Ranking class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef RANKING_H_INCLUDE
+#define RANKING_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+
+#include <vector>
+#include <functional>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Ranking class.
+ *  @details    This class sorts the models of a collection by distance on demand. The distance of each
+ *              model is either exact or a lower bound of the exact distance that was obtained when its
+ *              calculation was abandoned. The models are kept in a binary heap and only the ranks that
+ *              are requested are sorted; a lower bound that reaches the top of the heap is replaced
+ *              by the exact distance before the model is ranked. Models with the same distance keep the
+ *              order of the collection, so the result is the same as sorting all the exact distances.
+ *              The class is not thread safe.
+ */
+class Ranking final
+{
+public:
+
+    //// Types /////
+
+    /**
+     *  @brief      Distance function.
+     *  @details    Function that calculates the exact distance of a model given its index.
+     */
+    using DistanceFunction = std::function<double(std::size_t)>;
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes an empty ranking.
+     */
+    Ranking() = default;
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes a ranking with the exact distances of every model.
+     *  @param[in]  distances  The distance to each model.
+     *  @param[in]  models  If non-null, the sorted indices of the models that are ranked; the other
+     *              distances are ignored.
+     */
+    explicit Ranking(const nct::RealVector& distances, const std::vector<unsigned int>* models = nullptr);
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes a ranking with distances that can be lower bounds.
+     *  @param[in]  distances  The distance or a lower bound of the distance to each model.
+     *  @param[in]  exact  For each model, a non-zero value if its distance is exact.
+     *  @param[in]  f  The function that calculates the exact distance of a model.
+     *  @param[in]  models  If non-null, the sorted indices of the models that are ranked; the other
+     *              distances are ignored.
+     */
+    Ranking(const nct::RealVector& distances, const std::vector<char>& exact, DistanceFunction f,
+        const std::vector<unsigned int>* models = nullptr);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    Default copy constructor.
+     */
+    Ranking(const Ranking&) = default;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    Default move constructor.
+     */
+    Ranking(Ranking&&) = default;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~Ranking() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    Default assignment operator.
+     *  @returns    A reference to the object.
+     */
+    Ranking& operator=(const Ranking&) = default;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    Default move-assignment operator.
+     *  @returns    A reference to the object.
+     */
+    Ranking& operator=(Ranking&&) = default;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Size.
+     *  @details    This function returns the number of models of the ranking.
+     *  @returns    The number of models.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     *  @brief      Resolved ranks.
+     *  @details    This function returns the number of ranks that are already sorted.
+     *  @returns    The number of sorted ranks.
+     */
+    std::size_t resolved() const noexcept;
+
+    /**
+     *  @brief      Resolve ranks.
+     *  @details    This function sorts the first ranks of the collection.
+     *  @param[in]  n  The number of ranks to sort. If it is greater than the number of models,
+     *              every model is sorted.
+     */
+    void resolve(std::size_t n);
+
+    /**
+     *  @brief      Model.
+     *  @details    This function returns the model at a rank, sorting the ranks that are needed.
+     *  @param[in]  rank  The rank, starting from zero.
+     *  @returns    The index of the model.
+     */
+    unsigned int model(std::size_t rank);
+
+    /**
+     *  @brief      Distance.
+     *  @details    This function returns the exact distance of the model at a rank, sorting the
+     *              ranks that are needed.
+     *  @param[in]  rank  The rank, starting from zero.
+     *  @returns    The distance of the model.
+     */
+    double distance(std::size_t rank);
+
+    /**
+     *  @brief      Models.
+     *  @details    This function returns the first models of the ranking.
+     *  @param[in]  n  The number of models. If it is greater than the number of models, every
+     *              model is returned.
+     *  @returns    The indices of the models sorted from the closest to the farthest.
+     */
+    nct::Array<unsigned int> models(std::size_t n);
+
+    /**
+     *  @brief      Fuse rankings.
+     *  @details    This function aggregates the rankings of several descriptors of the same query.
+     *              The score of each model is the weighted mean of its ranks, starting from one, in
+     *              the rankings. Only the first ranks of each ranking are sorted; a model that is not
+     *              among them gets the rank that follows the last sorted one. The scores of the fused
+     *              ranking are its distances, and it contains the models of the first ranking.
+     *  @param[in, out]  rankings  The rankings to fuse. They must contain the same models.
+     *  @param[in]  weights  The weight of each ranking.
+     *  @param[in]  depth  The number of ranks that are sorted in each ranking. If it is zero, every
+     *              rank is sorted.
+     *  @returns    The fused ranking.
+     */
+    static Ranking fuse(std::vector<Ranking>& rankings, const std::vector<double>& weights, 
+        std::size_t depth);
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Heap entry.
+     *  @details    Distance of a model that is not ranked yet.
+     */
+    struct Entry final {
+        double distance {0};                    /**< Distance or lower bound of the distance. */
+        unsigned int model {0};                 /**< Index of the model. */
+        bool exact {true};                      /**< True if the distance is exact. */
+    };
+
+    //// Methods /////
+
+    /**
+     *  @brief      Compare entries.
+     *  @details    This function sorts the entries by distance and then by model index.
+     *  @param[in]  e1  The first entry.
+     *  @param[in]  e2  The second entry.
+     *  @returns    True if the first entry is ranked after the second one.
+     */
+    static bool after(const Entry& e1, const Entry& e2) noexcept;
+
+    //// Member variables ////
+
+    std::vector<Entry> heap_;                   /**< Models that are not ranked yet. */
+
+    std::vector<unsigned int> models_;          /**< Sorted models. */
+
+    std::vector<double> distances_;             /**< Distances of the sorted models. */
+
+    DistanceFunction distanceFunction_;         /**< Function that calculates exact distances. */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -27,6 +27,7 @@
 #include "ResultsDialog.h"
 
 #include <fstream>
+#include <stdexcept>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QFileDialog>
 
@@ -76,6 +77,9 @@ ResultsDialog::ResultsDialog(QWidget *objFather): QDialog(objFather)
     connect(ui_.openButton, &QPushButton::clicked, this, &ResultsDialog::open);
     connect(ui_.pageSpinBox, &QSpinBox::valueChanged, this, &ResultsDialog::showPage);
 
+    ui_.progressBar->setVisible(false);
+    ui_.cancelButton->setVisible(false);
+
     meshData_.featurePath = "";    
     meshData_.screenshotsPath = "";    
     meshData_.nModels = 0;
@@ -103,17 +107,59 @@ void ResultsDialog::setResults(const nct::Array<unsigned int>& sItems)
         return;
 
     sortedItems_ = sItems;
+    ranking_ = Ranking();
     ui_.pageSpinBox->setMinimum(1);
     ui_.pageSpinBox->setMaximum(static_cast<int>(sortedItems_.size()/10 + ( (sortedItems_.size()%10) > 0)));
     showPage(1);
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::setRanking(Ranking ranking)
+{
+    if (ranking.size()==0)
+        return;
+
+    ranking_ = std::move(ranking);
+    sortedItems_ = ranking_.models(ranking_.resolved());
+    ui_.pageSpinBox->setMinimum(1);
+    ui_.pageSpinBox->setMaximum(static_cast<int>(ranking_.size()/10 + ( (ranking_.size()%10) > 0)));
+    showPage(1);
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void ResultsDialog::setMeshData(const MainWindow::MeshData& meshData)
 {
     meshData_ = meshData;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::setTask(ComparisonTask* task)
+{
+    if (task == nullptr)
+        return;
+
+    // A previous comparison is canceled when its task is deleted.
+    delete task_;
+    task_ = task;
+    task_->setParent(this);
+
+    connect(task_, &ComparisonTask::partialResults, this, &ResultsDialog::showPartialResults);
+    connect(task_, &ComparisonTask::progressChanged, this, &ResultsDialog::showProgress);
+    connect(task_, &ComparisonTask::finished, this, &ResultsDialog::finishComparison);
+    connect(task_, &ComparisonTask::failed, this, &ResultsDialog::failComparison);
+    connect(task_, &ComparisonTask::canceled, this, &ResultsDialog::stopComparison);
+    connect(ui_.cancelButton, &QPushButton::clicked, task_, &ComparisonTask::cancel);
+
+    ui_.openButton->setEnabled(false);
+    ui_.saveButton->setEnabled(false);
+    ui_.cancelButton->setEnabled(true);
+    ui_.cancelButton->setVisible(true);
+    ui_.progressBar->setVisible(true);
+    showProgress(0, 0);
+
+    task_->start();
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void ResultsDialog::open()
 {
@@ -141,7 +187,7 @@ void ResultsDialog::open()
 //-----------------------------------------------------------------------------------------------------------------
 void ResultsDialog::save()
 {
-    if (sortedItems_.size()==0)
+    if (numberOfItems()==0)
         return;
 
     QString fileNameS = QFileDialog::getSaveFileName(this, "Results data file.", "", 
@@ -152,6 +198,9 @@ void ResultsDialog::save()
     QApplication::setOverrideCursor(Qt::WaitCursor);
     try
     {
+        if (sortedItems_.size() < numberOfItems())
+            sortedItems_ = ranking_.models(ranking_.size());
+
         ofstream file;
         file.open(fileNameS.toLatin1().data(), ios_base::binary);
         sortedItems_.write(file);
@@ -173,7 +222,7 @@ void ResultsDialog::showPage(int i)
     if (i<1)
         return;
 
-    if ( (sortedItems_.size() == 0) || (meshData_.nModels == 0) )
+    if ( (numberOfItems() == 0) || (meshData_.nModels == 0) )
         return;
 
     QGraphicsScene* scenes[10];
@@ -215,9 +264,13 @@ void ResultsDialog::showPage(int i)
 
     unsigned int iniIndex = (i-1)*10;
     unsigned int endIndex = iniIndex + 9;
-    endIndex = min(endIndex, min(static_cast<unsigned int>(sortedItems_.size())-1, meshData_.nModels-1));
+    endIndex = min(endIndex, min(static_cast<unsigned int>(numberOfItems())-1, meshData_.nModels-1));
     unsigned int nItems = endIndex - iniIndex + 1;
 
+    // Sort the ranks of the page.
+    if (sortedItems_.size() <= endIndex)
+        sortedItems_ = ranking_.models(endIndex + 1);
+
     for (unsigned int l=0; l<10; l++)
     {
         labels[l]->setText(QString("Object #") + QString::number(l+iniIndex+1));
@@ -255,6 +308,12 @@ void ResultsDialog::showPage(int i)
     }
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+std::size_t ResultsDialog::numberOfItems() const noexcept
+{
+    return ranking_.size() > 0 ? ranking_.size() : sortedItems_.size();
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void ResultsDialog::showErrorMessage(const QString& message, const std::exception* exception)
 {
@@ -268,6 +327,70 @@ void ResultsDialog::showErrorMessage(const QString& message, const std::exceptio
     dialog.exec();
 }        
 
+//=================================================================================================================
+//        SLOTS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::showPartialResults(const nct::Array<unsigned int>& models)
+{
+    if ((task_ == nullptr) || (models.size() == 0))
+        return;
+
+    ranking_ = Ranking();
+    sortedItems_ = models;
+    ui_.pageSpinBox->setMaximum(1);
+    showPage(1);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::showProgress(std::size_t scored, std::size_t total)
+{
+    if (total == 0) {
+        ui_.progressBar->setRange(0, 0);
+        ui_.progressBar->setFormat("Calculating the descriptor");
+    }
+    else {
+        ui_.progressBar->setRange(0, 100);
+        ui_.progressBar->setValue(static_cast<int>(100*min(scored, total)/total));
+        ui_.progressBar->setFormat("Comparing with the collection: %p%");
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::finishComparison()
+{
+    if (task_ == nullptr)
+        return;
+
+    auto ranking = task_->takeRanking();
+    stopComparison();
+    setRanking(std::move(ranking));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::failComparison(const QString& message)
+{
+    stopComparison();
+    std::runtime_error ex(message.toStdString());
+    showErrorMessage("Unable to compare object descriptor with the collection. "
+        "Make shure the collection data is valid.", &ex);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void ResultsDialog::stopComparison()
+{
+    if (task_ != nullptr) {
+        task_->deleteLater();
+        task_ = nullptr;
+    }
+
+    ui_.progressBar->setVisible(false);
+    ui_.cancelButton->setVisible(false);
+    ui_.openButton->setEnabled(true);
+    ui_.saveButton->setEnabled(true);
+}
+
 //=================================================================================================================
 //        END OF FILE
 //=================================================================================================================
@@ -29,6 +29,8 @@
 //=================================================================================================================
 #include "ui_ResultsDialog.h"
 #include "MainWindow.h"
+#include "Ranking.h"
+#include "ComparisonTask.h"
 
 #include "nct/nct.h"
 #include "nct/Array.h"
@@ -98,6 +100,14 @@ public:
      */
     void setResults(const nct::Array<unsigned int>& sItems);
 
+    /**
+     *  @brief      Set ranking.
+     *  @details    This function configures the results to be shown in the interface. The ranks
+     *              are sorted when the page that shows them is requested.
+     *  @param[in]  ranking  The ranking of the items.
+     */
+    void setRanking(Ranking ranking);
+
     /**
      *  @brief      Set mesh data.
      *  @details    This function sets the mesh data of the model collection.
@@ -105,6 +115,16 @@ public:
      */
     void setMeshData(const MainWindow::MeshData& meshData);
 
+    /**
+     *  @brief      Set comparison task.
+     *  @details    This function starts a comparison with the collection and shows its results. The
+     *              closest models found so far are shown in the first page while the collection is 
+     *              scanned, and the ranking replaces them when the comparison finishes. The dialog 
+     *              takes the ownership of the task, so closing it cancels the comparison.
+     *  @param[in]  task  The comparison task. It must not be started.
+     */
+    void setTask(ComparisonTask* task);
+
 public slots:
 
     /**
@@ -126,10 +146,58 @@ public slots:
      */
     void showPage(int i);
 
+private slots:
+
+    //// Slots /////
+
+    /**
+     *  @brief      Show partial results.
+     *  @details    This method shows the closest models found so far by the comparison.
+     *  @param[in]  models  The indices of the models sorted from the closest to the farthest.
+     */
+    void showPartialResults(const nct::Array<unsigned int>& models);
+
+    /**
+     *  @brief      Show progress.
+     *  @details    This method shows the progress of the comparison.
+     *  @param[in]  scored  The number of models that were compared.
+     *  @param[in]  total  The number of models of the collection, or zero while the descriptor of
+     *              the mesh is calculated.
+     */
+    void showProgress(std::size_t scored, std::size_t total);
+
+    /**
+     *  @brief      Finish comparison.
+     *  @details    This method shows the ranking of the finished comparison.
+     */
+    void finishComparison();
+
+    /**
+     *  @brief      Fail comparison.
+     *  @details    This method shows the error of a comparison that failed.
+     *  @param[in]  message  The description of the error.
+     */
+    void failComparison(const QString& message);
+
+    /**
+     *  @brief      Stop comparison.
+     *  @details    This method hides the progress of a comparison that ended. The closest models
+     *              found before a cancellation are still shown.
+     */
+    void stopComparison();
+
 private:
     
     //// Methods /////
 
+    /**
+     *  @brief      Number of items.
+     *  @details    Returns the number of items of the results, including those that are not
+     *              sorted yet.
+     *  @returns    The number of items.
+     */
+    std::size_t numberOfItems() const noexcept;
+
     /**
      *  @brief      Show error message.
      *  @details    Shows a dialog with the information of the last error that ocurred in the
@@ -147,6 +215,10 @@ private:
 
     nct::Array<unsigned int> sortedItems_;      /**< Sorted items.*/
 
+    Ranking ranking_;                           /**< Ranking of the items.*/
+
+    ComparisonTask* task_ {nullptr};            /**< Running comparison.*/
+
 };
 
 #endif
@@ -0,0 +1,318 @@
+//=================================================================================================================
+/**
+ *  @file       RotationIndexCache.cpp
+ *  @brief      RotationIndexCache class implementation file.
+ *  @details    This file contains the implementation of the RotationIndexCache class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "RotationIndexCache.h"
+
+#include "nct/nct_exception.h"
+#include "nct/geometry/mesh.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QByteArray>
+
+#include <cstring>
+#include <limits>
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//=================================================================================================================
+//        FILE STRUCTURES
+//=================================================================================================================
+
+namespace {
+
+/**
+ *  @brief      Magic key of the rotation index files.
+ */
+constexpr char rotationFileMagic[8] {'A', 'T', 'R', 'O', 'T', 'I', 'D', 'X'};
+
+/**
+ *  @brief      File header.
+ *  @details    Header stored at the beginning of the rotation index files.
+ */
+struct FileHeader final {
+    char magic[8] {};                       /**< Magic key. */
+    std::uint32_t version {0};              /**< Version of the format. */
+    std::uint32_t indexSize {0};            /**< Size of each index in bytes. */
+    std::uint32_t nVox {0};                 /**< Number of divisions of the rasterized objects. */
+    std::uint32_t nTestAngles {0};          /**< Number of test angles per axis. */
+    std::uint64_t nRotations {0};           /**< Number of rotations. */
+    std::uint64_t nDirections {0};          /**< Number of directions. */
+    std::uint64_t reserved {0};             /**< Reserved for future use. */
+};
+
+static_assert(sizeof(FileHeader) == 48, "Unexpected size of the file header.");
+
+/**
+ *  @brief      Encode indices.
+ *  @details    This function appends the indices of a table to a byte array.
+ *  @tparam     T  The type of the stored indices.
+ *  @param[in]  indices  The rotation indices.
+ *  @param[in, out]  data  The byte array.
+ */
+template<typename T>
+void encodeIndices(const RotationIndexCache::Indices& indices, QByteArray& data)
+{
+    for (const auto& row : indices) {
+        for (auto index : row) {
+            T value = static_cast<T>(index);
+            data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+    }
+}
+
+/**
+ *  @brief      Decode indices.
+ *  @details    This function fills a table with the indices stored in a byte array.
+ *  @tparam     T  The type of the stored indices.
+ *  @param[in]  data  The first stored index.
+ *  @param[in, out]  indices  The rotation indices. The rows must have the final size.
+ */
+template<typename T>
+void decodeIndices(const char* data, RotationIndexCache::Indices& indices)
+{
+    for (auto& row : indices) {
+        auto nDir = row.size();
+        for (auto& index : row) {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+
+            if (value >= nDir)
+                throw IOException(exc_bad_file_format, SOURCE_INFO);
+            index = value;
+        }
+    }
+}
+
+}
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+RotationIndexCache::RotationIndexCache(const QString& directory) :
+    directory_(directory)
+{
+
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void RotationIndexCache::reset(const QString& directory)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = directory;
+    indices_.clear();
+    sources_.clear();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString RotationIndexCache::directory() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return directory_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const RotationIndexCache::Indices> RotationIndexCache::indices(unsigned int nVox, 
+    unsigned int nTestAngles)
+{
+    // The lock is kept while a table is calculated, so that concurrent queries wait for it instead 
+    // of calculating it again.
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto key = std::make_pair(nVox, nTestAngles);
+    auto it = indices_.find(key);
+    if (it != indices_.end())
+        return it->second;
+
+    std::shared_ptr<const Indices> table;
+    QString name;
+    if (!directory_.isEmpty())
+        name = QDir(directory_).filePath(fileName(nVox, nTestAngles));
+
+    if (!name.isEmpty() && QFile::exists(name)) {
+        try {
+            table = std::make_shared<const Indices>(read(name, nVox, nTestAngles));
+        }
+        catch (const std::exception&) {
+            // A damaged file is replaced below.
+            table.reset();
+        }
+    }
+
+    if (table == nullptr) {
+        table = std::make_shared<const Indices>(calculate(nVox, nTestAngles));
+        
+        if (!name.isEmpty()) {
+            try {
+                write(name, nVox, nTestAngles, *table);
+            }
+            catch (const std::exception&) {
+                // The directory of the collection can be read-only; the table is kept in memory.
+            }
+        }
+    }
+
+    indices_[key] = table;
+    return table;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::shared_ptr<const RotationIndexCache::Sources> RotationIndexCache::sources(unsigned int nVox, 
+    unsigned int nTestAngles)
+{
+    auto key = std::make_pair(nVox, nTestAngles);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sources_.find(key);
+        if (it != sources_.end())
+            return it->second;
+    }
+
+    // The indices take the lock themselves.
+    auto table = std::make_shared<const Sources>(mesh::findRotationSources(*indices(nVox, nTestAngles)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = sources_[key];
+    if (entry == nullptr)
+        entry = table;
+    return entry;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString RotationIndexCache::fileName(unsigned int nVox, unsigned int nTestAngles)
+{
+    return QString("rotations_%1_%2.atr").arg(nVox).arg(nTestAngles);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+RotationIndexCache::Indices RotationIndexCache::calculate(unsigned int nVox, unsigned int nTestAngles)
+{
+    if (nVox == 0)
+        throw ArgumentException("nVox", nVox, 0U, RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    if (nTestAngles == 0)
+        throw ArgumentException("nTestAngles", nTestAngles, 0U, RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    // Directions of the symmetry descriptors (see RasterizedObject3D::symmetryDescriptor).
+    auto norms = mesh::sphereVertices(2*nVox, nVox);
+
+    return mesh::findRotationIndices(norms, nTestAngles);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+RotationIndexCache::Indices RotationIndexCache::read(const QString& fileName, unsigned int nVox, 
+    unsigned int nTestAngles)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw IOException(exc_error_opening_input_file, SOURCE_INFO);
+
+    auto data = file.readAll();
+    if (static_cast<std::size_t>(data.size()) < sizeof(FileHeader))
+        throw IOException(exc_error_reading_file_header, SOURCE_INFO);
+
+    FileHeader header;
+    std::memcpy(&header, data.constData(), sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, rotationFileMagic, sizeof(rotationFileMagic)) != 0)
+        throw IOException(exc_bad_magic_key, SOURCE_INFO);
+
+    if ((header.version == 0) || (header.version > version))
+        throw IOException(exc_not_supported_file, SOURCE_INFO);
+
+    if ((header.nVox != nVox) || (header.nTestAngles != nTestAngles) || 
+        (header.nRotations != static_cast<std::uint64_t>(nTestAngles)*nTestAngles*nTestAngles) ||
+        ((header.indexSize != sizeof(std::uint16_t)) && (header.indexSize != sizeof(std::uint32_t))) ||
+        (static_cast<std::uint64_t>(data.size()) != 
+            sizeof(FileHeader) + header.nRotations*header.nDirections*header.indexSize))
+        throw IOException(exc_bad_file_format, SOURCE_INFO);
+
+    Indices indices(static_cast<std::size_t>(header.nRotations));
+    for (auto& row : indices)
+        row.assign(static_cast<std::size_t>(header.nDirections), 0);
+
+    auto first = data.constData() + sizeof(FileHeader);
+    if (header.indexSize == sizeof(std::uint16_t))
+        decodeIndices<std::uint16_t>(first, indices);
+    else
+        decodeIndices<std::uint32_t>(first, indices);
+
+    return indices;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void RotationIndexCache::write(const QString& fileName, unsigned int nVox, unsigned int nTestAngles, 
+    const Indices& indices)
+{
+    std::uint64_t nDir = indices.size() > 0 ? indices[0].size() : 0;
+    for (const auto& row : indices) {
+        if (row.size() != nDir)
+            throw ArgumentException("indices", exc_arrays_of_different_lengths, SOURCE_INFO);
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, rotationFileMagic, sizeof(rotationFileMagic));
+    header.version = version;
+    header.indexSize = nDir <= std::numeric_limits<std::uint16_t>::max() + 1ULL ? 
+        sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    header.nVox = nVox;
+    header.nTestAngles = nTestAngles;
+    header.nRotations = indices.size();
+    header.nDirections = nDir;
+
+    QByteArray data;
+    data.reserve(static_cast<qsizetype>(sizeof(FileHeader) + header.nRotations*nDir*header.indexSize));
+    data.append(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    if (header.indexSize == sizeof(std::uint16_t))
+        encodeIndices<std::uint16_t>(indices, data);
+    else
+        encodeIndices<std::uint32_t>(indices, data);
+
+    // The file is replaced atomically, so that other processes never read a partial table.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        throw IOException(exc_error_opening_ouput_file, SOURCE_INFO);
+
+    if (file.write(data) != data.size())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+
+    if (!file.commit())
+        throw IOException(exc_error_writing_data, SOURCE_INFO);
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
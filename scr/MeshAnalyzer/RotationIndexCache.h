@@ -0,0 +1,224 @@
+//=================================================================================================================
+/**
+ *  @file       RotationIndexCache.h
+ *  @brief      RotationIndexCache class.
+ *  @details    Declaration file of the RotationIndexCache class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+#ifndef ROTATION_INDEX_CACHE_H_INCLUDE
+#define ROTATION_INDEX_CACHE_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include "nct/nct.h"
+#include "nct/Array.h"
+#include "nct/Array2D.h"
+
+#include <QtCore/QString>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Rotation index cache class.
+ *  @details    This class keeps the rotation index tables that are used to compare reflexive symmetry
+ *              descriptors (see mesh::findRotationIndices). A table only depends on the number of 
+ *              divisions of the rasterized objects, which defines the directions of the descriptors, 
+ *              and on the number of test angles, so it is calculated once and shared by every query. 
+ *              The tables are also stored in the directory of the cache, next to the feature files 
+ *              of the collection, and they are read from there the next time that they are needed. 
+ *              The class is thread safe.
+ *
+ *              File layout (all the integers are little-endian):
+ *              - Header: magic key, version, size of the indices in bytes (2 or 4), number of
+ *                divisions, number of test angles, number of rotations and number of directions.
+ *              - Indices: one row of nDirections indices for each rotation.
+ */
+class RotationIndexCache final
+{
+public:
+
+    //// Types /////
+
+    /**
+     *  @brief      Rotation indices.
+     *  @details    For each rotation, the index of the direction that matches each rotated direction.
+     */
+    using Indices = nct::Array<nct::Array<std::size_t>>;
+
+    /**
+     *  @brief      Rotation sources.
+     *  @details    For each rotation, the direction of the rotated descriptor that is compared with
+     *              each direction (see mesh::findRotationSources).
+     */
+    using Sources = nct::Array2D<unsigned int>;
+
+    //// Constants /////
+
+    static constexpr std::uint32_t version {1};             /**< Current version of the format. */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes an empty cache.
+     *  @param[in]  directory  The directory where the tables are stored. If it is empty, the tables
+     *              are only kept in memory.
+     */
+    explicit RotationIndexCache(const QString& directory = QString());
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    RotationIndexCache(const RotationIndexCache&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    RotationIndexCache(RotationIndexCache&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor.
+     */
+    ~RotationIndexCache() = default;
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    RotationIndexCache& operator=(const RotationIndexCache&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    RotationIndexCache& operator=(RotationIndexCache&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Reset.
+     *  @details    This function removes the tables from memory and changes the directory of the cache.
+     *  @param[in]  directory  The directory where the tables are stored. If it is empty, the tables
+     *              are only kept in memory.
+     */
+    void reset(const QString& directory = QString());
+
+    /**
+     *  @brief      Directory.
+     *  @details    This function returns the directory where the tables are stored.
+     *  @returns    The directory.
+     */
+    QString directory() const;
+
+    /**
+     *  @brief      Rotation indices.
+     *  @details    This function returns a rotation index table. The table is taken from memory, read 
+     *              from the directory of the cache or calculated, in that order. A calculated table is
+     *              written in the directory; if it cannot be written, it is only kept in memory.
+     *  @param[in]  nVox  The number of divisions of the rasterized objects.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The rotation indices.
+     */
+    std::shared_ptr<const Indices> indices(unsigned int nVox, unsigned int nTestAngles);
+
+    /**
+     *  @brief      Rotation sources.
+     *  @details    This function returns the inverse of a rotation index table, which is used to 
+     *              read the rotated descriptors without copying them. It is calculated from the 
+     *              indices the first time that it is requested and it is only kept in memory.
+     *  @param[in]  nVox  The number of divisions of the rasterized objects.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The rotation sources.
+     */
+    std::shared_ptr<const Sources> sources(unsigned int nVox, unsigned int nTestAngles);
+
+    /**
+     *  @brief      File name.
+     *  @details    This function returns the name of the file of a rotation index table.
+     *  @param[in]  nVox  The number of divisions of the rasterized objects.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The file name.
+     */
+    static QString fileName(unsigned int nVox, unsigned int nTestAngles);
+
+    /**
+     *  @brief      Calculate rotation indices.
+     *  @details    This function calculates a rotation index table for the directions of the symmetry
+     *              descriptors of objects rasterized with the specified number of divisions.
+     *  @param[in]  nVox  The number of divisions of the rasterized objects.
+     *  @param[in]  nTestAngles  The number of test angles per axis.
+     *  @returns    The rotation indices.
+     */
+    static Indices calculate(unsigned int nVox, unsigned int nTestAngles);
+
+    /**
+     *  @brief      Read rotation indices.
+     *  @details    This function reads a rotation index table from a file.
+     *  @param[in]  fileName  The name of the file.
+     *  @param[in]  nVox  The expected number of divisions.
+     *  @param[in]  nTestAngles  The expected number of test angles.
+     *  @returns    The rotation indices.
+     */
+    static Indices read(const QString& fileName, unsigned int nVox, unsigned int nTestAngles);
+
+    /**
+     *  @brief      Write rotation indices.
+     *  @details    This function writes a rotation index table in a file. The indices are stored with
+     *              16 bits when the number of directions allows it, and with 32 bits otherwise.
+     *  @param[in]  fileName  The name of the file.
+     *  @param[in]  nVox  The number of divisions.
+     *  @param[in]  nTestAngles  The number of test angles.
+     *  @param[in]  indices  The rotation indices.
+     */
+    static void write(const QString& fileName, unsigned int nVox, unsigned int nTestAngles, 
+        const Indices& indices);
+
+private:
+
+    //// Member variables ////
+
+    mutable std::mutex mutex_;                              /**< Mutex that protects the cache. */
+
+    QString directory_;                                     /**< Directory of the tables. */
+
+    /** Tables indexed by number of divisions and number of test angles. */
+    std::map<std::pair<unsigned int, unsigned int>, std::shared_ptr<const Indices>> indices_;
+
+    /** Sources indexed by number of divisions and number of test angles. */
+    std::map<std::pair<unsigned int, unsigned int>, std::shared_ptr<const Sources>> sources_;
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -26,9 +26,11 @@
 //=================================================================================================================
 #include "SDDialog.h"
 #include "ResultsDialog.h"
+#include "QueryEngine.h"
+#include "FusedQuery.h"
+#include "ComparisonTask.h"
 
 #include "nct/color/RgbColor.h"
-#include "nct/random/MersenneTwister.h"
 #include "nct/geometry/mesh.h"
 #include "nct/geometry/RasterizedObject3D.h"
 
@@ -37,7 +39,6 @@
 #include "qt_tools/graphics_3d/TriangularMesh.h"
 #include "qt_tools/QtConfig.h"
 
-#include <ctime>
 #include <fstream>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QFileDialog>
@@ -198,8 +199,6 @@ void SDDialog::calculate()
         return;
 
     // Calculate descriptor
-    random::MersenneTwister gnd(time(0));
-
     QApplication::setOverrideCursor(Qt::WaitCursor);    
 
     std::shared_ptr<StemPlot> scenes[5];
@@ -212,7 +211,7 @@ void SDDialog::calculate()
     try
     {        
 
-        mesh::ShapeDistribution functions[5] = 
+        Array<mesh::ShapeDistribution> functions = 
         {
             mesh::ShapeDistribution::CentroidDistance, 
             mesh::ShapeDistribution::TwoPointDistance,
@@ -223,14 +222,18 @@ void SDDialog::calculate()
 
         unsigned int nSamps = ui_.samplesSpinBox->value();
         unsigned int nBins = ui_.binsSpinBox->value();
+
+        // The seed only depends on the mesh and the parameters, so the same histograms are 
+        // obtained every time. The five histograms are taken from one pool of random points, as 
+        // in the queries, so with the sizes of the collection they are the compared ones. They
+        // don't depend on the number of threads.
+        auto seed = QueryCache::shapeDistributionSeed(QueryCache::hash(*vertices_, *triangles_), nSamps, nBins);
+        auto desc = mesh::calculateShapeDistributions(*vertices_, *triangles_, seed, functions, nSamps, nBins);
         
         for (unsigned int i=0; i<5; i++)
         {
-            auto desc = mesh::calculateShapeDistribution(*vertices_, *triangles_, gnd,
-                functions[i], nSamps, nBins);    
-
-            histograms_[i] = std::get<0>(desc);
-            bins_[i] = std::get<1>(desc);
+            histograms_[i] = std::get<0>(desc[i]);
+            bins_[i] = std::get<1>(desc[i]);
 
             scenes[i]->clearData();
             scenes[i]->addDataSet(bins_[i], histograms_[i], "", 0, 
@@ -262,7 +265,7 @@ void SDDialog::compare()
     if ( (vertices_->size() == 0) || (triangles_->size() == 0))
         return;
 
-    if (meshData_.nModels == 0)
+    if ( (meshData_.nModels == 0) || (store_ == nullptr) || (store_->numberOfModels() != meshData_.nModels) )
     {
         showErrorMessage("This operation requires a mesh collection loaded in memory.", nullptr);
         return;
@@ -270,42 +273,22 @@ void SDDialog::compare()
 
     try
     {
-        random::MersenneTwister gnd(time(0));
-
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-
         // Decode parameters
         unsigned int nS = static_cast<unsigned int>(ui_.stepsSpinBox->value());
         double sIni = static_cast<double>(ui_.iniStepSpinBox->value());
         double sEnd = static_cast<double>(ui_.endStepSpinBox->value());
 
         auto dist = mesh::ShapeDistribution::ThreePointArea;
-        QString sufix = "";
         if (ui_.descriptorComboBox->currentIndex() == 0)
-        {
             dist = mesh::ShapeDistribution::CentroidDistance;
-            sufix = "_SD_CD";
-        }
         else if (ui_.descriptorComboBox->currentIndex() == 1)
-        {
             dist = mesh::ShapeDistribution::TwoPointDistance;
-            sufix = "_SD_TPD";
-        }
         else if (ui_.descriptorComboBox->currentIndex() == 2)
-        {
             dist = mesh::ShapeDistribution::ThreePointArea;
-            sufix = "_SD_TPA";
-        }
         else if (ui_.descriptorComboBox->currentIndex() == 3)
-        {
             dist = mesh::ShapeDistribution::FourPointVolume;
-            sufix = "_SD_FPV";
-        }
         else if (ui_.descriptorComboBox->currentIndex() == 4)
-        {
             dist = mesh::ShapeDistribution::TwoVectorsAngle;
-            sufix = "_SD_TVA";
-        }
 
         bool cdf = false;
         auto f = mesh::DistanceFunction::EuclideanDistance;
@@ -346,56 +329,24 @@ void SDDialog::compare()
             cdf = true;
         }    
 
-        // Download descriptors of collection
-        auto modelNames = meshData_.models.selectColumn(0);
-
-        Array<Array<double>> hist(meshData_.nModels);
-        Array<Array<double>> bin(meshData_.nModels);
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-        {
-            bin[i] = MainWindow::decodeVectorFile(meshData_.featurePath + modelNames[i] + sufix + "_b.bin");
-            hist[i] = MainWindow::decodeVectorFile(meshData_.featurePath + modelNames[i] + sufix + "_h.bin");
-        }
-
-        // Calculate descriptor of this object according to the contiguracion
-        auto descriptor = mesh::calculateShapeDistribution(*vertices_, *triangles_, gnd, 
-            dist, meshData_.nSamps, meshData_.nBins);    
-
-        auto histRef = std::get<0>(descriptor);
-        auto binsRef = std::get<1>(descriptor);
-
-        // Compare descriptor with the rest and get the minimum distances
-        Array<std::pair<double, int>> ranks(meshData_.nModels);
-        
-        for (unsigned int i=0; i<meshData_.nModels; i++)
-        {
-            ranks[i].second = i;
-            if (dist == mesh::ShapeDistribution::TwoVectorsAngle)
-                ranks[i].first = mesh::calculateShapeDistributionDistance(histRef, hist[i], f, cdf);
-            else
-                ranks[i].first = mesh::calculateShapeDistributionDistance(histRef, binsRef, hist[i], bin[i], f, cdf,
-                meshData_.nBins, nS, sIni, sEnd);
-        }
-
-        sort(ranks.begin(), ranks.end(), [](const std::pair<double, int>& p1, const std::pair<double, int>& p2)
-            {return p1.first<p2.first;});
-
-        // Update progress        
-        QApplication::restoreOverrideCursor();
-
-        // Show results
-        Array<unsigned int> results(meshData_.nModels);
-        for (unsigned int i = 0; i < meshData_.nModels; i++)
-            results[i] = ranks[i].second;
+        // Calculate descriptor of this object according to the contiguracion and compare it with 
+        // the rest in a worker thread, while the results dialog shows the closest models found so 
+        // far. The descriptor and the ranking of a mesh that was compared before are taken from 
+        // the cache.
+        QueryEngine engine(meshData_, store_);
+        if (ui_.scaleSearchCheckBox->isChecked())
+            engine.setScaleSearch(QueryEngine::ScaleSearch::CoarseToFine);
 
         ResultsDialog rDialog;
         rDialog.setMeshData(meshData_);
-        rDialog.setResults(results);
+        rDialog.setTask(new ComparisonTask(engine, vertices_, triangles_, cache_, 
+            [dist, f, cdf, nS, sIni, sEnd](FusedQuery& query) {
+                return query.rankShapeDistribution(dist, f, cdf, nS, sIni, sEnd, 10);
+            }));
         rDialog.exec();
     }
     catch (const std::exception& ex)
     {
-        QApplication::restoreOverrideCursor();
         showErrorMessage("Unable to compare object descriptor with the collection. "
             "Make shure the collection data is valid.", &ex);
     }
@@ -477,6 +428,18 @@ void SDDialog::setMeshData(const MainWindow::MeshData& meshData)
     meshData_ = meshData;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+void SDDialog::setDescriptorStore(const std::shared_ptr<const DescriptorStore>& store)
+{
+    store_ = store;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void SDDialog::setQueryCache(const std::shared_ptr<QueryCache>& cache)
+{
+    cache_ = cache;
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 void SDDialog::showErrorMessage(const QString& message, const std::exception* exception)
 {
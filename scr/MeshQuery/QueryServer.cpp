@@ -0,0 +1,262 @@
+//=================================================================================================================
+/**
+ *  @file       QueryServer.cpp
+ *  @brief      QueryServer class implementation file.
+ *  @details    This file contains the implementation of the QueryServer class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include "QueryServer.h"
+
+#include "nct/nct_exception.h"
+#include "nct/nct_utils.h"
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonParseError>
+
+#include <algorithm>
+#include <exception>
+
+using namespace std;
+using namespace nct;
+
+//=================================================================================================================
+//        CONSTRUCTORS AND DESTRUCTOR
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryServer::QueryServer(Handler handler, unsigned int nThreads, QObject* objFather) :
+    QObject(objFather), handler_(std::move(handler)), nThreads_(nThreads)
+{
+    if (!handler_)
+        throw NullPointerException("handler", SOURCE_INFO);
+
+    connect(&server_, &QLocalServer::newConnection, this, &QueryServer::acceptConnections);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryServer::~QueryServer()
+{
+    if (worker_.joinable())
+        worker_.join();
+}
+
+//=================================================================================================================
+//        METHODS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryServer::listen(const QString& name)
+{
+    QLocalServer::removeServer(name);
+    server_.setSocketOptions(QLocalServer::UserAccessOption);
+    if (!server_.listen(name))
+        throw OperationException(("Unable to listen on " + name + ": " + server_.errorString()).toStdString(), "");
+
+    uptime_.start();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QString QueryServer::serverName() const
+{
+    return server_.fullServerName();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+std::vector<QJsonObject> QueryServer::process(const std::vector<QJsonObject>& requests) const
+{
+    auto n = requests.size();
+    std::vector<QJsonObject> replies(n);
+
+    nct::parallel_for(static_cast<size_t>(0), n, nThreads_, [&](size_t i) {
+        try {
+            replies[i] = handler_(requests[i], n);
+        }
+        catch (const std::exception& ex) {
+            replies[i] = QJsonObject();
+            replies[i]["error"] = QString(ex.what());
+        }
+
+        if (requests[i].contains("id"))
+            replies[i]["id"] = requests[i]["id"];
+    });
+
+    return replies;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+QueryServer::Statistics QueryServer::statistics() const
+{
+    auto s = statistics_;
+    if (s.requests > 0)
+        s.meanLatency = totalLatency_/s.requests;
+
+    if (uptime_.isValid())
+        s.uptime = uptime_.nsecsElapsed()/1e9;
+    if (s.uptime > 0)
+        s.throughput = s.requests/s.uptime;
+
+    return s;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryServer::startBatch()
+{
+    if (running_ || pending_.empty())
+        return;
+
+    // The requests that arrive while the batch runs wait for the next one.
+    batch_.swap(pending_);
+    running_ = true;
+
+    std::vector<QJsonObject> requests;
+    requests.reserve(batch_.size());
+    for (const auto& request : batch_)
+        requests.push_back(request.data);
+
+    worker_ = std::thread([this, requests = std::move(requests)]() {
+        replies_ = process(requests);
+        QMetaObject::invokeMethod(this, &QueryServer::finishBatch, Qt::QueuedConnection);
+    });
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryServer::reply(QLocalSocket* socket, const QJsonObject& reply)
+{
+    if ((socket == nullptr) || (socket->state() != QLocalSocket::ConnectedState))
+        return;
+
+    socket->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n');
+}
+
+//=================================================================================================================
+//        SLOTS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryServer::acceptConnections()
+{
+    while (server_.hasPendingConnections()) {
+        auto socket = server_.nextPendingConnection();
+        statistics_.connections++;
+
+        connect(socket, &QLocalSocket::readyRead, this, &QueryServer::readRequests);
+        connect(socket, &QLocalSocket::disconnected, this, [this]() { statistics_.connections--; });
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryServer::readRequests()
+{
+    auto socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr)
+        return;
+
+    while (socket->canReadLine()) {
+        Request request;
+        request.timer.start();
+
+        auto line = socket->readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+
+        QJsonParseError error;
+        auto document = QJsonDocument::fromJson(line, &error);
+        if (!document.isObject()) {
+            QJsonObject r;
+            r["error"] = "Invalid request: " + (error.error != QJsonParseError::NoError ? 
+                error.errorString() : QString("the request is not an object"));
+            reply(socket, r);
+            continue;
+        }
+
+        request.data = document.object();
+        if (request.data.contains("command")) {
+            QJsonObject r;
+            if (request.data["command"].toString() == "statistics") {
+                auto s = statistics();
+                r["requests"] = static_cast<qint64>(s.requests);
+                r["errors"] = static_cast<qint64>(s.errors);
+                r["batches"] = static_cast<qint64>(s.batches);
+                r["maxBatch"] = static_cast<qint64>(s.maxBatch);
+                r["connections"] = static_cast<qint64>(s.connections);
+                r["pending"] = static_cast<qint64>(pending_.size() + batch_.size());
+                r["meanLatency"] = s.meanLatency;
+                r["maxLatency"] = s.maxLatency;
+                r["uptime"] = s.uptime;
+                r["throughput"] = s.throughput;
+            }
+            else {
+                r["error"] = "Unknown command: " + request.data["command"].toString();
+            }
+
+            if (request.data.contains("id"))
+                r["id"] = request.data["id"];
+            reply(socket, r);
+            continue;
+        }
+
+        request.socket = socket;
+        pending_.push_back(std::move(request));
+    }
+
+    // A line can't be longer than the largest request.
+    if (socket->bytesAvailable() > maxRequestSize) {
+        QJsonObject r;
+        r["error"] = QString("The request is too large");
+        reply(socket, r);
+        socket->disconnectFromServer();
+    }
+
+    startBatch();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void QueryServer::finishBatch()
+{
+    worker_.join();
+    running_ = false;
+
+    for (size_t i = 0; i < batch_.size(); i++) {
+        auto latency = batch_[i].timer.nsecsElapsed()/1e6;
+        replies_[i]["latency"] = latency;
+
+        statistics_.requests++;
+        if (replies_[i].contains("error"))
+            statistics_.errors++;
+        totalLatency_ += latency;
+        statistics_.maxLatency = std::max(statistics_.maxLatency, latency);
+
+        reply(batch_[i].socket.data(), replies_[i]);
+    }
+
+    statistics_.batches++;
+    statistics_.maxBatch = std::max(statistics_.maxBatch, batch_.size());
+
+    batch_.clear();
+    replies_.clear();
+    startBatch();
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -0,0 +1,256 @@
+//=================================================================================================================
+/**
+ *  @file       QueryServer.h
+ *  @brief      QueryServer class.
+ *  @details    Declaration file of the QueryServer class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+ //=================================================================================================================
+
+//=================================================================================================================
+#ifndef QUERY_SERVER_H_INCLUDE
+#define QUERY_SERVER_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+//=================================================================================================================
+
+/**
+ *  @brief      Query server class.
+ *  @details    This class answers similarity queries sent by other processes through a local socket
+ *              (a Unix domain socket or a named pipe, depending on the platform), so that the
+ *              collection is loaded only once. Each request and each reply is a JSON object written
+ *              in a single line. The requests that arrive while a batch is running are answered
+ *              together in the next batch, in parallel. The request {"command": "statistics"} is
+ *              answered immediately with the counters of the server. The server and its sockets
+ *              live in the thread of the event loop; the batches run in a worker thread.
+ */
+class QueryServer : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    //// Types /////
+
+    /**
+     *  @brief      Handler.
+     *  @details    Function that answers a request. It is called from several threads at the same
+     *              time. The second argument is the number of requests of the batch. The reply can 
+     *              report an error with the field "error", and an exception is reported in the same 
+     *              way.
+     */
+    using Handler = std::function<QJsonObject(const QJsonObject& request, std::size_t batchSize)>;
+
+    /**
+     *  @brief      Statistics.
+     *  @details    Counters of the server.
+     */
+    struct Statistics {
+        std::size_t requests {0};                           /**< Answered requests. */
+        std::size_t errors {0};                             /**< Requests answered with an error. */
+        std::size_t batches {0};                            /**< Batches of requests. */
+        std::size_t maxBatch {0};                           /**< Size of the largest batch. */
+        std::size_t connections {0};                        /**< Open connections. */
+        double meanLatency {0};                             /**< Mean time between the arrival of a 
+                                                                 request and its reply (ms). */
+        double maxLatency {0};                              /**< Largest latency (ms). */
+        double uptime {0};                                  /**< Time since the server started (s). */
+        double throughput {0};                              /**< Answered requests per second. */
+    };
+
+    //// Constants /////
+
+    static constexpr qint64 maxRequestSize {512*1024*1024}; /**< Largest request (bytes). */
+
+    //// Constructors and destructor /////
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes the server. It doesn't listen until listen is called.
+     *  @param[in]  handler  The function that answers the requests.
+     *  @param[in]  nThreads  The number of requests of a batch that are answered at the same time.
+     *              Zero uses every core.
+     *  @param[in]  objFather  The father object.
+     */
+    QueryServer(Handler handler, unsigned int nThreads = 0, QObject* objFather = nullptr);
+
+    /**
+     *  @brief      Copy constructor.
+     *  @details    This constructor is deleted.
+     */
+    QueryServer(const QueryServer&) = delete;
+
+    /**
+     *  @brief      Move constructor.
+     *  @details    This constructor is deleted.
+     */
+    QueryServer(QueryServer&&) = delete;
+
+    /**
+     *  @brief      Destructor.
+     *  @details    Class destructor. It waits for the running batch.
+     */
+    ~QueryServer();
+
+    ////////// Operators //////////
+
+    /**
+     *  @brief      Assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    /**
+     *  @brief      Move-assignment operator.
+     *  @details    This operator is deleted.
+     *  @returns    N/A.
+     */
+    QueryServer& operator=(QueryServer&&) = delete;
+
+    //// Methods /////
+
+    /**
+     *  @brief      Listen.
+     *  @details    This function starts listening for connections. A stale socket with the same name
+     *              is removed, and only the current user can connect.
+     *  @param[in]  name  The name of the server. On Unix, it can also be the path of the socket.
+     */
+    void listen(const QString& name);
+
+    /**
+     *  @brief      Server name.
+     *  @details    This function returns the full name of the server, which is the path of the 
+     *              socket on Unix.
+     *  @returns    The name of the server.
+     */
+    QString serverName() const;
+
+    /**
+     *  @brief      Process.
+     *  @details    This function answers a batch of requests in parallel. The field "id" of each 
+     *              request is copied to its reply.
+     *  @param[in]  requests  The requests.
+     *  @returns    The replies in the order of the requests.
+     */
+    std::vector<QJsonObject> process(const std::vector<QJsonObject>& requests) const;
+
+    /**
+     *  @brief      Statistics.
+     *  @details    This function returns the counters of the server.
+     *  @returns    The statistics.
+     */
+    Statistics statistics() const;
+
+private slots:
+
+    //// Slots /////
+
+    /**
+     *  @brief      Accept connections.
+     *  @details    This method accepts the pending connections.
+     */
+    void acceptConnections();
+
+    /**
+     *  @brief      Read requests.
+     *  @details    This method reads the complete requests of the socket that sent the signal.
+     */
+    void readRequests();
+
+    /**
+     *  @brief      Finish batch.
+     *  @details    This method writes the replies of the batch that ended and starts the next one.
+     */
+    void finishBatch();
+
+private:
+
+    //// Structures /////
+
+    /**
+     *  @brief      Request.
+     *  @details    Request waiting for its reply.
+     */
+    struct Request {
+        QPointer<QLocalSocket> socket;                      /**< Socket of the client. */
+        QJsonObject data;                                   /**< Contents of the request. */
+        QElapsedTimer timer;                                /**< Timer started when it arrived. */
+    };
+
+    //// Methods /////
+
+    /**
+     *  @brief      Start batch.
+     *  @details    This function answers the pending requests in the worker thread if no batch is
+     *              running.
+     */
+    void startBatch();
+
+    /**
+     *  @brief      Reply.
+     *  @details    This function writes a reply to a client.
+     *  @param[in]  socket  The socket of the client. Nothing is written if it was closed.
+     *  @param[in]  reply  The reply.
+     */
+    static void reply(QLocalSocket* socket, const QJsonObject& reply);
+
+    //// Member variables ////
+
+    Handler handler_;                                       /**< Function that answers the requests. */
+
+    unsigned int nThreads_ {0};                             /**< Number of threads of a batch. */
+
+    QLocalServer server_;                                   /**< Server of the local socket. */
+
+    std::vector<Request> pending_;                          /**< Requests of the next batch. */
+
+    std::vector<Request> batch_;                            /**< Requests of the running batch. */
+
+    std::vector<QJsonObject> replies_;                      /**< Replies of the running batch. */
+
+    std::thread worker_;                                    /**< Thread of the running batch. */
+
+    bool running_ {false};                                  /**< Indicates whether a batch is running. */
+
+    QElapsedTimer uptime_;                                  /**< Timer started when listening began. */
+
+    Statistics statistics_;                                 /**< Counters of the server. */
+
+    double totalLatency_ {0};                               /**< Sum of the latencies (ms). */
+};
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
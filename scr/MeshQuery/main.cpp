@@ -0,0 +1,1413 @@
+//===========================================================================================================
+/**
+ *  @file       main.cpp
+ *  @brief      Mesh query program.
+ *  @details    This console program compares 3D meshes with the models of a mesh collection and reports
+ *              the closest models of each mesh. It also builds new collections from a directory of
+ *              meshes, and appends models to a collection or removes them without rebuilding it. It
+ *              can also keep a collection loaded and answer the queries of other processes through a
+ *              local socket, and it calculates the distances between every pair of models.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *
+ *  @copyright  Copyright (c) 2022 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//===========================================================================================================
+
+//===========================================================================================================
+//        HEADERS AND NAMESPACES
+//===========================================================================================================
+#include <cstdlib>
+#include <ctime>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDir>
+#include <QtCore/QDateTime>
+#include <QtCore/QTextStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtNetwork/QLocalSocket>
+
+#include "nct/nct_utils.h"
+#include "nct/nct_exception.h"
+#include "nct/random/MersenneTwister.h"
+#include "nct/geometry/mesh.h"
+
+#include "MeshAnalyzer/MeshData.h"
+#include "MeshAnalyzer/MeshFile.h"
+#include "MeshAnalyzer/DescriptorStore.h"
+#include "MeshAnalyzer/FeatureFile.h"
+#include "MeshAnalyzer/MetricTree.h"
+#include "MeshAnalyzer/InvertedFile.h"
+#include "MeshAnalyzer/QueryEngine.h"
+#include "MeshAnalyzer/Ranking.h"
+#include "MeshAnalyzer/FusedQuery.h"
+#include "MeshAnalyzer/QueryCache.h"
+#include "MeshAnalyzer/CollectionBuilder.h"
+#include "MeshAnalyzer/CollectionJournal.h"
+#include "MeshAnalyzer/DistanceMatrix.h"
+#include "MeshAnalyzer/MetadataIndex.h"
+
+#include "QueryServer.h"
+
+using namespace std;
+using namespace nct;
+using namespace nct::geometry;
+
+//===========================================================================================================
+//        STRUCTURES
+//===========================================================================================================
+
+/**
+ *  @brief      Query options.
+ *  @details    This structure contains the parameters that are used to compare the meshes.
+ */
+struct QueryOptions
+{
+    bool sd {true};                         /**< True if the shape distribution is compared. */
+    bool rsd {true};                        /**< True if the symmetry descriptor is compared. */
+    bool hm {true};                         /**< True if the harmonic descriptor is compared. */
+
+    mesh::ShapeDistribution dist {mesh::ShapeDistribution::CentroidDistance};   /**< Shape distribution. */
+    mesh::DistanceFunction f {mesh::DistanceFunction::EuclideanDistance};       /**< Distance function. */
+    bool cdf {false};                       /**< True if the cumulative distributions are compared. */
+
+    unsigned int nRot {8};                  /**< Number of rotations to compare symmetry descriptors. */
+    unsigned int nScales {256};             /**< Number of scales to compare shape distributions. */
+    double sIni {-10};                      /**< Log of the first scale. */
+    double sEnd {10};                       /**< Log of the last scale. */
+
+    unsigned int top {10};                  /**< Number of models reported for each query. */
+    bool fuse {false};                      /**< True if the rankings are fused. */
+    double weights[3] {1, 1, 1};            /**< Weights of the descriptors in the fused ranking. */
+    unsigned int depth {100};               /**< Number of ranks of each descriptor that are fused. */
+    unsigned long long seed {0};            /**< Seed of the random number generators. */
+    bool contentSeed {true};                /**< True if the seeds are derived from the contents of the meshes. */
+    bool recall {false};                    /**< True if the rankings are compared with a linear scan. */
+    std::uint64_t collection {0};           /**< Key of the collection in the query cache. */
+};
+
+/**
+ *  @brief      Descriptor result.
+ *  @details    This structure contains the closest models of the collection for one descriptor.
+ */
+struct DescriptorResult
+{
+    QString descriptor;                     /**< Name of the descriptor. */
+    Array<unsigned int> models;             /**< Closest models sorted from the closest to the farthest. */
+    RealVector distances;                   /**< Distance to each of the closest models. */
+    double scoringTime {0};                 /**< Time spent comparing with the collection in milliseconds. */
+    double recall {-1};                     /**< Fraction of the models of a linear scan that were reported,
+                                                 or -1 if it wasn't measured. */
+};
+
+/**
+ *  @brief      Query result.
+ *  @details    This structure contains the rankings of one query mesh.
+ */
+struct QueryResult
+{
+    QString fileName;                       /**< Name of the query file. */
+    QString error;                          /**< Error message if the query failed. */
+    std::vector<DescriptorResult> rankings; /**< Results of each descriptor. */
+};
+
+//===========================================================================================================
+//        FUNCTIONS
+//===========================================================================================================
+
+/**
+ *  @brief      Parse descriptor.
+ *  @details    This function selects the descriptors that are compared.
+ *  @param[in]  name  The name of the descriptor: sd, rsd, hm or all.
+ *  @param[in, out]  options  The parameters of the comparison.
+ */
+static void parseDescriptor(const QString& name, QueryOptions& options)
+{
+    auto descriptor = name.toLower();
+    options.sd = (descriptor == "all") || (descriptor == "sd");
+    options.rsd = (descriptor == "all") || (descriptor == "rsd");
+    options.hm = (descriptor == "all") || (descriptor == "hm");
+    if (!options.sd && !options.rsd && !options.hm)
+        throw OperationException("Unknown descriptor: " + descriptor.toStdString(), "");
+}
+
+/**
+ *  @brief      Parse shape distribution.
+ *  @details    This function converts the name of a shape distribution.
+ *  @param[in]  name  The name of the shape distribution: cd, tpd, tpa, fpv or tva.
+ *  @returns    The shape distribution.
+ */
+static mesh::ShapeDistribution parseShapeDistribution(const QString& name)
+{
+    auto dist = name.toLower();
+    if (dist == "cd")
+        return mesh::ShapeDistribution::CentroidDistance;
+    if (dist == "tpd")
+        return mesh::ShapeDistribution::TwoPointDistance;
+    if (dist == "tpa")
+        return mesh::ShapeDistribution::ThreePointArea;
+    if (dist == "fpv")
+        return mesh::ShapeDistribution::FourPointVolume;
+    if (dist == "tva")
+        return mesh::ShapeDistribution::TwoVectorsAngle;
+
+    throw OperationException("Unknown shape distribution: " + dist.toStdString(), "");
+}
+
+/**
+ *  @brief      Parse distance function.
+ *  @details    This function converts the name of a distance function.
+ *  @param[in]  name  The name of the distance function: euclidean, cityblock, chebychev or min.
+ *  @returns    The distance function.
+ */
+static mesh::DistanceFunction parseDistanceFunction(const QString& name)
+{
+    auto metric = name.toLower();
+    if (metric == "euclidean")
+        return mesh::DistanceFunction::EuclideanDistance;
+    if (metric == "cityblock")
+        return mesh::DistanceFunction::CityBlockDistance;
+    if (metric == "chebychev")
+        return mesh::DistanceFunction::ChebychevDistance;
+    if (metric == "min")
+        return mesh::DistanceFunction::MinDistance;
+
+    throw OperationException("Unknown distance function: " + metric.toStdString(), "");
+}
+
+/**
+ *  @brief      Parse condition.
+ *  @details    This function converts a condition on an info field of the collection.
+ *  @param[in]  text  The condition: the name of the field, an equal sign and the accepted values
+ *              separated by vertical bars.
+ *  @returns    The condition.
+ */
+static MetadataIndex::Condition parseCondition(const QString& text)
+{
+    auto separator = text.indexOf("=");
+    if (separator <= 0)
+        throw OperationException("Invalid filter: " + text.toStdString(), "");
+
+    MetadataIndex::Condition condition;
+    condition.field = text.left(separator).trimmed();
+    for (const auto& value : text.mid(separator + 1).split("|"))
+        condition.values.push_back(value);
+
+    return condition;
+}
+
+/**
+ *  @brief      Descriptor result.
+ *  @details    This function sorts the closest models of a ranking.
+ *  @param[in]  descriptor  The name of the descriptor.
+ *  @param[in, out]  ranking  The ranking of the collection.
+ *  @param[in]  top  The number of models that are reported.
+ *  @param[in]  timer  The timer that was started before the collection was scored.
+ *  @returns    The closest models of the collection.
+ */
+static DescriptorResult descriptorResult(const QString& descriptor, Ranking& ranking, unsigned int top, 
+    const QElapsedTimer& timer)
+{
+    DescriptorResult r;
+    r.descriptor = descriptor;
+    r.models = ranking.models(top);
+    r.distances = RealVector(r.models.size());
+    for (size_t i = 0; i < r.models.size(); i++)
+        r.distances[i] = ranking.distance(i);
+    r.scoringTime = timer.nsecsElapsed()/1e6;
+    return r;
+}
+
+/**
+ *  @brief      Recall.
+ *  @details    This function calculates the fraction of the closest models of an exact ranking that
+ *              are among the reported models of a descriptor.
+ *  @param[in]  r  The reported models.
+ *  @param[in, out]  exact  The exact ranking of the collection.
+ *  @param[in]  top  The number of models that are reported.
+ *  @returns    The recall.
+ */
+static double recall(const DescriptorResult& r, Ranking& exact, unsigned int top)
+{
+    auto expected = exact.models(top);
+    if (expected.size() == 0)
+        return 1;
+
+    std::set<unsigned int> reported(r.models.begin(), r.models.end());
+    size_t found = 0;
+    for (auto model : expected)
+        found += reported.count(model);
+
+    return static_cast<double>(found)/expected.size();
+}
+
+/**
+ *  @brief      Result key.
+ *  @details    This function calculates the key of the closest models of a query in the query cache.
+ *  @param[in]  query  The query.
+ *  @param[in]  options  The parameters of the comparison.
+ *  @param[in]  k  The number of ranks of each descriptor that are requested.
+ *  @returns    The key of the results.
+ */
+static std::uint64_t resultKey(const FusedQuery& query, const QueryOptions& options, size_t k)
+{
+    constexpr char tag[] {'M', 'Q', 'R', 'E', 'S'};
+    auto key = QueryCache::combine(query.hash(), tag);
+    key = QueryCache::combine(key, FusedQuery::samplingVersion);
+    key = QueryCache::combine(key, options.collection);
+    key = QueryCache::combine(key, query.seed());
+    for (auto value : {options.sd, options.rsd, options.hm, options.cdf, options.fuse})
+        key = QueryCache::combine(key, value);
+    key = QueryCache::combine(key, options.dist);
+    key = QueryCache::combine(key, options.f);
+    for (auto value : {options.nRot, options.nScales, options.top, options.depth})
+        key = QueryCache::combine(key, value);
+    for (auto value : {options.sIni, options.sEnd, options.weights[0], options.weights[1], options.weights[2]})
+        key = QueryCache::combine(key, value);
+
+    return query.rankingKey(key, k);
+}
+
+/**
+ *  @brief      Encode results.
+ *  @details    This function stores the closest models of each descriptor in a matrix with the indices
+ *              of the models in the first row and their distances in the second row.
+ *  @param[in]  rankings  The results of each descriptor.
+ *  @returns    The arrays of the results.
+ */
+static QueryCache::Arrays encodeResults(const std::vector<DescriptorResult>& rankings)
+{
+    QueryCache::Arrays arrays;
+    for (const auto& r : rankings) {
+        Matrix m(2, r.models.size());
+        for (size_t i = 0; i < r.models.size(); i++) {
+            m(0, i) = r.models[i];
+            m(1, i) = r.distances[i];
+        }
+        arrays.push_back(std::move(m));
+    }
+
+    return arrays;
+}
+
+/**
+ *  @brief      Decode results.
+ *  @details    This function restores the closest models of each descriptor of a query from the
+ *              query cache.
+ *  @param[in]  arrays  The arrays of the results (see encodeResults).
+ *  @param[in]  options  The parameters of the comparison.
+ *  @param[in]  nModels  The number of models of the collection.
+ *  @param[out]  rankings  The results of each descriptor.
+ *  @returns    True if the arrays match the parameters.
+ */
+static bool decodeResults(const QueryCache::Arrays& arrays, const QueryOptions& options, size_t nModels,
+    std::vector<DescriptorResult>& rankings)
+{
+    std::vector<QString> descriptors;
+    if (options.sd)
+        descriptors.push_back("sd");
+    if (options.rsd)
+        descriptors.push_back("rsd");
+    if (options.hm)
+        descriptors.push_back("hm");
+    if (options.fuse)
+        descriptors.push_back("fused");
+
+    if (arrays.size() != descriptors.size())
+        return false;
+
+    std::vector<DescriptorResult> results(descriptors.size());
+    for (size_t d = 0; d < descriptors.size(); d++) {
+        const auto& m = arrays[d];
+        if ((m.rows() != 2) || (m.columns() > options.top))
+            return false;
+
+        results[d].descriptor = descriptors[d];
+        results[d].models = Array<unsigned int>(m.columns());
+        results[d].distances = RealVector(m.columns());
+        for (size_t i = 0; i < m.columns(); i++) {
+            if (!(m(0, i) >= 0) || !(m(0, i) < nModels))
+                return false;
+            results[d].models[i] = static_cast<unsigned int>(m(0, i));
+            results[d].distances[i] = m(1, i);
+        }
+    }
+
+    rankings = std::move(results);
+    return true;
+}
+
+/**
+ *  @brief      Run query.
+ *  @details    This function calculates the descriptors of a mesh and ranks the collection. The
+ *              symmetry and harmonic descriptors share the rasterized mesh, and the rankings of the
+ *              descriptors are fused if it is requested. The indexed rankings can be compared with
+ *              the rankings of a linear scan to measure their recall. The descriptors and the 
+ *              rankings of a mesh that was compared before are taken from the cache, and so are 
+ *              the closest models when the recall is not measured.
+ *  @param[in]  engine  The query engine of the collection.
+ *  @param[in]  linear  The query engine of the collection that scans every model.
+ *  @param[in]  mesh  The mesh.
+ *  @param[in]  options  The parameters of the comparison.
+ *  @param[in]  seed  The seed of the random number generator of this query. It is ignored if the 
+ *              seeds are derived from the contents of the meshes.
+ *  @param[in]  cache  The cache of the descriptors and the rankings.
+ *  @returns    The rankings of the collection.
+ */
+static std::vector<DescriptorResult> runQuery(const QueryEngine& engine, const QueryEngine& linear,
+    const MeshGeometry& mesh, const QueryOptions& options, unsigned long long seed, 
+    const std::shared_ptr<QueryCache>& cache)
+{
+    std::vector<DescriptorResult> rankings;
+    std::vector<Ranking> fused;
+    std::vector<double> weights;
+    auto query = options.contentSeed ? std::make_unique<FusedQuery>(engine, mesh.vertices, mesh.triangles) : 
+        std::make_unique<FusedQuery>(engine, mesh.vertices, mesh.triangles, seed);
+    query->setCache(cache);
+
+    // The fused ranking needs the first ranks of each descriptor.
+    size_t k = options.fuse ? std::max<size_t>(options.top, options.depth) : options.top;
+
+    // The recall needs the rankings, so it is always calculated.
+    auto key = resultKey(*query, options, k);
+    QueryCache::Arrays arrays;
+    if (!options.recall && cache->find(key, arrays) && 
+        decodeResults(arrays, options, engine.meshData().nModels, rankings))
+        return rankings;
+
+    auto add = [&](const QString& descriptor, Ranking& ranking, double weight, const QElapsedTimer& timer) {
+        rankings.push_back(descriptorResult(descriptor, ranking, options.top, timer));
+        if (options.fuse) {
+            fused.push_back(std::move(ranking));
+            weights.push_back(weight);
+        }
+    };
+
+    // The descriptors are calculated before the timers start.
+    query->calculateDescriptors(options.sd, options.dist, options.rsd, options.hm);
+
+    if (options.sd) {
+        QElapsedTimer timer;
+        timer.start();
+        auto ranking = query->rankShapeDistribution(options.dist, options.f, options.cdf, options.nScales, 
+            options.sIni, options.sEnd, k);
+        add("sd", ranking, options.weights[0], timer);
+
+        if (options.recall) {
+            const auto& [hist, bins] = query->shapeDistribution(options.dist);
+            auto exact = linear.rankShapeDistribution(hist, bins, options.dist, options.f, options.cdf, 
+                options.nScales, options.sIni, options.sEnd, options.top);
+            rankings.back().recall = recall(rankings.back(), exact, options.top);
+        }
+    }
+
+    if (options.rsd) {
+        QElapsedTimer timer;
+        timer.start();
+        auto ranking = query->rankSymmetryDescriptor(options.nRot, options.f, k);
+        add("rsd", ranking, options.weights[1], timer);
+    }
+
+    if (options.hm) {
+        QElapsedTimer timer;
+        timer.start();
+        auto ranking = query->rankHarmonicDescriptor(options.f, k);
+        add("hm", ranking, options.weights[2], timer);
+
+        if (options.recall) {
+            auto exact = linear.rankHarmonicDescriptor(query->harmonicDescriptor(), options.f, options.top);
+            rankings.back().recall = recall(rankings.back(), exact, options.top);
+        }
+    }
+
+    if (options.fuse) {
+        QElapsedTimer timer;
+        timer.start();
+        auto ranking = Ranking::fuse(fused, weights, options.depth);
+        rankings.push_back(descriptorResult("fused", ranking, options.top, timer));
+    }
+
+    if (!options.recall)
+        cache->insert(key, encodeResults(rankings));
+
+    return rankings;
+}
+
+/**
+ *  @brief      Escape CSV field.
+ *  @details    This function quotes a field of a CSV file when it is necessary.
+ *  @param[in]  field  The field to escape.
+ *  @returns    The escaped field.
+ */
+static QString csvField(const QString& field)
+{
+    if (!field.contains(",") && !field.contains("\"") && !field.contains("\n"))
+        return field;
+
+    QString escaped = field;
+    escaped.replace("\"", "\"\"");
+    return "\"" + escaped + "\"";
+}
+
+/**
+ *  @brief      Escape JSON string.
+ *  @details    This function converts a text to a JSON string literal.
+ *  @param[in]  text  The text to convert.
+ *  @returns    The JSON string.
+ */
+static QString jsonString(const QString& text)
+{
+    QString escaped = text;
+    escaped.replace("\\", "\\\\");
+    escaped.replace("\"", "\\\"");
+    escaped.replace("\n", "\\n");
+    escaped.replace("\r", "\\r");
+    escaped.replace("\t", "\\t");
+    return "\"" + escaped + "\"";
+}
+
+/**
+ *  @brief      Write CSV results.
+ *  @details    This function writes the results of the queries as a CSV table with one row per
+ *              reported model.
+ *  @param[in, out]  out  The output stream.
+ *  @param[in]  results  The results of the queries.
+ *  @param[in]  meshData  The configuration data of the collection.
+ */
+static void writeCsv(QTextStream& out, const std::vector<QueryResult>& results, const MeshData& meshData)
+{
+    out << "query,descriptor,rank,model,distance" << Qt::endl;
+
+    for (const auto& result : results) {
+        for (const auto& r : result.rankings) {
+            for (size_t i = 0; i < r.models.size(); i++) {
+                auto model = r.models[i];
+                out << csvField(result.fileName) << "," << r.descriptor << "," << QString::number(i + 1) << "," <<
+                    csvField(meshData.models(model, 0)) << "," << QString::number(r.distances[i], 'g', 17) << 
+                    Qt::endl;
+            }
+        }
+    }
+}
+
+/**
+ *  @brief      Write JSON results.
+ *  @details    This function writes the results of the queries as a JSON array with one object per
+ *              query.
+ *  @param[in, out]  out  The output stream.
+ *  @param[in]  results  The results of the queries.
+ *  @param[in]  meshData  The configuration data of the collection.
+ */
+static void writeJson(QTextStream& out, const std::vector<QueryResult>& results, const MeshData& meshData)
+{
+    out << "[" << Qt::endl;
+
+    for (size_t q = 0; q < results.size(); q++) {
+        const auto& result = results[q];
+        out << "  {\"query\": " << jsonString(result.fileName);
+
+        if (!result.error.isEmpty())
+            out << ", \"error\": " << jsonString(result.error);
+
+        out << ", \"results\": {";
+        for (size_t d = 0; d < result.rankings.size(); d++) {
+            const auto& r = result.rankings[d];
+            out << (d > 0 ? ", " : "") << "\"" << r.descriptor << "\": [";
+
+            for (size_t i = 0; i < r.models.size(); i++) {
+                auto model = r.models[i];
+                out << (i > 0 ? ", " : "") << "{\"model\": " << jsonString(meshData.models(model, 0)) << 
+                    ", \"distance\": " << QString::number(r.distances[i], 'g', 17) << "}";
+            }
+            out << "]";
+        }
+        out << "}}" << (q + 1 < results.size() ? "," : "") << Qt::endl;
+    }
+
+    out << "]" << Qt::endl;
+}
+
+/**
+ *  @brief      Answer request.
+ *  @details    This function answers a request sent to the query server. The mesh of the request is
+ *              the path of a file in the field "mesh", or the contents of a file encoded in base64 in
+ *              the field "data" with its format in the field "format" (stl by default). The fields
+ *              "descriptor", "distribution", "metric", "cdf" and "k" replace the parameters of the 
+ *              server. The reply contains the closest models of each descriptor in the field "results".
+ *  @param[in]  engine  The query engine of the collection that is used by a single request.
+ *  @param[in]  batched  The query engine of the collection that is used by the requests of a batch.
+ *  @param[in]  request  The request.
+ *  @param[in]  options  The parameters of the server.
+ *  @param[in]  cache  The cache of the descriptors and the rankings.
+ *  @param[in]  batchSize  The number of requests of the batch.
+ *  @returns    The reply.
+ */
+static QJsonObject answerRequest(const QueryEngine& engine, const QueryEngine& batched, 
+    const QJsonObject& request, QueryOptions options, const std::shared_ptr<QueryCache>& cache, 
+    size_t batchSize)
+{
+    if (request.contains("descriptor"))
+        parseDescriptor(request["descriptor"].toString(), options);
+    if (request.contains("distribution"))
+        options.dist = parseShapeDistribution(request["distribution"].toString());
+    if (request.contains("metric"))
+        options.f = parseDistanceFunction(request["metric"].toString());
+    if (request.contains("cdf"))
+        options.cdf = request["cdf"].toBool();
+    if (request.contains("k")) {
+        auto k = request["k"].toInt(0);
+        if (k < 1)
+            throw OperationException("Invalid number of models", "");
+        options.top = static_cast<unsigned int>(k);
+    }
+
+    QString name;
+    MeshGeometry mesh;
+    if (request.contains("data")) {
+        name = request["name"].toString();
+        mesh = readMeshData(QByteArray::fromBase64(request["data"].toString().toLatin1()), 
+            request["format"].toString("stl"));
+    }
+    else if (request.contains("mesh")) {
+        name = request["mesh"].toString();
+        mesh = readMeshFile(name);
+    }
+    else {
+        throw OperationException("The request doesn't contain a mesh", "");
+    }
+
+    // As in the command line, a batch uses the threads to process different queries.
+    const auto& e = batchSize > 1 ? batched : engine;
+    auto rankings = runQuery(e, e, mesh, options, options.seed, cache);
+
+    const auto& meshData = engine.meshData();
+    QJsonObject results;
+    for (const auto& r : rankings) {
+        QJsonArray models;
+        for (size_t i = 0; i < r.models.size(); i++) {
+            QJsonObject model;
+            model["model"] = meshData.models(r.models[i], 0);
+            model["distance"] = r.distances[i];
+            models.append(model);
+        }
+        results[r.descriptor] = models;
+    }
+
+    QJsonObject reply;
+    reply["query"] = name;
+    reply["results"] = results;
+    return reply;
+}
+
+/**
+ *  @brief      Send requests.
+ *  @details    This function sends requests to a query server and waits for their replies. The
+ *              field "id" of each request is replaced by its index.
+ *  @param[in]  serverName  The name of the server.
+ *  @param[in]  requests  The requests.
+ *  @returns    The replies in the order of the requests.
+ */
+static std::vector<QJsonObject> sendRequests(const QString& serverName, std::vector<QJsonObject> requests)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected())
+        throw OperationException(("Unable to connect to " + serverName + ": " + socket.errorString()).toStdString(), 
+            "");
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        requests[i]["id"] = static_cast<qint64>(i);
+        socket.write(QJsonDocument(requests[i]).toJson(QJsonDocument::Compact) + '\n');
+    }
+    socket.flush();
+
+    // The replies are matched with the requests by their identifiers.
+    std::vector<QJsonObject> replies(requests.size());
+    size_t nReplies = 0;
+    while (nReplies < requests.size()) {
+        if (!socket.canReadLine() && !socket.waitForReadyRead(-1))
+            throw OperationException("The connection with the server was lost", "");
+
+        while (socket.canReadLine() && (nReplies < requests.size())) {
+            auto reply = QJsonDocument::fromJson(socket.readLine()).object();
+            auto id = reply["id"].toInt(-1);
+            if ((id < 0) || (static_cast<size_t>(id) >= requests.size()))
+                throw OperationException("Invalid reply of the server", "");
+
+            replies[id] = reply;
+            nReplies++;
+        }
+    }
+
+    socket.disconnectFromServer();
+    return replies;
+}
+
+/**
+ *  @brief      Write replies.
+ *  @details    This function writes the replies of a query server as a CSV table with one row per 
+ *              reported model, or as a JSON array.
+ *  @param[in, out]  out  The output stream.
+ *  @param[in]  files  The names of the query files.
+ *  @param[in]  replies  The replies of each file.
+ *  @param[in]  json  True if the replies are written as JSON.
+ */
+static void writeReplies(QTextStream& out, const QStringList& files, const std::vector<QJsonObject>& replies, 
+    bool json)
+{
+    if (json) {
+        QJsonArray array;
+        for (size_t q = 0; q < replies.size(); q++) {
+            auto reply = replies[q];
+            reply["query"] = files[q];
+            array.append(reply);
+        }
+        out << QString::fromUtf8(QJsonDocument(array).toJson());
+        return;
+    }
+
+    out << "query,descriptor,rank,model,distance" << Qt::endl;
+
+    for (size_t q = 0; q < replies.size(); q++) {
+        auto results = replies[q]["results"].toObject();
+        for (QString descriptor : {"sd", "rsd", "hm", "fused"}) {
+            auto models = results[descriptor].toArray();
+            for (qsizetype i = 0; i < models.size(); i++) {
+                auto model = models[i].toObject();
+                out << csvField(files[q]) << "," << descriptor << "," << QString::number(i + 1) << "," <<
+                    csvField(model["model"].toString()) << "," << 
+                    QString::number(model["distance"].toDouble(), 'g', 17) << Qt::endl;
+            }
+        }
+    }
+}
+
+/**
+ *  @brief      Main function.
+ *  @details    Function where the program starts execution. 
+ *  @param[in]  argc  Number of command-line arguments.
+ *  @param[in]  argv  Array with the command-line arguments.
+ *  @returns    Exit status of the process.
+ */
+int main(int argc,char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("MeshQuery");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QTextStream err(stderr);
+
+    // Command line
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares 3D meshes with the models of a mesh collection.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("files", "STL or PLY files to compare with the collection.", "[files...]");
+
+    QCommandLineOption configOption(QStringList{"c", "config"}, "Configuration file of the collection.", "file");
+    QCommandLineOption descriptorOption(QStringList{"d", "descriptor"}, 
+        "Descriptors to compare: sd, rsd, hm or all.", "name", "all");
+    QCommandLineOption distOption(QStringList{"s", "shape-distribution"}, 
+        "Shape distribution: cd, tpd, tpa, fpv or tva.", "name", "cd");
+    QCommandLineOption metricOption(QStringList{"m", "metric"}, 
+        "Distance function: euclidean, cityblock, chebychev or min.", "name", "euclidean");
+    QCommandLineOption cdfOption("cdf", "Compare the cumulative shape distributions.");
+    QCommandLineOption rotationsOption("rotations", "Number of rotations to compare symmetry descriptors.", "n");
+    QCommandLineOption stepsOption("steps", "Number of scales to compare shape distributions.", "n");
+    QCommandLineOption iniStepOption("ini-step", "Log of the first scale to compare shape distributions.", "x");
+    QCommandLineOption endStepOption("end-step", "Log of the last scale to compare shape distributions.", "x");
+    QCommandLineOption scaleSearchOption("scale-search", 
+        "Scale search of the shape distributions: exhaustive or coarse.", "name", "exhaustive");
+    QCommandLineOption scaleToleranceOption("scale-tolerance", 
+        "Tolerance (dB) of the coarse-to-fine scale search.", "x", QString::number(QueryEngine::defaultScaleTolerance));
+    QCommandLineOption scaleStepOption("scale-step", 
+        "Grid step (number of scales) of the coarse-to-fine scale search.", "n", QString::number(QueryEngine::defaultScaleStep));
+    QCommandLineOption indexOption("index", 
+        "Search of the closest models: linear, vptree or ivf.", "name", "linear");
+    QCommandLineOption cellsOption("cells", 
+        "Number of cells of the inverted file. Zero uses the square root of the number of models.", "n", "0");
+    QCommandLineOption probesOption("probes", 
+        "Number of cells of the inverted file probed by each query. Zero probes every cell.", "n", 
+        QString::number(InvertedFile::defaultProbes));
+    QCommandLineOption precisionOption("precision", 
+        "Precision of the symmetry and harmonic descriptors of the collection: double, half or byte.", "name", 
+        "double");
+    QCommandLineOption recallOption("recall", 
+        "Compare the indexed rankings with a linear scan and report their recall in the standard error.");
+    QCommandLineOption topOption(QStringList{"k", "top"}, "Number of models reported for each query.", "n", "10");
+    QCommandLineOption filterOption("filter", "Only compare the models whose info field has one of these "
+        "values, as in \"field=value1|value2\". The option can be repeated.", "condition");
+    QCommandLineOption fuseOption("fuse", 
+        "Report a ranking that fuses the ranks of the descriptors with these weights of sd, rsd and hm.", 
+        "weights");
+    QCommandLineOption depthOption("fuse-depth", "Number of ranks of each descriptor that are fused.", "n", "100");
+    QCommandLineOption formatOption(QStringList{"f", "format"}, "Output format: csv or json.", "name", "csv");
+    QCommandLineOption outputOption(QStringList{"o", "output"}, 
+        "Output file, or output directory of a new collection. The default is the standard output.", "file");
+    QCommandLineOption threadsOption(QStringList{"j", "threads"}, 
+        "Number of meshes processed at the same time. Zero uses every core.", "n", "0");
+    QCommandLineOption seedOption("seed", "Seed of the random number generators. By default, the shape "
+        "distributions of the queries are sampled with seeds derived from the contents of the meshes.", "n");
+    QCommandLineOption cacheOption("cache", 
+        "Directory where the descriptors of the queries are kept, so that they are not calculated again.", 
+        "directory");
+    QCommandLineOption timingOption("timing", "Report the time spent by the queries in the standard error.");
+    QCommandLineOption packOption("pack", "Write the packed feature file of the collection and exit.");
+    QCommandLineOption buildOption("build", 
+        "Build a collection with the meshes of a directory. The collection is written in the output directory.", 
+        "directory");
+    QCommandLineOption samplesOption("samples", "Number of samples of the shape distributions of a new collection.", 
+        "n", "1048576");
+    QCommandLineOption binsOption("bins", "Number of bins of the shape distributions of a new collection.", 
+        "n", "1024");
+    QCommandLineOption voxelsOption("voxels", "Number of divisions of the rasterized models of a new collection.", 
+        "n", "32");
+    QCommandLineOption addOption("add", 
+        "Append the meshes of a file or directory to the collection and exit. The option can be repeated.", 
+        "path");
+    QCommandLineOption removeOption("remove", 
+        "Remove a model from the collection and exit. The option can be repeated.", "name");
+    QCommandLineOption compactOption("compact", 
+        "Write the configuration and the packed features of the collection with the appended and removed "
+        "models and exit.");
+    QCommandLineOption serveOption("serve", 
+        "Keep the collection loaded and answer the queries sent through a local socket with this name.", "name");
+    QCommandLineOption serverOption("server", 
+        "Send the queries to the MeshQuery server that listens on a local socket with this name.", "name");
+    QCommandLineOption inlineOption("inline", "Send the contents of the meshes to the server instead of their paths.");
+    QCommandLineOption serverStatisticsOption("server-statistics", "Print the counters of the server.");
+    QCommandLineOption matrixOption("matrix", "Write the distances between every pair of models of the collection "
+        "for a descriptor (sd, rsd or hm) in the output file and exit. An interrupted calculation is resumed.", 
+        "name");
+
+    parser.addOption(configOption);
+    parser.addOption(descriptorOption);
+    parser.addOption(distOption);
+    parser.addOption(metricOption);
+    parser.addOption(cdfOption);
+    parser.addOption(rotationsOption);
+    parser.addOption(stepsOption);
+    parser.addOption(iniStepOption);
+    parser.addOption(endStepOption);
+    parser.addOption(scaleSearchOption);
+    parser.addOption(scaleToleranceOption);
+    parser.addOption(scaleStepOption);
+    parser.addOption(indexOption);
+    parser.addOption(cellsOption);
+    parser.addOption(probesOption);
+    parser.addOption(precisionOption);
+    parser.addOption(recallOption);
+    parser.addOption(topOption);
+    parser.addOption(filterOption);
+    parser.addOption(fuseOption);
+    parser.addOption(depthOption);
+    parser.addOption(formatOption);
+    parser.addOption(outputOption);
+    parser.addOption(threadsOption);
+    parser.addOption(seedOption);
+    parser.addOption(cacheOption);
+    parser.addOption(timingOption);
+    parser.addOption(packOption);
+    parser.addOption(buildOption);
+    parser.addOption(samplesOption);
+    parser.addOption(binsOption);
+    parser.addOption(voxelsOption);
+    parser.addOption(addOption);
+    parser.addOption(removeOption);
+    parser.addOption(compactOption);
+    parser.addOption(serveOption);
+    parser.addOption(serverOption);
+    parser.addOption(inlineOption);
+    parser.addOption(serverStatisticsOption);
+    parser.addOption(matrixOption);
+    parser.process(app);
+
+    try
+    {
+        // New collection
+        if (parser.isSet(buildOption)) {
+            if (!parser.isSet(outputOption))
+                throw OperationException("An output directory is required", "");
+
+            QueryOptions defaults;
+            MeshData parameters;
+            bool ok = true;
+
+            parameters.nSamps = parser.value(samplesOption).toUInt(&ok);
+            if (ok)
+                parameters.nBins = parser.value(binsOption).toUInt(&ok);
+            if (ok)
+                parameters.nVox = parser.value(voxelsOption).toUInt(&ok);
+
+            parameters.nTestAng = defaults.nRot;
+            parameters.nTestSteps = defaults.nScales;
+            parameters.iniStep = defaults.sIni;
+            parameters.endStep = defaults.sEnd;
+            if (ok && parser.isSet(rotationsOption))
+                parameters.nTestAng = parser.value(rotationsOption).toUInt(&ok);
+            if (ok && parser.isSet(stepsOption))
+                parameters.nTestSteps = parser.value(stepsOption).toUInt(&ok);
+            if (ok && parser.isSet(iniStepOption))
+                parameters.iniStep = parser.value(iniStepOption).toDouble(&ok);
+            if (ok && parser.isSet(endStepOption))
+                parameters.endStep = parser.value(endStepOption).toDouble(&ok);
+
+            unsigned int nThreads = 0;
+            if (ok)
+                nThreads = parser.value(threadsOption).toUInt(&ok);
+
+            unsigned long long seed = static_cast<unsigned long long>(time(0));
+            if (ok && parser.isSet(seedOption))
+                seed = parser.value(seedOption).toULongLong(&ok);
+
+            if (!ok)
+                throw OperationException("Invalid numeric option", "");
+
+            auto files = CollectionBuilder::findMeshFiles(parser.value(buildOption));
+            if (files.isEmpty())
+                throw OperationException("The directory doesn't contain STL or PLY files", "");
+
+            CollectionBuilder builder(parameters);
+            builder.setThreads(nThreads);
+            builder.setSeed(seed);
+            auto meshData = builder.build(files, parser.value(outputOption));
+
+            for (const auto& failure : builder.failures())
+                err << failure.fileName << ": " << failure.error << Qt::endl;
+
+            err << QString::number(meshData.nModels) << " models written to " << 
+                QDir(parser.value(outputOption)).absoluteFilePath(CollectionBuilder::configFileName) << Qt::endl;
+
+            return builder.failures().empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        // Client of a query server. The parameters that aren't given are those of the server.
+        if (parser.isSet(serverOption)) {
+            QFile outFile;
+            if (parser.isSet(outputOption)) {
+                outFile.setFileName(parser.value(outputOption));
+                if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+                    throw OperationException("Unable to open the output file", "");
+            }
+            else {
+                if (!outFile.open(stdout, QIODevice::WriteOnly))
+                    throw OperationException("Unable to open the standard output", "");
+            }
+            QTextStream out(&outFile);
+
+            if (parser.isSet(serverStatisticsOption)) {
+                QJsonObject request;
+                request["command"] = QString("statistics");
+                auto replies = sendRequests(parser.value(serverOption), {request});
+                replies[0].remove("id");
+                out << QString::fromUtf8(QJsonDocument(replies[0]).toJson());
+                return EXIT_SUCCESS;
+            }
+
+            auto format = parser.value(formatOption).toLower();
+            if ((format != "csv") && (format != "json"))
+                throw OperationException("Unknown output format: " + format.toStdString(), "");
+
+            auto files = parser.positionalArguments();
+            std::vector<QJsonObject> requests(files.size());
+            for (qsizetype i = 0; i < files.size(); i++) {
+                auto& request = requests[i];
+                if (parser.isSet(inlineOption)) {
+                    QFile file(files[i]);
+                    if (!file.open(QIODevice::ReadOnly))
+                        throw OperationException(("Unable to open " + files[i]).toStdString(), "");
+                    request["name"] = QFileInfo(files[i]).fileName();
+                    request["format"] = QFileInfo(files[i]).suffix().toLower();
+                    request["data"] = QString::fromLatin1(file.readAll().toBase64());
+                }
+                else {
+                    request["mesh"] = QFileInfo(files[i]).absoluteFilePath();
+                }
+
+                if (parser.isSet(descriptorOption))
+                    request["descriptor"] = parser.value(descriptorOption);
+                if (parser.isSet(distOption))
+                    request["distribution"] = parser.value(distOption);
+                if (parser.isSet(metricOption))
+                    request["metric"] = parser.value(metricOption);
+                if (parser.isSet(cdfOption))
+                    request["cdf"] = true;
+                if (parser.isSet(topOption))
+                    request["k"] = parser.value(topOption).toInt();
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            auto replies = sendRequests(parser.value(serverOption), requests);
+            auto elapsed = timer.nsecsElapsed()/1e6;
+
+            writeReplies(out, files, replies, format == "json");
+            out.flush();
+
+            size_t nErrors = 0;
+            double latency = 0;
+            for (qsizetype i = 0; i < files.size(); i++) {
+                latency += replies[i]["latency"].toDouble();
+                if (replies[i].contains("error")) {
+                    err << files[i] << ": " << replies[i]["error"].toString() << Qt::endl;
+                    nErrors++;
+                }
+            }
+
+            if (parser.isSet(timingOption) && !files.isEmpty()) {
+                err << QString::number(files.size()) << " queries in " << QString::number(elapsed, 'f', 1) << 
+                    " ms, mean server latency " << QString::number(latency/files.size(), 'f', 1) << " ms" << 
+                    Qt::endl;
+            }
+
+            return nErrors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+        if (!parser.isSet(configOption))
+            throw OperationException("A configuration file is required", "");
+
+        // Collection
+        auto meshData = readMeshDataFile(parser.value(configOption));
+
+        if (parser.isSet(packOption)) {
+            auto fileName = QDir(meshData.featurePath).filePath(FeatureFile::defaultFileName);
+            FeatureFile::convert(meshData.featurePath, meshData.models, fileName);
+            err << "Packed features written to " << fileName << Qt::endl;
+            return EXIT_SUCCESS;
+        }
+
+        // Incremental updates of the collection
+        if (parser.isSet(addOption) || parser.isSet(removeOption) || parser.isSet(compactOption)) {
+            // The store only appends and removes models, so the splines and the compressed copies
+            // of the queries are not built.
+            DescriptorStore store;
+            store.setLoadMode(DescriptorStore::LoadMode::Updates);
+            CollectionJournal journal(parser.value(configOption));
+            journal.load(meshData, store);
+
+            bool ok = true;
+            unsigned int nThreads = parser.value(threadsOption).toUInt(&ok);
+
+            unsigned long long seed = static_cast<unsigned long long>(time(0));
+            if (ok && parser.isSet(seedOption))
+                seed = parser.value(seedOption).toULongLong(&ok);
+
+            if (!ok)
+                throw OperationException("Invalid numeric option", "");
+
+            QStringList files;
+            for (const auto& path : parser.values(addOption)) {
+                if (QFileInfo(path).isDir()) {
+                    for (const auto& file : CollectionBuilder::findMeshFiles(path))
+                        files.append(file);
+                }
+                else {
+                    files.append(path);
+                }
+            }
+
+            // The descriptors of the new models are calculated in parallel and appended in order. 
+            // As in a new collection, model i is sampled with the seed plus i.
+            CollectionBuilder builder(meshData);
+            auto nFiles = static_cast<size_t>(files.size());
+            std::vector<DescriptorStore::Model> models(nFiles);
+            std::vector<QString> errors(nFiles);
+            auto firstModel = meshData.nModels;
+
+            nct::parallel_for(static_cast<size_t>(0), nFiles, nThreads, [&](size_t i) {
+                try {
+                    models[i] = builder.calculate(readMeshFile(files[i]), store.harmonicMatrices(), 
+                        seed + firstModel + i);
+                }
+                catch (const std::exception& ex) {
+                    errors[i] = ex.what();
+                }
+            });
+
+            size_t nFailures = 0;
+            for (size_t i = 0; i < nFiles; i++) {
+                try {
+                    if (!errors[i].isEmpty())
+                        throw OperationException(errors[i].toStdString(), "");
+
+                    Array<QString> fields(CollectionJournal::nFields);
+                    fields[0] = CollectionBuilder::modelName(files[i]);
+                    fields[1] = QFileInfo(files[i]).fileName().replace(",", "_");
+                    journal.append(meshData, store, fields, models[i]);
+                    models[i] = DescriptorStore::Model();
+                }
+                catch (const std::exception& ex) {
+                    err << files[i] << ": " << ex.what() << Qt::endl;
+                    nFailures++;
+                }
+            }
+
+            for (const auto& name : parser.values(removeOption)) {
+                try {
+                    journal.remove(meshData, store, name);
+                }
+                catch (const std::exception& ex) {
+                    err << name << ": " << ex.what() << Qt::endl;
+                    nFailures++;
+                }
+            }
+
+            if (parser.isSet(compactOption))
+                journal.compact(meshData, store);
+
+            err << QString::number(meshData.nModels) << " models, " << QString::number(journal.size()) << 
+                " journal records" << Qt::endl;
+
+            return nFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        auto store = std::make_shared<DescriptorStore>();
+        auto precision = parser.value(precisionOption).toLower();
+        if (precision == "double")
+            store->setPrecision(DescriptorStore::Precision::Float64);
+        else if (precision == "half")
+            store->setPrecision(DescriptorStore::Precision::Float16);
+        else if (precision == "byte")
+            store->setPrecision(DescriptorStore::Precision::UInt8);
+        else
+            throw OperationException("Unknown precision: " + precision.toStdString(), "");
+
+        CollectionJournal journal(parser.value(configOption));
+        journal.load(meshData, *store);
+        if ((meshData.nModels == 0) || (store->numberOfModels() != meshData.nModels))
+            throw OperationException("The collection doesn't contain models", "");
+
+        QueryEngine engine(meshData, store);
+
+        // Query parameters
+        QueryOptions options;
+        bool ok = true;
+
+        parseDescriptor(parser.value(descriptorOption), options);
+        options.dist = parseShapeDistribution(parser.value(distOption));
+        options.f = parseDistanceFunction(parser.value(metricOption));
+
+        options.cdf = parser.isSet(cdfOption);
+
+        if (meshData.nTestAng > 0)
+            options.nRot = meshData.nTestAng;
+        if (meshData.nTestSteps > 0) {
+            options.nScales = meshData.nTestSteps;
+            options.sIni = meshData.iniStep;
+            options.sEnd = meshData.endStep;
+        }
+
+        if (parser.isSet(rotationsOption))
+            options.nRot = parser.value(rotationsOption).toUInt(&ok);
+        if (ok && parser.isSet(stepsOption))
+            options.nScales = parser.value(stepsOption).toUInt(&ok);
+        if (ok && parser.isSet(iniStepOption))
+            options.sIni = parser.value(iniStepOption).toDouble(&ok);
+        if (ok && parser.isSet(endStepOption))
+            options.sEnd = parser.value(endStepOption).toDouble(&ok);
+        if (ok)
+            options.top = parser.value(topOption).toUInt(&ok);
+        if (ok)
+            options.depth = parser.value(depthOption).toUInt(&ok);
+
+        options.fuse = parser.isSet(fuseOption);
+        if (options.fuse) {
+            auto weights = parser.value(fuseOption).split(",");
+            if (weights.size() != 3)
+                throw OperationException("Three fusion weights are required", "");
+
+            for (int i = 0; (i < 3) && ok; i++)
+                options.weights[i] = weights[i].toDouble(&ok);
+        }
+
+        double scaleTolerance = QueryEngine::defaultScaleTolerance;
+        if (ok)
+            scaleTolerance = parser.value(scaleToleranceOption).toDouble(&ok);
+
+        unsigned int scaleStep = QueryEngine::defaultScaleStep;
+        if (ok)
+            scaleStep = parser.value(scaleStepOption).toUInt(&ok);
+
+        unsigned int nThreads = 0;
+        if (ok)
+            nThreads = parser.value(threadsOption).toUInt(&ok);
+
+        options.contentSeed = !parser.isSet(seedOption);
+        if (ok && parser.isSet(seedOption))
+            options.seed = parser.value(seedOption).toULongLong(&ok);
+
+        size_t nCells = 0;
+        if (ok)
+            nCells = parser.value(cellsOption).toULongLong(&ok);
+
+        size_t nProbes = 0;
+        if (ok)
+            nProbes = parser.value(probesOption).toULongLong(&ok);
+
+        if (!ok)
+            throw OperationException("Invalid numeric option", "");
+
+        options.recall = parser.isSet(recallOption);
+
+        auto scaleSearch = parser.value(scaleSearchOption).toLower();
+        if (scaleSearch == "exhaustive")
+            engine.setScaleSearch(QueryEngine::ScaleSearch::Exhaustive, scaleTolerance, scaleStep);
+        else if (scaleSearch == "coarse")
+            engine.setScaleSearch(QueryEngine::ScaleSearch::CoarseToFine, scaleTolerance, scaleStep);
+        else
+            throw OperationException("Unknown scale search: " + scaleSearch.toStdString(), "");
+
+        auto index = parser.value(indexOption).toLower();
+        if (index == "linear")
+            engine.setSearchIndex(QueryEngine::SearchIndex::LinearScan);
+        else if (index == "vptree")
+            engine.setSearchIndex(QueryEngine::SearchIndex::VantagePointTree);
+        else if (index == "ivf")
+            engine.setSearchIndex(QueryEngine::SearchIndex::InvertedFile);
+        else
+            throw OperationException("Unknown search index: " + index.toStdString(), "");
+        engine.setInvertedFile(nCells, nProbes);
+
+        // The bitmaps of the info fields select the models that are compared.
+        if (parser.isSet(filterOption)) {
+            MetadataIndex::Filter filter;
+            for (const auto& text : parser.values(filterOption))
+                filter.push_back(parseCondition(text));
+
+            MetadataIndex metadata(meshData);
+            engine.setSelection(metadata.select(filter));
+            err << QString::number(engine.selection()->size()) << " of " << QString::number(meshData.nModels) << 
+                " models match the filter" << Qt::endl;
+        }
+
+        auto format = parser.value(formatOption).toLower();
+        if ((format != "csv") && (format != "json"))
+            throw OperationException("Unknown output format: " + format.toStdString(), "");
+
+        // The results of the queries are only reused while the configuration, the packed features
+        // and the journal of the collection don't change.
+        auto cache = std::make_shared<QueryCache>(QueryCache::defaultCapacity, parser.value(cacheOption));
+        options.collection = QueryCache::combine(QueryCache::initialHash, static_cast<std::uint64_t>(meshData.nModels));
+        for (const auto& fileName : {parser.value(configOption), 
+            QDir(meshData.featurePath).filePath(FeatureFile::defaultFileName), journal.fileName()}) {
+            QFileInfo info(fileName);
+            options.collection = QueryCache::combine(options.collection, info.absoluteFilePath());
+            options.collection = QueryCache::combine(options.collection, 
+                info.exists() ? static_cast<qint64>(info.lastModified().toMSecsSinceEpoch()) : qint64(0));
+            options.collection = QueryCache::combine(options.collection, info.exists() ? info.size() : qint64(0));
+        }
+
+        // Distances between every pair of models
+        if (parser.isSet(matrixOption)) {
+            if (!parser.isSet(outputOption))
+                throw OperationException("An output file is required", "");
+
+            DistanceMatrix::Parameters parameters;
+            auto name = parser.value(matrixOption).toLower();
+            if (name == "sd")
+                parameters.descriptor = DistanceMatrix::Descriptor::ShapeDistribution;
+            else if (name == "rsd")
+                parameters.descriptor = DistanceMatrix::Descriptor::SymmetryDescriptor;
+            else if (name == "hm")
+                parameters.descriptor = DistanceMatrix::Descriptor::HarmonicDescriptor;
+            else
+                throw OperationException("Unknown descriptor: " + name.toStdString(), "");
+
+            parameters.dist = options.dist;
+            parameters.f = options.f;
+            parameters.cdf = options.cdf;
+            parameters.nRot = options.nRot;
+            parameters.nScales = options.nScales;
+            parameters.sIni = options.sIni;
+            parameters.sEnd = options.sEnd;
+            parameters.collection = options.collection;
+
+            engine.setThreads(nThreads);
+            DistanceMatrix matrix(engine, parameters);
+
+            QElapsedTimer timer;
+            timer.start();
+            auto nCalculated = matrix.calculate(parser.value(outputOption));
+
+            err << QString::number(nCalculated) << " of " << QString::number(matrix.numberOfBlocks()) << 
+                " blocks of " << QString::number(meshData.nModels) << " models calculated in " << 
+                QString::number(timer.nsecsElapsed()/1e6, 'f', 1) << " ms" << Qt::endl;
+            return EXIT_SUCCESS;
+        }
+
+        // Query server. The collection, the engines and the cache are shared by every request.
+        if (parser.isSet(serveOption)) {
+            options.recall = false;
+            engine.setThreads(nThreads);
+            auto batched = engine;
+            batched.setThreads(1);
+
+            QueryServer server([&](const QJsonObject& request, size_t batchSize) {
+                return answerRequest(engine, batched, request, options, cache, batchSize);
+            }, nThreads);
+            server.listen(parser.value(serveOption));
+
+            err << "Serving " << QString::number(meshData.nModels) << " models on " << server.serverName() << 
+                Qt::endl;
+            return app.exec();
+        }
+
+        // Run the queries. Each query has its own generator, so the results don't depend on the 
+        // number of threads. A single query uses the threads to score the collection; otherwise 
+        // the threads process different queries.
+        auto files = parser.positionalArguments();
+        engine.setThreads(files.size() > 1 ? 1 : nThreads);
+
+        auto linear = engine;
+        linear.setSearchIndex(QueryEngine::SearchIndex::LinearScan);
+
+        QElapsedTimer timer;
+        timer.start();
+        std::vector<QueryResult> results(files.size());
+        std::atomic<size_t> nErrors = 0;
+
+        nct::parallel_for(static_cast<size_t>(0), static_cast<size_t>(files.size()), nThreads, 
+            [&](size_t i) {
+                results[i].fileName = files[i];
+                try {
+                    results[i].rankings = runQuery(engine, linear, readMeshFile(files[i]), options, options.seed + i, cache);
+                }
+                catch (const std::exception& ex) {
+                    results[i].error = ex.what();
+                    nErrors++;
+                }
+            });
+
+        auto elapsed = timer.nsecsElapsed()/1e6;
+
+        // Results
+        QFile outFile;
+        if (parser.isSet(outputOption)) {
+            outFile.setFileName(parser.value(outputOption));
+            if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+                throw OperationException("Unable to open the output file", "");
+        }
+        else {
+            if (!outFile.open(stdout, QIODevice::WriteOnly))
+                throw OperationException("Unable to open the standard output", "");
+        }
+
+        QTextStream out(&outFile);
+        if (format == "json")
+            writeJson(out, results, meshData);
+        else
+            writeCsv(out, results, meshData);
+        out.flush();
+
+        for (const auto& result : results) {
+            if (!result.error.isEmpty())
+                err << result.fileName << ": " << result.error << Qt::endl;
+        }
+
+        if (parser.isSet(timingOption)) {
+            std::map<QString, double> scoringTime;
+            for (const auto& result : results) {
+                for (const auto& r : result.rankings)
+                    scoringTime[r.descriptor] += r.scoringTime;
+            }
+
+            err << QString::number(files.size()) << " queries against " << QString::number(meshData.nModels) << 
+                " models in " << QString::number(elapsed, 'f', 1) << " ms" << Qt::endl;
+
+            // The threads are reported so that runs with different values of -j can be compared.
+            auto hardwareThreads = std::thread::hardware_concurrency();
+            auto usedThreads = nThreads > 0 ? nThreads : std::max(hardwareThreads, 1U);
+            err << "  threads: " << QString::number(usedThreads) << " on the " << 
+                (files.size() > 1 ? "queries" : "collection") << ", " << QString::number(hardwareThreads) << 
+                " hardware threads" << Qt::endl;
+
+            for (const auto& [descriptor, time] : scoringTime)
+                err << "  " << descriptor << " scoring: " << QString::number(time, 'f', 1) << " ms" << Qt::endl;
+            err << "  rsd and hm descriptors: " << QString::number(store->comparedSize()/1024.0, 'f', 1) << 
+                " KiB" << Qt::endl;
+
+            auto s = cache->statistics();
+            err << "  cache: " << QString::number(s.hits) << " hits, " << QString::number(s.fileHits) << 
+                " read, " << QString::number(s.misses) << " misses" << Qt::endl;
+
+            // Distances that the metric trees didn't need to calculate.
+            std::vector<std::pair<QString, std::shared_ptr<const MetricTree>>> trees;
+            if ((engine.searchIndex() == QueryEngine::SearchIndex::VantagePointTree) && 
+                MetricTree::isMetric(options.f)) {
+                if (options.sd && (options.dist == mesh::ShapeDistribution::TwoVectorsAngle))
+                    trees.push_back({"sd", store->sdTree(options.dist, options.f, options.cdf)});
+                if (options.hm)
+                    trees.push_back({"hm", store->hmTree(options.f)});
+            }
+
+            for (const auto& [descriptor, tree] : trees) {
+                auto s = tree->statistics();
+                err << "  " << descriptor << " index: " << QString::number(s.evaluations) << " distances in " << 
+                    QString::number(s.queries) << " queries, " << QString::number(s.saved) << " saved" << Qt::endl;
+            }
+
+            if ((engine.searchIndex() == QueryEngine::SearchIndex::InvertedFile) && options.hm) {
+                auto invertedFile = store->hmInvertedFile(engine.invertedFileCells());
+                auto s = invertedFile->statistics();
+                err << "  hm index: " << QString::number(s.evaluations) << " distances in " << 
+                    QString::number(s.queries) << " queries, " << QString::number(s.saved) << " saved, " << 
+                    QString::number(engine.invertedFileProbes()) << " of " << 
+                    QString::number(invertedFile->numberOfCells()) << " cells probed" << Qt::endl;
+            }
+        }
+
+        // Mean recall of each descriptor over the queries.
+        if (options.recall) {
+            std::map<QString, std::pair<double, size_t>> recalls;
+            for (const auto& result : results) {
+                for (const auto& r : result.rankings) {
+                    if (r.recall >= 0) {
+                        recalls[r.descriptor].first += r.recall;
+                        recalls[r.descriptor].second++;
+                    }
+                }
+            }
+
+            for (const auto& [descriptor, sum] : recalls) {
+                err << "  " << descriptor << " recall@" << QString::number(options.top) << ": " << 
+                    QString::number(sum.first/sum.second, 'f', 3) << " in " << QString::number(sum.second) << 
+                    " queries" << Qt::endl;
+            }
+        }
+
+        return nErrors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    catch (const std::exception& ex)
+    {
+        err << "Error: " << ex.what() << Qt::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+//===========================================================================================================
+//        END OF FILE
+//===========================================================================================================
+
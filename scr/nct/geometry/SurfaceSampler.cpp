@@ -0,0 +1,209 @@
+//=================================================================================================================
+/**
+ *  @file       SurfaceSampler.cpp
+ *  @brief      nct::geometry::SurfaceSampler class implementation file.
+ *  @details    This file contains the implementation of the nct::geometry::SurfaceSampler class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,  
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial 
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include <nct/geometry/SurfaceSampler.h>
+#include <nct/geometry/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+
+//=================================================================================================================
+//        CONSTRUCTORS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::geometry::SurfaceSampler::SurfaceSampler(const Array<Point3D>& vertices, 
+    const Array<Vector3D<unsigned int>>& triangles)
+{
+    auto nt = triangles.size();
+    if (nt == 0)
+        throw EmptyArrayException("triangles", SOURCE_INFO);
+
+    // The areas are accumulated in the order of the triangles, so the total area is the same as
+    // the sum of mesh::calculateAreas.
+    RealVector areas = mesh::calculateAreas(vertices, triangles);
+    corners_.assign(3*nt, Point3D());
+    cumulative_.assign(nt, 0.0);
+    weightedSum_ = Point3D(0.0, 0.0, 0.0);
+
+    double acc = 0;
+    for (index_t i=0; i<nt; i++) {
+        const auto& v1 = vertices[triangles[i].v1()];
+        const auto& v2 = vertices[triangles[i].v2()];
+        const auto& v3 = vertices[triangles[i].v3()];
+
+        corners_[3*i] = v1;
+        corners_[3*i + 1] = v2;
+        corners_[3*i + 2] = v3;
+
+        acc = (i == 0) ? areas[0] : acc + areas[i];
+        cumulative_[i] = acc;
+        weightedSum_ += ( (v1 + v2 + v3) * (areas[i]/3.0));
+    }
+
+    area_ = acc;
+
+    // Guide table with one interval per triangle.
+    guide_.assign(nt, 0);
+    scale_ = area_ > 0 ? nt/area_ : 0;
+
+    size_t c = 0;
+    for (index_t b=0; b<nt; b++) {
+        double start = area_*b/nt;
+        while ( (c < nt - 1) && (start > (cumulative_[c] + VERY_SMALL_TOL)) )
+            c++;
+        guide_[b] = c;
+    }
+}
+
+//=================================================================================================================
+//        MEMBER FUNCTIONS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t nct::geometry::SurfaceSampler::numberOfTriangles() const noexcept
+{
+    return cumulative_.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double nct::geometry::SurfaceSampler::area() const noexcept
+{
+    return area_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Point3D nct::geometry::SurfaceSampler::centroid() const
+{
+    if (area_ == 0)
+        throw ArithmeticException(exc_div_by_zero, SOURCE_INFO);
+
+    return weightedSum_/area_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+size_t nct::geometry::SurfaceSampler::findTriangle(double a) const
+{
+    if (cumulative_.size() == 0)
+        throw EmptyArrayException("cumulative_", SOURCE_INFO);
+
+    // The result is the first triangle whose cumulative area reaches the position. The search 
+    // starts at the guide of its interval and moves back in case the interval was rounded, so the
+    // triangle is the same as the one of a binary search. Rounding errors can leave a position 
+    // slightly above the total area, which belongs to the last triangle.
+    auto nt = cumulative_.size();
+    size_t b = (a > 0) ? static_cast<size_t>(std::min(a*scale_, static_cast<double>(nt - 1))) : 0;
+    size_t c = guide_[b];
+
+    while ( (c > 0) && !(a > (cumulative_[c - 1] + VERY_SMALL_TOL)) )
+        c--;
+    while ( (c < nt - 1) && (a > (cumulative_[c] + VERY_SMALL_TOL)) )
+        c++;
+
+    return c;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void nct::geometry::SurfaceSampler::samplePoints(size_t nSamples, random::RandomNumber& rnd, 
+    double* x, double* y, double* z) const
+{
+    if (nSamples == 0)
+        throw ArgumentException("nSamples", static_cast<unsigned long long>(nSamples), 0ULL, 
+        RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    if ((x == nullptr) || (y == nullptr) || (z == nullptr))
+        throw NullPointerException("x, y, z", SOURCE_INFO);
+
+    if (cumulative_.size() == 0)
+        throw EmptyArrayException("cumulative_", SOURCE_INFO);
+
+    // The triangle of each point is kept in the x array until the point is calculated.
+    for (size_t i=0; i<nSamples; i++)
+        x[i] = static_cast<double>(findTriangle(area_*rnd.random()));
+
+    double r1, r2;
+    for (size_t i=0; i<nSamples; i++) {
+        r1 = std::sqrt(rnd.random());
+        r2 = rnd.random();
+
+        auto t = 3*static_cast<size_t>(x[i]);
+        const auto& v1 = corners_[t];
+        const auto& v2 = corners_[t + 1];
+        const auto& v3 = corners_[t + 2];
+
+        x[i] = (1-r1)*v1.v1() + r1*(1-r2)*v2.v1() + r1*r2*v3.v1();
+        y[i] = (1-r1)*v1.v2() + r1*(1-r2)*v2.v2() + r1*r2*v3.v2();
+        z[i] = (1-r1)*v1.v3() + r1*(1-r2)*v2.v3() + r1*r2*v3.v3();
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void nct::geometry::SurfaceSampler::samplePoints(size_t nSamples, random::RandomNumber& rnd, 
+    Point3D* points) const
+{
+    if (nSamples == 0)
+        throw ArgumentException("nSamples", static_cast<unsigned long long>(nSamples), 0ULL, 
+        RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    if (points == nullptr)
+        throw NullPointerException("points", SOURCE_INFO);
+
+    if (cumulative_.size() == 0)
+        throw EmptyArrayException("cumulative_", SOURCE_INFO);
+
+    // The triangle of each point is kept in its first coordinate until the point is calculated.
+    for (size_t i=0; i<nSamples; i++)
+        points[i][0] = static_cast<double>(findTriangle(area_*rnd.random()));
+
+    double r1, r2;
+    for (size_t i=0; i<nSamples; i++) {
+        r1 = std::sqrt(rnd.random());
+        r2 = rnd.random();
+
+        auto t = 3*static_cast<size_t>(points[i][0]);
+        const auto& v1 = corners_[t];
+        const auto& v2 = corners_[t + 1];
+        const auto& v3 = corners_[t + 2];
+
+        points[i] = (1-r1)*v1 + r1*(1-r2)*v2 + r1*r2*v3;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<nct::Point3D> nct::geometry::SurfaceSampler::samplePoints(size_t nSamples, 
+    random::RandomNumber& rnd) const
+{
+    if (nSamples == 0)
+        throw ArgumentException("nSamples", static_cast<unsigned long long>(nSamples), 0ULL, 
+        RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    Array<Point3D> points(nSamples);
+    samplePoints(nSamples, rnd, points.data());
+    return points;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
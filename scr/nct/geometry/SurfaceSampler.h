@@ -0,0 +1,156 @@
+//=================================================================================================================
+/**
+ *  @file       SurfaceSampler.h
+ *  @brief      nct::geometry::SurfaceSampler class.
+ *  @details    Declaration of the nct::geometry::SurfaceSampler class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,  
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial 
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+#ifndef NCT_SURFACE_SAMPLER_H_INCLUDE
+#define NCT_SURFACE_SAMPLER_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include <nct/nct.h>
+#include <nct/nct_exception.h>
+#include <nct/Array.h>
+#include <nct/Vector3D.h>
+#include <nct/random/RandomNumber.h>
+
+//=================================================================================================================
+namespace nct {
+namespace geometry {
+
+/**
+ *  @brief      Surface sampler.
+ *  @details    This class draws random points that are uniformly distributed on the surface of a 
+ *              triangular mesh. The areas, the cumulative areas and the centroid of the mesh are 
+ *              calculated once when the object is built, and the triangle of each point is found in
+ *              constant expected time with a guide table of the cumulative areas: the area is split 
+ *              in as many equal intervals as triangles, and the table keeps the first triangle of 
+ *              each interval, so only a few cumulative areas are compared. The same sampler can be 
+ *              used for every shape distribution of a mesh, and the samples are not sorted. The random numbers are 
+ *              consumed in the same order as mesh::samplePoints: first one number per point to 
+ *              select its triangle and then two numbers per point to place it in the triangle.
+ */
+class NCT_EXPIMP SurfaceSampler final {
+
+public:
+
+    ////////// Constructors //////////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes a sampler without triangles.
+     */
+    SurfaceSampler() = default;
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor calculates the cumulative areas of the triangles of a mesh.
+     *  @param[in]  vertices  Array with the vertices of the triangular mesh.
+     *  @param[in]  triangles  Array that defines the triangles of the mesh.
+     */
+    SurfaceSampler(const Array<Point3D>& vertices, const Array<Vector3D<unsigned int>>& triangles);
+
+    ////////// Member functions //////////
+
+    /**
+     *  @brief      Number of triangles.
+     *  @details    This function returns the number of triangles of the mesh.
+     *  @returns    The number of triangles.
+     */
+    size_t numberOfTriangles() const noexcept;
+
+    /**
+     *  @brief      Surface area.
+     *  @details    This function returns the total area of the mesh.
+     *  @returns    The area of the mesh.
+     */
+    double area() const noexcept;
+
+    /**
+     *  @brief      Centroid.
+     *  @details    This function returns the centroid of the mesh, which is the mean of the 
+     *              baricenters of the triangles weighted by their areas.
+     *  @returns    The centroid of the mesh.
+     */
+    Point3D centroid() const;
+
+    /**
+     *  @brief      Find triangle.
+     *  @details    This function finds the triangle that contains a position of the cumulative area 
+     *              of the mesh.
+     *  @param[in]  a  The position, between zero and the area of the mesh.
+     *  @returns    The index of the triangle.
+     */
+    size_t findTriangle(double a) const;
+
+    /**
+     *  @brief      Sample points.
+     *  @details    This function calculates random points of the surface and writes their 
+     *              coordinates in separated arrays.
+     *  @param[in]  nSamples  Number of random points to calculate.
+     *  @param[in, out] rnd  Pseudo-random number generator.
+     *  @param[out] x  Array of at least nSamples elements where the x coordinates are stored.
+     *  @param[out] y  Array of at least nSamples elements where the y coordinates are stored.
+     *  @param[out] z  Array of at least nSamples elements where the z coordinates are stored.
+     */
+    void samplePoints(size_t nSamples, random::RandomNumber& rnd, double* x, double* y, double* z) const;
+
+    /**
+     *  @brief      Sample points.
+     *  @details    This function calculates random points of the surface.
+     *  @param[in]  nSamples  Number of random points to calculate.
+     *  @param[in, out] rnd  Pseudo-random number generator.
+     *  @param[out] points  Array of at least nSamples elements where the points are stored.
+     */
+    void samplePoints(size_t nSamples, random::RandomNumber& rnd, Point3D* points) const;
+
+    /**
+     *  @brief      Sample points.
+     *  @details    This function calculates random points of the surface.
+     *  @param[in]  nSamples  Number of random points to calculate.
+     *  @param[in, out] rnd  Pseudo-random number generator.
+     *  @returns    An array with the sampled points.
+     */
+    Array<Point3D> samplePoints(size_t nSamples, random::RandomNumber& rnd) const;
+
+private:
+
+    ////////// Data members //////////
+
+    Array<Point3D> corners_;    /**< Vertices of each triangle, three consecutive points per triangle. */
+
+    RealVector cumulative_;     /**< Cumulative area of the triangles. */
+
+    Array<size_t> guide_;       /**< First triangle of each interval of the cumulative area. */
+
+    double scale_ {0};          /**< Number of intervals per unit of area. */
+
+    double area_ {0};           /**< Total area of the mesh. */
+
+    Point3D weightedSum_;       /**< Sum of the baricenters of the triangles weighted by their areas. */
+};
+
+}}
+
+#endif
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -24,11 +24,21 @@
 //        HEADERS AND NAMESPACES
 //=================================================================================================================
 #include <nct/geometry/mesh.h>
+#include <nct/geometry/mesh_kernels.h>
 #include <nct/statistics/statistics.h>
+#include <nct/statistics/HistogramAccumulator.h>
 #include <nct/statistics/distance_metrics.h>
 #include <nct/interpolation/CubicSpline.h>
 #include <nct/geometry/AffineTransformation3D.h>
 #include <nct/math/math.h>
+#include <nct/random/MersenneTwister.h>
+#include <nct/nct_utils.h>
+
+#include <algorithm>
+
+#if defined(NCT_MESH_AVX) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 //=================================================================================================================
 //        AUXILIAR FUNCTIONS
@@ -463,52 +473,7 @@ nct::Array<nct::Point3D> nct::geometry::mesh::samplePoints(
         throw ArgumentException("nSamples", nSamples, 0U, 
         RelationalOperator::GreaterThan, SOURCE_INFO);
 
-    // Calculate areas.
-    RealVector areas = calculateAreas(vertices, triangles);    
-    double totArea = areas.sum();
-
-    // Sample N points.
-    RealVector x(nSamples);
-    for (unsigned int i=0; i<nSamples; i++)
-        x[i] = totArea*rnd.random();
-
-    Array<std::pair<double, unsigned int>> sortedX(nSamples);
-    for (unsigned int i=0; i<nSamples; i++)
-        sortedX[i] = std::make_pair(x[i], i);
-
-    std::sort(sortedX.begin(), sortedX.end(), 
-        [](const std::pair<double, unsigned int>& x1, 
-        const std::pair<double, unsigned int>& x2){return x1.first < x2.first;});
-    
-    // Find the triangle where each sample point is located.
-    auto nt = triangles.size();
-    Array<size_t> tIndex(nSamples, nt);
-
-    size_t cIndex = 0;
-    double acc =  areas[0];
-    for (unsigned int i=0; i<nSamples; i++) {
-        while ( sortedX[i].first > (acc + VERY_SMALL_TOL) ) {
-            cIndex++;
-            acc += areas[cIndex];            
-        }
-        tIndex[sortedX[i].second] = cIndex;
-    }
-
-    // Find a random point into each selected triangle.
-    Array<Point3D> points(nSamples);
-    double r1, r2;
-    for (unsigned int i=0; i<nSamples; i++) {
-        r1 = std::sqrt(rnd.random());
-        r2 = rnd.random();
-
-        const auto& v1 = vertices[triangles[tIndex[i]].v1()];
-        const auto& v2 = vertices[triangles[tIndex[i]].v2()];
-        const auto& v3 = vertices[triangles[tIndex[i]].v3()];
-
-        points[i] = (1-r1)*v1 + r1*(1-r2)*v2 + r1*r2*v3;
-    }
-
-    return points;
+    return SurfaceSampler(vertices, triangles).samplePoints(nSamples, rnd);
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -553,7 +518,14 @@ nct::Point3D nct::geometry::mesh::calculateCentroid(
     const Array<Vector3D<unsigned int>>& triangles,
     unsigned int nSamples, random::RandomNumber& rnd)
 {
-    Array<Point3D> points = samplePoints(vertices, triangles, nSamples, rnd);
+    return calculateCentroid(SurfaceSampler(vertices, triangles), nSamples, rnd);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Point3D nct::geometry::mesh::calculateCentroid(const SurfaceSampler& sampler, 
+    unsigned int nSamples, random::RandomNumber& rnd)
+{
+    Array<Point3D> points = sampler.samplePoints(nSamples, rnd);
     return calculateCentroid(points);
 }
 
@@ -562,101 +534,333 @@ std::tuple<nct::RealVector, nct::RealVector> nct::geometry::mesh::calculateShape
     const Array<Point3D>& vertices, const Array<Vector3D<unsigned int>>& triangles,
     random::RandomNumber& rnd, ShapeDistribution dist, unsigned int nSamples, unsigned int nBins)
 {
-    RealVector histogram;
-    RealVector bins;
-
-    // Calculate random samples and the histogram of the selected distribution.
-    switch (dist) {
-        case ShapeDistribution::TwoVectorsAngle: {
-                RealVector samps(nSamples);
-                Array<Point3D> points = samplePoints(
-                    vertices, triangles, nSamples*3, rnd);
-                for (unsigned int i=0; i<nSamples; i++)
-                    samps[i] = math::wrapToPi(angleBetweenVectors(
-                    points[i * (size_t)3 + 1] - points[i * (size_t)3 + 0],
-                        points[i * (size_t)3 + 2] - points[i * (size_t)3 + 0]));
-
-                histogram.assign(nBins, 0.0);
-                bins.assign(nBins, 0.0);
-                statistics::histogram(samps.begin(), samps.end(), histogram.begin(),
-                    bins.begin(), nBins, 0, PI);
-                histogram /= static_cast<double>(nSamples);
-            }
-            break;
+    return calculateShapeDistribution(SurfaceSampler(vertices, triangles), rnd, dist, nSamples, nBins);
+}
 
-        case ShapeDistribution::CentroidDistance: {
-                Vector3D<double> c = calculateCentroid( vertices, triangles);
+//-----------------------------------------------------------------------------------------------------------------
+std::tuple<nct::RealVector, nct::RealVector> nct::geometry::mesh::calculateShapeDistribution(
+    const SurfaceSampler& sampler, random::RandomNumber& rnd, ShapeDistribution dist, 
+    unsigned int nSamples, unsigned int nBins)
+{
+    return std::move(calculateShapeDistributions(sampler, rnd, {dist}, nSamples, nBins)[0]);
+}
 
-                RealVector samps(nSamples);
-                Array<Point3D> points = samplePoints(
-                    vertices, triangles, nSamples, rnd);
-                for (unsigned int i=0; i<nSamples; i++)
-                    samps[i] = (points[i] - c).magnitude();  
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Points of the tuples of shape distributions.
+ *  @details    This function returns the number of random points of the tuples of a pool that is
+ *              shared by several shape distributions, that is, the number of points of the largest 
+ *              distribution.
+ *  @param[in]  dists  The shape distributions.
+ *  @param[out] centroid  True if the centroid of the mesh is needed.
+ *  @returns    The number of points of each tuple.
+ */
+static nct::size_t shapeDistributionPoints(
+    const nct::Array<nct::geometry::mesh::ShapeDistribution>& dists, bool& centroid)
+{
+    using nct::geometry::mesh::ShapeDistribution;
+
+    if (dists.size() == 0)
+        throw nct::EmptyArrayException("dists", SOURCE_INFO);
+
+    nct::size_t nPoints = 0;
+    centroid = false;
+    for (auto dist : dists) {
+        switch (dist) {
+            case ShapeDistribution::CentroidDistance:
+                nPoints = std::max(nPoints, static_cast<nct::size_t>(1));
+                centroid = true;
+                break;
+            case ShapeDistribution::TwoPointDistance:
+                nPoints = std::max(nPoints, static_cast<nct::size_t>(2));
+                break;
+            case ShapeDistribution::TwoVectorsAngle:
+            case ShapeDistribution::ThreePointArea:
+                nPoints = std::max(nPoints, static_cast<nct::size_t>(3));
+                break;
+            case ShapeDistribution::FourPointVolume:
+                nPoints = std::max(nPoints, static_cast<nct::size_t>(4));
+                break;
+            default:
+                throw nct::ArgumentException("dists", nct::exc_bad_shape_distribution, SOURCE_INFO);
+        }
+    }
 
-                histogram.assign(nBins, 0.0);
-                bins.assign(nBins, 0.0);
-                statistics::histogram(samps.begin(), samps.end(), histogram.begin(),
-                    bins.begin(), nBins);
+    return nPoints;
+}
 
-                histogram /= static_cast<double>(nSamples);
-            }
-            break;
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Scalar lanes.
+ *  @details    Operations of the kernels of the shape distributions on one sample at a time. They 
+ *              are used when the processor doesn't have vector registers and for the samples that
+ *              don't fill a vector register.
+ */
+struct ScalarLanes {
+    using type = double;
+    static constexpr nct::size_t width {1};
+    static type set(double a) noexcept {return a;}
+    static type load(const double* p) noexcept {return *p;}
+    static void store(double* p, type a) noexcept {*p = a;}
+    static type add(type a, type b) noexcept {return a + b;}
+    static type sub(type a, type b) noexcept {return a - b;}
+    static type mul(type a, type b) noexcept {return a*b;}
+    static type div(type a, type b) noexcept {return a/b;}
+    static type sqrt(type a) noexcept {return std::sqrt(a);}
+    static type abs(type a) noexcept {return std::abs(a);}
+};
+
+#if defined(NCT_MESH_SSE2)
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      SSE2 lanes.
+ *  @details    Operations of the kernels of the shape distributions on two samples at a time.
+ */
+struct Sse2Lanes {
+    using type = __m128d;
+    static constexpr nct::size_t width {2};
+    static type set(double a) noexcept {return _mm_set1_pd(a);}
+    static type load(const double* p) noexcept {return _mm_loadu_pd(p);}
+    static void store(double* p, type a) noexcept {_mm_storeu_pd(p, a);}
+    static type add(type a, type b) noexcept {return _mm_add_pd(a, b);}
+    static type sub(type a, type b) noexcept {return _mm_sub_pd(a, b);}
+    static type mul(type a, type b) noexcept {return _mm_mul_pd(a, b);}
+    static type div(type a, type b) noexcept {return _mm_div_pd(a, b);}
+    static type sqrt(type a) noexcept {return _mm_sqrt_pd(a);}
+    static type abs(type a) noexcept {return _mm_andnot_pd(_mm_set1_pd(-0.0), a);}
+};
+#endif
+
+#if defined(NCT_MESH_AVX)
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      AVX support.
+ *  @details    This function checks whether the processor and the operating system support the
+ *              AVX instructions.
+ *  @returns    True if the AVX instructions can be used.
+ */
+static bool avxSupported() noexcept
+{
+    static const bool supported = [] {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        return osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6);
+#else
+        return __builtin_cpu_supports("avx") != 0;
+#endif
+    }();
+
+    return supported;
+}
+#endif
 
-        case ShapeDistribution::TwoPointDistance: {
-                RealVector samps(nSamples);
-                Array<Point3D> points = samplePoints(
-                    vertices, triangles, nSamples * 2, rnd);
-                for (unsigned int i=0; i<nSamples; i++)
-                    samps[i] = (points[i * (size_t)2 + 1] - points[i * (size_t)2 + 0]).magnitude();
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Samples of a shape distribution.
+ *  @details    This function calculates the random samples of a shape distribution with the 
+ *              leading points of each tuple of a pool of points. The coordinates of the pool are 
+ *              stored by point of the tuples: the point j of the tuple i is the element j*n + i, 
+ *              so the samples are calculated with the widest vector instructions of the processor.
+ *  @param[in]  dist  The shape distribution.
+ *  @param[in]  x  The x coordinates of the points of the pool.
+ *  @param[in]  y  The y coordinates of the points of the pool.
+ *  @param[in]  z  The z coordinates of the points of the pool.
+ *  @param[in]  n  The number of tuples.
+ *  @param[in]  c  The centroid of the mesh.
+ *  @param[out] samps  The n samples of the distribution.
+ */
+static void shapeDistributionSamples(nct::geometry::mesh::ShapeDistribution dist, const double* x, 
+    const double* y, const double* z, nct::size_t n, const nct::Point3D& c, double* samps)
+{
+    nct::size_t m = 0;
 
-                histogram.assign(nBins, 0.0);
-                bins.assign(nBins, 0.0);
-                statistics::histogram(samps.begin(), samps.end(), histogram.begin(),
-                    bins.begin(), nBins);
+#if defined(NCT_MESH_AVX)
+    if (avxSupported()) {
+        m = n - n % nct::geometry::mesh::avxShapeDistributionWidth;
+        nct::geometry::mesh::avxShapeDistributionSamples(dist, x, y, z, n, m, c, samps);
+    }
+#endif
 
-                histogram /= static_cast<double>(nSamples);
-            }
-            break;
+#if defined(NCT_MESH_SSE2)
+    if (m == 0) {
+        m = n - n % Sse2Lanes::width;
+        shapeDistributionSamples<Sse2Lanes>(dist, x, y, z, n, 0, m, c, samps);
+    }
+#endif
 
-        case ShapeDistribution::ThreePointArea: {
-                RealVector samps(nSamples);
-                Array<Point3D> points = samplePoints(
-                    vertices, triangles, nSamples * 3, rnd);
-                for (unsigned int i=0; i<nSamples; i++)
-                    samps[i] = std::sqrt(triangleArea(points[i * (size_t)3 + 0],
-                    points[i * (size_t)3 + 1], points[i * (size_t)3 + 2]));
+    shapeDistributionSamples<ScalarLanes>(dist, x, y, z, n, m, n, c, samps);
+}
 
-                histogram.assign(nBins, 0.0);
-                bins.assign(nBins, 0.0);
-                statistics::histogram(samps.begin(), samps.end(), histogram.begin(),
-                    bins.begin(), nBins);
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Tuples of each block of the parallel sampling of shape distributions. The histograms 
+ *              depend on it, so changing it changes the histograms of a seed.
+ */
+static constexpr nct::size_t shapeDistributionBlockSize {8192};
 
-                histogram /= static_cast<double>(nSamples);
-            }
-            break;
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Seed of a stream.
+ *  @details    This function derives the seed of a stream of random numbers from the seed of a 
+ *              calculation and the index of the stream with the SplitMix64 finalizer, so that 
+ *              consecutive streams start from unrelated states.
+ *  @param[in]  seed  The seed of the calculation.
+ *  @param[in]  stream  The index of the stream.
+ *  @returns    The seed of the stream.
+ */
+static unsigned long long streamSeed(unsigned long long seed, nct::size_t stream) noexcept
+{
+    auto s = seed + (static_cast<unsigned long long>(stream) + 1)*0x9e3779b97f4a7c15ULL;
+    s = (s ^ (s >> 30))*0xbf58476d1ce4e5b9ULL;
+    s = (s ^ (s >> 27))*0x94d049bb133111ebULL;
+    return s ^ (s >> 31);
+}
 
-        case ShapeDistribution::FourPointVolume: {
-                RealVector samps(nSamples);
-                Array<Point3D> points = samplePoints(
-                    vertices, triangles, nSamples * 4, rnd);
-                for (unsigned int i=0; i<nSamples; i++)
-                    samps[i] = std::pow(tetrahedronVolume(points[i * (size_t)4 + 0],
-                    points[i * (size_t)4 + 1], points[i * (size_t)4 + 2], 
-                        points[i * (size_t)4 + 3]), 1.0 / 3.0);
-
-                histogram.assign(nBins, 0.0);
-                bins.assign(nBins, 0.0);
-                statistics::histogram(samps.begin(), samps.end(), histogram.begin(),
-                    bins.begin(), nBins);
-
-                histogram /= static_cast<double>(nSamples);
-            }
-            break;
-        default:
-            throw ArgumentException("dist", exc_bad_shape_distribution, SOURCE_INFO);
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<std::tuple<nct::RealVector, nct::RealVector>> nct::geometry::mesh::calculateShapeDistributions(
+    const Array<Point3D>& vertices, const Array<Vector3D<unsigned int>>& triangles,
+    random::RandomNumber& rnd, const Array<ShapeDistribution>& dists, unsigned int nSamples, 
+    unsigned int nBins)
+{
+    return calculateShapeDistributions(SurfaceSampler(vertices, triangles), rnd, dists, nSamples, nBins);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<std::tuple<nct::RealVector, nct::RealVector>> nct::geometry::mesh::calculateShapeDistributions(
+    const SurfaceSampler& sampler, random::RandomNumber& rnd, const Array<ShapeDistribution>& dists,
+    unsigned int nSamples, unsigned int nBins)
+{
+    bool centroid = false;
+    auto nPoints = shapeDistributionPoints(dists, centroid);
+
+    Point3D c;
+    if (centroid)
+        c = sampler.centroid();
+
+    // The coordinates of the points are written in separated arrays. The point j of the 
+    // tuple i is the element j*n + i.
+    auto n = static_cast<size_t>(nSamples);
+    RealVector x(nPoints*n), y(nPoints*n), z(nPoints*n);
+    sampler.samplePoints(nPoints*n, rnd, x.data(), y.data(), z.data());
+
+    Array<std::tuple<RealVector, RealVector>> results(dists.size());
+    RealVector samps(n);
+    for (index_t k=0; k<dists.size(); k++) {
+        shapeDistributionSamples(dists[k], x.data(), y.data(), z.data(), n, c, samps.data());
+
+        // Calculate the histogram. The angles are binned between 0 and pi, and the other 
+        // distributions between their minimum and maximum samples.
+        statistics::HistogramAccumulator accumulator;
+        if (dists[k] == ShapeDistribution::TwoVectorsAngle) {
+            accumulator = statistics::HistogramAccumulator(nBins, 0, PI);
+            accumulator.add(samps.data(), samps.data() + n);
+        }
+        else {
+            accumulator = statistics::HistogramAccumulator(samps.data(), samps.data() + n, nBins);
+        }
+
+        RealVector histogram = accumulator.histogram();
+        histogram /= static_cast<double>(nSamples);
+
+        results[k] = std::make_tuple(std::move(histogram), accumulator.bins());
     }
 
-    return std::make_tuple(histogram, bins);
+    return results;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<std::tuple<nct::RealVector, nct::RealVector>> nct::geometry::mesh::calculateShapeDistributions(
+    const Array<Point3D>& vertices, const Array<Vector3D<unsigned int>>& triangles,
+    unsigned long long seed, const Array<ShapeDistribution>& dists, unsigned int nSamples, 
+    unsigned int nBins, unsigned int nThreads)
+{
+    return calculateShapeDistributions(SurfaceSampler(vertices, triangles), seed, dists, nSamples, nBins,
+        nThreads);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array<std::tuple<nct::RealVector, nct::RealVector>> nct::geometry::mesh::calculateShapeDistributions(
+    const SurfaceSampler& sampler, unsigned long long seed, const Array<ShapeDistribution>& dists,
+    unsigned int nSamples, unsigned int nBins, unsigned int nThreads)
+{
+    bool centroid = false;
+    auto nPoints = shapeDistributionPoints(dists, centroid);
+
+    if (nSamples == 0)
+        throw ArgumentException("nSamples", nSamples, 0U, RelationalOperator::GreaterThan, SOURCE_INFO);
+
+    Point3D c;
+    if (centroid)
+        c = sampler.centroid();
+
+    // Each block of tuples is sampled with its own stream of random numbers and in its own buffers.
+    auto n = static_cast<size_t>(nSamples);
+    auto nd = dists.size();
+    auto nBlocks = n/shapeDistributionBlockSize + (n % shapeDistributionBlockSize > 0);
+
+    // The bounds of the samples of each block are found while they are in the cache.
+    Array<RealVector> samps(nd, RealVector(n));
+    RealVector blockMin(nd*nBlocks), blockMax(nd*nBlocks);
+
+    parallel_for(static_cast<size_t>(0), nBlocks, nThreads, [&](size_t block) {
+        auto first = block*shapeDistributionBlockSize;
+        auto m = std::min(shapeDistributionBlockSize, n - first);
+
+        random::MersenneTwister gnd(streamSeed(seed, block));
+        RealVector x(nPoints*m), y(nPoints*m), z(nPoints*m);
+        sampler.samplePoints(nPoints*m, gnd, x.data(), y.data(), z.data());
+
+        for (index_t k=0; k<nd; k++) {
+            auto s = samps[k].data() + first;
+            shapeDistributionSamples(dists[k], x.data(), y.data(), z.data(), m, c, s);
+
+            auto bounds = std::minmax_element(s, s + m);
+            blockMin[k*nBlocks + block] = *bounds.first;
+            blockMax[k*nBlocks + block] = *bounds.second;
+        }
+    });
+
+    // The histograms are limited by all the samples. The angles are binned between 0 and pi.
+    Array<statistics::HistogramAccumulator> accumulators(nd);
+    for (index_t k=0; k<nd; k++) {
+        if (dists[k] == ShapeDistribution::TwoVectorsAngle) {
+            accumulators[k] = statistics::HistogramAccumulator(nBins, 0, PI);
+        }
+        else {
+            auto xMin = *std::min_element(blockMin.data() + k*nBlocks, blockMin.data() + (k + 1)*nBlocks);
+            auto xMax = *std::max_element(blockMax.data() + k*nBlocks, blockMax.data() + (k + 1)*nBlocks);
+            accumulators[k] = statistics::HistogramAccumulator(nBins, xMin, xMax);
+        }
+    }
+
+    // Histogram of each block. They are merged in the order of the blocks.
+    Array<statistics::HistogramAccumulator> partial(nd*nBlocks);
+    parallel_for(static_cast<size_t>(0), nBlocks, nThreads, [&](size_t block) {
+        auto first = block*shapeDistributionBlockSize;
+        auto m = std::min(shapeDistributionBlockSize, n - first);
+
+        for (index_t k=0; k<nd; k++) {
+            auto& h = partial[k*nBlocks + block];
+            h = accumulators[k];
+            h.add(samps[k].data() + first, samps[k].data() + first + m);
+        }
+    });
+
+    Array<std::tuple<RealVector, RealVector>> results(nd);
+    for (index_t k=0; k<nd; k++) {
+        for (index_t block=0; block<nBlocks; block++)
+            accumulators[k].merge(partial[k*nBlocks + block]);
+
+        RealVector histogram = accumulators[k].histogram();
+        histogram /= static_cast<double>(nSamples);
+
+        results[k] = std::make_tuple(std::move(histogram), accumulators[k].bins());
+    }
+
+    return results;
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -704,8 +908,8 @@ double nct::geometry::mesh::compareFeatures(const RealVector& h1,
 }
 
 //-----------------------------------------------------------------------------------------------------------------
-double nct::geometry::mesh::calculateShapeDistributionDistance(const RealVector& h1, 
-    const RealVector& h2, DistanceFunction distFunction, bool useCumulativeDistribution)
+double nct::geometry::mesh::compareFeatures(const RealVector& h1, 
+    const RealVector& h2, DistanceFunction distFunction, double bound)
 {
     if (h1.size() == 0)
         throw EmptyArrayException("h1", SOURCE_INFO);
@@ -717,48 +921,209 @@ double nct::geometry::mesh::calculateShapeDistributionDistance(const RealVector&
         throw ArgumentException("h1, h2", exc_arrays_of_different_lengths, SOURCE_INFO);
 
     auto n = h1.size();
-    RealVector t1(n), t2(n);
+    double r = 0;
 
-    if (useCumulativeDistribution) {
-        statistics::cumulativeData(h1.begin(), h1.end(), t1.begin());
-        statistics::cumulativeData(h2.begin(), h2.end(), t2.begin());
-    }
-    else {
-        t1 = h1;
-        t2 = h2;
+    switch (distFunction) {
+        case DistanceFunction::EuclideanDistance:    
+        {
+            double b2 = bound*bound;
+            for (index_t i = 0; i<n; i++) {
+                r += math::sqr(h1[i] - h2[i]);
+                if (r >= b2)
+                    return math::max(std::sqrt(r), bound);
+            }
+            return std::sqrt(r);
+        }
+        
+        case DistanceFunction::CityBlockDistance:    
+            for (index_t i = 0; i<n; i++) {
+                r += std::abs(h1[i] - h2[i]);
+                if (r >= bound)
+                    return r;
+            }
+            return r;
+
+        default:
+            return compareFeatures(h1, h2, distFunction);
     }
+}
 
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Histogram distance.
+ *  @details    This function calculates the distance between two histograms of the same size.
+ *  @param[in]  t1  Histogram 1.
+ *  @param[in]  t2  Histogram 2.
+ *  @param[in]  distFunction  Distance function to use.
+ *  @returns    The distance between the histograms.
+ */
+static double histogramDistance(const nct::RealVector& t1, const nct::RealVector& t2, 
+    nct::geometry::mesh::DistanceFunction distFunction)
+{
     double d = 0;
     switch (distFunction) {
-        case DistanceFunction::EuclideanDistance:    
-            d = statistics::distance_metrics::euclideanDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
+        case nct::geometry::mesh::DistanceFunction::EuclideanDistance:    
+            d = nct::statistics::distance_metrics::euclideanDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
             break;
         
-        case DistanceFunction::CityBlockDistance:    
-            d = statistics::distance_metrics::cityBlockDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
+        case nct::geometry::mesh::DistanceFunction::CityBlockDistance:    
+            d = nct::statistics::distance_metrics::cityBlockDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
             break;
 
-        case DistanceFunction::ChebychevDistance:    
-            d = statistics::distance_metrics::chebychevDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
+        case nct::geometry::mesh::DistanceFunction::ChebychevDistance:    
+            d = nct::statistics::distance_metrics::chebychevDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
             break;
 
-        case DistanceFunction::MinDistance:    
-            d = statistics::distance_metrics::minDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
+        case nct::geometry::mesh::DistanceFunction::MinDistance:    
+            d = nct::statistics::distance_metrics::minDistance(t1.begin(), t1.end(), t2.begin(), t2.end());
             break;
 
-        case DistanceFunction::BhattacharyyaDistance:
-            d = statistics::distance_metrics::bhattacharrayDistance(t1.begin(), t1.end(), 
+        case nct::geometry::mesh::DistanceFunction::BhattacharyyaDistance:
+            d = nct::statistics::distance_metrics::bhattacharrayDistance(t1.begin(), t1.end(), 
                 t2.begin(), t2.end());
             break;
 
         default:
-            throw ArgumentException("distFunction", exc_bad_distance_function,
+            throw nct::ArgumentException("distFunction", nct::exc_bad_distance_function,
                 SOURCE_INFO);
     }
 
     return d;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+double nct::geometry::mesh::calculateShapeDistributionDistance(const RealVector& h1, 
+    const RealVector& h2, DistanceFunction distFunction, bool useCumulativeDistribution)
+{
+    if (h1.size() == 0)
+        throw EmptyArrayException("h1", SOURCE_INFO);
+    
+    if (h2.size() == 0)
+        throw EmptyArrayException("h2", SOURCE_INFO);
+    
+    if (h1.size() != h2.size())
+        throw ArgumentException("h1, h2", exc_arrays_of_different_lengths, SOURCE_INFO);
+
+    auto n = h1.size();
+    RealVector t1(n), t2(n);
+
+    if (useCumulativeDistribution) {
+        statistics::cumulativeData(h1.begin(), h1.end(), t1.begin());
+        statistics::cumulativeData(h2.begin(), h2.end(), t2.begin());
+    }
+    else {
+        t1 = h1;
+        t2 = h2;
+    }
+
+    return histogramDistance(t1, t2, distFunction);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Resample spline.
+ *  @details    This function evaluates a spline at the points x/scale, sets the negative values to 
+ *              zero and normalizes the result so that it sums one. The points are evaluated in a 
+ *              single pass over the intervals of the spline when they are sorted.
+ *  @param[in]  f  Spline to be evaluated.
+ *  @param[in]  x  Points to evaluate before scaling.
+ *  @param[in]  scale  The scale of the points.
+ *  @param[out] h  The resampled histogram. It must have the same size of x.
+ */
+static void resampleSpline(const nct::interpolation::CubicSpline& f, const nct::RealVector& x, 
+    double scale, nct::RealVector& h)
+{
+    const auto& xData = f.xValues();
+    const auto& yData = f.yValues();
+    const auto& d2 = f.deriv2();
+    auto n = xData.size();
+    auto m = x.size();
+
+    for (nct::index_t j=0; j<m; j++)
+        h[j] = x[j]/scale;
+
+    // The interval search below mirrors CubicSpline::eval, which sorts the points first.
+    bool sorted = true;
+    for (nct::index_t j=1; (j<m) && sorted; j++)
+        sorted = h[j-1] <= h[j];
+
+    if (sorted) {
+        nct::size_t i = 0;
+        for (nct::index_t j=0; j<m; j++) {
+            double xj = h[j];
+            if (!(i == 0 && (xj < xData[0]))) {
+                for (; i<n-1; i++) {
+                    if ((xj >= xData[i]) && (xj < xData[i+1]))
+                         break;
+                }    
+                if (i == n-1)
+                    i--;
+            }
+
+            double temp = (xData[i+1] - xData[i]);
+            double a = (xData[i+1] - xj) / temp;
+            double b = 1-a;
+            temp*=temp/6;        
+            double c = (a*a-1)*a*temp;
+            double d = (b*b-1)*b*temp;
+            h[j] = a*yData[i] + b*yData[i+1] + c*d2[i] + d*d2[i+1];
+        }
+    }
+    else {
+        h = f.eval(h);
+    }
+
+    std::transform(h.begin(), h.end(), h.begin(), nct::math::positivePart<double>);
+    double sum = h.sum();
+    if (sum > 0)
+        h /= sum;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Scaled shape distribution distance.
+ *  @details    This function calculates the distance between two shape distributions when the 
+ *              second one is scaled.
+ *  @param[in]  sd1  Spline of shape distribution 1.
+ *  @param[in]  sd2  Spline of shape distribution 2.
+ *  @param[in]  scale  Scale of shape distribution 2.
+ *  @param[in]  distFunction  Distance function to use.
+ *  @param[in]  useCumulativeDistribution  True to use the cumulative distribution.
+ *  @param[out] xts  Array where the sample points are stored. Its size is the number of points.
+ *  @param[out] ht1  Array where distribution 1 is resampled. It must have the size of xts.
+ *  @param[out] ht2  Array where distribution 2 is resampled. It must have the size of xts.
+ *  @param[out] ct1  Array where cumulative distribution 1 is stored, if it is used.
+ *  @param[out] ct2  Array where cumulative distribution 2 is stored, if it is used.
+ *  @returns    The distance between the shape distributions.
+ */
+static double scaledShapeDistributionDistance(const nct::geometry::mesh::ShapeDistributionSpline& sd1,
+    const nct::geometry::mesh::ShapeDistributionSpline& sd2, double scale, 
+    nct::geometry::mesh::DistanceFunction distFunction, bool useCumulativeDistribution, 
+    nct::RealVector& xts, nct::RealVector& ht1, nct::RealVector& ht2, nct::RealVector& ct1, 
+    nct::RealVector& ct2)
+{
+    auto nPoints = xts.size();
+    double s1 = sd1.scale;
+    double s2 = scale;
+
+    double xmin = nct::math::min(s1*sd1.minBin, s2*sd2.minBin);
+    double xmax = nct::math::max(s1*sd1.maxBin, s2*sd2.maxBin);
+
+    for (nct::index_t i=0; i<nPoints; i++)
+        xts[i] = xmin + i * (xmax - xmin)/(nPoints - 1.0);
+
+    resampleSpline(sd1.spline, xts, s1, ht1);
+    resampleSpline(sd2.spline, xts, s2, ht2);
+
+    if (useCumulativeDistribution) {
+        nct::statistics::cumulativeData(ht1.begin(), ht1.end(), ct1.begin());
+        nct::statistics::cumulativeData(ht2.begin(), ht2.end(), ct2.begin());
+        return histogramDistance(ct1, ct2, distFunction);
+    }
+
+    return histogramDistance(ht1, ht2, distFunction);
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 double nct::geometry::mesh::calculateShapeDistributionDistance(const RealVector& h1,
     const RealVector& b1, const RealVector& h2,
@@ -784,6 +1149,46 @@ double nct::geometry::mesh::calculateShapeDistributionDistance(const RealVector&
     if (h2.size() != b2.size())
         throw ArgumentException("h2, b2", exc_arrays_of_different_lengths, SOURCE_INFO);
 
+    return calculateShapeDistributionDistance(shapeDistributionSpline(h1, b1), 
+        shapeDistributionSpline(h2, b2), distFunction, useCumulativeDistribution, 
+        nPoints, nScales, minDbScale, maxDbScale);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::geometry::mesh::ShapeDistributionSpline nct::geometry::mesh::shapeDistributionSpline(
+    const RealVector& h, const RealVector& b)
+{
+    if (h.size() == 0)
+        throw EmptyArrayException("h", SOURCE_INFO);
+
+    if (b.size() == 0)
+        throw EmptyArrayException("b", SOURCE_INFO);
+
+    if (h.size() != b.size())
+        throw ArgumentException("h, b", exc_arrays_of_different_lengths, SOURCE_INFO);
+
+    ShapeDistributionSpline sd;
+    sd.spline = interpolation::CubicSpline(b, h);
+
+    double m = dotProduct(b, h);
+    if (m!=0)
+        sd.scale = 1.0/m;
+
+    sd.minBin = b.min();
+    sd.maxBin = b.max();
+
+    return sd;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double nct::geometry::mesh::calculateShapeDistributionDistance(const ShapeDistributionSpline& sd1, 
+    const ShapeDistributionSpline& sd2, DistanceFunction distFunction, 
+    bool useCumulativeDistribution, unsigned int nPoints, unsigned int nScales, 
+    double minDbScale, double maxDbScale)
+{
+    if ((sd1.spline.deriv2().size() == 0) || (sd2.spline.deriv2().size() == 0))
+        throw ConfigurationException(exc_bad_interpolation_model, SOURCE_INFO);
+
     if (nPoints == 0)
         throw ArgumentException("nPoints", nPoints, 0U, RelationalOperator::GreaterThan, 
         SOURCE_INFO);
@@ -795,74 +1200,133 @@ double nct::geometry::mesh::calculateShapeDistributionDistance(const RealVector&
     if (minDbScale > maxDbScale)
         throw ArgumentException("minDbScale, maxDbScale", exc_bad_bounds, SOURCE_INFO);
 
-
     RealVector scales(nScales);
     for (unsigned int i=0; i<nScales; i++)
         scales[i] = exp(minDbScale + i * (maxDbScale - minDbScale)/(nScales - 1.0));
 
-    interpolation::CubicSpline f1(b1, h1);
-    interpolation::CubicSpline f2(b2, h2);
-    double m1 = dotProduct(b1, h1);
-    double m2 = dotProduct(b2, h2);
-    
-    double s1 = 1;
-    if (m1!=0)
-        s1 = 1.0/m1;
-    
-    double s2 = 1;
-    if (m2!=0)
-        s2 = 1.0/m2;
-
-    double xmin = math::min(s1*b1.min(), s2*b2.min());
-    double xmax = math::max(s1*b1.max(), s2*b2.max());
-    
+    // The first distribution keeps its normalization scale, while both distributions are 
+    // resampled at each tested scale.
     RealVector xts(nPoints);
-    for (unsigned int i=0; i<nPoints; i++)
-        xts[i] = xmin + i * (xmax - xmin)/(nPoints - 1.0);
+    RealVector ht1(nPoints);
+    RealVector ht2(nPoints);
+    RealVector ct1(useCumulativeDistribution ? nPoints : 0);
+    RealVector ct2(useCumulativeDistribution ? nPoints : 0);
 
-    auto tmp = f1.eval(xts/s1);
+    RealVector d(nScales);
+    for (unsigned int s = 0; s<nScales; s++)
+        d[s] = scaledShapeDistributionDistance(sd1, sd2, scales[s], distFunction, 
+            useCumulativeDistribution, xts, ht1, ht2, ct1, ct2);
 
-    RealVector ht1(tmp.size());
-    std::transform(tmp.begin(), tmp.end(), ht1.begin(), math::positivePart<double>);
-    double sum1 = ht1.sum();
-    if (sum1 > 0)
-        ht1 /= sum1;
-    
-    tmp = f2.eval(xts/s2);
-    RealVector ht2(tmp.size());
-    std::transform(tmp.begin(), tmp.end(), ht2.begin(), math::positivePart<double>);
-    double sum2 = ht2.sum();
-    if (sum2 > 0)
-        ht2 /= sum2;
+    return d.min();
+}
 
-    RealVector d(nScales);
-    for (unsigned int s = 0; s<nScales; s++) {
-        s2 = scales[s];
+//-----------------------------------------------------------------------------------------------------------------
+double nct::geometry::mesh::searchShapeDistributionDistance(const ShapeDistributionSpline& sd1, 
+    const ShapeDistributionSpline& sd2, DistanceFunction distFunction, 
+    bool useCumulativeDistribution, unsigned int nPoints, unsigned int nScales, 
+    unsigned int coarseStep, double tolerance, double minDbScale, double maxDbScale)
+{
+    if ((sd1.spline.deriv2().size() == 0) || (sd2.spline.deriv2().size() == 0))
+        throw ConfigurationException(exc_bad_interpolation_model, SOURCE_INFO);
 
-        xmin = math::min(s1*b1.min(), s2*b2.min());
-        xmax = math::max(s1*b1.max(), s2*b2.max());
-    
-        for (unsigned int i=0; i<nPoints; i++)
-            xts[i] = xmin + i * (xmax - xmin)/(nPoints - 1.0);
-
-        tmp = f1.eval(xts/s1);
-        ht1.assign(tmp.size(), 0.0);
-        std::transform(tmp.begin(), tmp.end(), ht1.begin(), math::positivePart<double>);
-        sum1 = ht1.sum();
-        if (sum1 > 0)
-            ht1 /= sum1;
-    
-        tmp = f2.eval(xts/s2);
-        ht2.assign(tmp.size(), 0.0);
-        std::transform(tmp.begin(), tmp.end(), ht2.begin(), math::positivePart<double>);
-        sum2 = ht2.sum();
-        if (sum2 > 0)
-            ht2 /= sum2;        
-        
-        d[s] = calculateShapeDistributionDistance(ht1, ht2, distFunction, useCumulativeDistribution);        
+    if (nPoints == 0)
+        throw ArgumentException("nPoints", nPoints, 0U, RelationalOperator::GreaterThan, 
+        SOURCE_INFO);
+
+    if (nScales < 2)
+        throw ArgumentException("nScales", nScales, 2U, 
+        RelationalOperator::GreaterThanOrEqualTo, SOURCE_INFO);
+
+    if (coarseStep == 0)
+        throw ArgumentException("coarseStep", coarseStep, 0U, RelationalOperator::GreaterThan, 
+        SOURCE_INFO);
+
+    if (tolerance <= 0)
+        throw ArgumentException("tolerance", tolerance, 0.0, RelationalOperator::GreaterThan, 
+        SOURCE_INFO);
+
+    if (minDbScale > maxDbScale)
+        throw ArgumentException("minDbScale, maxDbScale", exc_bad_bounds, SOURCE_INFO);
+
+    RealVector xts(nPoints);
+    RealVector ht1(nPoints);
+    RealVector ht2(nPoints);
+    RealVector ct1(useCumulativeDistribution ? nPoints : 0);
+    RealVector ct2(useCumulativeDistribution ? nPoints : 0);
+
+    // The scales are those of the exhaustive scan, so that the result is one of its distances.
+    // Each scale is evaluated once at most. The evaluated scales are flagged apart from their 
+    // distances, since some distance functions can be negative.
+    double dbStep = (maxDbScale - minDbScale)/(nScales - 1.0);
+    std::vector<double> d(nScales);
+    std::vector<char> evaluated(nScales, 0);
+    unsigned int best = 0;
+
+    auto distance = [&](unsigned int i) {
+        if (!evaluated[i]) {
+            d[i] = scaledShapeDistributionDistance(sd1, sd2, 
+                exp(minDbScale + i * (maxDbScale - minDbScale)/(nScales - 1.0)), distFunction, 
+                useCumulativeDistribution, xts, ht1, ht2, ct1, ct2);
+            if (!evaluated[best] || (d[i] < d[best]))
+                best = i;
+            evaluated[i] = 1;
+        }
+        return d[i];
+    };
+
+    // Scale that matches the means of the distributions, which is usually close to the minimum.
+    // The grid is dense around it and sparse elsewhere, since the minima far from it are the
+    // wide basins of distributions whose means differ.
+    auto n = static_cast<int>(nScales);
+    auto step = static_cast<int>(coarseStep);
+    auto denseStep = std::max(1, step/2);
+    double prior = (log(sd2.scale) - minDbScale)/dbStep;
+    auto p = static_cast<int>(std::lround(std::min(std::max(prior, 0.0), n - 1.0)));
+
+    for (int i = std::max(0, p - 1); i <= std::min(n - 1, p + 1); i++)
+        distance(static_cast<unsigned int>(i));
+    for (int i = p - denseStep; (i >= 0) && (p - i <= step); i -= denseStep)
+        distance(static_cast<unsigned int>(i));
+    for (int i = p + denseStep; (i < n) && (i - p <= step); i += denseStep)
+        distance(static_cast<unsigned int>(i));
+    for (int i = p - 3*step; i >= 0; i -= 2*step)
+        distance(static_cast<unsigned int>(i));
+    for (int i = p + 3*step; i < n; i += 2*step)
+        distance(static_cast<unsigned int>(i));
+    distance(0);
+    distance(nScales - 1);
+
+    // The best scale descends with steps that are halved down to the tolerance, and then walks
+    // while a neighbor is better.
+    auto minStep = std::max(1, static_cast<int>(tolerance/dbStep));
+    auto at = [&](int i) {
+        return ((i < 0) || (i >= n)) ? std::numeric_limits<double>::infinity() : 
+            distance(static_cast<unsigned int>(i));
+    };
+
+    auto c = static_cast<int>(best);
+    auto h = (std::abs(c - p) <= step ? denseStep : 2*step)/2;
+    for (; h >= minStep; h /= 2) {
+        double l = at(c - h);
+        double r = at(c + h);
+        if ((l < d[c]) && (l <= r))
+            c -= h;
+        else if (r < d[c])
+            c += h;
     }
 
-    return d.min();
+    for (;;) {
+        double l = at(c - minStep);
+        double r = at(c + minStep);
+        if ((l < d[c]) && (l <= r))
+            c -= minStep;
+        else if (r < d[c])
+            c += minStep;
+        else
+            break;
+    }
+
+    return d[best];
 }
 
 //-----------------------------------------------------------------------------------------------------------------
@@ -913,6 +1377,66 @@ nct::Array<nct::Array<nct::size_t>> nct::geometry::mesh::findRotationIndices(
     return indices;
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+nct::Array2D<unsigned int> nct::geometry::mesh::findRotationSources(const Array<Array<size_t>>& rotIndices)
+{
+    // Verify arguments.
+    auto nRot = rotIndices.size();
+
+    if (nRot<1)
+        throw EmptyArrayException("rotIndices", SOURCE_INFO);
+
+    auto nDir = rotIndices[0].size();
+
+    if (nDir<1)
+        throw EmptyArrayException("rotIndices", SOURCE_INFO);
+
+    if (nDir >= std::numeric_limits<unsigned int>::max())
+        throw ArgumentException("rotIndices", exc_value_too_large, SOURCE_INFO);
+
+    // Each rotation starts with the sources of the previous one, so the directions that do not 
+    // receive any element keep them. The sources of the first rotation point to the zeros.
+    Array2D<unsigned int> sources(nRot, nDir, static_cast<unsigned int>(nDir));
+
+    for (index_t i=0; i<nRot; i++) {
+        if (rotIndices[i].size() != nDir)
+            throw ArgumentException("rotIndices", exc_bad_array_dimensions, SOURCE_INFO);
+
+        if (i>0)
+            std::copy(&sources(i - 1, 0), &sources(i - 1, 0) + nDir, &sources(i, 0));
+
+        for (index_t j=0; j<nDir; j++) {
+            if (rotIndices[i][j] >= nDir)
+                throw IndexOutOfRangeException("rotIndices", SOURCE_INFO);
+            sources(i, rotIndices[i][j]) = static_cast<unsigned int>(j);
+        }
+    }
+
+    return sources;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::Matrix nct::geometry::mesh::symmetryDescriptorColumns(const Matrix& rsd)
+{
+    // Verify arguments.
+    auto nDir = rsd.rows();
+
+    if (nDir<1)
+        throw EmptyArrayException("rsd", SOURCE_INFO);
+
+    if (rsd.columns() != 2)
+        throw ArgumentException("rsd", exc_bad_array_dimensions, SOURCE_INFO);
+
+    // The last column stays at zero.
+    Matrix columns(2, nDir + 1, 0);
+    for (index_t j=0; j<nDir; j++) {
+        columns(0, j) = rsd(j, 0);
+        columns(1, j) = rsd(j, 1);
+    }
+
+    return columns;
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 double nct::geometry::mesh::compareSymmetryDescriptors(const Matrix& rsd1,
     const Matrix& rsd2, const Array<Vector3D<double>>& dirVectors,
@@ -1007,7 +1531,7 @@ double nct::geometry::mesh::compareSymmetryDescriptors(const Matrix& rsd1,
 
 //-----------------------------------------------------------------------------------------------------------------
 double nct::geometry::mesh::compareSymmetryDescriptors(const Matrix& rsd1,
-    const Matrix& rsd2, Array<Array<size_t>>& rotIndices,
+    const Matrix& rsd2, const Array<Array<size_t>>& rotIndices,
     DistanceFunction distFunction)
 {
     // Verify arguments.
@@ -1075,6 +1599,218 @@ double nct::geometry::mesh::compareSymmetryDescriptors(const Matrix& rsd1,
     
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+double nct::geometry::mesh::compareSymmetryDescriptors(const Matrix& rsd1,
+    const Matrix& rsd2, const Array<Array<size_t>>& rotIndices,
+    DistanceFunction distFunction, double bound)
+{
+    if ((distFunction != DistanceFunction::EuclideanDistance) && 
+        (distFunction != DistanceFunction::CityBlockDistance))
+        return compareSymmetryDescriptors(rsd1, rsd2, rotIndices, distFunction);
+
+    // Verify arguments.
+    auto nDir = rsd1.rows();
+    auto nRot = rotIndices.size();
+
+    if (nRot<1)
+        throw EmptyArrayException("rotIndices", SOURCE_INFO);
+
+    if (nDir<1)
+        throw EmptyArrayException("dirVectors", SOURCE_INFO);
+
+    if ( (rsd1.columns() != 2))
+        throw ArgumentException("rsd1", exc_bad_array_dimensions, SOURCE_INFO);
+
+    if ( (rsd2.rows() != nDir) || (rsd2.columns() != 2))
+        throw ArgumentException("rsd2", exc_bad_array_dimensions, SOURCE_INFO);
+    
+    for (unsigned int i=0; i<nRot; i++) {
+        if ( (rotIndices[i].size() != nDir))
+            throw ArgumentException("rotIndices", exc_bad_array_dimensions, SOURCE_INFO);
+    }
+
+    // For each rotation. The partial sums are compared with the square of the threshold 
+    // when the Euclidean distance is used.
+    bool euclidean = distFunction == DistanceFunction::EuclideanDistance;
+    auto n = rsd1.size();
+    double best = std::numeric_limits<double>::infinity();
+    double lowerBound = std::numeric_limits<double>::infinity();
+    Matrix rotrsd(nDir, 2);
+
+    for (unsigned int i=0; i<nRot; i++) {                
+        // Fill temp array with the rotated descriptor.
+        for (index_t j = 0; j<nDir; j++) {
+            rotrsd(rotIndices[i][j], 0) = rsd2(j, 0);
+            rotrsd(rotIndices[i][j], 1) = rsd2(j, 1);
+        }
+                
+        // Calculate distance until it reaches the threshold.
+        double threshold = math::min(bound, best);
+        double t = euclidean ? threshold*threshold : threshold;
+        double r = 0;
+        bool abandoned = false;
+
+        for (index_t k = 0; k<n; k++) {
+            r += euclidean ? math::sqr(rsd1[k] - rotrsd[k]) : std::abs(rsd1[k] - rotrsd[k]);
+            if (r >= t) {
+                abandoned = true;
+                break;
+            }
+        }
+
+        double d = euclidean ? std::sqrt(r) : r;
+        if (abandoned)
+            lowerBound = math::min(lowerBound, math::max(d, threshold));
+        else
+            best = d;
+    }
+    
+    return best < bound ? best : math::max(lowerBound, bound);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Rotated symmetry descriptor distance.
+ *  @details    This function accumulates the distance between the columns of a symmetry descriptor
+ *              and the columns of a second descriptor that are read through the sources of one 
+ *              rotation. The directions are processed in blocks. Inside a block, each lane 
+ *              accumulates its own partial result, so the iterations are independent and can be 
+ *              vectorized; the partial results are combined after each block to check the threshold.
+ *  @tparam     distFunction  Distance function. It must be the Euclidean (without the square root),
+ *              city-block, Chebychev or minimum distance.
+ *  @param[in]  x1  First column of descriptor 1.
+ *  @param[in]  y1  Second column of descriptor 1.
+ *  @param[in]  x2  First column of descriptor 2.
+ *  @param[in]  y2  Second column of descriptor 2.
+ *  @param[in]  sources  Sources of the rotation.
+ *  @param[in]  nDir  Number of directions.
+ *  @param[in]  threshold  The accumulation stops as soon as the result reaches this value.
+ *  @returns    The accumulated result. It is less than the threshold only if every direction was
+ *              accumulated.
+ */
+template<nct::geometry::mesh::DistanceFunction distFunction>
+static double rotatedSymmetryDescriptorDistance(const double* x1, const double* y1, 
+    const double* x2, const double* y2, const unsigned int* sources, nct::size_t nDir, double threshold)
+{
+    using nct::geometry::mesh::DistanceFunction;
+
+    constexpr nct::size_t nLanes = 4;
+    constexpr nct::size_t blockSize = 32;
+    constexpr bool minimum = distFunction == DistanceFunction::MinDistance;
+    constexpr double initial = minimum ? std::numeric_limits<double>::infinity() : 0;
+
+    auto term = [](double a, double b) {
+        if constexpr (distFunction == DistanceFunction::EuclideanDistance)
+            return nct::math::sqr(a - b);
+        else
+            return std::abs(a - b);
+    };
+
+    auto combine = [](double r, double v) {
+        if constexpr (minimum)
+            return std::min(r, v);
+        else if constexpr (distFunction == DistanceFunction::ChebychevDistance)
+            return std::max(r, v);
+        else
+            return r + v;
+    };
+
+    double acc[nLanes] {initial, initial, initial, initial};
+    double r = initial;
+
+    for (nct::size_t j = 0; j<nDir; ) {
+        auto last = std::min(j + blockSize, nDir);
+
+        for (; j + nLanes <= last; j += nLanes) {
+            for (nct::size_t l = 0; l<nLanes; l++) {
+                auto s = sources[j + l];
+                acc[l] = combine(acc[l], combine(term(x1[j + l], x2[s]), term(y1[j + l], y2[s])));
+            }
+        }
+
+        for (; j<last; j++) {
+            auto s = sources[j];
+            acc[0] = combine(acc[0], combine(term(x1[j], x2[s]), term(y1[j], y2[s])));
+        }
+
+        r = combine(combine(acc[0], acc[1]), combine(acc[2], acc[3]));
+        if (r >= threshold)
+            break;
+    }
+
+    return r;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double nct::geometry::mesh::compareSymmetryDescriptorColumns(const Matrix& rsd1,
+    const Matrix& rsd2, const Array2D<unsigned int>& rotSources,
+    DistanceFunction distFunction, double bound)
+{
+    // Verify arguments.
+    auto nRot = rotSources.rows();
+    auto nDir = rotSources.columns();
+
+    if ((nRot<1) || (nDir<1))
+        throw EmptyArrayException("rotSources", SOURCE_INFO);
+
+    if ((rsd1.rows() != 2) || (rsd1.columns() != nDir + 1))
+        throw ArgumentException("rsd1", exc_bad_array_dimensions, SOURCE_INFO);
+
+    if ((rsd2.rows() != 2) || (rsd2.columns() != nDir + 1))
+        throw ArgumentException("rsd2", exc_bad_array_dimensions, SOURCE_INFO);
+
+    // Distance of one rotation.
+    double (*distance)(const double*, const double*, const double*, const double*, 
+        const unsigned int*, size_t, double) = nullptr;
+
+    switch (distFunction) {
+        case DistanceFunction::EuclideanDistance:
+            distance = rotatedSymmetryDescriptorDistance<DistanceFunction::EuclideanDistance>;
+            break;
+
+        case DistanceFunction::CityBlockDistance:
+            distance = rotatedSymmetryDescriptorDistance<DistanceFunction::CityBlockDistance>;
+            break;
+
+        case DistanceFunction::ChebychevDistance:
+            distance = rotatedSymmetryDescriptorDistance<DistanceFunction::ChebychevDistance>;
+            break;
+
+        case DistanceFunction::MinDistance:
+            distance = rotatedSymmetryDescriptorDistance<DistanceFunction::MinDistance>;
+            break;
+
+        default:
+            throw ArgumentException("distFunction", exc_bad_distance_function, SOURCE_INFO);
+    }
+
+    // For each rotation. The minimum distance cannot be abandoned because it decreases as the
+    // directions are accumulated. The partial sums are compared with the square of the threshold
+    // when the Euclidean distance is used.
+    bool euclidean = distFunction == DistanceFunction::EuclideanDistance;
+    bool abandon = distFunction != DistanceFunction::MinDistance;
+    auto x1 = rsd1.data();
+    auto y1 = rsd1.data() + nDir + 1;
+    auto x2 = rsd2.data();
+    auto y2 = rsd2.data() + nDir + 1;
+    double best = std::numeric_limits<double>::infinity();
+    double lowerBound = std::numeric_limits<double>::infinity();
+
+    for (index_t i=0; i<nRot; i++) {
+        double threshold = abandon ? math::min(bound, best) : std::numeric_limits<double>::infinity();
+        double t = euclidean ? threshold*threshold : threshold;
+        double r = distance(x1, y1, x2, y2, rotSources.data() + i*nDir, nDir, t);
+        double d = euclidean ? std::sqrt(r) : r;
+
+        if (r >= t)
+            lowerBound = math::min(lowerBound, math::max(d, threshold));
+        else
+            best = math::min(best, d);
+    }
+    
+    return (best < bound) || !abandon ? best : math::max(lowerBound, bound);
+}
+
 //-----------------------------------------------------------------------------------------------------------------
 nct::Array<nct::geometry::Triangle3D> nct::geometry::mesh::triangleCoord(
     const Array<Point3D>& vertices, 
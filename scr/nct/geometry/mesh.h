@@ -33,7 +33,9 @@
 #include <nct/Vector3D.h>
 #include <nct/SparseArray3D.h>
 #include <nct/random/RandomNumber.h>
+#include <nct/interpolation/CubicSpline.h>
 #include <nct/geometry/Triangle3D.h>
+#include <nct/geometry/SurfaceSampler.h>
 
 //=================================================================================================================
 namespace nct {
@@ -80,6 +82,24 @@ enum class DistanceFunction : unsigned char {
     BhattacharyyaDistance,  /**< Bhattacharyya difference between distributions. */
 };
 
+////////// Structures //////////
+
+/**
+ *  @brief      Shape distribution spline.
+ *  @details    This structure contains the cubic spline of a shape distribution and the constants
+ *              that are needed to resample it at different scales.
+ */
+struct ShapeDistributionSpline final {
+
+    interpolation::CubicSpline spline;  /**< Spline that interpolates the histogram. */
+
+    double scale {1};                   /**< Inverse of the mean of the distribution. */
+
+    double minBin {0};                  /**< Center of the first bin. */
+
+    double maxBin {0};                  /**< Center of the last bin. */
+};
+
 ////////// Auxiliar functions //////////
 
 /**
@@ -199,7 +219,8 @@ NCT_EXPIMP RealVector calculateAreas(
 
 /**
  *  @brief      Calculate random points.
- *  @details    This function calculates random points of the specified mesh.
+ *  @details    This function calculates random points of the specified mesh. Use a SurfaceSampler
+ *              to draw several sets of points of the same mesh.
  *  @param[in]  vertices  Array with the vertices of the triangular mesh.
  *  @param[in]  triangles  Array that defines the triangles of the mesh.
  *  @param[in]  nSamples  Number of random points to calcualte.
@@ -245,6 +266,17 @@ NCT_EXPIMP Point3D calculateCentroid(const Array<Point3D>& vertices,
     const Array<Vector3D<unsigned int>>& triangles, unsigned int nSamples,
     random::RandomNumber& rnd);
 
+/**
+ *  @brief      Calculate the centroid of a mesh.
+ *  @details    This function calculates the centroid of a mesh by averaging random points.
+ *  @param[in]  sampler  The sampler of the surface of the mesh.
+ *  @param[in]  nSamples  Number of random points to use in the centroid calculation. 
+ *  @param[in, out] rnd  Pseudo-random number generator.
+ *  @returns    The centroid of the figure.
+ */
+NCT_EXPIMP Point3D calculateCentroid(const SurfaceSampler& sampler, unsigned int nSamples,
+    random::RandomNumber& rnd);
+
 /**
  *  @brief      Calculate a shape distribution.
  *  @details    This function calculates a shape distribution of the triangular mesh specified in
@@ -263,6 +295,110 @@ NCT_EXPIMP std::tuple<RealVector, RealVector> calculateShapeDistribution(
     random::RandomNumber& rnd, ShapeDistribution dist, unsigned int nSamples = 65535,
     unsigned int nBins = 256);
 
+/**
+ *  @brief      Calculate a shape distribution.
+ *  @details    This function calculates a shape distribution of a mesh with a sampler of its 
+ *              surface, so the areas and the centroid of the mesh are not calculated again for 
+ *              each distribution. The result is the same as the one of the function that receives
+ *              the vertices and triangles of the mesh.
+ *  @param[in]  sampler  The sampler of the surface of the mesh.
+ *  @param[in, out] rnd  Pseudo-random number generator.
+ *  @param[in]  dist  Type of distribution to be calculated.
+ *  @param[in]  nSamples  Number of samples to use in the calculation of the shape distribution.
+ *  @param[in]  nBins  Number of bins of the histogram that represents the shape distribution.
+ *  @returns    A tuple with the following elements: \n * The values of the histogram for each bin. * The
+ *              histogram bins.
+ */
+NCT_EXPIMP std::tuple<RealVector, RealVector> calculateShapeDistribution(
+    const SurfaceSampler& sampler, random::RandomNumber& rnd, ShapeDistribution dist, 
+    unsigned int nSamples = 65535, unsigned int nBins = 256);
+
+/**
+ *  @brief      Calculate several shape distributions.
+ *  @details    This function calculates several shape distributions of the triangular mesh 
+ *              specified in the input arguments with one pool of random points.
+ *  @param[in]  vertices  Array with the vertices of the triangular mesh.
+ *  @param[in]  triangles  Array that defines the triangles of the mesh.
+ *  @param[in, out] rnd  Pseudo-random number generator.
+ *  @param[in]  dists  The distributions to be calculated.
+ *  @param[in]  nSamples  Number of samples to use in the calculation of each shape distribution.
+ *  @param[in]  nBins  Number of bins of the histograms that represent the shape distributions.
+ *  @returns    An array with a tuple for each distribution in dists, with the values of the 
+ *              histogram and the histogram bins.
+ */
+NCT_EXPIMP Array<std::tuple<RealVector, RealVector>> calculateShapeDistributions(
+    const Array<Point3D>& vertices, const Array<Vector3D<unsigned int>>& triangles, 
+    random::RandomNumber& rnd, const Array<ShapeDistribution>& dists, unsigned int nSamples = 65535,
+    unsigned int nBins = 256);
+
+/**
+ *  @brief      Calculate several shape distributions.
+ *  @details    This function calculates several shape distributions of a mesh with one pool of 
+ *              random points. The pool has nSamples tuples of as many points as the largest 
+ *              distribution needs (four when the FourPointVolume is included), and every 
+ *              distribution takes the leading points of each tuple: the centroid distance uses 
+ *              the first point, the two point distance the first two, and the three point area
+ *              and the angle between two vectors the first three. The samples of each histogram
+ *              remain independent, so each histogram follows the same distribution as the one
+ *              that is calculated alone, but the histograms of the same call are correlated. When 
+ *              only one distribution is requested, the result is the same as the one of 
+ *              calculateShapeDistribution.
+ *  @param[in]  sampler  The sampler of the surface of the mesh.
+ *  @param[in, out] rnd  Pseudo-random number generator.
+ *  @param[in]  dists  The distributions to be calculated.
+ *  @param[in]  nSamples  Number of samples to use in the calculation of each shape distribution.
+ *  @param[in]  nBins  Number of bins of the histograms that represent the shape distributions.
+ *  @returns    An array with a tuple for each distribution in dists, with the values of the 
+ *              histogram and the histogram bins.
+ */
+NCT_EXPIMP Array<std::tuple<RealVector, RealVector>> calculateShapeDistributions(
+    const SurfaceSampler& sampler, random::RandomNumber& rnd, const Array<ShapeDistribution>& dists,
+    unsigned int nSamples = 65535, unsigned int nBins = 256);
+
+/**
+ *  @brief      Calculate several shape distributions in parallel.
+ *  @details    This function calculates several shape distributions of the triangular mesh 
+ *              specified in the input arguments with one pool of random points, using several 
+ *              threads.
+ *  @param[in]  vertices  Array with the vertices of the triangular mesh.
+ *  @param[in]  triangles  Array that defines the triangles of the mesh.
+ *  @param[in]  seed  The seed of the random numbers.
+ *  @param[in]  dists  The distributions to be calculated.
+ *  @param[in]  nSamples  Number of samples to use in the calculation of each shape distribution.
+ *  @param[in]  nBins  Number of bins of the histograms that represent the shape distributions.
+ *  @param[in]  nThreads  The number of threads. If it is zero, the number of hardware threads is used.
+ *  @returns    An array with a tuple for each distribution in dists, with the values of the 
+ *              histogram and the histogram bins.
+ */
+NCT_EXPIMP Array<std::tuple<RealVector, RealVector>> calculateShapeDistributions(
+    const Array<Point3D>& vertices, const Array<Vector3D<unsigned int>>& triangles, 
+    unsigned long long seed, const Array<ShapeDistribution>& dists, unsigned int nSamples = 65535,
+    unsigned int nBins = 256, unsigned int nThreads = 0);
+
+/**
+ *  @brief      Calculate several shape distributions in parallel.
+ *  @details    This function calculates several shape distributions of a mesh with one pool of 
+ *              random points, like the function that receives a generator, using several threads.
+ *              The tuples of the pool are split in blocks of 8192 tuples, and each block is 
+ *              sampled with its own Mersenne twister, whose seed is derived from the seed of the 
+ *              calculation and the index of the block. The threads take the blocks as they finish 
+ *              the previous ones, calculate a histogram of each block and the histograms are added
+ *              in the order of the blocks with the bounds of all the samples. Thus, the result only 
+ *              depends on the seed and it is the same for any number of threads, but it is not the
+ *              same as the one of the function that receives a generator.
+ *  @param[in]  sampler  The sampler of the surface of the mesh.
+ *  @param[in]  seed  The seed of the random numbers.
+ *  @param[in]  dists  The distributions to be calculated.
+ *  @param[in]  nSamples  Number of samples to use in the calculation of each shape distribution.
+ *  @param[in]  nBins  Number of bins of the histograms that represent the shape distributions.
+ *  @param[in]  nThreads  The number of threads. If it is zero, the number of hardware threads is used.
+ *  @returns    An array with a tuple for each distribution in dists, with the values of the 
+ *              histogram and the histogram bins.
+ */
+NCT_EXPIMP Array<std::tuple<RealVector, RealVector>> calculateShapeDistributions(
+    const SurfaceSampler& sampler, unsigned long long seed, const Array<ShapeDistribution>& dists,
+    unsigned int nSamples = 65535, unsigned int nBins = 256, unsigned int nThreads = 0);
+
 /**
  *  @brief      Calculate the distance between two features.
  *  @details    This function calculates the distance between two feautres.
@@ -274,6 +410,22 @@ NCT_EXPIMP std::tuple<RealVector, RealVector> calculateShapeDistribution(
 NCT_EXPIMP double compareFeatures(const RealVector& h1,
     const RealVector& h2, DistanceFunction distFunction);
 
+/**
+ *  @brief      Calculate the distance between two features.
+ *  @details    This function calculates the distance between two feautres, but stops the
+ *              calculation as soon as the distance reaches an upper bound. The early termination 
+ *              is applied to the Euclidean and city-block distances; the other distances are 
+ *              always calculated completely.
+ *  @param[in]  h1  Feature 1.
+ *  @param[in]  h2  Feature 2.
+ *  @param[in]  distFunction  Distance function to use.
+ *  @param[in]  bound  Upper bound of the distances of interest.
+ *  @returns    The distance between the features if it is less than the bound. Otherwise, a 
+ *              lower bound of the distance that is greater than or equal to the bound.
+ */
+NCT_EXPIMP double compareFeatures(const RealVector& h1,
+    const RealVector& h2, DistanceFunction distFunction, double bound);
+
 /**
  *  @brief      Calculate the distance between shape distributions.
  *  @details    This function calculates the distance between two shape distributions.
@@ -309,6 +461,66 @@ NCT_EXPIMP double calculateShapeDistributionDistance(const RealVector& h1,
     bool useCumulativeDistribution, unsigned int nPoints = 256,
     unsigned int nScales = 256, double minDbScale = -10.0, double maxDbScale = 10.0);
 
+/**
+ *  @brief      Shape distribution spline.
+ *  @details    This function builds the spline of a shape distribution. The spline can be reused 
+ *              to compare the distribution with several other distributions.
+ *  @param[in]  h  Normalized histogram of the shape distribution.
+ *  @param[in]  b  Centers of the bins of the shape distribution.
+ *  @returns    The spline of the shape distribution.
+ */
+NCT_EXPIMP ShapeDistributionSpline shapeDistributionSpline(const RealVector& h, const RealVector& b);
+
+/**
+ *  @brief      Calculate the distance between shape distributions.
+ *  @details    This function calculates the distance between two shape distributions whose splines
+ *              were previously built. The second distribution is scaled in order to find the 
+ *              optimal distance. The result is the same as the result of the function that receives 
+ *              the histograms.
+ *  @param[in]  sd1  Spline of shape distribution 1.
+ *  @param[in]  sd2  Spline of shape distribution 2.
+ *  @param[in]  distFunction  Distance function to use.
+ *  @param[in]  useCumulativeDistribution  True to use the cumulative distribution.
+ *  @param[in]  nPoints  Number of points to use in the evaluation of each distribution.
+ *  @param[in]  nScales  Number of scales to test.
+ *  @param[in]  minDbScale  Minimum scale (in DB) to test.
+ *  @param[in]  maxDbScale  Maximum scale (in DB) to test.
+ *  @returns    The distance between the shape distributions.
+ */
+NCT_EXPIMP double calculateShapeDistributionDistance(const ShapeDistributionSpline& sd1, 
+    const ShapeDistributionSpline& sd2, DistanceFunction distFunction, 
+    bool useCumulativeDistribution, unsigned int nPoints = 256,
+    unsigned int nScales = 256, double minDbScale = -10.0, double maxDbScale = 10.0);
+
+/**
+ *  @brief      Search the distance between shape distributions.
+ *  @details    This function calculates the distance between two shape distributions whose splines
+ *              were previously built. The scales are those of the exhaustive scan, but only a 
+ *              subset of them is tested: the grid is dense within coarseStep scales of the scale 
+ *              that matches the means of the distributions, and sparse elsewhere. The best scale 
+ *              found is then refined by a descent whose step is halved down to the tolerance. The 
+ *              result is one of the distances of the exhaustive scan and usually its minimum, with 
+ *              much fewer evaluations. Distributions whose distance has several narrow minima 
+ *              (such as the centroid distance) should be compared with the exhaustive scan.
+ *  @param[in]  sd1  Spline of shape distribution 1.
+ *  @param[in]  sd2  Spline of shape distribution 2.
+ *  @param[in]  distFunction  Distance function to use.
+ *  @param[in]  useCumulativeDistribution  True to use the cumulative distribution.
+ *  @param[in]  nPoints  Number of points to use in the evaluation of each distribution.
+ *  @param[in]  nScales  Number of scales of the exhaustive scan.
+ *  @param[in]  coarseStep  Half-width of the dense grid. Its scales are coarseStep/2 apart, and 
+ *              those of the sparse grid 2*coarseStep apart.
+ *  @param[in]  tolerance  Smallest step (in DB) of the refinement.
+ *  @param[in]  minDbScale  Minimum scale (in DB) to test.
+ *  @param[in]  maxDbScale  Maximum scale (in DB) to test.
+ *  @returns    The distance between the shape distributions.
+ */
+NCT_EXPIMP double searchShapeDistributionDistance(const ShapeDistributionSpline& sd1, 
+    const ShapeDistributionSpline& sd2, DistanceFunction distFunction, 
+    bool useCumulativeDistribution, unsigned int nPoints = 256, unsigned int nScales = 256,
+    unsigned int coarseStep = 16, double tolerance = 0.1, double minDbScale = -10.0, 
+    double maxDbScale = 10.0);
+
 /**
  *  @brief      Find rotation indices.
  *  @details    This function finds the indices that are needed to match rotations. This indices
@@ -321,6 +533,31 @@ NCT_EXPIMP double calculateShapeDistributionDistance(const RealVector& h1,
 NCT_EXPIMP Array<Array<size_t>> findRotationIndices(const Array<Vector3D<double>>& dirVectors,
     unsigned int nTestAngles = 8);
 
+/**
+ *  @brief      Find rotation sources.
+ *  @details    This function inverts the rotation indices returned by findRotationIndices, so that
+ *              the rotated descriptors can be read through the table instead of being copied. The
+ *              element j of each row is the element of the second descriptor that is compared with
+ *              the element j of the first descriptor. When several elements are moved to the same
+ *              direction, the last one is kept, and a direction that does not receive any element 
+ *              keeps the source of the previous rotation, as in compareSymmetryDescriptors. The 
+ *              number of directions is used as the source of the elements that are zero.
+ *  @param[in]  rotIndices  Indices that are used to match rotations.
+ *  @returns    A matrix with the sources of one rotation in each row.
+ */
+NCT_EXPIMP Array2D<unsigned int> findRotationSources(const Array<Array<size_t>>& rotIndices);
+
+/**
+ *  @brief      Symmetry descriptor columns.
+ *  @details    This function stores the two columns of a reflexive symmetry descriptor in the
+ *              rows of a matrix, which is the layout used by compareSymmetryDescriptorColumns. 
+ *              The matrix has an additional column of zeros that is referenced by the sources of 
+ *              the rotations.
+ *  @param[in]  rsd  Symmetry descriptor.
+ *  @returns    A matrix of size 2 x (n + 1), where n is the number of directions.
+ */
+NCT_EXPIMP Matrix symmetryDescriptorColumns(const Matrix& rsd);
+
 /**
  *  @brief      Compare reflexive symmetry descriptors.
  *  @details    This function calculates the distance between two shape reflexive symmetry
@@ -347,9 +584,50 @@ NCT_EXPIMP double compareSymmetryDescriptors(const Matrix& rsd1,
  *  @returns    The distance between the descriptors.
  */
 NCT_EXPIMP double compareSymmetryDescriptors(const Matrix& rsd1,
-    const Matrix& rsd2, Array<Array<size_t>>& rotIndices,
+    const Matrix& rsd2, const Array<Array<size_t>>& rotIndices,
     DistanceFunction distFunction);
 
+/**
+ *  @brief      Compare reflexive symmetry descriptors.
+ *  @details    This function calculates the distance between two shape reflexive symmetry
+ *              descriptors. The minimum distance among rotation is returned by this function.
+ *              The distance of each rotation stops accumulating as soon as it reaches the 
+ *              bound or the minimum distance of the previous rotations. The early termination
+ *              is applied to the Euclidean and city-block distances.
+ *  @param[in]  rsd1  Symmetry descriptor 1.
+ *  @param[in]  rsd2  Symmetry descriptor 2.
+ *  @param[in]  rotIndices  Indices that are used to match rotations. 
+ *  @param[in]  distFunction  Distance function to use in this function.
+ *  @param[in]  bound  Upper bound of the distances of interest.
+ *  @returns    The distance between the descriptors if it is less than the bound. Otherwise, a 
+ *              lower bound of the distance that is greater than or equal to the bound.
+ */
+NCT_EXPIMP double compareSymmetryDescriptors(const Matrix& rsd1,
+    const Matrix& rsd2, const Array<Array<size_t>>& rotIndices,
+    DistanceFunction distFunction, double bound);
+
+/**
+ *  @brief      Compare reflexive symmetry descriptor columns.
+ *  @details    This function calculates the distance between two shape reflexive symmetry
+ *              descriptors that are stored by columns (see symmetryDescriptorColumns). The
+ *              minimum distance among rotations is returned by this function. The second
+ *              descriptor is read through the sources of each rotation, and the distance is
+ *              accumulated over blocks of directions in independent partial sums. The distance of
+ *              a rotation is abandoned as soon as it reaches the bound or the minimum distance of
+ *              the previous rotations. The early termination is applied to the Euclidean, 
+ *              city-block and Chebychev distances.
+ *  @param[in]  rsd1  Columns of symmetry descriptor 1.
+ *  @param[in]  rsd2  Columns of symmetry descriptor 2.
+ *  @param[in]  rotSources  Sources of the tested rotations (see findRotationSources).
+ *  @param[in]  distFunction  Distance function to use in this function.
+ *  @param[in]  bound  Upper bound of the distances of interest.
+ *  @returns    The distance between the descriptors if it is less than the bound. Otherwise, a 
+ *              lower bound of the distance that is greater than or equal to the bound.
+ */
+NCT_EXPIMP double compareSymmetryDescriptorColumns(const Matrix& rsd1,
+    const Matrix& rsd2, const Array2D<unsigned int>& rotSources,
+    DistanceFunction distFunction, double bound);
+
 /**
  *  @brief      Coordinates of triangles.
  *  @details    This function returns in one object the coordinates of a set of triangles.
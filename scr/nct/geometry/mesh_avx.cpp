@@ -0,0 +1,89 @@
+//=================================================================================================================
+/**
+ *  @file       mesh_avx.cpp
+ *  @brief      AVX kernels of the nct::geometry::mesh namespace.
+ *  @details    This file contains the kernels of the shape distributions that use the AVX
+ *              instructions.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,  
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial 
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include <nct/geometry/mesh.h>
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Every function defined after the headers is compiled for AVX: the lanes, the kernels of 
+// mesh_kernels.h and the templates instantiated from them. So the vectors are passed between them
+// with the same ABI at every optimization level, whether they are inlined or not. The headers of 
+// the library and the standard library are included before, so that their inline functions keep 
+// the baseline instruction set. MSVC accepts the AVX intrinsics in any function.
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx")
+#endif
+
+#include <nct/geometry/mesh_kernels.h>
+
+//=================================================================================================================
+//        AUXILIAR FUNCTIONS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      AVX lanes.
+ *  @details    Operations of the kernels of the shape distributions on four samples at a time.
+ */
+struct AvxLanes {
+    using type = __m256d;
+    static constexpr nct::size_t width {nct::geometry::mesh::avxShapeDistributionWidth};
+    static type set(double a) noexcept {return _mm256_set1_pd(a);}
+    static type load(const double* p) noexcept {return _mm256_loadu_pd(p);}
+    static void store(double* p, type a) noexcept {_mm256_storeu_pd(p, a);}
+    static type add(type a, type b) noexcept {return _mm256_add_pd(a, b);}
+    static type sub(type a, type b) noexcept {return _mm256_sub_pd(a, b);}
+    static type mul(type a, type b) noexcept {return _mm256_mul_pd(a, b);}
+    static type div(type a, type b) noexcept {return _mm256_div_pd(a, b);}
+    static type sqrt(type a) noexcept {return _mm256_sqrt_pd(a);}
+    static type abs(type a) noexcept {return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);}
+};
+
+//-----------------------------------------------------------------------------------------------------------------
+void nct::geometry::mesh::avxShapeDistributionSamples(ShapeDistribution dist, const double* x, 
+    const double* y, const double* z, nct::size_t n, nct::size_t m, const Point3D& c, double* samps)
+{
+    shapeDistributionSamples<AvxLanes>(dist, x, y, z, n, 0, m, c, samps);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
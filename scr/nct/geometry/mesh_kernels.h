@@ -0,0 +1,221 @@
+//=================================================================================================================
+/**
+ *  @file       mesh_kernels.h
+ *  @brief      Kernels of the shape distributions of the nct::geometry::mesh namespace.
+ *  @details    This file contains the kernels that calculate the samples of the shape distributions
+ *              with vector instructions. It is shared by mesh.cpp and mesh_avx.cpp and it is not
+ *              part of the interface of the library.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+#ifndef NCT_mesh_kernels_H_INCLUDE
+#define NCT_mesh_kernels_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include <nct/geometry/mesh.h>
+
+#include <cmath>
+
+// The vector kernels are compiled for every x86-64 build. The SSE2 lanes are part of the
+// baseline of x86-64, while the AVX lanes are compiled for AVX in mesh_avx.cpp and only run
+// when the processor supports them.
+#if defined(_M_X64) || defined(__x86_64__)
+#define NCT_MESH_SSE2
+#define NCT_MESH_AVX
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+//=================================================================================================================
+namespace nct {
+namespace geometry {
+namespace mesh {
+
+#if defined(NCT_MESH_AVX)
+/**
+ *  @brief      Samples of the AVX lanes.
+ */
+constexpr nct::size_t avxShapeDistributionWidth {4};
+
+/**
+ *  @brief      Samples of a shape distribution.
+ *  @details    This function calculates the first random samples of a shape distribution with the
+ *              AVX lanes. It is implemented in mesh_avx.cpp, which is compiled for AVX, so it must
+ *              only be called when the processor supports AVX.
+ *  @param[in]  dist  The shape distribution.
+ *  @param[in]  x  The x coordinates of the points of the pool.
+ *  @param[in]  y  The y coordinates of the points of the pool.
+ *  @param[in]  z  The z coordinates of the points of the pool.
+ *  @param[in]  n  The number of tuples of the pool.
+ *  @param[in]  m  The number of samples. It must be a multiple of avxShapeDistributionWidth.
+ *  @param[in]  c  The centroid of the mesh.
+ *  @param[out] samps  The m samples of the distribution.
+ */
+void avxShapeDistributionSamples(ShapeDistribution dist, const double* x, const double* y,
+    const double* z, nct::size_t n, nct::size_t m, const Point3D& c, double* samps);
+#endif
+
+}}}
+
+//=================================================================================================================
+//        KERNELS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Difference of two points.
+ *  @details    This function calculates one coordinate of the point j of the tuples i to
+ *              i + L::width - 1 minus the same coordinate of their first point.
+ *  @param[in]  p  The coordinates of the points of the pool.
+ *  @param[in]  n  The number of tuples of the pool.
+ *  @param[in]  j  The point of the tuples.
+ *  @param[in]  i  The first tuple.
+ *  @returns    The differences of the coordinates.
+ */
+template<class L>
+static typename L::type shapeDistributionDifference(const double* p, nct::size_t n, nct::size_t j,
+    nct::size_t i) noexcept
+{
+    return L::sub(L::load(p + j*n + i), L::load(p + i));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Norm of a vector.
+ *  @param[in]  u  The x coordinates of the vectors.
+ *  @param[in]  v  The y coordinates of the vectors.
+ *  @param[in]  w  The z coordinates of the vectors.
+ *  @returns    The norms of the vectors.
+ */
+template<class L>
+static typename L::type shapeDistributionNorm(typename L::type u, typename L::type v,
+    typename L::type w) noexcept
+{
+    return L::sqrt(L::add(L::add(L::mul(u, u), L::mul(v, v)), L::mul(w, w)));
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+/**
+ *  @brief      Samples of a shape distribution.
+ *  @details    This function calculates the random samples first to last - 1 of a shape
+ *              distribution with the operations of the lanes L. The arithmetic is the same for
+ *              all the lanes, so every sample is the same regardless of the lanes that calculate
+ *              it. The cube roots and the angles are calculated one sample at a time.
+ *  @param[in]  dist  The shape distribution.
+ *  @param[in]  x  The x coordinates of the points of the pool.
+ *  @param[in]  y  The y coordinates of the points of the pool.
+ *  @param[in]  z  The z coordinates of the points of the pool.
+ *  @param[in]  n  The number of tuples of the pool.
+ *  @param[in]  first  The first sample.
+ *  @param[in]  last  The sample after the last one. last - first must be a multiple of the width
+ *              of the lanes.
+ *  @param[in]  c  The centroid of the mesh.
+ *  @param[out] samps  The n samples of the distribution.
+ */
+template<class L>
+static void shapeDistributionSamples(nct::geometry::mesh::ShapeDistribution dist, const double* x,
+    const double* y, const double* z, nct::size_t n, nct::size_t first, nct::size_t last,
+    const nct::Point3D& c, double* samps)
+{
+    using nct::geometry::mesh::ShapeDistribution;
+    using T = typename L::type;
+
+    switch (dist) {
+        case ShapeDistribution::TwoVectorsAngle:
+            for (nct::size_t i=first; i<last; i+=L::width) {
+                T ux = shapeDistributionDifference<L>(x, n, 1, i);
+                T uy = shapeDistributionDifference<L>(y, n, 1, i);
+                T uz = shapeDistributionDifference<L>(z, n, 1, i);
+                T vx = shapeDistributionDifference<L>(x, n, 2, i);
+                T vy = shapeDistributionDifference<L>(y, n, 2, i);
+                T vz = shapeDistributionDifference<L>(z, n, 2, i);
+
+                T cx = L::sub(L::mul(uy, vz), L::mul(uz, vy));
+                T cy = L::sub(L::mul(uz, vx), L::mul(ux, vz));
+                T cz = L::sub(L::mul(ux, vy), L::mul(uy, vx));
+                T dot = L::add(L::add(L::mul(ux, vx), L::mul(uy, vy)), L::mul(uz, vz));
+
+                // The angle is between 0 and pi, and it is 0 when one of the vectors is null.
+                double d[L::width];
+                L::store(samps + i, shapeDistributionNorm<L>(cx, cy, cz));
+                L::store(d, dot);
+                for (nct::size_t l=0; l<L::width; l++)
+                    samps[i + l] = std::atan2(samps[i + l], d[l]);
+            }
+            break;
+
+        case ShapeDistribution::CentroidDistance:
+            for (nct::size_t i=first; i<last; i+=L::width) {
+                L::store(samps + i, shapeDistributionNorm<L>(L::sub(L::load(x + i), L::set(c.v1())),
+                    L::sub(L::load(y + i), L::set(c.v2())), L::sub(L::load(z + i), L::set(c.v3()))));
+            }
+            break;
+
+        case ShapeDistribution::TwoPointDistance:
+            for (nct::size_t i=first; i<last; i+=L::width) {
+                L::store(samps + i, shapeDistributionNorm<L>(shapeDistributionDifference<L>(x, n, 1, i),
+                    shapeDistributionDifference<L>(y, n, 1, i), shapeDistributionDifference<L>(z, n, 1, i)));
+            }
+            break;
+
+        case ShapeDistribution::ThreePointArea:
+            for (nct::size_t i=first; i<last; i+=L::width) {
+                T ux = shapeDistributionDifference<L>(x, n, 1, i);
+                T uy = shapeDistributionDifference<L>(y, n, 1, i);
+                T uz = shapeDistributionDifference<L>(z, n, 1, i);
+                T vx = shapeDistributionDifference<L>(x, n, 2, i);
+                T vy = shapeDistributionDifference<L>(y, n, 2, i);
+                T vz = shapeDistributionDifference<L>(z, n, 2, i);
+
+                T cx = L::sub(L::mul(uy, vz), L::mul(uz, vy));
+                T cy = L::sub(L::mul(uz, vx), L::mul(ux, vz));
+                T cz = L::sub(L::mul(ux, vy), L::mul(uy, vx));
+                L::store(samps + i, L::sqrt(L::div(shapeDistributionNorm<L>(cx, cy, cz), L::set(2.0))));
+            }
+            break;
+
+        default:
+            for (nct::size_t i=first; i<last; i+=L::width) {
+                T ux = shapeDistributionDifference<L>(x, n, 1, i);
+                T uy = shapeDistributionDifference<L>(y, n, 1, i);
+                T uz = shapeDistributionDifference<L>(z, n, 1, i);
+                T vx = shapeDistributionDifference<L>(x, n, 2, i);
+                T vy = shapeDistributionDifference<L>(y, n, 2, i);
+                T vz = shapeDistributionDifference<L>(z, n, 2, i);
+                T wx = shapeDistributionDifference<L>(x, n, 3, i);
+                T wy = shapeDistributionDifference<L>(y, n, 3, i);
+                T wz = shapeDistributionDifference<L>(z, n, 3, i);
+
+                T t = L::add(L::sub(
+                    L::mul(ux, L::sub(L::mul(vy, wz), L::mul(vz, wy))),
+                    L::mul(uy, L::sub(L::mul(vx, wz), L::mul(vz, wx)))),
+                    L::mul(uz, L::sub(L::mul(vx, wy), L::mul(vy, wx))));
+                L::store(samps + i, L::abs(L::div(t, L::set(6.0))));
+                for (nct::size_t l=0; l<L::width; l++)
+                    samps[i + l] = std::cbrt(samps[i + l]);
+            }
+            break;
+    }
+}
+
+#endif
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
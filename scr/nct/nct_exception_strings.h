@@ -471,6 +471,7 @@ inline constexpr const char* exc_bad_fisher_test {"No successes were found by th
 
 inline constexpr const char* exc_error_performing_resampling {"Unable to perform resampling operation."};
 inline constexpr const char* exc_error_calculating_statistic {"Unable to calculate statistic of data."};
+inline constexpr const char* exc_bad_histogram_bins {"The histograms don't have the same bins."};
 
 inline constexpr const char* exc_error_at_mls_algorithm {"Unable to apply MLS algorithm on the specified data."};
 inline constexpr const char* exc_error_testing_mls_algorithm {"Unable to test results of MLS algorithm."};
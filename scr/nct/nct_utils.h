@@ -312,6 +312,25 @@ template<typename IntegerType, typename FunctionType>
 requires std::integral<IntegerType> && std::invocable<FunctionType, IntegerType>
 void parallel_for(IntegerType first, IntegerType last, FunctionType f);
 
+/**
+ *  @brief      Parallel for.
+ *  @details    This helper function calls an indexed functor multiple times using a fixed number of
+ *              threads. Each thread takes the next pending index as soon as it finishes the previous
+ *              one, so invocations with different costs are balanced between the threads.
+ *  @note       In case of an exception inside a thread, this function cancels the rest of invocations
+ *              and produces only one exception indicating the index that failed in the execution.
+ *  @tparam     IntegerType  The type of index variable.
+ *  @tparam     FunctionType  The type of function to be executed in parallel.
+ *  @param[in]  first  The first index to be included in the iteration.
+ *  @param[in]  last  The index one past the last index to be included in the iteration.
+ *  @param[in]  nThreads  The number of threads. If it is zero, the number of hardware threads is used.
+ *  @param[in]  f  The function to invoke. It must be a callabe object that takes as argument 
+ *              an integer.
+ */
+template<typename IntegerType, typename FunctionType> 
+requires std::integral<IntegerType> && std::invocable<FunctionType, IntegerType>
+void parallel_for(IntegerType first, IntegerType last, unsigned int nThreads, FunctionType f);
+
 }
 
 ////////// Template and inline functions //////////
@@ -212,6 +212,57 @@ void nct::parallel_for(IntegerType first, IntegerType last, FunctionType f)
     }
 }
 
+//-----------------------------------------------------------------------------------------------------------------
+template <typename IntegerType, typename FunctionType>
+requires std::integral<IntegerType> && std::invocable<FunctionType, IntegerType>
+void nct::parallel_for(IntegerType first, IntegerType last, unsigned int nThreads, FunctionType f)
+{
+    if (last <= first)
+        return;
+
+    if (nThreads == 0)
+        nThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+    auto n = static_cast<std::size_t>(last - first);
+    if (nThreads > n)
+        nThreads = static_cast<unsigned int>(n);
+
+    std::atomic<std::size_t> next = 0;
+    std::atomic<bool> exceptionFlag = false;
+    std::size_t exceptionIndex = 0;
+    std::exception_ptr exception = nullptr;
+    std::mutex exceptionMutex;
+
+    auto worker = [&] () -> void {
+        for (auto k = next++; (k < n) && !exceptionFlag; k = next++) {
+            try {
+                f(static_cast<IntegerType>(first + static_cast<IntegerType>(k)));
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exceptionFlag) {
+                    exceptionFlag = true;
+                    exceptionIndex = static_cast<std::size_t>(first) + k;
+                    exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::list<std::future<void>> futureList;
+    for (unsigned int t = 1; t < nThreads; t++)
+        futureList.push_back(std::async(std::launch::async, worker));
+    worker();
+
+    for (auto& fli : futureList)
+        fli.get();
+
+    if (exception) {
+        throw OperationException(exc_error_invoking_function, exceptionIndex, 
+            SOURCE_INFO, exception);
+    }
+}
+
 //=================================================================================================================
 //        END OF FILE
 //=================================================================================================================
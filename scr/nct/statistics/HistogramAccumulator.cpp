@@ -0,0 +1,148 @@
+//=================================================================================================================
+/**
+ *  @file       HistogramAccumulator.cpp
+ *  @brief      nct::statistics::HistogramAccumulator class implementation file.
+ *  @details    This file contains the implementation of the nct::statistics::HistogramAccumulator class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,  
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial 
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+//=================================================================================================================
+//        HEADERS AND NAMESPACES
+//=================================================================================================================
+#include <nct/statistics/HistogramAccumulator.h>
+
+//=================================================================================================================
+//        CONSTRUCTORS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::statistics::HistogramAccumulator::HistogramAccumulator(size_t nBins, double xMin, double xMax)
+{
+    setBins(nBins, xMin, xMax);
+}
+
+//=================================================================================================================
+//        MEMBER FUNCTIONS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::size_t nct::statistics::HistogramAccumulator::numberOfBins() const noexcept
+{
+    return counts_.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double nct::statistics::HistogramAccumulator::lowerLimit() const noexcept
+{
+    return xMin_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+double nct::statistics::HistogramAccumulator::upperLimit() const noexcept
+{
+    return xMax_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::size_t nct::statistics::HistogramAccumulator::numberOfObservations() const noexcept
+{
+    return nObservations_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::size_t nct::statistics::HistogramAccumulator::outOfRange() const noexcept
+{
+    return nOutOfRange_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void nct::statistics::HistogramAccumulator::merge(const HistogramAccumulator& other)
+{
+    if ((other.counts_.size() != counts_.size()) || (other.xMin_ != xMin_) || (other.xMax_ != xMax_))
+        throw ArgumentException("other", exc_bad_histogram_bins, SOURCE_INFO);
+
+    for (index_t i=0; i<counts_.size(); i++)
+        counts_[i] += other.counts_[i];
+
+    nObservations_ += other.nObservations_;
+    nOutOfRange_ += other.nOutOfRange_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void nct::statistics::HistogramAccumulator::reset() noexcept
+{
+    for (auto& c : counts_)
+        c = 0;
+
+    nObservations_ = 0;
+    nOutOfRange_ = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+const nct::Array<nct::size_t>& nct::statistics::HistogramAccumulator::counts() const noexcept
+{
+    return counts_;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector nct::statistics::HistogramAccumulator::histogram(double scale) const
+{
+    RealVector h(counts_.size());
+    for (index_t i=0; i<counts_.size(); i++)
+        h[i] = scale*static_cast<double>(counts_[i]);
+
+    return h;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+nct::RealVector nct::statistics::HistogramAccumulator::bins() const
+{
+    auto nBins = counts_.size();
+    RealVector b(nBins);
+    for (index_t i=0; i<nBins; i++)
+        b[i] = xMin_ + (xMax_ - xMin_)*((i + 0.5)/static_cast<double>(nBins));
+
+    return b;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+void nct::statistics::HistogramAccumulator::setBins(size_t nBins, double xMin, double xMax)
+{
+    if (nBins < 2) 
+        throw ArgumentException("nBins", static_cast<unsigned long long>(nBins), 2ULL,
+        RelationalOperator::GreaterThanOrEqualTo, SOURCE_INFO);
+    if (!(xMax > xMin)) 
+        throw ArgumentException("xMin, xMax", exc_bad_bounds, SOURCE_INFO);
+
+    xMin_ = xMin;
+    xMax_ = xMax;
+    scale_ = static_cast<double>(nBins)/(xMax - xMin);
+    counts_.assign(nBins, 0);
+    nObservations_ = 0;
+    nOutOfRange_ = 0;
+
+    // The limits are the same as the ones of statistics::histogram, except the last one, which
+    // is the upper limit of the range.
+    limits_.assign(nBins + 1, 0.0);
+    for (index_t i=0; i<nBins; i++)
+        limits_[i] = xMin + (xMax - xMin)*(i/static_cast<double>(nBins));
+    limits_[nBins] = xMax;
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
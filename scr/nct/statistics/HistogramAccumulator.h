@@ -0,0 +1,222 @@
+//=================================================================================================================
+/**
+ *  @file       HistogramAccumulator.h
+ *  @brief      nct::statistics::HistogramAccumulator class.
+ *  @details    Declaration of the nct::statistics::HistogramAccumulator class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,  
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial 
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+#ifndef NCT_HISTOGRAM_ACCUMULATOR_H_INCLUDE
+#define NCT_HISTOGRAM_ACCUMULATOR_H_INCLUDE
+
+//=================================================================================================================
+//        HEADERS
+//=================================================================================================================
+#include <nct/nct.h>
+#include <nct/nct_exception.h>
+#include <nct/Array.h>
+
+#include <iterator>
+
+//=================================================================================================================
+namespace nct {
+namespace statistics {
+
+/**
+ *  @brief      Histogram accumulator.
+ *  @details    This class calculates a histogram in one pass over the observations. The bin of each 
+ *              observation is found by arithmetic on its value, so the observations are neither 
+ *              copied nor sorted. The limits of the bins are the same as the ones of 
+ *              statistics::histogram: each bin includes its upper limit, the first bin includes the
+ *              lower limit of the range, and the observations that are outside the range are only
+ *              counted by outOfRange. The observations can be added in several calls, and the 
+ *              histograms of several parts of the data, for example one per thread, can be merged 
+ *              when they have the same bins. When the range is not known, the accumulator can be 
+ *              built with the range of the data, which takes a second pass over them.
+ */
+class NCT_EXPIMP HistogramAccumulator final {
+
+public:
+
+    ////////// Constructors //////////
+
+    /**
+     *  @brief      Default constructor.
+     *  @details    This constructor initializes an accumulator without bins.
+     */
+    HistogramAccumulator() = default;
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor initializes an empty histogram with a fixed range.
+     *  @param[in]  nBins  Number of bins of the histogram.
+     *  @param[in]  xMin  Lower limit of the first bin.
+     *  @param[in]  xMax  Upper limit of the last bin.
+     */
+    HistogramAccumulator(size_t nBins, double xMin, double xMax);
+
+    /**
+     *  @brief      Class constructor.
+     *  @details    This constructor calculates the histogram of a set of observations with the range
+     *              of the observations. The first pass finds the range and the second one adds the
+     *              observations.
+     *  @tparam     InputIt  The type of iterator of the observations.
+     *  @param[in]  first  Input iterator to the initial position of the observations.
+     *  @param[in]  last  Input iterator to the final position of the observations.
+     *  @param[in]  nBins  Number of bins of the histogram.
+     */
+    template<std::forward_iterator InputIt>
+    HistogramAccumulator(InputIt first, InputIt last, size_t nBins);
+
+    ////////// Member functions //////////
+
+    /**
+     *  @brief      Number of bins.
+     *  @details    This function returns the number of bins of the histogram.
+     *  @returns    The number of bins.
+     */
+    size_t numberOfBins() const noexcept;
+
+    /**
+     *  @brief      Lower limit.
+     *  @details    This function returns the lower limit of the first bin.
+     *  @returns    The lower limit of the range.
+     */
+    double lowerLimit() const noexcept;
+
+    /**
+     *  @brief      Upper limit.
+     *  @details    This function returns the upper limit of the last bin.
+     *  @returns    The upper limit of the range.
+     */
+    double upperLimit() const noexcept;
+
+    /**
+     *  @brief      Number of observations.
+     *  @details    This function returns the number of observations that were counted in the bins.
+     *  @returns    The number of observations in the range.
+     */
+    size_t numberOfObservations() const noexcept;
+
+    /**
+     *  @brief      Observations out of range.
+     *  @details    This function returns the number of observations that were outside the range
+     *              and weren't counted.
+     *  @returns    The number of observations out of range.
+     */
+    size_t outOfRange() const noexcept;
+
+    /**
+     *  @brief      Bin.
+     *  @details    This function returns the bin that corresponds to a value.
+     *  @param[in]  x  The value.
+     *  @returns    The index of the bin, or the number of bins if the value is out of range.
+     */
+    size_t bin(double x) const noexcept;
+
+    /**
+     *  @brief      Add observation.
+     *  @details    This function adds an observation to the histogram.
+     *  @param[in]  x  The observation.
+     */
+    void add(double x) noexcept;
+
+    /**
+     *  @brief      Add observations.
+     *  @details    This function adds a set of observations to the histogram.
+     *  @tparam     InputIt  The type of iterator of the observations.
+     *  @param[in]  first  Input iterator to the initial position of the observations.
+     *  @param[in]  last  Input iterator to the final position of the observations.
+     */
+    template<std::input_iterator InputIt>
+    void add(InputIt first, InputIt last);
+
+    /**
+     *  @brief      Merge histograms.
+     *  @details    This function adds the counts of another histogram with the same bins.
+     *  @param[in]  other  The histogram to add.
+     */
+    void merge(const HistogramAccumulator& other);
+
+    /**
+     *  @brief      Reset.
+     *  @details    This function sets the counts to zero and keeps the bins.
+     */
+    void reset() noexcept;
+
+    /**
+     *  @brief      Counts.
+     *  @details    This function returns the number of observations of each bin.
+     *  @returns    The counts of the bins.
+     */
+    const Array<size_t>& counts() const noexcept;
+
+    /**
+     *  @brief      Histogram.
+     *  @details    This function returns the counts of the bins multiplied by a factor.
+     *  @param[in]  scale  The factor of the counts.
+     *  @returns    The values of the histogram.
+     */
+    RealVector histogram(double scale = 1) const;
+
+    /**
+     *  @brief      Bin centers.
+     *  @details    This function returns the centers of the bins.
+     *  @returns    The centers of the bins.
+     */
+    RealVector bins() const;
+
+private:
+
+    ////////// Member functions //////////
+
+    /**
+     *  @brief      Set bins.
+     *  @details    This function sets the range and the bins of an empty histogram.
+     *  @param[in]  nBins  Number of bins of the histogram.
+     *  @param[in]  xMin  Lower limit of the first bin.
+     *  @param[in]  xMax  Upper limit of the last bin.
+     */
+    void setBins(size_t nBins, double xMin, double xMax);
+
+    ////////// Data members //////////
+
+    Array<size_t> counts_;      /**< Number of observations of each bin. */
+
+    RealVector limits_;         /**< Limits of the bins (one more than bins). */
+
+    double xMin_ {0};           /**< Lower limit of the range. */
+
+    double xMax_ {0};           /**< Upper limit of the range. */
+
+    double scale_ {0};          /**< Number of bins per unit. */
+
+    size_t nObservations_ {0};  /**< Number of observations in the range. */
+
+    size_t nOutOfRange_ {0};    /**< Number of observations out of range. */
+};
+
+}}
+
+////////// Implementation of method templates //////////
+#include <nct/statistics/HistogramAccumulator_template.h>
+
+#endif
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
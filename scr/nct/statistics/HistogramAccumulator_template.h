@@ -0,0 +1,97 @@
+//=================================================================================================================
+/**
+ *  @file       HistogramAccumulator_template.h
+ *  @brief      nct::statistics::HistogramAccumulator class implementation file.
+ *  @details    This file contains the implementation of template and inline methods of 
+ *              the nct::statistics::HistogramAccumulator class.
+ *  @author     Omar Mendoza Montoya (email: omendoz@live.com.mx).
+ *  @copyright  Copyright (c) 2012 Omar Mendoza Montoya \n \n
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ *  associated documentation files (the "Software"), to deal in the Software without restriction,  
+ *  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,  
+ *  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, 
+ *  subject to the following conditions: \n
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial 
+ *  portions of the Software. \n
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ *  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//=================================================================================================================
+
+//=================================================================================================================
+//        CONSTRUCTORS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+template<std::forward_iterator InputIt>
+nct::statistics::HistogramAccumulator::HistogramAccumulator(InputIt first, InputIt last, size_t nBins)
+{
+    if (first == last)
+        throw RangeException("first, last", SOURCE_INFO);
+
+    double xMin = static_cast<double>(*first);
+    double xMax = xMin;
+    for (auto x = first; x != last; ++x) {
+        auto v = static_cast<double>(*x);
+        if (xMin > v)
+            xMin = v;
+        if (xMax < v)
+            xMax = v;
+    }
+
+    setBins(nBins, xMin, xMax);
+    add(first, last);
+}
+
+//=================================================================================================================
+//        MEMBER FUNCTIONS
+//=================================================================================================================
+
+//-----------------------------------------------------------------------------------------------------------------
+inline nct::size_t nct::statistics::HistogramAccumulator::bin(double x) const noexcept
+{
+    auto nBins = counts_.size();
+    if ((nBins == 0) || !(x >= xMin_) || !(x <= xMax_))
+        return nBins;
+
+    auto b = static_cast<size_t>((x - xMin_)*scale_);
+    if (b >= nBins)
+        b = nBins - 1;
+
+    // The product can be one bin away from the limits, which are calculated as in 
+    // statistics::histogram.
+    while ((b > 0) && (x <= limits_[b]))
+        b--;
+    while ((b + 1 < nBins) && (x > limits_[b + 1]))
+        b++;
+
+    return b;
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+inline void nct::statistics::HistogramAccumulator::add(double x) noexcept
+{
+    auto b = bin(x);
+    if (b < counts_.size()) {
+        counts_[b]++;
+        nObservations_++;
+    }
+    else {
+        nOutOfRange_++;
+    }
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+template<std::input_iterator InputIt>
+void nct::statistics::HistogramAccumulator::add(InputIt first, InputIt last)
+{
+    for (auto x = first; x != last; ++x)
+        add(static_cast<double>(*x));
+}
+
+//=================================================================================================================
+//        END OF FILE
+//=================================================================================================================
@@ -29,6 +29,7 @@
 #include <nct/nct.h>
 #include <nct/nct_exception.h>
 #include <nct/math/math.h>
+#include <nct/statistics/HistogramAccumulator.h>
 
 #include <algorithm>
 #include <vector>
@@ -1287,7 +1288,8 @@ void pvalToCDF(InputIt pFirst, InputIt pLast, OutIt pOut, ResultType pvalType);
 
 /**
  *  @brief      Histogram.
- *  @details    This function gets the histogram of a set of observations.
+ *  @details    This function gets the histogram of a set of observations. The histogram is 
+ *              limited by the minimum and maximum observations (see HistogramAccumulator).
  *  @tparam     InputIt  The iterator type to be used to traverse the sequence of observations.
  *  @tparam     OutIt  The iterator type to be used to store the results.
  *  @param[in]  first  Iterator defining the beginning of the source container.
@@ -1306,7 +1308,8 @@ void histogram(InputIt first, InputIt last, OutIt hOut, OutIt bins, size_t nBins
 /**
  *  @brief      Histogram.
  *  @details    This function gets the histogram of a set of observations. Thi histogram is
- *              limited by the minimin and maximum values specified in the parameters.
+ *              limited by the minimin and maximum values specified in the parameters. The 
+ *              observations are binned in one pass (see HistogramAccumulator).
  *  @tparam     InputIt  The iterator type to be used to traverse the sequence of observations.
  *  @tparam     OutIt  The iterator type to be used to store the result.
  *  @param[in]  first  Iterator defining the beginning of the source container.
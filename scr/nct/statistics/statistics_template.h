@@ -2443,6 +2443,9 @@ requires std::output_iterator<OutIt, typename InputIt::value_type> &&
 void nct::statistics::histogram(InputIt first, InputIt last, OutIt hOut, 
     OutIt bins, size_t nBins)
 {
+    if (first >= last)
+        throw RangeException("first, last", SOURCE_INFO);
+
     double xMin = *first;
     double xMax = *first;    
     for (InputIt x=first; x!=last; ++x) {
@@ -2469,34 +2472,15 @@ void nct::statistics::histogram(InputIt first, InputIt last, OutIt hOut,
     if (xMax <= xMin) 
         throw ArgumentException("xMin, xMax", exc_bad_bounds, SOURCE_INFO);
         
-    // Sort data.
-    auto size = (last - first);
-    diff_t c=0;
-    std::vector<double> xSort(size);
-    for (InputIt x=first; x!=last; ++x)
-        xSort[c++] = static_cast<double>(*x);
-    std::sort(xSort.begin(), xSort.end());
+    // Histogram. The observations are binned in one pass.
+    HistogramAccumulator accumulator(nBins, xMin, xMax);
+    accumulator.add(first, last);
+    const auto& counts = accumulator.counts();
 
-    // Histogram.
-    double lowerLimit = xMin;
-    double upperLimit = xMin;
-    diff_t lastIndex = 0;
     for (index_t i=0; i<nBins; i++) {
         // Bin value.
         *bins = xMin + (xMax-xMin)*((i+0.5)/static_cast<double>(nBins));
-        lowerLimit = upperLimit;
-        upperLimit = xMin + (xMax-xMin)*((i+1.0)/static_cast<double>(nBins));
-
-        // Acumulated data.
-        *hOut = 0;
-        for (diff_t j=lastIndex; j<size; j++) {
-            if (xSort[j]>upperLimit) {
-                lastIndex = j;
-                break;
-            }
-            else if (xSort[j]>=lowerLimit)
-                (*hOut)++;
-        }        
+        *hOut = static_cast<std::remove_cvref_t<decltype(*hOut)>>(counts[i]);
         
         // Increase iterators.
         ++hOut;